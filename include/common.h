@@ -11,6 +11,7 @@
 #ifndef NEGOTIO_COMMON_H
 #define NEGOTIO_COMMON_H
 
+#include <array>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -51,6 +52,8 @@ namespace negotio {
         RANDOM1 = 1, // 随机数1
         RANDOM2 = 2, // 随机数2
         CONFIRM = 3, // 确认
+        RESUME = 4, // 携带恢复票据的随机数1（1-RTT 重新协商）
+        RESUME_ACK = 5, // 恢复协商的随机数2
     };
 
     // 数据包头部结构
@@ -88,6 +91,9 @@ namespace negotio {
     constexpr uint32_t RANDOM_NUMBER = 32; // 随机数大小(字节)
     constexpr uint32_t KEY_SIZE = 32; // 密钥大小(字节)
 
+    using SessionRandom = std::array<uint8_t, RANDOM_NUMBER>; // 协商随机数
+    using SessionKey = std::array<uint8_t, KEY_SIZE>; // 协商密钥
+
     // 错误处理函数
     std::string GetErrorMessage(ErrorCode code);
 }
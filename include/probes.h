@@ -0,0 +1,63 @@
+/**
+ * @file probes.h
+ * @brief USDT 静态探针定义
+ * @details 在协商关键阶段放置 USDT（sys/sdt.h）探针，供 bpftrace / perf / systemtap 在生产环境挂载，
+ *          无需重新编译或重启进程。未挂载追踪器时探针只是一条 nop 指令，参数均为已在寄存器中的整数。
+ *
+ *          provider 为 negotio，探针列表：
+ *          - packet__received(policy_id, type, bytes)        UDP 收到并解析出一个数据包
+ *          - packet__sent(policy_id, type, bytes)            UDP 发出一个数据包
+ *          - session__created(policy_id, role)               创建会话，role: 0 发起方，1 响应方
+ *          - state__change(policy_id, from, to, age_ns)      会话状态迁移，age_ns 为触发包到达时会话已存在的时长
+ *          - key__computed(policy_id, age_ns)                共享密钥计算完成
+ *          - negotiation__done(policy_id, role, duration_ns) 协商成功
+ *          - negotiation__failed(policy_id, type, error)     协商失败，error 为 ErrorCode
+ *          - packet__stale(policy_id, type, delay_ms)        排队时延超过协商超时，未处理即丢弃
+ *
+ *          CMake 选项 NEGOTIO_USDT（默认 ON）控制是否生成探针；系统缺少 sys/sdt.h 时自动退化为空宏，参数不求值。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#ifndef NEGOTIO_PROBES_H
+#define NEGOTIO_PROBES_H
+
+// USDT 探针开关: 0:关闭,1:开启（由 CMake 选项 NEGOTIO_USDT 控制）
+#ifndef NEGOTIO_USDT
+#define NEGOTIO_USDT 0
+#endif
+
+#if NEGOTIO_USDT && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define NEGOTIO_HAVE_SDT 1
+#endif
+#endif
+
+#ifdef NEGOTIO_HAVE_SDT
+#define NEGOTIO_PROBE2(name, a1, a2) DTRACE_PROBE2(negotio, name, a1, a2)
+#define NEGOTIO_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(negotio, name, a1, a2, a3)
+#define NEGOTIO_PROBE4(name, a1, a2, a3, a4) DTRACE_PROBE4(negotio, name, a1, a2, a3, a4)
+#else
+// 未生成探针时参数不求值，探针位置上的耗时计算等不留下任何开销
+#define NEGOTIO_PROBE2(name, a1, a2) do { } while (0)
+#define NEGOTIO_PROBE3(name, a1, a2, a3) do { } while (0)
+#define NEGOTIO_PROBE4(name, a1, a2, a3, a4) do { } while (0)
+#endif
+
+namespace negotio {
+    /**
+     * @brief 探针是否已编译进二进制
+     */
+    constexpr bool usdtProbesEnabled() {
+#ifdef NEGOTIO_HAVE_SDT
+        return true;
+#else
+        return false;
+#endif
+    }
+}
+
+#endif // NEGOTIO_PROBES_H
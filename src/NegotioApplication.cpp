@@ -5,18 +5,37 @@
 #include <csignal>
 #include <chrono>
 #include <cstdlib>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <condition_variable>
 #include <sys/mman.h>
 #include <pthread.h>
 #include <sched.h>
 
 #include "unixsocket/unixsocket.h"
+#include "control/control.h"
 #include "udp/udp.h"
+#include "localtransport/localtransport.h"
 #include "policy/policy.h"
 #include "negotiate/negotiate.h"
 #include "monitor/monitor.h"
+#include "capture/capture.h"
+#include "allocstat/allocstat.h"
+#include "warmup/warmup.h"
+#include "bootstrap/bootstrap.h"
+#include "prefork/prefork.h"
+#include "sharedtable/sharedtable.h"
+#include "concurrency/concurrency.h"
+#include "lockedarena/lockedarena.h"
+#include "batching/batching.h"
 
 #include "nlohmann/json.hpp"
 #include <sys/epoll.h>
+#include <poll.h>
 #include <cerrno>
 #include <arpa/inet.h>
 
@@ -44,6 +63,92 @@ struct TraceBlock {
     }
 };
 
+// 一个接收分片的批处理阶段：RX 一次 recvmmsg 的数据报数、处理线程每次处理的数据包数、一次 sendmmsg 的数据包数。
+// 块交给分片常驻的处理线程，不为每块创建线程
+struct ShardBatching {
+    negotio::AdaptiveBatcher rx;
+    negotio::AdaptiveBatcher crypto;
+    negotio::AdaptiveBatcher tx;
+    std::atomic<uint32_t> processing{0}; ///< 排队与正在处理的块数，即处理阶段的积压
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<std::vector<negotio::AddressedPacket>> chunks; ///< 等待处理线程的块
+    bool stopping = false;
+
+    ShardBatching(const negotio::BatchOptions &rxOptions, const negotio::BatchOptions &cryptoOptions,
+                  const negotio::BatchOptions &txOptions)
+        : rx(rxOptions), crypto(cryptoOptions), tx(txOptions) {
+    }
+
+    void submit(std::vector<negotio::AddressedPacket> chunk) {
+        {
+            std::lock_guard lock(queueMutex);
+            chunks.push_back(std::move(chunk));
+        }
+        queueReady.notify_one();
+    }
+
+    // 取出一块；until 之前没有块可取时返回 false，stopped 表示已停止且队列已空
+    bool take(std::vector<negotio::AddressedPacket> &chunk, const std::chrono::steady_clock::time_point until,
+              bool &stopped) {
+        std::unique_lock lock(queueMutex);
+        queueReady.wait_until(lock, until, [this] { return stopping || !chunks.empty(); });
+        if (chunks.empty()) {
+            stopped = stopping;
+            return false;
+        }
+        chunk = std::move(chunks.front());
+        chunks.pop_front();
+        return true;
+    }
+
+    // 块未达到处理阶段的批大小时，在刷新期限内等待并合并随后到达的整块，返回合并的块数
+    uint32_t topUp(std::vector<negotio::AddressedPacket> &chunk, const size_t target,
+                   const std::chrono::steady_clock::time_point until) {
+        std::unique_lock lock(queueMutex);
+        uint32_t merged = 0;
+        while (chunk.size() < target) {
+            if (!queueReady.wait_until(lock, until, [this] { return stopping || !chunks.empty(); })
+                || chunks.empty() || chunk.size() + chunks.front().size() > target) {
+                break;
+            }
+            std::move(chunks.front().begin(), chunks.front().end(), std::back_inserter(chunk));
+            chunks.pop_front();
+            ++merged;
+        }
+        return merged;
+    }
+
+    void shutdown() {
+        {
+            std::lock_guard lock(queueMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+    }
+};
+
+// 处理线程的发送批：udpSender 把发往 UDP 对端的数据包追加到这里，攒满或到期时以一次 sendmmsg 发出
+struct TxBatch {
+    negotio::UdpSocket *socket;
+    negotio::AdaptiveBatcher *batcher;
+    std::vector<negotio::AddressedPacket> pending;
+    std::chrono::steady_clock::time_point oldest;
+
+    void flush(const bool full) {
+        if (pending.empty()) {
+            return;
+        }
+        socket->sendPackets(pending);
+        batcher->observe(static_cast<uint32_t>(pending.size()), full ? 1 : 0);
+        pending.clear();
+    }
+};
+
+// 当前线程的发送批，只在批处理线程中设置；其余线程（控制线程、异步发起协商）的发送立即发出
+thread_local TxBatch *currentTxBatch = nullptr;
+
 void signalHandler(int signum) {
     running = false;
 }
@@ -56,11 +161,104 @@ void setThreadAffinity(int cpu_id) {
     pthread_setaffinity_np(current_thread, sizeof(cpu_set_t), &cpuset);
 }
 
-int main() {
-    if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
-        std::cerr << "mlockall 失败" << std::endl;
+// 多进程模式下工作进程的上下文，单进程模式为 nullptr
+struct WorkerContext {
+    uint32_t index;                         ///< 工作进程序号
+    uint32_t workers;                       ///< 工作进程总数，负责 policy_id % workers == index 的策略
+    int controlFd;                          ///< 接收监督进程转发的控制命令
+    negotio::SharedSessionTable *sharedTable; ///< 共享会话与策略表
+};
+
+int runService(const json &config, std::vector<std::unique_ptr<negotio::UdpSocket>> &udpSockets, uint32_t rxFirstCpu,
+               const WorkerContext *worker);
+
+// 多进程模式：监督进程持有套接字与共享表，经单线程的孵化进程 fork 工作进程并在其崩溃时重启
+int runPrefork(const json &config) {
+    const auto &preforkConfig = config["prefork"];
+    const uint16_t udpPort = config["network"]["udp_port"].get<uint16_t>();
+    const std::string unixSocketPath = config["network"]["unix_socket_path"].get<std::string>();
+    const uint32_t rxFirstCpu = config["network"].value("rx_first_cpu", 1u);
+    negotio::PreforkOptions options;
+    options.workers = std::max<uint32_t>(1, preforkConfig.value("workers", options.workers));
+
+    negotio::SharedSessionTable sharedTable;
+    const std::string tablePath = preforkConfig.value("shared_table_path", std::string("/dev/shm/negotio.sessions"));
+    if (!sharedTable.create(tablePath, preforkConfig.value("session_capacity", negotio::DEFAULT_SHARED_SESSIONS),
+                            preforkConfig.value("policy_capacity", negotio::DEFAULT_SHARED_POLICIES))) {
+        return 1;
+    }
+
+    // 每个工作进程一个 SO_REUSEPORT 套接字，按 policy_id 分流；监督进程始终持有全部套接字，组内顺序不随重启变化
+    std::vector<std::unique_ptr<negotio::UdpSocket>> udpSockets;
+    for (uint32_t i = 0; i < options.workers; ++i) {
+        negotio::UdpSocketOptions socketOptions;
+        socketOptions.reusePort = true;
+        auto socket = std::make_unique<negotio::UdpSocket>();
+        if (socket->init(udpPort, socketOptions) != negotio::ErrorCode::SUCCESS) {
+            std::cerr << "UDP 模块初始化失败" << std::endl;
+            return 1;
+        }
+        udpSockets.push_back(std::move(socket));
+    }
+    if (udpSockets[0]->attachPolicySteering(options.workers) != negotio::ErrorCode::SUCCESS) {
+        std::cerr << "挂载 reuseport 策略分流程序失败，多进程模式需要同一策略的数据包由同一进程处理" << std::endl;
+        return 1;
+    }
+
+    negotio::PreforkSupervisor supervisor([&](const uint32_t index, const int controlFd) {
+        // 工作进程只保留自己的套接字
+        std::vector<std::unique_ptr<negotio::UdpSocket>> own;
+        own.push_back(std::move(udpSockets[index]));
+        udpSockets.clear();
+        const WorkerContext worker{index, options.workers, controlFd, &sharedTable};
+        return runService(config, own, rxFirstCpu + index, &worker);
+    }, options);
+    if (!supervisor.start()) {
+        return 1;
     }
+    std::cout << "多进程模式，工作进程数: " << options.workers << "，共享会话表: " << tablePath << std::endl;
 
+    // 监督进程只解码控制命令：写入共享策略表后转发给所属工作进程执行
+    negotio::UnixSocketServer unixServer;
+    if (!unixServer.init(unixSocketPath)) {
+        std::cerr << "Unix Socket 模块初始化失败" << std::endl;
+        supervisor.stop();
+        return 1;
+    }
+    std::thread unixThread([&unixServer, &supervisor, &sharedTable]() {
+        setThreadAffinity(0);
+        unixServer.setCommandHandler([&](const std::string &cmd) {
+            negotio::ControlCommand command{};
+            if (!negotio::decodeControlCommand(cmd, command)) {
+                return;
+            }
+            if (command.action == negotio::ControlAction::ADD && !sharedTable.storePolicy(command.policy)) {
+                std::cerr << "共享策略表已满，策略 " << command.policy.policy_id << " 不会在工作进程重启后恢复" << std::endl;
+            }
+            if (!supervisor.forward(command.policy.policy_id, cmd)) {
+                std::cerr << "控制命令转发到工作进程 " << supervisor.ownerOf(command.policy.policy_id) << " 失败"
+                          << std::endl;
+            }
+        });
+        unixServer.run();
+    });
+
+    while (running && supervisor.isAlive()) {
+        supervisor.superviseOnce();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    std::cout << "正在停止服务..." << std::endl;
+    unixServer.stop();
+    if (unixThread.joinable()) {
+        unixThread.join();
+    }
+    supervisor.stop();
+    std::cout << "服务已停止，工作进程重启次数: " << supervisor.getRestarts() << std::endl;
+    return 0;
+}
+
+int main() {
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
 
@@ -77,72 +275,303 @@ int main() {
         return 1;
     }
 
+    if (config.contains("prefork") && config["prefork"].value("enabled", false)) {
+        return runPrefork(config);
+    }
+
     uint16_t udpPort = config["network"]["udp_port"].get<uint16_t>();
-    std::string unixSocketPath = config["network"]["unix_socket_path"].get<std::string>();
-    uint32_t negotiationTimeoutMs = config["negotiation"]["timeout_ms"].get<uint32_t>();
-    const int epollTimeoutMs = 10;
 
-    negotio::UdpSocket udpSocket;
-    if (udpSocket.init(udpPort) != negotio::ErrorCode::SUCCESS) {
-        std::cerr << "UDP 模块初始化失败" << std::endl;
-        return 1;
+    // 接收分片：每个 RX 线程绑定一个核并持有一个 SO_REUSEPORT 套接字，套接字的 SO_INCOMING_CPU 设为同一个核，
+    // 再挂载按 CPU 选择分片的 cBPF 程序，使数据包由收到它的软中断所在核上的线程处理
+    const uint32_t rxThreads = std::max<uint32_t>(1, config["network"].value("rx_threads", 1u));
+    const uint32_t rxFirstCpu = config["network"].value("rx_first_cpu", 1u);
+    std::vector<std::unique_ptr<negotio::UdpSocket>> udpSockets;
+    for (uint32_t i = 0; i < rxThreads; ++i) {
+        negotio::UdpSocketOptions socketOptions;
+        socketOptions.reusePort = rxThreads > 1;
+        socketOptions.incomingCpu = static_cast<int>(rxFirstCpu + i);
+        auto socket = std::make_unique<negotio::UdpSocket>();
+        if (socket->init(udpPort, socketOptions) != negotio::ErrorCode::SUCCESS) {
+            std::cerr << "UDP 模块初始化失败" << std::endl;
+            return 1;
+        }
+        udpSockets.push_back(std::move(socket));
+    }
+    if (rxThreads > 1 && udpSockets[0]->attachCpuSteering(rxFirstCpu, rxThreads) != negotio::ErrorCode::SUCCESS) {
+        std::cerr << "挂载 reuseport CPU 分流程序失败，仅按 SO_INCOMING_CPU 选择分片" << std::endl;
     }
+    return runService(config, udpSockets, rxFirstCpu, nullptr);
+}
+
+// 协商服务主体：单进程模式由 main 直接调用，多进程模式由每个工作进程调用
+int runService(const json &config, std::vector<std::unique_ptr<negotio::UdpSocket>> &udpSockets,
+               const uint32_t rxFirstCpu, const WorkerContext *worker) {
+    // 内存锁定：默认（arena）只锁定密钥与协商热表所在的锁定内存区，JSON、线程栈与日志缓冲等保持可换出；
+    // all 沿用整个进程 mlockall，none 不锁定。需在创建 Negotiator 之前完成，热表才会分配在锁定内存区
+    const json memoryLock = config.contains("memory_lock") ? config["memory_lock"] : json::object();
+    if (const std::string lockMode = memoryLock.value("mode", std::string("arena")); lockMode == "all") {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
+            std::cerr << "mlockall 失败" << std::endl;
+        }
+    } else if (lockMode == "arena") {
+        const size_t arenaMb = memoryLock.value("arena_mb", negotio::DEFAULT_LOCKED_ARENA_BYTES >> 20);
+        negotio::LockedArena &arena = negotio::LockedArena::instance();
+        if (arena.init(arenaMb << 20)) {
+            std::cout << "锁定内存区: " << arenaMb << " MB" << (arena.isLocked() ? "" : "（mlock 失败，未锁定）")
+                      << std::endl;
+        }
+        if (worker && !worker->sharedTable->lockInMemory()) {
+            std::cerr << "共享会话表 mlock 失败" << std::endl;
+        }
+    }
+
+    const uint16_t udpPort = config["network"]["udp_port"].get<uint16_t>();
+    const std::string unixSocketPath = config["network"]["unix_socket_path"].get<std::string>();
+    const uint32_t negotiationTimeoutMs = config["negotiation"]["timeout_ms"].get<uint32_t>();
+    const int epollTimeoutMs = 10;
+    const uint32_t rxThreads = static_cast<uint32_t>(udpSockets.size());
+    // 多进程模式下各工作进程的抓包与统计文件加上进程序号后缀
+    const std::string fileSuffix = worker ? std::string(".") + std::to_string(worker->index) : std::string();
 
 #ifdef DEBUG
     std::cout << "UDP 模块初始化成功，端口: " << udpPort << std::endl;
 #endif
 
+    // 可选：将接收到的数据报录制到抓包文件，供 NegotioReplay 回放
+    std::unique_ptr<negotio::CaptureWriter> captureWriter;
+    if (config.contains("capture") && config["capture"].value("enabled", false)) {
+        captureWriter = std::make_unique<negotio::CaptureWriter>(
+            config["capture"].value("ring_capacity", negotio::DEFAULT_CAPTURE_RING_CAPACITY));
+        const std::string capturePath = config["capture"].value("path", std::string("negotio.ncap")) + fileSuffix;
+        if (captureWriter->open(capturePath)) {
+            for (const auto &socket : udpSockets) {
+                socket->setCaptureWriter(captureWriter.get());
+            }
+            std::cout << "已开启抓包，文件: " << capturePath << std::endl;
+        } else {
+            captureWriter.reset();
+        }
+    }
+
+    // 可选：同主机对端经 AF_UNIX 数据报协商，不经过 UDP/IP 协议栈
+    std::unique_ptr<negotio::LocalTransport> localTransport;
+    if (worker && config.contains("local_transport") && config["local_transport"].value("enabled", false)) {
+        std::cerr << "多进程模式不支持本地传输，全部经 UDP 协商" << std::endl;
+    } else if (config.contains("local_transport") && config["local_transport"].value("enabled", false)) {
+        const auto &localConfig = config["local_transport"];
+        sockaddr_in self{};
+        self.sin_family = AF_INET;
+        self.sin_port = htons(udpPort);
+        inet_pton(AF_INET, localConfig.value("self_ip", std::string("127.0.0.1")).c_str(), &self.sin_addr);
+        const std::string socketDir = localConfig.value("socket_dir", std::string("/run/negotio"));
+        localTransport = std::make_unique<negotio::LocalTransport>();
+        for (const auto &subnet : localConfig.value("local_subnets", std::vector<std::string>{"127.0.0.0/8"})) {
+            if (!localTransport->addLocalSubnet(subnet)) {
+                std::cerr << "本机网段格式错误: " << subnet << std::endl;
+            }
+        }
+        if (localTransport->init(socketDir, self) == negotio::ErrorCode::SUCCESS) {
+            std::cout << "已开启本地传输，目录: " << socketDir << std::endl;
+        } else {
+            std::cerr << "本地传输初始化失败，全部经 UDP 协商" << std::endl;
+            localTransport.reset();
+        }
+    }
+
+    // 多进程模式由监督进程监听控制套接字
     negotio::UnixSocketServer unixServer;
-    if (!unixServer.init(unixSocketPath)) {
+    if (!worker && !unixServer.init(unixSocketPath)) {
         std::cerr << "Unix Socket 模块初始化失败" << std::endl;
         return 1;
     }
 
 #ifdef DEBUG
-    std::cout << "Unix Socket 模块初始化成功，路径: " << unixSocketPath << std::endl;
+    if (!worker) {
+        std::cout << "Unix Socket 模块初始化成功，路径: " << unixSocketPath << std::endl;
+    }
 #endif
 
     negotio::PolicyManager policyManager;
     negotio::Negotiator negotiator;
     negotio::Monitor monitor;
     negotiator.setMonitor(&monitor);
+    negotiator.setImplicitConfirm(config["negotiation"].value("implicit_confirm", false));
+    negotiator.setKeyBatchSize(config["negotiation"].value("key_batch_size", 1u));
+    negotiator.setStaleThreshold(negotiationTimeoutMs);
+    if (config.contains("resumption")) {
+        negotiator.setResumption(config["resumption"].value("enabled", true),
+                                 config["resumption"].value("ticket_lifetime_s", negotio::DEFAULT_TICKET_LIFETIME_S));
+    }
+    // 自适应并发限制：按实测协商耗时相对协商超时调整同时进行的协商数，上限经 Monitor 报告
+    std::unique_ptr<negotio::ConcurrencyLimiter> concurrencyLimiter;
+    size_t maxDeferred = negotio::DEFAULT_MAX_DEFERRED;
+    if (!config.contains("admission") || config["admission"].value("enabled", true)) {
+        negotio::ConcurrencyLimitOptions limitOptions;
+        limitOptions.targetLatencyMs = negotiationTimeoutMs;
+        if (config.contains("admission")) {
+            const auto &admissionConfig = config["admission"];
+            limitOptions.initialLimit = admissionConfig.value("initial_limit", limitOptions.initialLimit);
+            limitOptions.minLimit = admissionConfig.value("min_limit", limitOptions.minLimit);
+            limitOptions.maxLimit = admissionConfig.value("max_limit", limitOptions.maxLimit);
+            limitOptions.windowSamples = admissionConfig.value("window_samples", limitOptions.windowSamples);
+            maxDeferred = admissionConfig.value("max_deferred", maxDeferred);
+        }
+        concurrencyLimiter = std::make_unique<negotio::ConcurrencyLimiter>(limitOptions);
+        monitor.setConcurrencyLimiter(concurrencyLimiter.get());
+    }
+    // 可选：将监控计数器发布到内存映射统计文件，供 NegotioStat 等外部程序零系统调用读取
+    if (config.contains("stats_file") && config["stats_file"].value("enabled", false)) {
+        const std::string statsPath = config["stats_file"].value("path", std::string("/dev/shm/negotio.stats"))
+                                      + fileSuffix;
+        if (monitor.enableStatsFile(statsPath, config["stats_file"].value("interval_ms", 100u))) {
+            std::cout << "已开启统计文件: " << statsPath << std::endl;
+        }
+    }
+
+    // 自适应批处理：每个分片的接收、处理、发送阶段按到达速率与积压选择批大小，空闲时逐包处理、立即发送
+    std::vector<std::unique_ptr<ShardBatching>> shardBatching;
+    uint32_t processingThreads = 2; ///< 每个分片常驻的处理线程数
+    if (!config.contains("batching") || config["batching"].value("enabled", true)) {
+        negotio::BatchOptions rxOptions;
+        negotio::BatchOptions cryptoOptions;
+        cryptoOptions.maxBatch = 32;
+        negotio::BatchOptions txOptions;
+        if (config.contains("batching")) {
+            processingThreads = std::max<uint32_t>(1, config["batching"].value("processing_threads", processingThreads));
+            const auto &batchingConfig = config["batching"];
+            rxOptions.maxBatch = batchingConfig.value("max_rx_batch", rxOptions.maxBatch);
+            cryptoOptions.maxBatch = batchingConfig.value("max_crypto_batch", cryptoOptions.maxBatch);
+            txOptions.maxBatch = batchingConfig.value("max_tx_batch", txOptions.maxBatch);
+            const uint32_t maxDelayUs = batchingConfig.value("max_delay_us", rxOptions.maxDelayUs);
+            rxOptions.maxDelayUs = cryptoOptions.maxDelayUs = txOptions.maxDelayUs = maxDelayUs;
+        }
+        for (size_t shard = 0; shard < udpSockets.size(); ++shard) {
+            auto &stages = *shardBatching.emplace_back(
+                std::make_unique<ShardBatching>(rxOptions, cryptoOptions, txOptions));
+            monitor.addBatcher("rx" + std::to_string(shard), &stages.rx);
+            monitor.addBatcher("crypto" + std::to_string(shard), &stages.crypto);
+            monitor.addBatcher("tx" + std::to_string(shard), &stages.tx);
+        }
+    }
     monitor.start();
 
-    // 设置 UDP 发送器，便于 Negotiator 内部发送 CONFIRM 包
-    negotiator.setUdpSender([&udpSocket](const negotio::NegotiationPacket &pkt, const sockaddr_in &addr) {
-        udpSocket.sendPacket(pkt, const_cast<sockaddr_in &>(addr));
+    // 设置 UDP 发送器，便于 Negotiator 内部发送 CONFIRM 包；本机网段的对端优先走本地传输，失败时回退 UDP
+    // 多个分片时从当前核对应分片的套接字发出，各分片的发送锁互不竞争；批处理线程中的发送进入发送批
+    negotiator.setUdpSender([&udpSockets, &localTransport, rxFirstCpu](const negotio::NegotiationPacket &pkt,
+                                                                       const sockaddr_in &addr) {
+        if (localTransport && localTransport->isLocal(addr)
+            && localTransport->sendPacket(pkt, addr) == negotio::ErrorCode::SUCCESS) {
+            return;
+        }
+        if (TxBatch *tx = currentTxBatch) {
+            const auto now = std::chrono::steady_clock::now();
+            if (tx->pending.empty()) {
+                tx->oldest = now;
+            }
+            tx->pending.emplace_back(pkt, addr);
+            if (tx->pending.size() >= tx->batcher->getBatchSize()) {
+                tx->flush(true);
+            } else if (now - tx->oldest >= std::chrono::microseconds(tx->batcher->getDeadlineUs())) {
+                tx->flush(false);
+            }
+            return;
+        }
+        const int cpu = sched_getcpu();
+        negotio::UdpSocket &socket = *udpSockets[cpu < 0 ? 0 : (static_cast<uint32_t>(cpu) - rxFirstCpu)
+                                                                  % udpSockets.size()];
+        socket.sendPacket(pkt, const_cast<sockaddr_in &>(addr));
     });
 
-    // 启动 Unix 域套接字服务线程
-    std::thread unixThread([&unixServer, &policyManager, &negotiator]() {
+    // 启动预热：在接收线程启动前完成，使第一次协商与稳态协商一样快
+    if (!config.contains("warmup") || config["warmup"].value("enabled", true)) {
+        negotio::WarmupOptions warmupOptions;
+        if (config.contains("warmup")) {
+            warmupOptions.expectedSessions = config["warmup"].value("expected_sessions", warmupOptions.expectedSessions);
+            warmupOptions.hashIterations = config["warmup"].value("hash_iterations", warmupOptions.hashIterations);
+            warmupOptions.negotiationRounds = config["warmup"].value("negotiation_rounds",
+                                                                     warmupOptions.negotiationRounds);
+        }
+        const negotio::WarmupReport report = negotio::warmUp(negotiator, warmupOptions);
+        std::cout << "预热完成，耗时: " << report.elapsedUs << " us，演练协商首次/末次: "
+                  << report.firstNegotiationNs / 1000 << "/" << report.lastNegotiationNs / 1000 << " us" << std::endl;
+    }
+    // 预热的演练协商不计入并发限制的样本
+    if (concurrencyLimiter) {
+        negotiator.setConcurrencyLimiter(concurrencyLimiter.get(), maxDeferred);
+    }
+
+    // 多进程模式：从共享表恢复本进程负责的会话与策略（重启后），此后的密钥写入同步到共享表
+    // 已有策略但没有密钥的（崩溃时协商尚未完成）重新发起协商，应答在套接字缓冲区中等待接收线程
+    if (worker) {
+        size_t restoredSessions = 0;
+        for (const negotio::ColdSession &session : worker->sharedTable->snapshotSessions()) {
+            if (session.policy_id % worker->workers == worker->index) {
+                negotiator.restoreSession(session);
+                ++restoredSessions;
+            }
+        }
+        size_t restoredPolicies = 0;
+        for (const negotio::PolicyConfig &policy : worker->sharedTable->snapshotPolicies()) {
+            if (policy.policy_id % worker->workers != worker->index) {
+                continue;
+            }
+            policyManager.addPolicy(policy);
+            ++restoredPolicies;
+            if (!negotiator.getEstablishedKey(policy.policy_id)) {
+                negotiator.startNegotiation(policy);
+            }
+        }
+        negotiator.setSharedTable(worker->sharedTable);
+        std::cout << "工作进程 " << worker->index << " (pid " << getpid() << ") 已启动，恢复会话: "
+                  << restoredSessions << "，恢复策略: " << restoredPolicies << std::endl;
+    }
+
+    // 控制命令执行分片：控制线程只解码，同一策略的命令在同一分片上按序执行
+    negotio::ControlDispatcherOptions controlOptions;
+    if (config.contains("control")) {
+        controlOptions.workerThreads = config["control"].value("worker_threads", controlOptions.workerThreads);
+        controlOptions.maxQueuedPerShard = config["control"].value("max_queued_per_shard",
+                                                                   controlOptions.maxQueuedPerShard);
+    }
+    negotio::ControlDispatcher controlDispatcher(
+        [&policyManager, &negotiator](const negotio::ControlCommand &command) {
+            negotio::executeControlCommand(command, policyManager, negotiator);
+        }, controlOptions);
+    controlDispatcher.start();
+
+    // 启动控制线程：单进程模式监听 Unix 域套接字，多进程模式接收监督进程转发的命令
+    std::thread unixThread([&unixServer, &controlDispatcher, worker]() {
         setThreadAffinity(0);
+        negotio::prefaultStack();
+        if (worker) {
+            std::string cmd;
+            while (running) {
+                const negotio::ErrorCode received = negotio::PreforkSupervisor::receiveCommand(
+                    worker->controlFd, cmd, 100);
+                if (received == negotio::ErrorCode::SOCKET_ERROR) {
+                    std::cerr << "监督进程已退出，工作进程 " << worker->index << " 停止" << std::endl;
+                    running = false;
+                    break;
+                }
+                if (received != negotio::ErrorCode::SUCCESS) {
+                    continue;
+                }
+                negotio::AllocScope allocScope(negotio::AllocTag::CONTROL);
+                negotio::ControlCommand command{};
+                if (negotio::decodeControlCommand(cmd, command)) {
+                    controlDispatcher.dispatch(std::move(command));
+                }
+            }
+            return;
+        }
         unixServer.setCommandHandler([&](const std::string &cmd) {
+            negotio::AllocScope allocScope(negotio::AllocTag::CONTROL);
 #ifdef DEBUG
             std::cout << "收到 Unix 命令: " << cmd << std::endl;
 #endif
-            try {
-                auto j = json::parse(cmd);
-                std::string action = j["action"].get<std::string>();
-                if (action == "add") {
-                    auto policy_config = j["policy"].get<negotio::PolicyConfig>();
-                    bool success = policyManager.addPolicy(policy_config);
-#ifdef DEBUG
-                    DEBUG_LOG("策略" << (success ? "添加成功" : "添加失败")
-                        << "，策略ID: " << policy_config.policy_id);
-#else
-                    (void) success; // 引用 success 以避免未使用警告
-#endif
-                    // 立即发起协商
-                    sockaddr_in addr{};
-                    addr.sin_family = AF_INET;
-                    addr.sin_port = htons(policy_config.remote_port);
-                    inet_pton(AF_INET, policy_config.remote_ip.c_str(), &addr.sin_addr);
-
-                    negotiator.startNegotiation(policy_config.policy_id, addr);
-                }
-                // 可添加其它命令处理
-            } catch (const std::exception &e) {
-                std::cerr << "命令解析错误: " << e.what() << std::endl;
+            negotio::ControlCommand command{};
+            if (negotio::decodeControlCommand(cmd, command)) {
+                controlDispatcher.dispatch(std::move(command));
             }
         });
 
@@ -151,65 +580,199 @@ int main() {
 
     constexpr int recvTimeoutMs = 0;
 
-    // 启动 UDP 数据包接收线程
-    std::thread udpThread([&udpSocket, &negotiator, recvTimeoutMs, epollTimeoutMs]() {
-        TRACE_BLOCK("udpThread total");
-        setThreadAffinity(1);
-        int epollFd = epoll_create1(0);
-        if (epollFd == -1) {
-            std::cerr << "UDP epoll_create1 失败" << std::endl;
-            return;
-        }
-        struct epoll_event ev{};
-        ev.events = EPOLLIN;
-        ev.data.fd = udpSocket.getSocketFd();
-        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, udpSocket.getSocketFd(), &ev) == -1) {
-            std::cerr << "UDP epoll_ctl 添加失败" << std::endl;
-            close(epollFd);
-            return;
-        }
-        while (running) {
-            constexpr int MAX_EVENTS = 10;
-            struct epoll_event events[MAX_EVENTS];
-            int nfds = epoll_wait(epollFd, events, MAX_EVENTS, epollTimeoutMs);
-            if (nfds < 0) {
-                if (errno == EINTR)
-                    continue;
-                std::cerr << "UDP epoll_wait 失败" << std::endl;
-                break;
+    // 启动 UDP 数据包接收线程，每个分片一个；本地传输由分片 0 接收
+    // 处理线程由 RX 线程创建，继承其 CPU 亲和性，仍在收包核上运行
+    std::vector<std::thread> udpThreads;
+    for (uint32_t shard = 0; shard < rxThreads; ++shard) {
+        ShardBatching *batching = shardBatching.empty() ? nullptr : shardBatching[shard].get();
+        udpThreads.emplace_back([&udpSockets, &localTransport, &negotiator, shard, rxFirstCpu, recvTimeoutMs,
+                                 epollTimeoutMs, batching, processingThreads]() {
+            TRACE_BLOCK("udpThread total");
+            setThreadAffinity(static_cast<int>(rxFirstCpu + shard));
+            negotio::prefaultStack();
+            negotio::UdpSocket::prefaultBuffers(batching ? batching->rx.getMaxBatch() : 1);
+            negotio::UdpSocket &udpSocket = *udpSockets[shard];
+            // 分片常驻的处理线程：依次取块处理。块不足处理批时在处理阶段的刷新期限内合并后续的块；
+            // 应答进入发送批，攒满或到达发送阶段的刷新期限时发出，空闲等待也以发送批的期限为限
+            std::vector<std::thread> processors;
+            for (uint32_t p = 0; batching && p < processingThreads; ++p) {
+                processors.emplace_back([&negotiator, &udpSocket, batching]() {
+                    using std::chrono::microseconds;
+                    std::vector<negotio::AddressedPacket> chunk;
+                    TxBatch tx{&udpSocket, &batching->tx, {}, {}};
+                    bool stopped = false;
+                    while (!stopped) {
+                        const auto now = std::chrono::steady_clock::now();
+                        const auto until = tx.pending.empty()
+                                               ? now + std::chrono::milliseconds(100)
+                                               : tx.oldest + microseconds(batching->tx.getDeadlineUs());
+                        if (!batching->take(chunk, until, stopped)) {
+                            tx.flush(false);
+                            continue;
+                        }
+                        uint32_t merged = 0;
+                        if (const uint32_t cryptoDeadlineUs = batching->crypto.getDeadlineUs(); cryptoDeadlineUs > 0) {
+                            merged = batching->topUp(chunk, batching->crypto.getBatchSize(),
+                                                     std::chrono::steady_clock::now() + microseconds(cryptoDeadlineUs));
+                        }
+                        {
+                            TRACE_BLOCK("recvPackets+handlePacket batch");
+                            currentTxBatch = &tx;
+                            for (const auto &[packet, srcAddr] : chunk) {
+                                negotiator.handlePacket(packet, srcAddr);
+                            }
+                            currentTxBatch = nullptr;
+                        }
+                        if (!tx.pending.empty() && std::chrono::steady_clock::now() - tx.oldest
+                                                   >= microseconds(batching->tx.getDeadlineUs())) {
+                            tx.flush(false);
+                        }
+                        batching->processing.fetch_sub(1 + merged, std::memory_order_relaxed);
+                    }
+                    tx.flush(false);
+                });
             }
-            for (int i = 0; i < nfds; ++i) {
-                sockaddr_in srcAddr{};
-                negotio::NegotiationPacket packet;
-                if (udpSocket.recvPacket(packet, srcAddr, recvTimeoutMs) ==
-                    negotio::ErrorCode::SUCCESS) {
-#ifdef DEBUG
-                    std::cout << "收到 UDP 数据包，策略ID: " << packet.header.sequence << std::endl;
-#endif
-                    // ✅ 加 TRACE_BLOCK 观察 handlePacket 是否耗时
-                    std::thread([packet, srcAddr, &negotiator]() {
-                        TRACE_BLOCK("recvPacket+handlePacket");
-                        negotiator.handlePacket(packet, srcAddr);
-                    }).detach();
+            negotio::LocalTransport *local = shard == 0 ? localTransport.get() : nullptr;
+            int epollFd = epoll_create1(0);
+            if (epollFd == -1) {
+                std::cerr << "UDP epoll_create1 失败" << std::endl;
+                return;
+            }
+            struct epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.fd = udpSocket.getSocketFd();
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, udpSocket.getSocketFd(), &ev) == -1) {
+                std::cerr << "UDP epoll_ctl 添加失败" << std::endl;
+                close(epollFd);
+                return;
+            }
+            if (local) {
+                ev.data.fd = local->getSocketFd();
+                if (epoll_ctl(epollFd, EPOLL_CTL_ADD, local->getSocketFd(), &ev) == -1) {
+                    std::cerr << "本地传输 epoll_ctl 添加失败" << std::endl;
                 }
             }
-        }
-        close(epollFd);
-    });
+            std::vector<negotio::AddressedPacket> rxBatch;
+            while (running) {
+                constexpr int MAX_EVENTS = 10;
+                struct epoll_event events[MAX_EVENTS];
+                int nfds = epoll_wait(epollFd, events, MAX_EVENTS, epollTimeoutMs);
+                if (nfds < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    std::cerr << "UDP epoll_wait 失败" << std::endl;
+                    break;
+                }
+                for (int i = 0; i < nfds; ++i) {
+                    if (batching && events[i].data.fd == udpSocket.getSocketFd()) {
+                        // 一次 recvmmsg 取走至多一批数据报。读满时再非阻塞地读一批：读到的数据报即本批之后的实际积压，
+                        // 一并处理。批大小为 1 时恰好读满一个并不说明有积压，不能据此翻倍
+                        const uint32_t rxSize = batching->rx.getBatchSize();
+                        rxBatch.clear();
+                        size_t datagrams = udpSocket.recvPackets(rxBatch, rxSize);
+                        // 未读满一批时在接收阶段的刷新期限内继续等待后续数据报
+                        if (const uint32_t rxDeadlineUs = batching->rx.getDeadlineUs();
+                            datagrams < rxSize && rxDeadlineUs > 0) {
+                            const auto until = std::chrono::steady_clock::now()
+                                               + std::chrono::microseconds(rxDeadlineUs);
+                            pollfd pfd{udpSocket.getSocketFd(), POLLIN, 0};
+                            while (datagrams < rxSize) {
+                                const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    until - std::chrono::steady_clock::now()).count();
+                                const timespec wait{0, static_cast<long>(remaining)};
+                                if (remaining <= 0 || ppoll(&pfd, 1, &wait, nullptr) <= 0) {
+                                    break;
+                                }
+                                datagrams += udpSocket.recvPackets(rxBatch, rxSize - datagrams);
+                            }
+                        }
+                        const size_t backlog = datagrams == rxSize ? udpSocket.recvPackets(rxBatch, rxSize) : 0;
+                        batching->rx.observe(static_cast<uint32_t>(datagrams + backlog), static_cast<uint32_t>(backlog));
+                        // 按处理阶段的批大小切分，交给分片的处理线程
+                        const size_t chunkSize = batching->crypto.getBatchSize();
+                        for (size_t begin = 0; begin < rxBatch.size(); begin += chunkSize) {
+                            const size_t end = std::min(rxBatch.size(), begin + chunkSize);
+                            std::vector<negotio::AddressedPacket> chunk(
+                                std::make_move_iterator(rxBatch.begin() + static_cast<std::ptrdiff_t>(begin)),
+                                std::make_move_iterator(rxBatch.begin() + static_cast<std::ptrdiff_t>(end)));
+                            const uint32_t queued = batching->processing.fetch_add(1, std::memory_order_relaxed);
+                            batching->crypto.observe(static_cast<uint32_t>(chunk.size()), queued);
+                            batching->submit(std::move(chunk));
+                        }
+                        continue;
+                    }
+                    sockaddr_in srcAddr{};
+                    negotio::NegotiationPacket packet;
+                    const negotio::ErrorCode received = local && events[i].data.fd == local->getSocketFd()
+                                                            ? local->recvPacket(packet, srcAddr, recvTimeoutMs)
+                                                            : udpSocket.recvPacket(packet, srcAddr, recvTimeoutMs);
+                    if (received == negotio::ErrorCode::SUCCESS) {
+    #ifdef DEBUG
+                        std::cout << "收到 UDP 数据包，策略ID: " << packet.header.sequence << std::endl;
+    #endif
+                        // ✅ 加 TRACE_BLOCK 观察 handlePacket 是否耗时
+                        std::thread([packet, srcAddr, &negotiator]() {
+                            TRACE_BLOCK("recvPacket+handlePacket");
+                            negotiator.handlePacket(packet, srcAddr);
+                        }).detach();
+                    }
+                }
+            }
+            close(epollFd);
+            if (batching) {
+                batching->shutdown();
+            }
+            for (auto &processor : processors) {
+                processor.join();
+            }
+        });
+    }
 
+    // 可选：加载启动策略集并按优先级分批协商
+    std::unique_ptr<negotio::Bootstrapper> bootstrapper;
+    if (worker && config.contains("bootstrap") && config["bootstrap"].value("enabled", false)) {
+        std::cerr << "多进程模式不支持启动策略引导，请通过控制套接字下发策略" << std::endl;
+    } else if (config.contains("bootstrap") && config["bootstrap"].value("enabled", false)) {
+        const auto &bootConfig = config["bootstrap"];
+        negotio::BootstrapOptions bootOptions;
+        bootOptions.policyFile = bootConfig.value("policy_file", std::string("configs/startup_policies.jsonl"));
+        bootOptions.loaderThreads = bootConfig.value("loader_threads", bootOptions.loaderThreads);
+        bootOptions.initialWaveSize = bootConfig.value("initial_wave_size", bootOptions.initialWaveSize);
+        bootOptions.maxWaveSize = bootConfig.value("max_wave_size", bootOptions.maxWaveSize);
+        bootOptions.waveIntervalMs = bootConfig.value("wave_interval_ms", bootOptions.waveIntervalMs);
+        bootstrapper = std::make_unique<negotio::Bootstrapper>(policyManager, negotiator, &monitor, bootOptions);
+        bootstrapper->start();
+    }
+
+    // 主循环：删除超时未完成的协商（归还并发名额），并在有名额时发起延后的协商
     while (running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::this_thread::sleep_for(std::chrono::milliseconds(epollTimeoutMs));
+        negotiator.expireSessions(negotiationTimeoutMs);
     }
 
     std::cout << "正在停止服务..." << std::endl;
+    if (bootstrapper) {
+        bootstrapper->stop();
+    }
     unixServer.stop();
     monitor.stop();
-    if (udpThread.joinable()) {
-        udpThread.join();
+    for (auto &udpThread : udpThreads) {
+        if (udpThread.joinable()) {
+            udpThread.join();
+        }
     }
     if (unixThread.joinable()) {
         unixThread.join();
     }
+    controlDispatcher.stop();
+    if (captureWriter) {
+        for (const auto &socket : udpSockets) {
+            socket->setCaptureWriter(nullptr);
+        }
+        captureWriter->close();
+        std::cout << "抓包记录: " << captureWriter->getRecorded()
+                  << ", 丢弃: " << captureWriter->getDropped() << std::endl;
+    }
     std::cout << "服务已停止." << std::endl;
     return 0;
 }
@@ -0,0 +1,164 @@
+/**
+ * 抓包回放工具
+ *
+ * 将 Negotio 录制的抓包文件重新送入协商流程，用于基于真实流量模式的基准测试与问题定位：
+ * - memory 传输：直接在进程内构造 Negotiator，逐条调用 handlePacket（保留原始源地址），发送被计数后丢弃
+ * - udp 传输：通过真实 UDP 套接字将原始数据报发往目标 Negotio 实例（源地址为本工具的地址）
+ *
+ * 用法：NegotioReplay <capture file> [--transport memory|udp] [--target 127.0.0.1:5000]
+ *                     [--speed 1.0] [--loop 1] [--verbose]
+ *   --speed 回放倍速，1 为原始速度，0 表示不限速（尽可能快）
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+
+#include "capture/capture.h"
+#include "negotiate/negotiate.h"
+#include "udp/udp.h"
+#include "common.h"
+
+using namespace std::chrono;
+
+namespace {
+    struct ReplayOptions {
+        std::string capturePath;
+        std::string transport = "memory";
+        std::string targetIp = "127.0.0.1";
+        uint16_t targetPort = 5000;
+        double speed = 1.0;
+        uint32_t loops = 1;
+        bool verbose = false;
+    };
+
+    void printUsage(const char *prog) {
+        std::cerr << "用法: " << prog << " <capture file> [--transport memory|udp] [--target 127.0.0.1:5000]"
+                  << " [--speed 1.0] [--loop 1] [--verbose]" << std::endl;
+    }
+
+    bool parseArgs(int argc, char *argv[], ReplayOptions &opts) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--transport" && i + 1 < argc) {
+                opts.transport = argv[++i];
+            } else if (arg == "--target" && i + 1 < argc) {
+                const std::string target = argv[++i];
+                const auto colon = target.rfind(':');
+                if (colon == std::string::npos) {
+                    return false;
+                }
+                opts.targetIp = target.substr(0, colon);
+                opts.targetPort = static_cast<uint16_t>(std::stoul(target.substr(colon + 1)));
+            } else if (arg == "--speed" && i + 1 < argc) {
+                opts.speed = std::stod(argv[++i]);
+            } else if (arg == "--loop" && i + 1 < argc) {
+                opts.loops = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--verbose") {
+                opts.verbose = true;
+            } else if (opts.capturePath.empty() && arg.rfind("--", 0) != 0) {
+                opts.capturePath = arg;
+            } else {
+                return false;
+            }
+        }
+        return !opts.capturePath.empty() && (opts.transport == "memory" || opts.transport == "udp");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    ReplayOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    negotio::CaptureReader reader;
+    if (!reader.open(opts.capturePath)) {
+        std::cerr << "无法打开抓包文件或格式不正确: " << opts.capturePath << std::endl;
+        return 1;
+    }
+
+    // 回放时默认屏蔽协商路径上的 TRACE 日志
+    std::streambuf *savedCout = nullptr;
+    if (!opts.verbose) {
+        savedCout = std::cout.rdbuf(nullptr);
+    }
+
+    negotio::Negotiator negotiator;
+    std::atomic<uint64_t> responses{0};
+    negotiator.setUdpSender([&responses](const negotio::NegotiationPacket &, const sockaddr_in &) {
+        responses.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    negotio::UdpSocket udpSocket;
+    sockaddr_in target{};
+    if (opts.transport == "udp") {
+        if (udpSocket.init(0) != negotio::ErrorCode::SUCCESS) {
+            std::cerr << "UDP 套接字初始化失败" << std::endl;
+            return 1;
+        }
+        target.sin_family = AF_INET;
+        target.sin_port = htons(opts.targetPort);
+        if (inet_pton(AF_INET, opts.targetIp.c_str(), &target.sin_addr) != 1) {
+            std::cerr << "无效的目标地址: " << opts.targetIp << std::endl;
+            return 1;
+        }
+    }
+
+    uint64_t replayed = 0;
+    uint64_t malformed = 0;
+    std::map<negotio::ErrorCode, uint64_t> results;
+    const auto replayStart = steady_clock::now();
+    for (uint32_t loop = 0; loop < opts.loops; ++loop) {
+        reader.rewind();
+        negotio::CaptureRecord record;
+        uint64_t firstTimestampNs = 0;
+        const auto loopStart = steady_clock::now();
+        while (reader.next(record)) {
+            if (firstTimestampNs == 0) {
+                firstTimestampNs = record.timestampNs;
+            }
+            if (opts.speed > 0) {
+                // 按原始时间间隔（除以倍速）节流
+                const auto offset = nanoseconds(static_cast<int64_t>(
+                    static_cast<double>(record.timestampNs - firstTimestampNs) / opts.speed));
+                std::this_thread::sleep_until(loopStart + offset);
+            }
+            ++replayed;
+            if (opts.transport == "udp") {
+                results[udpSocket.sendBuffer(record.data.data(), record.data.size(), target)]++;
+                continue;
+            }
+            negotio::NegotiationPacket packet;
+            if (negotio::UdpSocket::deserializePacket(record.data, packet) < 0) {
+                ++malformed;
+                continue;
+            }
+            results[negotiator.handlePacket(packet, record.src)]++;
+        }
+    }
+    const double seconds = duration_cast<duration<double>>(steady_clock::now() - replayStart).count();
+
+    if (savedCout) {
+        std::cout.rdbuf(savedCout);
+        std::cout.clear();
+    }
+    std::cout << "回放数据报: " << replayed << ", 耗时: " << seconds << " s, 速率: "
+              << (seconds > 0 ? static_cast<double>(replayed) / seconds : 0) << " pps" << std::endl;
+    if (opts.transport == "memory") {
+        std::cout << "无法解析: " << malformed << ", 触发发送: " << responses.load() << std::endl;
+    }
+    for (const auto &[code, count] : results) {
+        std::cout << "  结果码 " << static_cast<int>(code) << ": " << count << std::endl;
+    }
+    return 0;
+}
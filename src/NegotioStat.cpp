@@ -0,0 +1,143 @@
+/**
+ * NegotioStat.cpp
+ *
+ * 统计文件读取工具：以只读方式映射 Negotio 发布的统计文件，打印协商计数、耗时直方图、
+ * 锁竞争与分配统计。读取过程不与 Negotio 进程交互，不增加其任何系统调用。
+ *
+ * 用法：NegotioStat [path] [--interval ms] [--count N]
+ *   path        统计文件路径，默认 /dev/shm/negotio.stats
+ *   --interval  周期打印间隔（毫秒），0 表示只打印一次（默认）
+ *   --count     周期打印次数，0 表示不限（默认）
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#include "statsfile/statsfile.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace negotio;
+
+namespace {
+    // 直方图桶的显示区间，与 latencyBucketOf 对应
+    std::string latencyBucketLabel(const size_t bucket) {
+        if (bucket == 0) {
+            return "0 ms";
+        }
+        const uint64_t low = 1ull << (bucket - 1);
+        if (bucket == STATS_LATENCY_BUCKETS - 1) {
+            return ">= " + std::to_string(low) + " ms";
+        }
+        return std::to_string(low) + "-" + std::to_string((1ull << bucket) - 1) + " ms";
+    }
+
+    void printSnapshot(const StatsPayload &stats, const StatsPayload *previous, const double intervalSec) {
+        const double avgLatency = stats.successfulNegotiations > 0
+                                      ? static_cast<double>(stats.totalLatencyMs) / stats.successfulNegotiations
+                                      : 0.0;
+        std::cout << "协商总数: " << stats.totalNegotiations
+                  << ", 成功: " << stats.successfulNegotiations
+                  << ", 平均延迟: " << std::fixed << std::setprecision(2) << avgLatency << " ms";
+        if (previous && intervalSec > 0) {
+            std::cout << ", 速率: " << std::setprecision(0)
+                      << (stats.totalNegotiations - previous->totalNegotiations) / intervalSec << " 次/秒";
+        }
+        std::cout << std::endl;
+        if (stats.bootstrapTotal > 0) {
+            std::cout << "启动策略引导: 已完成 " << stats.bootstrapCompleted << "/" << stats.bootstrapTotal
+                      << ", 已发起 " << stats.bootstrapStarted << std::endl;
+        }
+        if (stats.concurrencyLimit > 0) {
+            std::cout << "并发限制: 上限 " << stats.concurrencyLimit << ", 在途 " << stats.concurrencyInFlight
+                      << ", 拒绝 " << stats.admissionRejected << ", 窗口 p90 ";
+            if (stats.concurrencyWindowMs == UINT32_MAX) {
+                std::cout << "超时";
+            } else {
+                std::cout << stats.concurrencyWindowMs << " ms";
+            }
+            std::cout << " (目标 " << stats.concurrencyTargetMs << " ms)" << std::endl;
+        }
+
+        for (size_t i = 0; i < STATS_LATENCY_BUCKETS; ++i) {
+            if (stats.latencyHistogram[i] > 0) {
+                std::cout << "  " << std::left << std::setw(18) << latencyBucketLabel(i) << std::right
+                          << stats.latencyHistogram[i] << std::endl;
+            }
+        }
+        uint64_t delaySamples = 0;
+        for (const uint64_t count : stats.oneWayDelayHistogram) {
+            delaySamples += count;
+        }
+        if (delaySamples > 0) {
+            std::cout << "单向排队时延（过期丢弃: " << stats.stalePackets << "）:" << std::endl;
+            for (size_t i = 0; i < STATS_LATENCY_BUCKETS; ++i) {
+                if (stats.oneWayDelayHistogram[i] > 0) {
+                    std::cout << "  " << std::left << std::setw(18) << latencyBucketLabel(i) << std::right
+                              << stats.oneWayDelayHistogram[i] << std::endl;
+                }
+            }
+        }
+        for (uint32_t i = 0; i < stats.lockSiteCount && i < STATS_MAX_LOCK_SITES; ++i) {
+            const StatsLockSite &site = stats.lockSites[i];
+            std::cout << "锁 " << site.name << ": 获取 " << site.acquisitions
+                      << ", 竞争 " << site.contended
+                      << ", 累计等待 " << site.waitNs / 1000 << " us"
+                      << ", 最长等待 " << site.maxWaitNs / 1000 << " us" << std::endl;
+        }
+        for (uint32_t tag = 0; tag < stats.allocTagCount && tag < ALLOC_TAG_COUNT; ++tag) {
+            std::cout << "分配 " << allocTagName(static_cast<AllocTag>(tag)) << ": "
+                      << stats.allocByTag[tag].allocations << " 次, "
+                      << stats.allocByTag[tag].bytes << " B" << std::endl;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string path = "/dev/shm/negotio.stats";
+    uint32_t intervalMs = 0;
+    uint32_t count = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--interval" && i + 1 < argc) {
+            intervalMs = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--count" && i + 1 < argc) {
+            count = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (!arg.empty() && arg[0] != '-') {
+            path = arg;
+        } else {
+            std::cerr << "用法: " << argv[0] << " [path] [--interval ms] [--count N]" << std::endl;
+            return 2;
+        }
+    }
+
+    StatsFileReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "无法打开统计文件 " << path << "（文件不存在或版本不匹配）" << std::endl;
+        return 1;
+    }
+    std::cout << "统计文件: " << path << ", 写入进程 PID: " << reader.writerPid() << std::endl;
+
+    StatsPayload current{};
+    StatsPayload previous{};
+    bool havePrevious = false;
+    for (uint32_t n = 0; count == 0 || n < count; ++n) {
+        if (!reader.read(current)) {
+            std::cerr << "读取一致快照失败（写入方持续更新）" << std::endl;
+            return 1;
+        }
+        printSnapshot(current, havePrevious ? &previous : nullptr, intervalMs / 1000.0);
+        if (intervalMs == 0) {
+            break;
+        }
+        previous = current;
+        havePrevious = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+    return 0;
+}
@@ -0,0 +1,229 @@
+/**
+ * @file allocstat.cpp
+ * @brief 堆分配统计实现
+ *
+ * 开启 NEGOTIO_ALLOC_STATS 时在此替换全局 operator new/delete。计数存放在固定大小的线程槽中，
+ * 线程首次分配时领取槽位，统计本身不会再触发堆分配。每块内存前有一段前缀，末字节记录分配时的子系统标签，
+ * 释放计入分配它的子系统（释放线程的槽位），各子系统的分配与释放数因此可以直接对比。
+ */
+
+#include "allocstat.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <unistd.h>
+
+namespace negotio {
+    namespace {
+        struct AtomicCounters {
+            std::atomic<uint64_t> allocations{0};
+            std::atomic<uint64_t> bytes{0};
+            std::atomic<uint64_t> frees{0};
+        };
+
+        struct alignas(64) ThreadSlot {
+            std::atomic<int> tid{0};
+            std::array<AtomicCounters, ALLOC_TAG_COUNT> byTag{};
+        };
+
+        std::array<ThreadSlot, MAX_ALLOC_THREADS + 1> threadSlots; // 最后一个为溢出槽
+        std::atomic<size_t> claimedSlots{0};
+
+        thread_local ThreadSlot *currentSlot = nullptr;
+
+        ThreadSlot *slotForCurrentThread() {
+            if (currentSlot == nullptr) {
+                const size_t idx = claimedSlots.fetch_add(1, std::memory_order_relaxed);
+                if (idx < MAX_ALLOC_THREADS) {
+                    currentSlot = &threadSlots[idx];
+                    currentSlot->tid.store(static_cast<int>(gettid()), std::memory_order_relaxed);
+                } else {
+                    currentSlot = &threadSlots[MAX_ALLOC_THREADS];
+                    currentSlot->tid.store(-1, std::memory_order_relaxed);
+                }
+            }
+            return currentSlot;
+        }
+
+        AllocCounters load(const AtomicCounters &counters) {
+            return {
+                counters.allocations.load(std::memory_order_relaxed),
+                counters.bytes.load(std::memory_order_relaxed),
+                counters.frees.load(std::memory_order_relaxed)
+            };
+        }
+
+        size_t usedSlots() {
+            const size_t claimed = claimedSlots.load(std::memory_order_relaxed);
+            return claimed < MAX_ALLOC_THREADS ? claimed : MAX_ALLOC_THREADS + 1;
+        }
+    }
+
+#if NEGOTIO_ALLOC_STATS
+    namespace {
+        thread_local AllocTag currentTag = AllocTag::OTHER;
+
+        // 普通分配的前缀长度，保持 operator new 的默认对齐
+        constexpr size_t TAG_PREFIX = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+        // 在前缀末字节记录标签并计数，返回交给调用方的地址
+        void *recordAllocation(void *base, const size_t prefix, const size_t size) {
+            auto *user = static_cast<uint8_t *>(base) + prefix;
+            user[-1] = static_cast<uint8_t>(currentTag);
+            AtomicCounters &counters = slotForCurrentThread()->byTag[static_cast<size_t>(currentTag)];
+            counters.allocations.fetch_add(1, std::memory_order_relaxed);
+            counters.bytes.fetch_add(size, std::memory_order_relaxed);
+            return user;
+        }
+
+        // 按前缀中记录的标签计入释放，返回分配时的起始地址
+        void *recordFree(void *ptr, const size_t prefix) {
+            auto *user = static_cast<uint8_t *>(ptr);
+            const size_t tag = user[-1] < ALLOC_TAG_COUNT ? user[-1] : static_cast<size_t>(AllocTag::OTHER);
+            slotForCurrentThread()->byTag[tag].frees.fetch_add(1, std::memory_order_relaxed);
+            return user - prefix;
+        }
+
+        void *trackedAlloc(const size_t size) {
+            void *base = std::malloc(TAG_PREFIX + (size == 0 ? 1 : size));
+            return base ? recordAllocation(base, TAG_PREFIX, size) : nullptr;
+        }
+
+        void *trackedAlignedAlloc(const size_t size, const std::align_val_t align) {
+            const auto alignment = static_cast<size_t>(align);
+            // 前缀占一个对齐单位；aligned_alloc 要求 size 为 alignment 的整数倍
+            const size_t rounded = alignment + ((size == 0 ? 1 : size) + alignment - 1) / alignment * alignment;
+            void *base = std::aligned_alloc(alignment, rounded);
+            return base ? recordAllocation(base, alignment, size) : nullptr;
+        }
+
+        void trackedFree(void *ptr) {
+            if (ptr) {
+                std::free(recordFree(ptr, TAG_PREFIX));
+            }
+        }
+
+        void trackedAlignedFree(void *ptr, const std::align_val_t align) {
+            if (ptr) {
+                std::free(recordFree(ptr, static_cast<size_t>(align)));
+            }
+        }
+    }
+
+    AllocScope::AllocScope(const AllocTag tag) : previous(currentTag) {
+        currentTag = tag;
+    }
+
+    AllocScope::~AllocScope() {
+        currentTag = previous;
+    }
+#endif
+
+    std::array<AllocCounters, ALLOC_TAG_COUNT> getAllocStatsByTag() {
+        std::array<AllocCounters, ALLOC_TAG_COUNT> totals{};
+        for (size_t i = 0; i < usedSlots(); ++i) {
+            for (size_t tag = 0; tag < ALLOC_TAG_COUNT; ++tag) {
+                const AllocCounters c = load(threadSlots[i].byTag[tag]);
+                totals[tag].allocations += c.allocations;
+                totals[tag].bytes += c.bytes;
+                totals[tag].frees += c.frees;
+            }
+        }
+        return totals;
+    }
+
+    std::vector<ThreadAllocStats> getAllocStatsByThread() {
+        std::vector<ThreadAllocStats> result;
+        for (size_t i = 0; i < usedSlots(); ++i) {
+            ThreadAllocStats stats{};
+            stats.tid = threadSlots[i].tid.load(std::memory_order_relaxed);
+            for (size_t tag = 0; tag < ALLOC_TAG_COUNT; ++tag) {
+                stats.byTag[tag] = load(threadSlots[i].byTag[tag]);
+            }
+            result.push_back(stats);
+        }
+        return result;
+    }
+
+    AllocCounters currentThreadAllocCounters() {
+        AllocCounters total{0, 0, 0};
+        if (!allocStatsEnabled()) {
+            return total;
+        }
+        for (const auto &counters : slotForCurrentThread()->byTag) {
+            const AllocCounters c = load(counters);
+            total.allocations += c.allocations;
+            total.bytes += c.bytes;
+            total.frees += c.frees;
+        }
+        return total;
+    }
+
+    const char *allocTagName(const AllocTag tag) {
+        switch (tag) {
+            case AllocTag::OTHER: return "other";
+            case AllocTag::UDP: return "udp";
+            case AllocTag::NEGOTIATE: return "negotiate";
+            case AllocTag::POLICY: return "policy";
+            case AllocTag::CONTROL: return "control";
+            case AllocTag::MONITOR: return "monitor";
+            default: return "unknown";
+        }
+    }
+} // namespace negotio
+
+#if NEGOTIO_ALLOC_STATS
+// 全局 operator new/delete 替换
+
+void *operator new(const size_t size) {
+    if (void *ptr = negotio::trackedAlloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](const size_t size) {
+    if (void *ptr = negotio::trackedAlloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(const size_t size, const std::nothrow_t &) noexcept {
+    return negotio::trackedAlloc(size);
+}
+
+void *operator new[](const size_t size, const std::nothrow_t &) noexcept {
+    return negotio::trackedAlloc(size);
+}
+
+void *operator new(const size_t size, const std::align_val_t align) {
+    if (void *ptr = negotio::trackedAlignedAlloc(size, align)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](const size_t size, const std::align_val_t align) {
+    if (void *ptr = negotio::trackedAlignedAlloc(size, align)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { negotio::trackedFree(ptr); }
+void operator delete[](void *ptr) noexcept { negotio::trackedFree(ptr); }
+void operator delete(void *ptr, size_t) noexcept { negotio::trackedFree(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { negotio::trackedFree(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { negotio::trackedFree(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { negotio::trackedFree(ptr); }
+void operator delete(void *ptr, const std::align_val_t align) noexcept { negotio::trackedAlignedFree(ptr, align); }
+void operator delete[](void *ptr, const std::align_val_t align) noexcept { negotio::trackedAlignedFree(ptr, align); }
+void operator delete(void *ptr, size_t, const std::align_val_t align) noexcept {
+    negotio::trackedAlignedFree(ptr, align);
+}
+void operator delete[](void *ptr, size_t, const std::align_val_t align) noexcept {
+    negotio::trackedAlignedFree(ptr, align);
+}
+#endif
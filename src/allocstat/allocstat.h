@@ -0,0 +1,109 @@
+/**
+ * 堆分配统计
+ *
+ * 可选的构建模式（CMake 选项 NEGOTIO_ALLOC_STATS，默认关闭）：开启后替换全局 operator new/delete，
+ * 按线程、按子系统标签统计分配次数与字节数。子系统标签通过 AllocScope 在调用路径上设置，
+ * 例如 udp 收发、协商处理、策略管理、控制命令与监控线程。
+ *
+ * 关闭时 AllocScope 为空对象、不替换 operator new，不产生任何运行期开销。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_ALLOCSTAT_H
+#define NEGOTIO_ALLOCSTAT_H
+
+// 分配统计开关: 0:关闭,1:开启（由 CMake 选项 NEGOTIO_ALLOC_STATS 控制）
+#ifndef NEGOTIO_ALLOC_STATS
+#define NEGOTIO_ALLOC_STATS 0
+#endif
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace negotio {
+    // 子系统标签
+    enum class AllocTag : uint8_t {
+        OTHER = 0,
+        UDP,
+        NEGOTIATE,
+        POLICY,
+        CONTROL,
+        MONITOR,
+        COUNT
+    };
+
+    constexpr size_t ALLOC_TAG_COUNT = static_cast<size_t>(AllocTag::COUNT);
+    constexpr size_t MAX_ALLOC_THREADS = 256; ///< 单独统计的线程数上限，超出部分合并到溢出槽
+
+    // 一组分配计数
+    struct AllocCounters {
+        uint64_t allocations; ///< 分配次数
+        uint64_t bytes;       ///< 分配字节数
+        uint64_t frees;       ///< 释放次数
+    };
+
+    // 单个线程的分配统计
+    struct ThreadAllocStats {
+        int tid;                                           ///< 线程 ID，溢出槽为 -1
+        std::array<AllocCounters, ALLOC_TAG_COUNT> byTag;  ///< 按标签统计
+    };
+
+    /**
+     * @brief 在作用域内将当前线程的分配归属到指定子系统
+     */
+    class AllocScope {
+    public:
+#if NEGOTIO_ALLOC_STATS
+        explicit AllocScope(AllocTag tag);
+
+        ~AllocScope();
+#else
+        explicit AllocScope(AllocTag) {
+        }
+#endif
+
+        AllocScope(const AllocScope &) = delete;
+        AllocScope &operator=(const AllocScope &) = delete;
+
+#if NEGOTIO_ALLOC_STATS
+
+    private:
+        AllocTag previous;
+#endif
+    };
+
+    /**
+     * @brief 获取所有子系统的分配汇总
+     */
+    std::array<AllocCounters, ALLOC_TAG_COUNT> getAllocStatsByTag();
+
+    /**
+     * @brief 获取每个线程的分配统计
+     */
+    std::vector<ThreadAllocStats> getAllocStatsByThread();
+
+    /**
+     * @brief 获取当前线程的分配汇总（所有标签之和），用于测量一段代码的分配次数
+     */
+    AllocCounters currentThreadAllocCounters();
+
+    /**
+     * @brief 获取子系统标签名称
+     */
+    const char *allocTagName(AllocTag tag);
+
+    /**
+     * @brief 分配统计是否在编译期开启
+     */
+    constexpr bool allocStatsEnabled() {
+        return NEGOTIO_ALLOC_STATS != 0;
+    }
+} // namespace negotio
+
+#endif // NEGOTIO_ALLOCSTAT_H
@@ -0,0 +1,50 @@
+/**
+ * @file batching.cpp
+ * @brief 自适应批大小实现
+ */
+
+#include "batching.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace negotio {
+    AdaptiveBatcher::AdaptiveBatcher(const BatchOptions &options)
+        : options(options), batchSize(std::max<uint32_t>(options.minBatch, 1)) {
+        this->options.minBatch = std::max<uint32_t>(options.minBatch, 1);
+        this->options.maxBatch = std::max(options.maxBatch, this->options.minBatch);
+    }
+
+    void AdaptiveBatcher::observe(const uint32_t items, const uint32_t backlog,
+                                  const std::chrono::steady_clock::time_point now) {
+        std::lock_guard lock(observeMutex);
+        const bool first = lastObserve == std::chrono::steady_clock::time_point{};
+        const double elapsedSec = std::chrono::duration<double>(now - lastObserve).count();
+        lastObserve = now;
+
+        double rate = arrivalRate.load(std::memory_order_relaxed);
+        if (!first && elapsedSec > 0) {
+            const double sample = items / elapsedSec;
+            rate = rate == 0.0 ? sample : rate + RATE_SMOOTHING * (sample - rate);
+            arrivalRate.store(rate, std::memory_order_relaxed);
+        }
+
+        // 一个期限内预计到达的条目数；仍有积压说明当前批偏小
+        const uint32_t current = batchSize.load(std::memory_order_relaxed);
+        double target = rate * options.maxDelayUs / 1e6;
+        if (backlog > 0) {
+            target = std::max(target, current * 2.0);
+        }
+        target = std::clamp(target, current / 2.0, current * 2.0);
+        const auto next = static_cast<uint32_t>(std::clamp(std::lround(target),
+                                                           static_cast<long>(options.minBatch),
+                                                           static_cast<long>(options.maxBatch)));
+        batchSize.store(next, std::memory_order_relaxed);
+
+        uint32_t deadline = 0;
+        if (next > 1 && rate > 0) {
+            deadline = static_cast<uint32_t>(std::min<double>(options.maxDelayUs, next / rate * 1e6));
+        }
+        deadlineUs.store(deadline, std::memory_order_relaxed);
+    }
+} // namespace negotio
@@ -0,0 +1,83 @@
+/**
+ * 自适应批大小
+ *
+ * 固定的批大小在低负载时徒增时延，在高负载时又限制吞吐。AdaptiveBatcher 仿照网卡的自适应中断合并，
+ * 按观察到的到达速率与积压为一个批处理阶段（接收、协商计算、发送）选择批大小与刷新期限：
+ * - 每处理完一批调用 observe，按两次调用的间隔估计到达速率（EWMA）；
+ * - 目标批大小为一个期限（maxDelayUs）内预计到达的条目数；该批处理后仍有积压时目标至少为当前值的两倍；
+ * - 每次调整最多翻倍或减半，避免在突发与空闲之间振荡；批大小限制在 [minBatch, maxBatch]；
+ * - 刷新期限为攒满一批的预计时间（不超过 maxDelayUs），批大小为 1 时期限为 0，即空闲时立即处理、立即发送。
+ *
+ * observe 可在多个线程中调用（持有内部锁），getBatchSize / getDeadlineUs 不加锁。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_BATCHING_H
+#define NEGOTIO_BATCHING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace negotio {
+    // 批处理阶段参数
+    struct BatchOptions {
+        uint32_t minBatch = 1;      ///< 批大小下界
+        uint32_t maxBatch = 64;     ///< 批大小上界
+        uint32_t maxDelayUs = 200;  ///< 为攒批愿意增加的最大时延（微秒）
+    };
+
+    class AdaptiveBatcher {
+    public:
+        explicit AdaptiveBatcher(const BatchOptions &options = {});
+
+        /**
+         * @brief 记录一批的处理结果并调整批大小与刷新期限
+         * @param items 本批处理的条目数
+         * @param backlog 本批处理后仍在等待的条目数（未知时，批已满传 1，否则传 0）
+         * @param now 当前时间
+         */
+        void observe(uint32_t items, uint32_t backlog,
+                     std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+        [[nodiscard]] uint32_t getBatchSize() const {
+            return batchSize.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] uint32_t getMaxBatch() const {
+            return options.maxBatch;
+        }
+
+        /**
+         * @brief 当前刷新期限（微秒），0 表示不等待
+         */
+        [[nodiscard]] uint32_t getDeadlineUs() const {
+            return deadlineUs.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 估计的到达速率（条目/秒）
+         */
+        [[nodiscard]] double getArrivalRate() const {
+            return arrivalRate.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr double RATE_SMOOTHING = 0.25; ///< 到达速率 EWMA 的新样本权重
+
+        BatchOptions options;
+        std::atomic<uint32_t> batchSize;
+        std::atomic<uint32_t> deadlineUs{0};
+        std::atomic<double> arrivalRate{0.0};
+
+        std::mutex observeMutex;
+        std::chrono::steady_clock::time_point lastObserve{};
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_BATCHING_H
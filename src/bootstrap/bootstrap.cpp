@@ -0,0 +1,277 @@
+/**
+ * @file bootstrap.cpp
+ * @brief 启动策略分批引导实现
+ */
+
+#include "bootstrap.h"
+#include "../policy/policy.h"
+#include "../negotiate/negotiate.h"
+#include "../monitor/monitor.h"
+#include "json_support.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string_view>
+
+namespace negotio {
+    namespace {
+        constexpr uint32_t PACING_SLICES = 10; ///< 每波拆分为若干片在波次间隔内均匀发出
+
+        // 解析 [begin, end) 范围内的各行，begin 必须位于行首
+        void parseRange(const std::string &content, size_t begin, const size_t end,
+                        std::vector<StartupPolicy> &out) {
+            while (begin < end) {
+                size_t lineEnd = content.find('\n', begin);
+                if (lineEnd == std::string::npos || lineEnd > end) {
+                    lineEnd = end;
+                }
+                const std::string_view line(content.data() + begin, lineEnd - begin);
+                begin = lineEnd + 1;
+                if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+                    continue;
+                }
+                try {
+                    const auto j = nlohmann::json::parse(line);
+                    StartupPolicy policy{};
+                    policy.config = j.get<PolicyConfig>();
+                    policy.priority = j.value("priority", 0u);
+                    in_addr addr{};
+                    if (policy.config.policy_id == 0
+                        || inet_pton(AF_INET, policy.config.remote_ip.c_str(), &addr) != 1) {
+                        continue;
+                    }
+                    out.push_back(std::move(policy));
+                } catch (const std::exception &e) {
+                    std::cerr << "启动策略解析错误: " << e.what() << std::endl;
+                }
+            }
+        }
+    }
+
+    bool loadStartupPolicies(const std::string &path, const uint32_t threads, std::vector<StartupPolicy> &out) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "无法打开启动策略文件 " << path << std::endl;
+            return false;
+        }
+        std::ostringstream buffer;
+        buffer << file.rdbuf();
+        const std::string content = buffer.str();
+
+        // 按字节均分后对齐到行首，各线程解析自己的分段
+        const size_t numThreads = std::max<uint32_t>(1, threads);
+        std::vector<size_t> bounds{0};
+        for (size_t t = 1; t < numThreads; ++t) {
+            size_t pos = std::max(bounds.back(), content.size() * t / numThreads);
+            pos = content.find('\n', pos);
+            bounds.push_back(pos == std::string::npos ? content.size() : pos + 1);
+        }
+        bounds.push_back(content.size());
+
+        std::vector<std::vector<StartupPolicy>> parts(numThreads);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < numThreads; ++t) {
+            workers.emplace_back(parseRange, std::cref(content), bounds[t], bounds[t + 1], std::ref(parts[t]));
+        }
+        for (auto &w : workers) {
+            w.join();
+        }
+
+        out.clear();
+        for (auto &part : parts) {
+            out.insert(out.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+        }
+        std::stable_sort(out.begin(), out.end(), [](const StartupPolicy &a, const StartupPolicy &b) {
+            return a.priority > b.priority;
+        });
+        return true;
+    }
+
+    Bootstrapper::Bootstrapper(PolicyManager &policyManager, Negotiator &negotiator, Monitor *monitor,
+                               BootstrapOptions options)
+        : policyManager(policyManager), negotiator(negotiator), monitor(monitor), options(std::move(options)) {
+        this->options.initialWaveSize = std::max<uint32_t>(1, this->options.initialWaveSize);
+        this->options.maxWaveSize = std::max(this->options.initialWaveSize, this->options.maxWaveSize);
+    }
+
+    Bootstrapper::~Bootstrapper() {
+        stop();
+    }
+
+    void Bootstrapper::start() {
+        if (worker.joinable()) {
+            return;
+        }
+        running = true;
+        worker = std::thread(&Bootstrapper::run, this);
+    }
+
+    void Bootstrapper::stop() {
+        running = false;
+        join();
+    }
+
+    void Bootstrapper::join() {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    BootstrapProgress Bootstrapper::progress() const {
+        return {total.load(), started.load(), completed.load(), retried.load(), abandoned.load(), waveSize.load(),
+                finished.load()};
+    }
+
+    std::vector<StartupPolicy> Bootstrapper::registerPolicies(std::vector<StartupPolicy> &&policies) const {
+        // 容量按启动策略集扩大，不受默认上限 MAX_POLICY_COUNT 限制；写入只有一把锁，串行写入即可保持优先级顺序
+        policyManager.ensureCapacity(static_cast<uint32_t>(
+            std::min<size_t>(UINT32_MAX, policyManager.size() + policies.size())));
+        std::vector<StartupPolicy> registered;
+        registered.reserve(policies.size());
+        for (auto &policy : policies) {
+            if (policyManager.addPolicy(policy.config)) {
+                registered.push_back(std::move(policy));
+            } else {
+                std::cerr << "启动策略重复或超出策略上限，已跳过, policy_id = " << policy.config.policy_id << std::endl;
+            }
+        }
+        return registered;
+    }
+
+    void Bootstrapper::startOne(const PolicyConfig &config) const {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(config.remote_port);
+        inet_pton(AF_INET, config.remote_ip.c_str(), &addr.sin_addr);
+        negotiator.startNegotiation(config.policy_id, addr);
+    }
+
+    void Bootstrapper::publishProgress() const {
+        if (monitor) {
+            monitor->setBootstrapProgress(total.load(), started.load(), completed.load());
+        }
+    }
+
+    bool Bootstrapper::sleepFor(const uint32_t ms) const {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+        while (running) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                deadline - now, std::chrono::milliseconds(10)));
+        }
+        return false;
+    }
+
+    void Bootstrapper::run() {
+        std::vector<StartupPolicy> loaded;
+        const auto loadStart = std::chrono::steady_clock::now();
+        if (!loadStartupPolicies(options.policyFile, options.loaderThreads, loaded)) {
+            finished = true;
+            return;
+        }
+        const std::vector<StartupPolicy> policies = registerPolicies(std::move(loaded));
+        total = static_cast<uint32_t>(policies.size());
+        publishProgress();
+        std::cout << "启动策略加载完成: " << policies.size() << " 条，耗时: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - loadStart).count() << " ms" << std::endl;
+
+        // 首波前随机抖动，错开同时重启的多个节点
+        std::mt19937 rng(std::random_device{}());
+        if (!sleepFor(std::uniform_int_distribution<uint32_t>(0, options.waveIntervalMs)(rng))) {
+            return;
+        }
+
+        // 已发出、尚未确定结果的协商
+        struct Outstanding {
+            size_t index;
+            std::chrono::steady_clock::time_point deadline;
+        };
+        const uint32_t sliceMs = options.waveIntervalMs / PACING_SLICES;
+        uint32_t wave = options.initialWaveSize;
+        std::deque<size_t> queue(policies.size());
+        std::iota(queue.begin(), queue.end(), 0);
+        std::vector<uint32_t> attempts(policies.size(), 0);
+        std::vector<Outstanding> outstanding;
+        while (running && (!queue.empty() || !outstanding.empty())) {
+            // 按优先级发出一波（包括重新排队的策略），队列为空时只等待在途协商的结果
+            const size_t count = std::min<size_t>(queue.size(), wave);
+            waveSize = wave;
+            if (count == 0 && !sleepFor(options.waveIntervalMs)) {
+                return;
+            }
+            const size_t sliceSize = std::max<size_t>(1, (count + PACING_SLICES - 1) / PACING_SLICES);
+            std::vector<size_t> issued;
+            issued.reserve(count);
+            for (size_t sliceBegin = 0; sliceBegin < count; sliceBegin += sliceSize) {
+                for (size_t i = sliceBegin; i < std::min(count, sliceBegin + sliceSize); ++i) {
+                    const size_t index = queue.front();
+                    queue.pop_front();
+                    const PolicyConfig &config = policies[index].config;
+                    startOne(config);
+                    if (attempts[index]++ == 0) {
+                        ++started;
+                    } else {
+                        ++retried;
+                    }
+                    issued.push_back(index);
+                    outstanding.push_back({index, std::chrono::steady_clock::now()
+                                                  + std::chrono::milliseconds(std::max(config.timeout_ms,
+                                                                                       options.waveIntervalMs))});
+                }
+                if (!sleepFor(sliceMs)) {
+                    return;
+                }
+            }
+
+            // 检查在途协商：已完成的计数；已不在协商中或超时仍未完成的在重试次数内重新排队
+            const auto now = std::chrono::steady_clock::now();
+            std::erase_if(outstanding, [&](const Outstanding &entry) {
+                const PolicyConfig &config = policies[entry.index].config;
+                // 只读冷存储，不与协商线程争用桶锁
+                if (negotiator.getKeyEpoch(config.policy_id)) {
+                    ++completed;
+                    return true;
+                }
+                if (now < entry.deadline && negotiator.isNegotiating(config.policy_id)) {
+                    return false;
+                }
+                if (attempts[entry.index] <= config.retry_times) {
+                    queue.push_back(entry.index);
+                } else {
+                    ++abandoned;
+                    std::cerr << "启动策略协商失败, 已重试 " << config.retry_times << " 次, policy_id = "
+                              << config.policy_id << std::endl;
+                }
+                return true;
+            });
+
+            // AIMD：本波完成率达标则加性增大，否则减半
+            if (!issued.empty()) {
+                const auto done = std::count_if(issued.begin(), issued.end(), [&](const size_t index) {
+                    return negotiator.getKeyEpoch(policies[index].config.policy_id).has_value();
+                });
+                const double ratio = static_cast<double>(done) / static_cast<double>(issued.size());
+                wave = ratio >= options.absorbRatio
+                           ? std::min(options.maxWaveSize, wave + options.initialWaveSize)
+                           : std::max<uint32_t>(1, wave / 2);
+            }
+            publishProgress();
+        }
+
+        finished = true;
+        publishProgress();
+        std::cout << "启动策略引导结束: 已完成 " << completed.load() << "/" << total.load()
+                  << ", 重试 " << retried.load() << " 次, 放弃 " << abandoned.load() << std::endl;
+    }
+} // namespace negotio
@@ -0,0 +1,143 @@
+/**
+ * 启动策略分批引导
+ *
+ * 节点重启时从 config.json 引用的启动策略集（JSON Lines，每行一个策略）加载策略：
+ * 1. 多线程并行解析文件的各个分段，按优先级（priority 越大越先协商）排序
+ * 2. 按启动策略数扩大 PolicyManager 的容量上限，再按优先级顺序写入
+ * 3. 以限速的波次发起协商：每一波在一个波次间隔内均匀发出，首波前加入随机抖动，
+ *    避免多个节点同时重启时形成同步的协商风暴
+ * 4. 每波结束后检查完成率，达到阈值则加性增大下一波规模，否则减半（AIMD），
+ *    使引导速度逼近对端的实际处理能力
+ * 5. 未完成且已不在协商中（被丢弃、超时或未能发起）、或超过 timeout_ms 仍未完成的策略重新排到队尾，
+ *    每个策略最多重试 retry_times 次
+ *
+ * 进度（总数 / 已发起 / 已完成 / 重试）通过 Monitor 写入日志和统计文件。
+ *
+ * 启动策略文件每行格式：
+ * {"policy_id": 1, "remote_ip": "10.0.0.2", "remote_port": 5000, "timeout_ms": 100, "retry_times": 3, "priority": 10}
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_BOOTSTRAP_H
+#define NEGOTIO_BOOTSTRAP_H
+
+#include "common.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace negotio {
+    class PolicyManager;
+    class Negotiator;
+    class Monitor;
+
+    // 启动策略条目
+    struct StartupPolicy {
+        PolicyConfig config; ///< 策略配置
+        uint32_t priority;   ///< 优先级，越大越先协商，缺省为 0
+    };
+
+    // 引导参数
+    struct BootstrapOptions {
+        std::string policyFile;          ///< 启动策略文件路径（JSON Lines）
+        uint32_t loaderThreads = 4;      ///< 并行解析线程数
+        uint32_t initialWaveSize = 256;  ///< 首波规模，同时也是每次加性增大的步长
+        uint32_t maxWaveSize = 8192;     ///< 单波规模上限
+        uint32_t waveIntervalMs = 100;   ///< 每波的发送时长与完成检查间隔
+        double absorbRatio = 0.9;        ///< 完成率不低于该值时扩大下一波
+    };
+
+    // 引导进度
+    struct BootstrapProgress {
+        uint32_t total;     ///< 成功加载的策略数
+        uint32_t started;   ///< 已发起协商的策略数（不含重试）
+        uint32_t completed; ///< 已完成协商的策略数
+        uint32_t retried;   ///< 重新发起的协商次数
+        uint32_t abandoned; ///< 用尽重试次数仍未完成的策略数
+        uint32_t waveSize;  ///< 当前波次规模
+        bool finished;      ///< 所有波次均已发出且完成最终统计
+    };
+
+    /**
+     * @brief 并行解析启动策略文件
+     * @param path 文件路径（JSON Lines）
+     * @param threads 解析线程数
+     * @param out 解析结果，按优先级从高到低排序（同优先级保持文件顺序）
+     * @return 文件无法读取时返回 false；格式错误的行会被跳过
+     */
+    bool loadStartupPolicies(const std::string &path, uint32_t threads, std::vector<StartupPolicy> &out);
+
+    /**
+     * @brief 启动策略引导器，在后台线程中加载并分批协商
+     */
+    class Bootstrapper {
+    public:
+        Bootstrapper(PolicyManager &policyManager, Negotiator &negotiator, Monitor *monitor,
+                     BootstrapOptions options);
+
+        ~Bootstrapper();
+
+        Bootstrapper(const Bootstrapper &) = delete;
+        Bootstrapper &operator=(const Bootstrapper &) = delete;
+
+        /**
+         * @brief 启动后台引导线程
+         */
+        void start();
+
+        /**
+         * @brief 停止引导（未发出的波次被放弃）
+         */
+        void stop();
+
+        /**
+         * @brief 等待引导结束
+         */
+        void join();
+
+        [[nodiscard]] BootstrapProgress progress() const;
+
+    private:
+        PolicyManager &policyManager;
+        Negotiator &negotiator;
+        Monitor *monitor;
+        BootstrapOptions options;
+        std::thread worker;
+        std::atomic<bool> running{false};
+        std::atomic<uint32_t> total{0};
+        std::atomic<uint32_t> started{0};
+        std::atomic<uint32_t> completed{0};
+        std::atomic<uint32_t> retried{0};
+        std::atomic<uint32_t> abandoned{0};
+        std::atomic<uint32_t> waveSize{0};
+        std::atomic<bool> finished{false};
+
+        void run();
+
+        /**
+         * @brief 按优先级顺序将加载结果写入 PolicyManager，返回写入成功（去重）的策略
+         */
+        std::vector<StartupPolicy> registerPolicies(std::vector<StartupPolicy> &&policies) const;
+
+        /**
+         * @brief 发起一次协商
+         */
+        void startOne(const PolicyConfig &config) const;
+
+        void publishProgress() const;
+
+        /**
+         * @brief 可被 stop() 打断的睡眠，返回 false 表示已停止
+         */
+        bool sleepFor(uint32_t ms) const;
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_BOOTSTRAP_H
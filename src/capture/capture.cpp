@@ -0,0 +1,187 @@
+/**
+ * @file capture.cpp
+ * @brief 数据包抓取与回放支持实现
+ *
+ * 写入端采用有界多生产者队列（每个槽位带序号），接收线程只做一次 CAS 和一次内存拷贝，
+ * 队列满时直接丢弃并计数，绝不阻塞接收路径。
+ */
+
+#include "capture.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace negotio {
+    namespace {
+        size_t roundUpPowerOfTwo(size_t value) {
+            size_t result = 1;
+            while (result < value) {
+                result <<= 1;
+            }
+            return result;
+        }
+    }
+
+    CaptureWriter::CaptureWriter(const size_t ringCapacity)
+        : capacity(roundUpPowerOfTwo(ringCapacity < 2 ? 2 : ringCapacity)),
+          mask(capacity - 1), file(nullptr), running(false) {
+        slots = std::make_unique<Slot[]>(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    CaptureWriter::~CaptureWriter() {
+        close();
+    }
+
+    bool CaptureWriter::open(const std::string &path) {
+        if (file) {
+            return false;
+        }
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            std::cerr << "无法创建抓包文件 " << path << std::endl;
+            return false;
+        }
+        CaptureFileHeader header{};
+        std::memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+        header.version = CAPTURE_VERSION;
+        header.snaplen = CAPTURE_SNAPLEN;
+        std::fwrite(&header, sizeof(header), 1, file);
+        running = true;
+        flushThread = std::thread(&CaptureWriter::flushLoop, this);
+        return true;
+    }
+
+    void CaptureWriter::close() {
+        running = false;
+        if (flushThread.joinable()) {
+            flushThread.join();
+        }
+        if (file) {
+            drain();
+            std::fclose(file);
+            file = nullptr;
+        }
+    }
+
+    bool CaptureWriter::record(const uint8_t *data, const size_t len, const sockaddr_in &src) {
+        if (!running.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &slots[pos & mask];
+            const uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // 落盘线程跟不上，丢弃而不是阻塞接收路径
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        const size_t captured = len < CAPTURE_SNAPLEN ? len : CAPTURE_SNAPLEN;
+        slot->header.timestampNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        slot->header.srcAddr = src.sin_addr.s_addr;
+        slot->header.srcPort = src.sin_port;
+        slot->header.capturedLen = static_cast<uint16_t>(captured);
+        slot->header.originalLen = static_cast<uint16_t>(len > UINT16_MAX ? UINT16_MAX : len);
+        slot->header.reserved = 0;
+        std::memcpy(slot->data, data, captured);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        recorded.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t CaptureWriter::drain() {
+        size_t written = 0;
+        while (true) {
+            Slot &slot = slots[dequeuePos & mask];
+            if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) {
+                break;
+            }
+            std::fwrite(&slot.header, sizeof(slot.header), 1, file);
+            std::fwrite(slot.data, 1, slot.header.capturedLen, file);
+            slot.sequence.store(dequeuePos + capacity, std::memory_order_release);
+            ++dequeuePos;
+            ++written;
+        }
+        return written;
+    }
+
+    void CaptureWriter::flushLoop() {
+        using namespace std::chrono_literals;
+        while (running) {
+            if (drain() == 0) {
+                std::fflush(file);
+                std::this_thread::sleep_for(1ms);
+            }
+        }
+    }
+
+    CaptureReader::CaptureReader() : file(nullptr) {
+    }
+
+    CaptureReader::~CaptureReader() {
+        if (file) {
+            std::fclose(file);
+        }
+    }
+
+    bool CaptureReader::open(const std::string &path) {
+        // 重复打开时先关闭上一个文件
+        if (file) {
+            std::fclose(file);
+            file = nullptr;
+        }
+        file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        CaptureFileHeader header{};
+        if (std::fread(&header, sizeof(header), 1, file) != 1
+            || std::memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0
+            || header.version != CAPTURE_VERSION) {
+            std::fclose(file);
+            file = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    bool CaptureReader::next(CaptureRecord &record) {
+        if (!file) {
+            return false;
+        }
+        CaptureRecordHeader header{};
+        if (std::fread(&header, sizeof(header), 1, file) != 1 || header.capturedLen > CAPTURE_SNAPLEN) {
+            return false;
+        }
+        record.timestampNs = header.timestampNs;
+        record.src = {};
+        record.src.sin_family = AF_INET;
+        record.src.sin_addr.s_addr = header.srcAddr;
+        record.src.sin_port = header.srcPort;
+        record.originalLen = header.originalLen;
+        record.data.resize(header.capturedLen);
+        return header.capturedLen == 0
+               || std::fread(record.data.data(), 1, header.capturedLen, file) == header.capturedLen;
+    }
+
+    void CaptureReader::rewind() {
+        if (file) {
+            std::fseek(file, sizeof(CaptureFileHeader), SEEK_SET);
+        }
+    }
+} // namespace negotio
@@ -0,0 +1,161 @@
+/**
+ * 数据包抓取与回放支持
+ *
+ * CaptureWriter 在接收路径上以无锁方式记录原始数据报（时间戳、源地址、字节内容），
+ * 后台线程将记录批量写入紧凑的抓包文件；CaptureReader 顺序读取抓包文件供回放工具使用。
+ *
+ * 文件格式：CaptureFileHeader + 若干 (CaptureRecordHeader + 数据字节)，均为本机字节序，
+ * 源地址与端口保持网络字节序（与 sockaddr_in 一致）。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_CAPTURE_H
+#define NEGOTIO_CAPTURE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+
+namespace negotio {
+    constexpr char CAPTURE_MAGIC[8] = {'N', 'G', 'O', 'C', 'A', 'P', '\0', '\0'};
+    constexpr uint32_t CAPTURE_VERSION = 1;
+    constexpr uint32_t CAPTURE_SNAPLEN = 256; ///< 单条记录最多保存的字节数
+    constexpr size_t DEFAULT_CAPTURE_RING_CAPACITY = 8192;
+
+#pragma pack(push, 1)
+    // 抓包文件头
+    struct CaptureFileHeader {
+        char magic[8];    ///< 文件魔数 "NGOCAP"
+        uint32_t version; ///< 格式版本
+        uint32_t snaplen; ///< 单条记录最大保存字节数
+    };
+
+    // 单条记录头，其后紧跟 capturedLen 字节的数据
+    struct CaptureRecordHeader {
+        uint64_t timestampNs; ///< 接收时间（CLOCK_REALTIME，纳秒）
+        uint32_t srcAddr;     ///< 源 IPv4 地址（网络字节序）
+        uint16_t srcPort;     ///< 源端口（网络字节序）
+        uint16_t capturedLen; ///< 实际保存的字节数
+        uint16_t originalLen; ///< 原始数据报长度
+        uint16_t reserved;
+    };
+#pragma pack(pop)
+
+    // 回放时读取出的单条记录
+    struct CaptureRecord {
+        uint64_t timestampNs;
+        sockaddr_in src;
+        uint16_t originalLen;
+        std::vector<uint8_t> data;
+    };
+
+    /**
+     * @brief 抓包写入器：多生产者无锁环形队列 + 单个后台落盘线程
+     */
+    class CaptureWriter {
+    public:
+        explicit CaptureWriter(size_t ringCapacity = DEFAULT_CAPTURE_RING_CAPACITY);
+
+        ~CaptureWriter();
+
+        CaptureWriter(const CaptureWriter &) = delete;
+        CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+        /**
+         * @brief 创建抓包文件并启动后台落盘线程
+         * @param path 抓包文件路径
+         * @return 成功返回 true
+         */
+        bool open(const std::string &path);
+
+        /**
+         * @brief 写出队列中剩余记录并关闭文件
+         */
+        void close();
+
+        /**
+         * @brief 记录一个接收到的数据报（无锁，可在多个接收线程中并发调用）
+         * @param data 数据报内容
+         * @param len 数据报长度
+         * @param src 源地址
+         * @return 记录成功返回 true；队列已满时丢弃并返回 false
+         */
+        bool record(const uint8_t *data, size_t len, const sockaddr_in &src);
+
+        [[nodiscard]] uint64_t getRecorded() const { return recorded.load(std::memory_order_relaxed); }
+        [[nodiscard]] uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> sequence;
+            CaptureRecordHeader header;
+            uint8_t data[CAPTURE_SNAPLEN];
+        };
+
+        std::unique_ptr<Slot[]> slots;
+        const size_t capacity; ///< 2 的幂
+        const size_t mask;
+        alignas(64) std::atomic<uint64_t> enqueuePos{0};
+        alignas(64) uint64_t dequeuePos{0}; ///< 仅由落盘线程访问
+        std::atomic<uint64_t> recorded{0};
+        std::atomic<uint64_t> dropped{0};
+
+        std::FILE *file;
+        std::atomic<bool> running;
+        std::thread flushThread;
+
+        void flushLoop();
+
+        /**
+         * @brief 将队列中已就绪的记录写入文件
+         * @return 写出的记录数
+         */
+        size_t drain();
+    };
+
+    /**
+     * @brief 抓包文件读取器
+     */
+    class CaptureReader {
+    public:
+        CaptureReader();
+
+        ~CaptureReader();
+
+        CaptureReader(const CaptureReader &) = delete;
+        CaptureReader &operator=(const CaptureReader &) = delete;
+
+        /**
+         * @brief 打开并校验抓包文件，已打开的文件先关闭
+         * @param path 抓包文件路径
+         * @return 成功返回 true
+         */
+        bool open(const std::string &path);
+
+        /**
+         * @brief 读取下一条记录
+         * @param record 输出参数
+         * @return 读取成功返回 true，文件结束或格式错误返回 false
+         */
+        bool next(CaptureRecord &record);
+
+        /**
+         * @brief 回到第一条记录
+         */
+        void rewind();
+
+    private:
+        std::FILE *file;
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_CAPTURE_H
@@ -0,0 +1,76 @@
+/**
+ * @file concurrency.cpp
+ * @brief 自适应并发限制实现
+ */
+
+#include "concurrency.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace negotio {
+    ConcurrencyLimiter::ConcurrencyLimiter(const ConcurrencyLimitOptions &options) : options(options) {
+        // 时延目标为 0（如 timeout_ms 配置为 0）时按 1 ms 处理，余量计算不会除以 0
+        this->options.targetLatencyMs = std::max<uint32_t>(1, this->options.targetLatencyMs);
+        this->options.minLimit = std::max<uint32_t>(1, this->options.minLimit);
+        this->options.maxLimit = std::max(this->options.minLimit, this->options.maxLimit);
+        this->options.windowSamples = std::max<uint32_t>(1, this->options.windowSamples);
+        this->options.decreaseFactor = std::clamp(this->options.decreaseFactor, 0.1, 1.0);
+        limit.store(std::clamp(this->options.initialLimit, this->options.minLimit, this->options.maxLimit),
+                    std::memory_order_relaxed);
+        samples.reserve(this->options.windowSamples);
+    }
+
+    bool ConcurrencyLimiter::tryAcquire() {
+        uint32_t current = inFlight.load(std::memory_order_relaxed);
+        do {
+            if (current >= limit.load(std::memory_order_relaxed)) {
+                rejected.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!inFlight.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+        return true;
+    }
+
+    void ConcurrencyLimiter::release(const uint32_t latencyMs) {
+        record(std::min(latencyMs, TIMED_OUT - 1));
+    }
+
+    void ConcurrencyLimiter::releaseTimedOut() {
+        record(TIMED_OUT);
+    }
+
+    void ConcurrencyLimiter::cancel() {
+        inFlight.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void ConcurrencyLimiter::record(const uint32_t latencyMs) {
+        const uint32_t occupied = inFlight.fetch_sub(1, std::memory_order_relaxed);
+        std::lock_guard lock(windowMutex);
+        peakInFlight = std::max(peakInFlight, occupied);
+        samples.push_back(latencyMs);
+        if (samples.size() >= options.windowSamples) {
+            closeWindow();
+        }
+    }
+
+    void ConcurrencyLimiter::closeWindow() {
+        const auto p90 = samples.begin() + static_cast<std::ptrdiff_t>(samples.size() * 9 / 10);
+        std::nth_element(samples.begin(), p90, samples.end());
+        const uint32_t latency = *p90;
+        windowLatencyMs.store(latency, std::memory_order_relaxed);
+
+        const uint32_t current = limit.load(std::memory_order_relaxed);
+        uint32_t next = current;
+        if (latency > options.targetLatencyMs) {
+            next = static_cast<uint32_t>(current * options.decreaseFactor);
+        } else if (peakInFlight * 2 >= current) {
+            // 余量梯度：p90 为 0 时增大 sqrt(limit)，接近目标时增大 1
+            const double headroom = 1.0 - static_cast<double>(latency) / options.targetLatencyMs;
+            next = current + std::max<uint32_t>(1, static_cast<uint32_t>(std::sqrt(current) * headroom));
+        }
+        limit.store(std::clamp(next, options.minLimit, options.maxLimit), std::memory_order_relaxed);
+        samples.clear();
+        peakInFlight = 0;
+    }
+} // namespace negotio
@@ -0,0 +1,110 @@
+/**
+ * 自适应并发限制
+ *
+ * 固定的在途协商上限要么过低（浪费容量），要么过高（排队使协商超过时延目标）。
+ * ConcurrencyLimiter 按实测协商耗时相对时延目标（协商超时）动态调整允许同时进行的协商数：
+ * - 每完成 windowSamples 个协商（含超时）结算一个窗口，取窗口内耗时的 p90，超时样本计为无穷大；
+ * - p90 超过目标时乘性减小上限（AIMD 的 MD），少量丢包造成的超时不会触发减小；
+ * - 否则按距目标的余量梯度增大：余量越大增幅越大（最多 sqrt(limit)），接近目标时每窗口只加 1；
+ * - 窗口内在途数从未达到上限的一半时说明负载本身不高，上限保持不变，避免空闲时无限增长。
+ *
+ * tryAcquire / release 成对调用，tryAcquire 不加锁；release 只在记录样本时短暂持有窗口锁。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_CONCURRENCY_H
+#define NEGOTIO_CONCURRENCY_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace negotio {
+    // 并发限制参数
+    struct ConcurrencyLimitOptions {
+        uint32_t targetLatencyMs = 100; ///< 时延目标，通常取协商超时（至少按 1 ms 处理）
+        uint32_t initialLimit = 256;    ///< 初始上限
+        uint32_t minLimit = 16;         ///< 上限下界
+        uint32_t maxLimit = 65536;      ///< 上限上界
+        uint32_t windowSamples = 64;    ///< 每个窗口的样本数
+        double decreaseFactor = 0.8;    ///< 超出时延目标时上限乘以该系数
+    };
+
+    class ConcurrencyLimiter {
+    public:
+        explicit ConcurrencyLimiter(const ConcurrencyLimitOptions &options = {});
+
+        /**
+         * @brief 申请一个在途名额（不加锁）
+         * @return 在途数未达到上限时占用名额并返回 true，否则计入拒绝数并返回 false
+         */
+        bool tryAcquire();
+
+        /**
+         * @brief 协商完成，归还名额并记录耗时样本
+         * @param latencyMs 协商耗时（毫秒）
+         */
+        void release(uint32_t latencyMs);
+
+        /**
+         * @brief 协商超时，归还名额并记录一个超出时延目标的样本
+         */
+        void releaseTimedOut();
+
+        /**
+         * @brief 协商被取消（如同时发起时转为响应方），只归还名额，不记录样本
+         */
+        void cancel();
+
+        [[nodiscard]] uint32_t getLimit() const {
+            return limit.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] uint32_t getInFlight() const {
+            return inFlight.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] uint64_t getRejected() const {
+            return rejected.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 最近一个窗口的耗时 p90（毫秒），尚未结算过窗口时为 0，p90 落在超时样本上时为 TIMED_OUT
+         */
+        [[nodiscard]] uint32_t getWindowLatencyMs() const {
+            return windowLatencyMs.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] uint32_t getTargetLatencyMs() const {
+            return options.targetLatencyMs;
+        }
+
+        static constexpr uint32_t TIMED_OUT = UINT32_MAX; ///< 超时样本
+
+    private:
+
+        ConcurrencyLimitOptions options;
+        std::atomic<uint32_t> limit;
+        std::atomic<uint32_t> inFlight{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint32_t> windowLatencyMs{0};
+
+        std::mutex windowMutex;
+        std::vector<uint32_t> samples; ///< 当前窗口的耗时样本
+        uint32_t peakInFlight = 0;     ///< 当前窗口内观察到的最大在途数
+
+        void record(uint32_t latencyMs);
+
+        /**
+         * @brief 结算当前窗口并调整上限（调用方持有 windowMutex）
+         */
+        void closeWindow();
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_CONCURRENCY_H
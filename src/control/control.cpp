@@ -0,0 +1,163 @@
+/**
+ * @file control.cpp
+ * @brief 控制命令解码与分片执行实现
+ */
+
+#include "control.h"
+#include "../policy/policy.h"
+#include "../negotiate/negotiate.h"
+#include "../allocstat/allocstat.h"
+#include "../warmup/warmup.h"
+#include "../profiler/profiler.h"
+#include "json_support.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <iostream>
+
+namespace negotio {
+    bool decodeControlCommand(const std::string &text, ControlCommand &out) {
+        try {
+            const auto j = nlohmann::json::parse(text);
+            const std::string action = j.at("action").get<std::string>();
+            if (action == "profile_start") {
+                out.action = ControlAction::PROFILE_START;
+                out.policy = PolicyConfig{};
+                out.profileHz = j.value("frequency_hz", DEFAULT_PROFILE_HZ);
+                return true;
+            }
+            if (action == "profile_stop") {
+                out.action = ControlAction::PROFILE_STOP;
+                out.policy = PolicyConfig{};
+                out.profilePath = j.value("path", std::string("negotio.pprof"));
+                return true;
+            }
+            if (action != "add") {
+                std::cerr << "未知控制命令: " << action << std::endl;
+                return false;
+            }
+            out.action = ControlAction::ADD;
+            out.policy = j.at("policy").get<PolicyConfig>();
+        } catch (const std::exception &e) {
+            std::cerr << "命令解析错误: " << e.what() << std::endl;
+            return false;
+        }
+        in_addr addr{};
+        if (out.policy.policy_id == 0 || inet_pton(AF_INET, out.policy.remote_ip.c_str(), &addr) != 1) {
+            std::cerr << "命令参数非法，策略ID: " << out.policy.policy_id << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void executeControlCommand(const ControlCommand &command, PolicyManager &policyManager, Negotiator &negotiator) {
+        switch (command.action) {
+            case ControlAction::ADD: {
+                const bool success = policyManager.addPolicy(command.policy);
+#ifdef DEBUG
+                DEBUG_LOG("策略" << (success ? "添加成功" : "添加失败")
+                    << "，策略ID: " << command.policy.policy_id);
+#else
+                (void) success; // 引用 success 以避免未使用警告
+#endif
+                // 立即发起协商，超时后按策略的 retry_times 重新发起
+                negotiator.startNegotiation(command.policy);
+                break;
+            }
+            case ControlAction::PROFILE_START: {
+                const bool started = Profiler::instance().start(command.profileHz);
+                std::cout << (started ? "CPU 采样已开始，频率: " : "CPU 采样启动失败（是否已在采样），频率: ")
+                          << command.profileHz << " Hz" << std::endl;
+                break;
+            }
+            case ControlAction::PROFILE_STOP: {
+                Profiler &profiler = Profiler::instance();
+                const uint64_t samples = profiler.getSamples();
+                const uint64_t dropped = profiler.getDropped();
+                if (profiler.stop(command.profilePath)) {
+                    std::cout << "CPU 采样已写入 " << command.profilePath << "，样本: " << samples
+                              << "，丢弃: " << dropped << std::endl;
+                } else {
+                    std::cerr << "CPU 采样停止失败（未在采样或无法写入 " << command.profilePath << "）" << std::endl;
+                }
+                break;
+            }
+        }
+    }
+
+    ControlDispatcher::ControlDispatcher(ControlExecutor executor, ControlDispatcherOptions options)
+        : executor(std::move(executor)), options(options) {
+        this->options.workerThreads = std::max<uint32_t>(1, this->options.workerThreads);
+        this->options.maxQueuedPerShard = std::max<size_t>(1, this->options.maxQueuedPerShard);
+        for (uint32_t i = 0; i < this->options.workerThreads; ++i) {
+            shards.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    ControlDispatcher::~ControlDispatcher() {
+        stop();
+    }
+
+    void ControlDispatcher::start() {
+        if (running.exchange(true)) {
+            return;
+        }
+        for (auto &shard : shards) {
+            shard->worker = std::thread(&ControlDispatcher::runShard, this, std::ref(*shard));
+        }
+    }
+
+    void ControlDispatcher::stop() {
+        running = false;
+        for (auto &shard : shards) {
+            {
+                // 持锁通知，避免工作线程在检查 running 与进入等待之间错过唤醒
+                std::lock_guard lock(shard->mtx);
+            }
+            shard->notEmpty.notify_all();
+            shard->notFull.notify_all();
+        }
+        for (auto &shard : shards) {
+            if (shard->worker.joinable()) {
+                shard->worker.join();
+            }
+        }
+    }
+
+    bool ControlDispatcher::dispatch(ControlCommand &&command) {
+        Shard &shard = *shards[shardOf(command.policy.policy_id)];
+        {
+            std::unique_lock lock(shard.mtx);
+            shard.notFull.wait(lock, [&]() {
+                return !running || shard.queue.size() < options.maxQueuedPerShard;
+            });
+            if (!running) {
+                return false;
+            }
+            shard.queue.push_back(std::move(command));
+        }
+        shard.notEmpty.notify_one();
+        return true;
+    }
+
+    void ControlDispatcher::runShard(Shard &shard) {
+        prefaultStack();
+        AllocScope allocScope(AllocTag::CONTROL);
+        for (;;) {
+            ControlCommand command;
+            {
+                std::unique_lock lock(shard.mtx);
+                shard.notEmpty.wait(lock, [&]() { return !running || !shard.queue.empty(); });
+                // 停止后仍执行完已排队的命令
+                if (shard.queue.empty()) {
+                    return;
+                }
+                command = std::move(shard.queue.front());
+                shard.queue.pop_front();
+            }
+            shard.notFull.notify_one();
+            executor(command);
+            executed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+} // namespace negotio
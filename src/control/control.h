@@ -0,0 +1,132 @@
+/**
+ * 控制命令的解码与分片执行
+ *
+ * Unix 套接字线程只负责解码命令（JSON 解析与校验），执行（写入策略表、发起协商，
+ * 其中包含随机数生成与 UDP 发送）交给若干工作分片：命令按 policy_id % 分片数 进入对应分片的 FIFO 队列，
+ * 因此同一策略的命令严格按接收顺序执行，不同策略的命令在各分片上并行执行，
+ * 批量 add 不再受限于控制线程所在的单个核心。
+ *
+ * 分片队列有容量上限，队列满时 dispatch 阻塞控制线程，向命令发送方形成背压。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_CONTROL_H
+#define NEGOTIO_CONTROL_H
+
+#include "common.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace negotio {
+    class PolicyManager;
+    class Negotiator;
+
+    // 控制命令类型
+    enum class ControlAction {
+        ADD,           ///< 添加策略并立即发起协商
+        PROFILE_START, ///< 开始 CPU 采样
+        PROFILE_STOP   ///< 停止 CPU 采样并写出 pprof 文件
+    };
+
+    // 解码后的控制命令
+    struct ControlCommand {
+        ControlAction action;     ///< 命令类型
+        PolicyConfig policy;      ///< 策略配置，policy.policy_id 决定所在分片（采样命令为 0，在分片 0 执行）
+        uint32_t profileHz = 0;   ///< PROFILE_START 的采样频率
+        std::string profilePath;  ///< PROFILE_STOP 的输出路径
+    };
+
+    /**
+     * @brief 解码一条控制命令
+     * @param text 命令文本，例如 {"action": "add", "policy": {...}}、{"action": "profile_start", "frequency_hz": 99}、
+     *             {"action": "profile_stop", "path": "/tmp/negotio.pprof"}
+     * @param out 解码结果
+     * @return 成功返回 true；JSON 格式错误、未知 action 或策略字段非法时返回 false 并输出错误信息
+     */
+    bool decodeControlCommand(const std::string &text, ControlCommand &out);
+
+    /**
+     * @brief 在当前线程执行一条控制命令
+     */
+    void executeControlCommand(const ControlCommand &command, PolicyManager &policyManager, Negotiator &negotiator);
+
+    // 分片执行参数
+    struct ControlDispatcherOptions {
+        uint32_t workerThreads = 4;    ///< 工作分片数（每个分片一个线程）
+        size_t maxQueuedPerShard = 4096; ///< 单个分片的最大排队命令数
+    };
+
+    using ControlExecutor = std::function<void(const ControlCommand &)>;
+
+    /**
+     * @brief 按 policy_id 将控制命令分派到工作分片执行
+     */
+    class ControlDispatcher {
+    public:
+        ControlDispatcher(ControlExecutor executor, ControlDispatcherOptions options);
+
+        ~ControlDispatcher();
+
+        ControlDispatcher(const ControlDispatcher &) = delete;
+        ControlDispatcher &operator=(const ControlDispatcher &) = delete;
+
+        /**
+         * @brief 启动工作线程
+         */
+        void start();
+
+        /**
+         * @brief 停止接收新命令，执行完已排队的命令后退出工作线程
+         */
+        void stop();
+
+        /**
+         * @brief 将命令放入所属分片的队列；队列满时阻塞直到有空位
+         * @return 已停止时返回 false
+         */
+        bool dispatch(ControlCommand &&command);
+
+        /**
+         * @brief 命令所在的分片
+         */
+        [[nodiscard]] size_t shardOf(uint32_t policy_id) const {
+            return policy_id % shards.size();
+        }
+
+        [[nodiscard]] uint64_t getExecuted() const {
+            return executed.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Shard {
+            std::mutex mtx;
+            std::condition_variable notEmpty;
+            std::condition_variable notFull;
+            std::deque<ControlCommand> queue;
+            std::thread worker;
+        };
+
+        void runShard(Shard &shard);
+
+        ControlExecutor executor;
+        ControlDispatcherOptions options;
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::atomic<bool> running{false};
+        std::atomic<uint64_t> executed{0};
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_CONTROL_H
@@ -0,0 +1,49 @@
+/**
+ * @file keybatch.cpp
+ * @brief 批量密钥派生实现
+ */
+
+#include "keybatch.h"
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+namespace negotio {
+    namespace {
+        constexpr char EXTRACT_SALT[] = "negotio key batch";
+        constexpr char EXPAND_LABEL[] = "negotio key";
+
+        void putBigEndian32(uint8_t *out, const uint32_t value) {
+            out[0] = static_cast<uint8_t>(value >> 24);
+            out[1] = static_cast<uint8_t>(value >> 16);
+            out[2] = static_cast<uint8_t>(value >> 8);
+            out[3] = static_cast<uint8_t>(value);
+        }
+    }
+
+    KeyBatchSecret extractKeyBatchSecret(const SessionKey &key) {
+        KeyBatchSecret prk{};
+        unsigned int len = 0;
+        HMAC(EVP_sha256(), EXTRACT_SALT, sizeof(EXTRACT_SALT) - 1, key.data(), key.size(), prk.data(), &len);
+        return prk;
+    }
+
+    SessionKey deriveBatchKey(const KeyBatchSecret &prk, const uint32_t policy_id, const uint32_t index) {
+        // info = label || policy_id || index，后接 HKDF-Expand 的块计数 0x01
+        uint8_t info[sizeof(EXPAND_LABEL) - 1 + 2 * sizeof(uint32_t) + 1];
+        size_t pos = 0;
+        for (size_t i = 0; i < sizeof(EXPAND_LABEL) - 1; ++i) {
+            info[pos++] = static_cast<uint8_t>(EXPAND_LABEL[i]);
+        }
+        putBigEndian32(info + pos, policy_id);
+        pos += sizeof(uint32_t);
+        putBigEndian32(info + pos, index);
+        pos += sizeof(uint32_t);
+        info[pos] = 0x01;
+
+        SessionKey key{};
+        unsigned int len = 0;
+        HMAC(EVP_sha256(), prk.data(), static_cast<int>(prk.size()), info, sizeof(info), key.data(), &len);
+        return key;
+    }
+} // namespace negotio
@@ -0,0 +1,51 @@
+/**
+ * 批量密钥派生
+ *
+ * 一次协商得到的密钥 K 作为一个批次的第 0 个密钥，批次内其余密钥由双方在本地按序派生，不再经过网络：
+ *   PRK   = HMAC-SHA256("negotio key batch", K)                         （HKDF-Extract）
+ *   K_i   = HMAC-SHA256(PRK, "negotio key" || policy_id || i || 0x01)   （HKDF-Expand，单块，i = 1..N-1）
+ * policy_id 与 i 均按大端序编码。批次大小 N 在 RANDOM1 / RANDOM2 的能力字中协商（取双方配置的较小值），
+ * 批次用完后才需要重新协商，重新协商的网络与 CPU 开销因此降为原来的 1/N。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_KEYBATCH_H
+#define NEGOTIO_KEYBATCH_H
+
+#include "common.h"
+
+#include <array>
+#include <cstdint>
+
+namespace negotio {
+    constexpr uint32_t MAX_KEY_BATCH = 0xFFFF; ///< 批次大小上限（能力字中占 16 位）
+
+    using KeyBatchSecret = std::array<uint8_t, KEY_SIZE>;
+
+    // 一个策略当前的密钥批次
+    struct KeyBatch {
+        KeyBatchSecret prk; ///< 由批次首个密钥提取的伪随机密钥
+        uint32_t size;      ///< 批次大小（含协商得到的首个密钥）
+        uint32_t next;      ///< 下一个待派生的批次内序号，等于 size 时批次用完
+    };
+
+    /**
+     * @brief 由协商得到的密钥提取批次伪随机密钥（HKDF-Extract）
+     */
+    KeyBatchSecret extractKeyBatchSecret(const SessionKey &key);
+
+    /**
+     * @brief 派生批次内第 index 个密钥（HKDF-Expand）
+     * @param prk 批次伪随机密钥
+     * @param policy_id 策略ID
+     * @param index 批次内序号（>= 1）
+     * @return 32 字节密钥
+     */
+    SessionKey deriveBatchKey(const KeyBatchSecret &prk, uint32_t policy_id, uint32_t index);
+} // namespace negotio
+
+#endif // NEGOTIO_KEYBATCH_H
@@ -0,0 +1,212 @@
+/**
+ * @file localtransport.cpp
+ * @brief 同主机本地传输实现
+ */
+
+#include "localtransport.h"
+#include "../udp/udp.h"
+#include "../allocstat/allocstat.h"
+#include "probes.h"
+
+#include <arpa/inet.h>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace negotio {
+    namespace {
+        constexpr char PATH_PREFIX[] = "negotio-";
+        constexpr char PATH_SUFFIX[] = ".sock";
+
+        bool toUnixAddr(const std::string &path, sockaddr_un &out) {
+            if (path.size() >= sizeof(out.sun_path)) {
+                return false;
+            }
+            out = {};
+            out.sun_family = AF_UNIX;
+            std::memcpy(out.sun_path, path.c_str(), path.size());
+            return true;
+        }
+    }
+
+    LocalTransport::LocalTransport() : sockfd(-1) {
+    }
+
+    LocalTransport::~LocalTransport() {
+        if (sockfd != -1) {
+            close(sockfd);
+            unlink(boundPath.c_str());
+        }
+    }
+
+    ErrorCode LocalTransport::init(const std::string &socketDir, const sockaddr_in &self) {
+        dir = socketDir;
+        boundPath = socketPath(socketDir, self);
+        sockaddr_un addr{};
+        if (!toUnixAddr(boundPath, addr)) {
+            return ErrorCode::INVALID_PARAM;
+        }
+
+        sockfd = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (sockfd == -1) {
+            return ErrorCode::SOCKET_ERROR;
+        }
+        if (const int flags = fcntl(sockfd, F_GETFL, 0);
+            flags == -1 || fcntl(sockfd, F_SETFL, flags | O_NONBLOCK) == -1) {
+            close(sockfd);
+            sockfd = -1;
+            return ErrorCode::SOCKET_ERROR;
+        }
+        // 上次运行残留的套接字文件
+        unlink(boundPath.c_str());
+        if (bind(sockfd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+            close(sockfd);
+            sockfd = -1;
+            return ErrorCode::SOCKET_ERROR;
+        }
+        return ErrorCode::SUCCESS;
+    }
+
+    bool LocalTransport::addLocalSubnet(const std::string &cidr) {
+        const size_t slash = cidr.find('/');
+        const std::string ip = cidr.substr(0, slash);
+        int prefix = 32;
+        if (slash != std::string::npos) {
+            try {
+                prefix = std::stoi(cidr.substr(slash + 1));
+            } catch (const std::exception &) {
+                return false;
+            }
+        }
+        in_addr addr{};
+        if (prefix < 0 || prefix > 32 || inet_pton(AF_INET, ip.c_str(), &addr) != 1) {
+            return false;
+        }
+        const uint32_t mask = prefix == 0 ? 0 : ~0u << (32 - prefix);
+        subnets.push_back({ntohl(addr.s_addr) & mask, mask});
+        return true;
+    }
+
+    bool LocalTransport::isLocal(const sockaddr_in &addr) const {
+        const uint32_t ip = ntohl(addr.sin_addr.s_addr);
+        for (const Subnet &subnet : subnets) {
+            if ((ip & subnet.mask) == subnet.network) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    ErrorCode LocalTransport::sendPacket(const NegotiationPacket &packet, const sockaddr_in &addr) {
+        AllocScope allocScope(AllocTag::UDP);
+        // 目标路径与序列化缓冲区均为线程局部，稳态下不分配
+        static thread_local std::string path;
+        static thread_local std::vector<uint8_t> buffer;
+        path = socketPath(dir, addr);
+        sockaddr_un target{};
+        if (sockfd == -1 || !toUnixAddr(path, target)) {
+            return ErrorCode::SOCKET_ERROR;
+        }
+        buffer.clear();
+        if (UdpSocket::serializePacket(packet, buffer) < 0) {
+            return ErrorCode::INVALID_PARAM;
+        }
+        std::lock_guard lock(sendMutex);
+        if (sendto(sockfd, buffer.data(), buffer.size(), 0, reinterpret_cast<sockaddr *>(&target),
+                   sizeof(target)) < 0) {
+            return ErrorCode::SOCKET_ERROR;
+        }
+        NEGOTIO_PROBE3(packet__sent, packet.header.sequence, static_cast<uint32_t>(packet.header.type),
+                       buffer.size());
+        return ErrorCode::SUCCESS;
+    }
+
+    ErrorCode LocalTransport::recvPacket(NegotiationPacket &packet, sockaddr_in &addr, const int timeout_ms) const {
+        AllocScope allocScope(AllocTag::UDP);
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(sockfd, &readfds);
+        timeval tv{};
+        tv.tv_sec = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        if (const int ret = select(sockfd + 1, &readfds, nullptr, nullptr, &tv); ret < 0) {
+            return ErrorCode::SOCKET_ERROR;
+        } else if (ret == 0) {
+            return ErrorCode::TIMEOUT;
+        }
+
+        static thread_local std::vector<uint8_t> buffer;
+        buffer.resize(4096);
+        sockaddr_un source{};
+        socklen_t sourceLen = sizeof(source);
+        const ssize_t received = recvfrom(sockfd, buffer.data(), buffer.size(), 0,
+                                          reinterpret_cast<sockaddr *>(&source), &sourceLen);
+        if (received == -1) {
+            return ErrorCode::SOCKET_ERROR;
+        }
+        // 未绑定路径的发送方无法回复，丢弃
+        const size_t pathLen = sourceLen > offsetof(sockaddr_un, sun_path)
+                                   ? strnlen(source.sun_path, sourceLen - offsetof(sockaddr_un, sun_path))
+                                   : 0;
+        if (!parseSocketPath(std::string(source.sun_path, pathLen), addr)) {
+            return ErrorCode::INVALID_PARAM;
+        }
+        buffer.resize(received);
+        if (UdpSocket::deserializePacket(buffer, packet) < 0) {
+            return ErrorCode::INVALID_PARAM;
+        }
+        NEGOTIO_PROBE3(packet__received, packet.header.sequence, static_cast<uint32_t>(packet.header.type),
+                       static_cast<size_t>(received));
+        return ErrorCode::SUCCESS;
+    }
+
+    std::string LocalTransport::socketPath(const std::string &socketDir, const sockaddr_in &addr) {
+        char ip[INET_ADDRSTRLEN] = {};
+        inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+        std::string path = socketDir;
+        path += '/';
+        path += PATH_PREFIX;
+        path += ip;
+        path += '-';
+        path += std::to_string(ntohs(addr.sin_port));
+        path += PATH_SUFFIX;
+        return path;
+    }
+
+    bool LocalTransport::parseSocketPath(const std::string &path, sockaddr_in &addr) {
+        const size_t nameStart = path.rfind('/') == std::string::npos ? 0 : path.rfind('/') + 1;
+        const std::string name = path.substr(nameStart);
+        constexpr size_t prefixLen = sizeof(PATH_PREFIX) - 1;
+        constexpr size_t suffixLen = sizeof(PATH_SUFFIX) - 1;
+        if (name.size() <= prefixLen + suffixLen || name.compare(0, prefixLen, PATH_PREFIX) != 0
+            || name.compare(name.size() - suffixLen, suffixLen, PATH_SUFFIX) != 0) {
+            return false;
+        }
+        const std::string body = name.substr(prefixLen, name.size() - prefixLen - suffixLen);
+        const size_t dash = body.rfind('-');
+        if (dash == std::string::npos) {
+            return false;
+        }
+        addr = {};
+        addr.sin_family = AF_INET;
+        if (inet_pton(AF_INET, body.substr(0, dash).c_str(), &addr.sin_addr) != 1) {
+            return false;
+        }
+        unsigned long port = 0;
+        try {
+            size_t used = 0;
+            port = std::stoul(body.substr(dash + 1), &used);
+            if (used != body.size() - dash - 1 || port > 0xFFFF) {
+                return false;
+            }
+        } catch (const std::exception &) {
+            return false;
+        }
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        return true;
+    }
+} // namespace negotio
@@ -0,0 +1,103 @@
+/**
+ * 同主机本地传输
+ *
+ * 同一主机上的 Negotio 实例（如各容器）之间的协商数据包改走 AF_UNIX SOCK_DGRAM，不经过 UDP/IP 协议栈。
+ * 每个实例在共享目录（容器间挂载同一卷）下绑定一个以自身地址命名的套接字：
+ *   <socket_dir>/negotio-<IPv4>-<端口>.sock
+ * 发送方按对端的 sockaddr_in 拼出目标路径；接收方从发送方绑定的路径还原出其 sockaddr_in，
+ * 因此协商器看到的对端地址与走 UDP 时完全相同，会话、票据、时延估计等按地址索引的状态无需区分传输方式。
+ *
+ * 是否走本地传输按对端地址类别选择：地址落在配置的本机网段（如 127.0.0.0/8、容器网桥网段）内时优先本地传输，
+ * 对端套接字不存在（对端未开启本地传输或不在本机）或其接收队列已满时由调用方回退到 UDP。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_LOCALTRANSPORT_H
+#define NEGOTIO_LOCALTRANSPORT_H
+
+#include "common.h"
+#include "../lockstat/lockstat.h"
+
+#include <cstdint>
+#include <netinet/in.h>
+#include <string>
+#include <vector>
+
+namespace negotio {
+    class LocalTransport {
+    public:
+        LocalTransport();
+
+        ~LocalTransport();
+
+        LocalTransport(const LocalTransport &) = delete;
+        LocalTransport &operator=(const LocalTransport &) = delete;
+
+        /**
+         * @brief 在共享目录下绑定本实例的本地套接字（已存在的同名套接字文件会被替换）
+         * @param socketDir 共享目录
+         * @param self 本实例对外的地址（对端用来访问本实例的 IP 与 UDP 端口）
+         * @return 成功返回 ErrorCode::SUCCESS, 否则返回 ErrorCode::SOCKET_ERROR
+         */
+        ErrorCode init(const std::string &socketDir, const sockaddr_in &self);
+
+        /**
+         * @brief 添加一个本机网段，地址落在其中的对端优先走本地传输
+         * @param cidr 如 "172.17.0.0/16"，不带前缀长度时按 /32 处理
+         * @return 格式错误返回 false
+         */
+        bool addLocalSubnet(const std::string &cidr);
+
+        /**
+         * @brief 对端地址是否属于本机网段
+         */
+        [[nodiscard]] bool isLocal(const sockaddr_in &addr) const;
+
+        /**
+         * @brief 通过本地套接字发送数据包
+         * @return 成功返回 ErrorCode::SUCCESS；对端套接字不存在或接收队列已满返回 ErrorCode::SOCKET_ERROR，调用方应回退到 UDP
+         */
+        ErrorCode sendPacket(const NegotiationPacket &packet, const sockaddr_in &addr);
+
+        /**
+         * @brief 接收数据包
+         * @param packet 输出参数，接到的数据包
+         * @param addr 输出参数，由发送方套接字路径还原的对端地址
+         * @param timeout_ms 超时时间，默认 10 毫秒
+         * @return 成功返回 ErrorCode::SUCCESS；发送方路径无法解析或数据包格式错误返回 ErrorCode::INVALID_PARAM
+         */
+        ErrorCode recvPacket(NegotiationPacket &packet, sockaddr_in &addr, int timeout_ms = 10) const;
+
+        [[nodiscard]] int getSocketFd() const { return sockfd; }
+
+        /**
+         * @brief 地址对应的本地套接字路径
+         */
+        static std::string socketPath(const std::string &socketDir, const sockaddr_in &addr);
+
+        /**
+         * @brief 由本地套接字路径还原地址
+         * @return 路径不是 negotio-<IPv4>-<端口>.sock 形式时返回 false
+         */
+        static bool parseSocketPath(const std::string &path, sockaddr_in &addr);
+
+    private:
+        // 本机网段，均为主机字节序
+        struct Subnet {
+            uint32_t network;
+            uint32_t mask;
+        };
+
+        int sockfd;
+        std::string dir;
+        std::string boundPath;
+        std::vector<Subnet> subnets;
+        InstrumentedMutex sendMutex{"LocalTransport::sendMutex"};
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_LOCALTRANSPORT_H
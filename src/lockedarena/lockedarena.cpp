@@ -0,0 +1,131 @@
+/**
+ * @file lockedarena.cpp
+ * @brief 锁定内存区实现
+ */
+
+#include "lockedarena.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace negotio {
+    namespace {
+        // 块大小所属的尺寸类：类 i 的块大小为 16 << i
+        size_t sizeClassOf(const size_t bytes) {
+            size_t cls = 0;
+            while ((LOCKED_ARENA_MIN_BLOCK << cls) < bytes) {
+                ++cls;
+            }
+            return cls;
+        }
+    }
+
+    LockedArena &LockedArena::instance() {
+        // 不析构：静态对象析构之后仍可能有容器归还内存
+        static auto *arena = new LockedArena();
+        return *arena;
+    }
+
+    bool LockedArena::init(const size_t capacityBytes) {
+        std::lock_guard lock(initMutex);
+        if (base.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t size = (std::max(capacityBytes, page) + page - 1) / page * page;
+        void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "锁定内存区映射失败: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        madvise(mapped, size, MADV_DONTDUMP);
+        // 按需锁定：只有实际触碰的页常驻，而不是一次性调入整个区域
+        if (mlock2(mapped, size, MLOCK_ONFAULT) == 0) {
+            locked.store(true, std::memory_order_relaxed);
+        } else {
+            std::cerr << "锁定内存区 mlock 失败（" << std::strerror(errno) << "），密钥与热表仍可能被换出" << std::endl;
+        }
+        capacity = size;
+        base.store(static_cast<uint8_t *>(mapped), std::memory_order_release);
+        return true;
+    }
+
+    void *LockedArena::allocate(const size_t bytes, const size_t alignment) {
+        uint8_t *const region = base.load(std::memory_order_acquire);
+        const size_t cls = sizeClassOf(std::max<size_t>(bytes, 1));
+        const size_t blockSize = LOCKED_ARENA_MIN_BLOCK << cls;
+        // 块按 min(块大小, 4 KB) 对齐，满足不了的对齐要求回退到堆
+        const size_t blockAlign = std::min<size_t>(blockSize, 4096);
+        if (!region) {
+            return heapAllocate(bytes, alignment);
+        }
+        if (blockSize > LOCKED_ARENA_MAX_BLOCK || alignment > blockAlign) {
+            fallbacks.fetch_add(1, std::memory_order_relaxed);
+            return heapAllocate(bytes, alignment);
+        }
+
+        SizeClass &sizeClass = classes[cls];
+        {
+            std::lock_guard lock(sizeClass.mtx);
+            if (FreeBlock *block = sizeClass.head) {
+                sizeClass.head = block->next;
+                block->next = nullptr;
+                usedBytes.fetch_add(blockSize, std::memory_order_relaxed);
+                return block;
+            }
+        }
+
+        size_t offset = bump.load(std::memory_order_relaxed);
+        size_t aligned;
+        do {
+            aligned = (offset + blockAlign - 1) & ~(blockAlign - 1);
+            if (aligned + blockSize > capacity) {
+                fallbacks.fetch_add(1, std::memory_order_relaxed);
+                return heapAllocate(bytes, alignment);
+            }
+        } while (!bump.compare_exchange_weak(offset, aligned + blockSize, std::memory_order_relaxed));
+        usedBytes.fetch_add(blockSize, std::memory_order_relaxed);
+        return region + aligned;
+    }
+
+    void LockedArena::deallocate(void *ptr, const size_t bytes, const size_t alignment) noexcept {
+        if (!ptr) {
+            return;
+        }
+        // 密钥材料不在空闲块与归还给堆的内存中残留
+        if (!contains(ptr)) {
+            secureWipe(ptr, bytes);
+            heapDeallocate(ptr, alignment);
+            return;
+        }
+        const size_t cls = sizeClassOf(std::max<size_t>(bytes, 1));
+        secureWipe(ptr, std::max<size_t>(bytes, sizeof(FreeBlock)));
+        auto *block = static_cast<FreeBlock *>(ptr);
+        SizeClass &sizeClass = classes[cls];
+        std::lock_guard lock(sizeClass.mtx);
+        block->next = sizeClass.head;
+        sizeClass.head = block;
+        usedBytes.fetch_sub(LOCKED_ARENA_MIN_BLOCK << cls, std::memory_order_relaxed);
+    }
+
+    void *LockedArena::heapAllocate(const size_t bytes, const size_t alignment) {
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return ::operator new(bytes, std::align_val_t(alignment));
+        }
+        return ::operator new(bytes);
+    }
+
+    void LockedArena::heapDeallocate(void *ptr, const size_t alignment) noexcept {
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(ptr, std::align_val_t(alignment));
+        } else {
+            ::operator delete(ptr);
+        }
+    }
+} // namespace negotio
@@ -0,0 +1,203 @@
+/**
+ * 锁定内存区
+ *
+ * mlockall(MCL_CURRENT | MCL_FUTURE) 会锁住进程触碰过的每一页，包括配置的 JSON DOM、线程栈与日志缓冲，
+ * 常驻内存因此远超真正需要常驻的部分。LockedArena 只为密钥材料与协商热路径上的表提供一块专用的锁定内存：
+ * - init 时 mmap 一段匿名内存并以 MLOCK_ONFAULT 锁定，页面在首次触碰时才调入并锁定，常驻量等于实际使用量；
+ * - 该区域标记为 MADV_DONTDUMP，密钥不会出现在 core 文件中，释放的块清零后才放回空闲链表；
+ * - 按 2 的幂划分尺寸类，每类一个空闲链表（各自加锁），空闲链表为空时从区域末尾原子地切分；
+ * - 未初始化时使用普通堆分配；区域用尽或请求过大时同样回退到堆（计入 getFallbacks），释放时按地址区分来源。
+ *
+ * 回退到堆的块释放时同样先清零；栈上或调用方持有的密钥副本用 secureWipe 清除。
+ *
+ * 区域在进程生命周期内不解除映射，init 每个进程只生效一次（多进程模式下由各工作进程分别调用，锁定不随 fork 继承）。
+ * 使用方式：容器使用 LockedAllocator / LockedMap，定长数组使用 makeLockedArray。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_LOCKEDARENA_H
+#define NEGOTIO_LOCKEDARENA_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace negotio {
+    constexpr size_t LOCKED_ARENA_MIN_BLOCK = 16;               ///< 最小块大小
+    constexpr size_t LOCKED_ARENA_MAX_BLOCK = 16 * 1024 * 1024; ///< 最大块大小，更大的请求回退到堆
+    constexpr size_t DEFAULT_LOCKED_ARENA_BYTES = 64 * 1024 * 1024;
+
+    /**
+     * @brief 清除可能含有密钥材料的内存，不会被编译器当作死存储优化掉
+     */
+    inline void secureWipe(void *ptr, const size_t bytes) noexcept {
+        explicit_bzero(ptr, bytes);
+    }
+
+    class LockedArena {
+    public:
+        static LockedArena &instance();
+
+        LockedArena(const LockedArena &) = delete;
+        LockedArena &operator=(const LockedArena &) = delete;
+
+        /**
+         * @brief 映射并锁定锁定内存区（每个进程只生效一次）
+         * @param capacityBytes 区域大小，按页向上取整
+         * @return 区域已映射（含此前已初始化）时返回 true；锁定失败（如 RLIMIT_MEMLOCK 不足）时区域仍可用，见 isLocked
+         */
+        bool init(size_t capacityBytes = DEFAULT_LOCKED_ARENA_BYTES);
+
+        /**
+         * @brief 分配一块内存，区域不可用时回退到 operator new
+         */
+        void *allocate(size_t bytes, size_t alignment);
+
+        /**
+         * @brief 释放 allocate 返回的内存，bytes 与 alignment 需与分配时一致
+         */
+        void deallocate(void *ptr, size_t bytes, size_t alignment) noexcept;
+
+        [[nodiscard]] bool contains(const void *ptr) const {
+            const auto address = reinterpret_cast<uintptr_t>(ptr);
+            const auto begin = reinterpret_cast<uintptr_t>(base.load(std::memory_order_acquire));
+            return begin != 0 && address >= begin && address < begin + capacity;
+        }
+
+        [[nodiscard]] bool isMapped() const {
+            return base.load(std::memory_order_acquire) != nullptr;
+        }
+
+        /**
+         * @brief 区域是否已锁定在内存中（mlock 成功）
+         */
+        [[nodiscard]] bool isLocked() const {
+            return locked.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] size_t getCapacity() const {
+            return capacity;
+        }
+
+        /**
+         * @brief 已切分出的字节数（高水位，即最多会被锁定的常驻量）
+         */
+        [[nodiscard]] size_t getReservedBytes() const {
+            return bump.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 当前已分配未释放的块的字节数（按块大小计）
+         */
+        [[nodiscard]] size_t getUsedBytes() const {
+            return usedBytes.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 区域已用尽或请求过大而回退到堆的分配次数（未初始化时的分配不计入）
+         */
+        [[nodiscard]] uint64_t getFallbacks() const {
+            return fallbacks.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr size_t SIZE_CLASSES = 21; ///< 16 B .. 16 MB
+
+        struct FreeBlock {
+            FreeBlock *next;
+        };
+
+        struct SizeClass {
+            std::mutex mtx;
+            FreeBlock *head = nullptr;
+        };
+
+        LockedArena() = default;
+
+        std::mutex initMutex;
+        std::atomic<uint8_t *> base{nullptr};
+        size_t capacity = 0;
+        std::atomic<bool> locked{false};
+        std::atomic<size_t> bump{0};
+        std::atomic<size_t> usedBytes{0};
+        std::atomic<uint64_t> fallbacks{0};
+        std::array<SizeClass, SIZE_CLASSES> classes;
+
+        static void *heapAllocate(size_t bytes, size_t alignment);
+
+        static void heapDeallocate(void *ptr, size_t alignment) noexcept;
+    };
+
+    /**
+     * @brief 从锁定内存区分配的 STL 分配器
+     */
+    template<typename T>
+    class LockedAllocator {
+    public:
+        using value_type = T;
+
+        LockedAllocator() noexcept = default;
+
+        template<typename U>
+        LockedAllocator(const LockedAllocator<U> &) noexcept {
+        }
+
+        T *allocate(const size_t n) {
+            return static_cast<T *>(LockedArena::instance().allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *ptr, const size_t n) noexcept {
+            LockedArena::instance().deallocate(ptr, n * sizeof(T), alignof(T));
+        }
+
+        template<typename U>
+        bool operator==(const LockedAllocator<U> &) const noexcept {
+            return true;
+        }
+
+        template<typename U>
+        bool operator!=(const LockedAllocator<U> &) const noexcept {
+            return false;
+        }
+    };
+
+    // 节点与桶数组均位于锁定内存区的哈希表
+    template<typename K, typename V>
+    using LockedMap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, LockedAllocator<std::pair<const K, V>>>;
+
+    // makeLockedArray 的删除器，析构元素并归还内存
+    template<typename T>
+    struct LockedArrayDeleter {
+        size_t count = 0;
+
+        void operator()(T *ptr) const noexcept {
+            std::destroy_n(ptr, count);
+            LockedArena::instance().deallocate(ptr, count * sizeof(T), alignof(T));
+        }
+    };
+
+    template<typename T>
+    using LockedArray = std::unique_ptr<T[], LockedArrayDeleter<T>>;
+
+    /**
+     * @brief 在锁定内存区分配 count 个值初始化的元素
+     */
+    template<typename T>
+    LockedArray<T> makeLockedArray(const size_t count) {
+        T *ptr = static_cast<T *>(LockedArena::instance().allocate(count * sizeof(T), alignof(T)));
+        std::uninitialized_value_construct_n(ptr, count);
+        return LockedArray<T>(ptr, LockedArrayDeleter<T>{count});
+    }
+} // namespace negotio
+
+#endif // NEGOTIO_LOCKEDARENA_H
@@ -0,0 +1,118 @@
+/**
+ * @file lockstat.cpp
+ * @brief 锁竞争统计实现
+ */
+
+#include "lockstat.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace negotio {
+    namespace {
+        // 锁位点登记表：固定大小，登记只发生在互斥锁构造时
+        std::array<LockSite, MAX_LOCK_SITES> sites;
+        std::atomic<size_t> siteCount{0};
+        std::mutex registryMutex;
+        LockSite overflowSite;
+
+        size_t bucketOf(uint64_t ns) {
+            if (ns == 0) {
+                return 0;
+            }
+            const size_t bucket = 63 - static_cast<size_t>(__builtin_clzll(ns));
+            return bucket < LOCK_WAIT_BUCKETS ? bucket : LOCK_WAIT_BUCKETS - 1;
+        }
+    }
+
+    uint64_t LockSiteStats::waitPercentileNs(const double quantile) const {
+        if (contended == 0) {
+            return 0;
+        }
+        const auto target = static_cast<uint64_t>(quantile * static_cast<double>(contended));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < LOCK_WAIT_BUCKETS; ++i) {
+            seen += waitHistogram[i];
+            if (seen > target) {
+                return 2ull << i;
+            }
+        }
+        return maxWaitNs;
+    }
+
+    void LockSite::recordWait(const uint64_t ns) {
+        contended.fetch_add(1, std::memory_order_relaxed);
+        waitNs.fetch_add(ns, std::memory_order_relaxed);
+        waitHistogram[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t currentMax = maxWaitNs.load(std::memory_order_relaxed);
+        while (ns > currentMax && !maxWaitNs.compare_exchange_weak(currentMax, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    LockSiteStats LockSite::snapshot() const {
+        LockSiteStats stats{};
+        stats.name = name ? name : "(overflow)";
+        stats.acquisitions = acquisitions.load(std::memory_order_relaxed);
+        stats.contended = contended.load(std::memory_order_relaxed);
+        stats.waitNs = waitNs.load(std::memory_order_relaxed);
+        stats.maxWaitNs = maxWaitNs.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < LOCK_WAIT_BUCKETS; ++i) {
+            stats.waitHistogram[i] = waitHistogram[i].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+    void LockSite::reset() {
+        acquisitions.store(0, std::memory_order_relaxed);
+        contended.store(0, std::memory_order_relaxed);
+        waitNs.store(0, std::memory_order_relaxed);
+        maxWaitNs.store(0, std::memory_order_relaxed);
+        for (auto &bucket : waitHistogram) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    LockSite *LockSite::get(const char *name) {
+        std::lock_guard lock(registryMutex);
+        const size_t count = siteCount.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) {
+            if (std::strcmp(sites[i].name, name) == 0) {
+                return &sites[i];
+            }
+        }
+        if (count == MAX_LOCK_SITES) {
+            return &overflowSite;
+        }
+        sites[count].name = name;
+        siteCount.store(count + 1, std::memory_order_release);
+        return &sites[count];
+    }
+
+#if NEGOTIO_LOCK_STATS
+    void InstrumentedMutex::lockContended() {
+        const auto waitStart = std::chrono::steady_clock::now();
+        mtx.lock();
+        const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - waitStart).count();
+        site->recordWait(static_cast<uint64_t>(waited));
+    }
+#endif
+
+    std::vector<LockSiteStats> getLockStats() {
+        std::vector<LockSiteStats> result;
+        const size_t count = siteCount.load(std::memory_order_acquire);
+        result.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            result.push_back(sites[i].snapshot());
+        }
+        return result;
+    }
+
+    void resetLockStats() {
+        const size_t count = siteCount.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            sites[i].reset();
+        }
+        overflowSite.reset();
+    }
+} // namespace negotio
@@ -0,0 +1,157 @@
+/**
+ * 锁竞争统计
+ *
+ * InstrumentedMutex 是 std::mutex 的薄包装，按“锁位点”（如 SessionBucket::mtx）汇总获取次数、
+ * 竞争次数与等待时间直方图。统计在编译期通过 NEGOTIO_LOCK_STATS 开启：
+ * - 开启时：无竞争路径只有一次 try_lock 与一次 relaxed 自增，仅在发生竞争时读取时钟；
+ * - 关闭时：所有方法直接转发到 std::mutex，不产生任何额外开销。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_LOCKSTAT_H
+#define NEGOTIO_LOCKSTAT_H
+
+// 锁统计开关: 0:关闭,1:开启（由 CMake 选项 NEGOTIO_LOCK_STATS 控制）
+#ifndef NEGOTIO_LOCK_STATS
+#define NEGOTIO_LOCK_STATS 0
+#endif
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace negotio {
+    constexpr size_t LOCK_WAIT_BUCKETS = 32; ///< 等待时间直方图桶数，第 i 桶覆盖 [2^i, 2^(i+1)) 纳秒
+    constexpr size_t MAX_LOCK_SITES = 64;    ///< 最多支持的锁位点数量
+
+    // 单个锁位点的统计快照
+    struct LockSiteStats {
+        std::string name;        ///< 锁位点名称
+        uint64_t acquisitions;   ///< 获取次数
+        uint64_t contended;      ///< 需要等待的获取次数
+        uint64_t waitNs;         ///< 累计等待时间（纳秒）
+        uint64_t maxWaitNs;      ///< 最长单次等待（纳秒）
+        std::array<uint64_t, LOCK_WAIT_BUCKETS> waitHistogram; ///< 等待时间直方图
+
+        /**
+         * @brief 根据直方图估算等待时间分位数（返回所在桶的上界）
+         * @param quantile 分位 [0, 1]
+         * @return 等待时间（纳秒），无竞争时返回 0
+         */
+        [[nodiscard]] uint64_t waitPercentileNs(double quantile) const;
+    };
+
+    /**
+     * @brief 锁位点：同名的所有互斥锁实例共享一组计数器
+     */
+    class LockSite {
+    public:
+        LockSite() = default;
+
+        void recordAcquire() {
+            acquisitions.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void recordWait(uint64_t ns);
+
+        [[nodiscard]] LockSiteStats snapshot() const;
+
+        void reset();
+
+        /**
+         * @brief 按名称查找锁位点，不存在时登记一个新位点
+         * @param name 锁位点名称（需为静态生命周期的字符串）
+         * @return 锁位点；位点数量超过 MAX_LOCK_SITES 时返回共享的溢出位点
+         */
+        static LockSite *get(const char *name);
+
+    private:
+        const char *name = nullptr;
+        std::atomic<uint64_t> acquisitions{0};
+        std::atomic<uint64_t> contended{0};
+        std::atomic<uint64_t> waitNs{0};
+        std::atomic<uint64_t> maxWaitNs{0};
+        std::array<std::atomic<uint64_t>, LOCK_WAIT_BUCKETS> waitHistogram{};
+    };
+
+    /**
+     * @brief 带竞争统计的互斥锁，满足 Lockable 要求，可直接用于 std::lock_guard / std::unique_lock
+     */
+    class InstrumentedMutex {
+    public:
+        /**
+         * @param siteName 锁位点名称，例如 "SessionBucket::mtx"
+         */
+        explicit InstrumentedMutex(const char *siteName)
+#if NEGOTIO_LOCK_STATS
+            : site(LockSite::get(siteName))
+#endif
+        {
+            (void) siteName;
+        }
+
+        InstrumentedMutex(const InstrumentedMutex &) = delete;
+        InstrumentedMutex &operator=(const InstrumentedMutex &) = delete;
+
+        void lock() {
+#if NEGOTIO_LOCK_STATS
+            site->recordAcquire();
+            if (!mtx.try_lock()) {
+                lockContended();
+            }
+#else
+            mtx.lock();
+#endif
+        }
+
+        bool try_lock() {
+#if NEGOTIO_LOCK_STATS
+            const bool locked = mtx.try_lock();
+            if (locked) {
+                site->recordAcquire();
+            }
+            return locked;
+#else
+            return mtx.try_lock();
+#endif
+        }
+
+        void unlock() {
+            mtx.unlock();
+        }
+
+    private:
+        std::mutex mtx;
+#if NEGOTIO_LOCK_STATS
+        LockSite *site;
+
+        void lockContended();
+#endif
+    };
+
+    /**
+     * @brief 获取所有锁位点的统计快照
+     */
+    std::vector<LockSiteStats> getLockStats();
+
+    /**
+     * @brief 清零所有锁位点的统计
+     */
+    void resetLockStats();
+
+    /**
+     * @brief 锁统计是否在编译期开启
+     */
+    constexpr bool lockStatsEnabled() {
+        return NEGOTIO_LOCK_STATS != 0;
+    }
+} // namespace negotio
+
+#endif // NEGOTIO_LOCKSTAT_H
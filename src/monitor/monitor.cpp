@@ -4,8 +4,15 @@
  */
 
 #include "monitor.h"
+#include "../lockstat/lockstat.h"
+#include "../allocstat/allocstat.h"
+#include "../concurrency/concurrency.h"
+#include "../lockedarena/lockedarena.h"
+#include "../batching/batching.h"
+#include <algorithm>
 #include <iostream>
 #include <chrono>
+#include <cstring>
 #include <thread>
 
 namespace negotio {
@@ -38,14 +45,58 @@ namespace negotio {
         if (success) {
             ++successfulNegotiations;
             totalLatencyMs += durationMs;
+            latencyHistogram[latencyBucketOf(durationMs)].fetch_add(1, std::memory_order_relaxed);
         }
     }
 
+    void Monitor::recordOneWayDelay(const uint32_t delayMs) {
+        oneWayDelaySamples.fetch_add(1, std::memory_order_relaxed);
+        oneWayDelayTotalMs.fetch_add(delayMs, std::memory_order_relaxed);
+        oneWayDelayHistogram[latencyBucketOf(delayMs)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Monitor::recordStalePacket() {
+        stalePackets.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Monitor::setBootstrapProgress(const uint32_t total, const uint32_t started, const uint32_t completed) {
+        bootstrapTotal = total;
+        bootstrapStarted = started;
+        bootstrapCompleted = completed;
+    }
+
+    void Monitor::setConcurrencyLimiter(const ConcurrencyLimiter *limiter) {
+        concurrencyLimiter = limiter;
+    }
+
+    bool Monitor::enableStatsFile(const std::string &path, const uint32_t intervalMs) {
+        auto writer = std::make_unique<StatsFileWriter>();
+        if (!writer->open(path)) {
+            return false;
+        }
+        statsFile = std::move(writer);
+        statsIntervalMs = std::clamp<uint32_t>(intervalMs, 1, 1000);
+        return true;
+    }
+
+    void Monitor::addBatcher(const std::string &name, const AdaptiveBatcher *batcher) {
+        batchers.emplace_back(name, batcher);
+    }
+
     // 移除 const 限定符，以便修改 logFile
     void Monitor::monitorLoop() {
         using namespace std::chrono_literals;
+        AllocScope allocScope(AllocTag::MONITOR);
+        // 统计文件按 statsIntervalMs 发布，日志仍每秒写一次
+        auto nextLog = std::chrono::steady_clock::now() + 1s;
         while (running) {
-            std::this_thread::sleep_for(1s);
+            std::this_thread::sleep_for(statsFile ? std::chrono::milliseconds(statsIntervalMs)
+                                                  : std::chrono::milliseconds(1s));
+            publishStats();
+            if (std::chrono::steady_clock::now() < nextLog) {
+                continue;
+            }
+            nextLog += 1s;
             uint32_t total = totalNegotiations.load();
             uint32_t success = successfulNegotiations.load();
             uint32_t latency = totalLatencyMs.load();
@@ -60,8 +111,46 @@ namespace negotio {
                     logFile << "监控统计: 总协商数: " << total
                             << ", 尚无成功协商数据" << std::endl;
                 }
+                if (const uint32_t bootTotal = bootstrapTotal.load(); bootTotal > 0) {
+                    logFile << "启动策略引导: 已完成 " << bootstrapCompleted.load() << "/" << bootTotal
+                            << ", 已发起 " << bootstrapStarted.load() << std::endl;
+                }
+                if (const uint64_t samples = oneWayDelaySamples.load(); samples > 0) {
+                    logFile << "单向时延估计: 平均排队时延: "
+                            << static_cast<double>(oneWayDelayTotalMs.load()) / samples << " ms"
+                            << ", 过期丢弃: " << stalePackets.load() << std::endl;
+                }
+                if (concurrencyLimiter) {
+                    logFile << "并发限制: 上限: " << concurrencyLimiter->getLimit()
+                            << ", 在途: " << concurrencyLimiter->getInFlight()
+                            << ", 拒绝: " << concurrencyLimiter->getRejected();
+                    if (const uint32_t windowMs = concurrencyLimiter->getWindowLatencyMs();
+                        windowMs == ConcurrencyLimiter::TIMED_OUT) {
+                        logFile << ", 窗口 p90: 超时";
+                    } else {
+                        logFile << ", 窗口 p90: " << windowMs << " ms";
+                    }
+                    logFile << " (目标 " << concurrencyLimiter->getTargetLatencyMs() << " ms)" << std::endl;
+                }
+                if (const LockedArena &arena = LockedArena::instance(); arena.isMapped()) {
+                    logFile << "锁定内存区: 使用中: " << arena.getUsedBytes() / 1024 << " KB"
+                            << ", 已切分: " << arena.getReservedBytes() / 1024 << " KB"
+                            << ", 容量: " << arena.getCapacity() / (1024 * 1024) << " MB"
+                            << ", 回退堆分配: " << arena.getFallbacks()
+                            << (arena.isLocked() ? "" : ", 未锁定") << std::endl;
+                }
+                if (!batchers.empty()) {
+                    logFile << "批大小:";
+                    for (const auto &[name, batcher] : batchers) {
+                        logFile << " " << name << "=" << batcher->getBatchSize()
+                                << "(" << batcher->getDeadlineUs() << " us)";
+                    }
+                    logFile << std::endl;
+                }
                 logFile.flush();
             }
+            logLockStats();
+            logAllocStats(total);
 #ifdef DEBUG
             std::cout << "调试日志: 总协商数: " << total
                       << ", 成功协商数: " << success
@@ -69,4 +158,90 @@ namespace negotio {
 #endif
         }
     }
+
+    void Monitor::publishStats() {
+        if (!statsFile) {
+            return;
+        }
+        // 快照约 6 KB，放在线程局部存储中避免监控线程栈上的大对象与重复分配
+        static thread_local StatsPayload snapshot;
+        std::memset(&snapshot, 0, sizeof(snapshot));
+        snapshot.updateTimeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        snapshot.totalNegotiations = totalNegotiations.load();
+        snapshot.successfulNegotiations = successfulNegotiations.load();
+        snapshot.totalLatencyMs = totalLatencyMs.load();
+        snapshot.bootstrapTotal = bootstrapTotal.load();
+        snapshot.bootstrapStarted = bootstrapStarted.load();
+        snapshot.bootstrapCompleted = bootstrapCompleted.load();
+        snapshot.stalePackets = stalePackets.load(std::memory_order_relaxed);
+        if (concurrencyLimiter) {
+            snapshot.concurrencyLimit = concurrencyLimiter->getLimit();
+            snapshot.concurrencyInFlight = concurrencyLimiter->getInFlight();
+            snapshot.concurrencyWindowMs = concurrencyLimiter->getWindowLatencyMs();
+            snapshot.concurrencyTargetMs = concurrencyLimiter->getTargetLatencyMs();
+            snapshot.admissionRejected = concurrencyLimiter->getRejected();
+        }
+        for (size_t i = 0; i < STATS_LATENCY_BUCKETS; ++i) {
+            snapshot.latencyHistogram[i] = latencyHistogram[i].load(std::memory_order_relaxed);
+            snapshot.oneWayDelayHistogram[i] = oneWayDelayHistogram[i].load(std::memory_order_relaxed);
+        }
+        if (lockStatsEnabled()) {
+            for (const auto &site : getLockStats()) {
+                if (snapshot.lockSiteCount == STATS_MAX_LOCK_SITES) {
+                    break;
+                }
+                StatsLockSite &out = snapshot.lockSites[snapshot.lockSiteCount++];
+                std::strncpy(out.name, site.name.c_str(), STATS_NAME_LEN - 1);
+                out.acquisitions = site.acquisitions;
+                out.contended = site.contended;
+                out.waitNs = site.waitNs;
+                out.maxWaitNs = site.maxWaitNs;
+                std::copy(site.waitHistogram.begin(), site.waitHistogram.end(), out.waitHistogram);
+            }
+        }
+        if (allocStatsEnabled()) {
+            const auto byTag = getAllocStatsByTag();
+            snapshot.allocTagCount = ALLOC_TAG_COUNT;
+            std::copy(byTag.begin(), byTag.end(), snapshot.allocByTag);
+        }
+        statsFile->publish(snapshot);
+    }
+
+    void Monitor::logLockStats() {
+        if (!lockStatsEnabled() || !logFile.is_open()) {
+            return;
+        }
+        // 仅输出发生过竞争的锁位点，按累计等待时间给出 p99 估计
+        for (const auto &site : getLockStats()) {
+            if (site.contended == 0) {
+                continue;
+            }
+            logFile << "锁统计: " << site.name
+                    << ", 获取次数: " << site.acquisitions
+                    << ", 竞争次数: " << site.contended
+                    << ", 累计等待: " << site.waitNs / 1000 << " us"
+                    << ", 等待 p99: " << site.waitPercentileNs(0.99) / 1000 << " us"
+                    << ", 最长等待: " << site.maxWaitNs / 1000 << " us" << std::endl;
+        }
+    }
+
+    void Monitor::logAllocStats(const uint32_t total) {
+        if (!allocStatsEnabled() || !logFile.is_open()) {
+            return;
+        }
+        const auto byTag = getAllocStatsByTag();
+        logFile << "分配统计:";
+        for (size_t tag = 0; tag < ALLOC_TAG_COUNT; ++tag) {
+            logFile << " " << allocTagName(static_cast<AllocTag>(tag))
+                    << "=" << byTag[tag].allocations << "次/" << byTag[tag].bytes << "B";
+        }
+        // 每次协商的分配次数只统计协商热路径（协商处理 + UDP 收发）
+        const uint64_t hotPath = byTag[static_cast<size_t>(AllocTag::NEGOTIATE)].allocations
+                                 + byTag[static_cast<size_t>(AllocTag::UDP)].allocations;
+        if (total > 0) {
+            logFile << ", 每次协商分配: " << static_cast<double>(hotPath) / total;
+        }
+        logFile << std::endl;
+    }
 } // namespace negotio
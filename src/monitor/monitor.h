@@ -12,11 +12,20 @@
 #undef Monitor
 #endif
 
+#include "../statsfile/statsfile.h"
+
+#include <array>
 #include <atomic>
 #include <thread>
 #include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace negotio {
+    class ConcurrencyLimiter;
+    class AdaptiveBatcher;
 
     class Monitor {
     public:
@@ -40,6 +49,44 @@ namespace negotio {
          */
         void recordNegotiation(uint32_t durationMs, bool success);
 
+        /**
+         * @brief 记录一个数据包的单向排队时延估计（相对于该对端的基线，毫秒）
+         */
+        void recordOneWayDelay(uint32_t delayMs);
+
+        /**
+         * @brief 记录一个因排队时延超过协商超时而被丢弃的过期包
+         */
+        void recordStalePacket();
+
+        /**
+         * @brief 开启内存映射统计文件，需在 start() 之前调用
+         * @param path 统计文件路径
+         * @param intervalMs 发布间隔（毫秒），不大于日志间隔 1 秒
+         * @return 成功返回 true
+         */
+        bool enableStatsFile(const std::string &path, uint32_t intervalMs);
+
+        /**
+         * @brief 更新启动策略引导进度
+         * @param total 启动策略总数
+         * @param started 已发起协商数
+         * @param completed 已完成协商数
+         */
+        void setBootstrapProgress(uint32_t total, uint32_t started, uint32_t completed);
+
+        /**
+         * @brief 设置要报告的并发限制器，其当前上限、在途数与拒绝数随统计一起发布，需在 start() 之前调用
+         */
+        void setConcurrencyLimiter(const ConcurrencyLimiter *limiter);
+
+        /**
+         * @brief 添加要报告的批处理阶段，其当前批大小与刷新期限写入日志，需在 start() 之前调用
+         * @param name 阶段名（如 rx0）
+         * @param batcher 该阶段的批大小控制器，生命周期需长于 Monitor
+         */
+        void addBatcher(const std::string &name, const AdaptiveBatcher *batcher);
+
         std::ofstream logFile;
 
     private:
@@ -48,8 +95,36 @@ namespace negotio {
         std::atomic<uint32_t> totalNegotiations;
         std::atomic<uint32_t> successfulNegotiations;
         std::atomic<uint32_t> totalLatencyMs; // 累计延迟（毫秒）
+        std::array<std::atomic<uint64_t>, STATS_LATENCY_BUCKETS> latencyHistogram{}; // 成功协商耗时直方图
+        std::array<std::atomic<uint64_t>, STATS_LATENCY_BUCKETS> oneWayDelayHistogram{}; // 单向排队时延直方图
+        std::atomic<uint64_t> oneWayDelaySamples{0};
+        std::atomic<uint64_t> oneWayDelayTotalMs{0};
+        std::atomic<uint64_t> stalePackets{0};
+        std::atomic<uint32_t> bootstrapTotal{0};
+        std::atomic<uint32_t> bootstrapStarted{0};
+        std::atomic<uint32_t> bootstrapCompleted{0};
+        const ConcurrencyLimiter *concurrencyLimiter = nullptr;
+        std::vector<std::pair<std::string, const AdaptiveBatcher *>> batchers;
+        std::unique_ptr<StatsFileWriter> statsFile;
+        uint32_t statsIntervalMs = 1000;
 
         void monitorLoop();
+
+        /**
+         * @brief 将当前计数器、直方图、锁与分配统计发布到统计文件
+         */
+        void publishStats();
+
+        /**
+         * @brief 将发生过竞争的锁位点统计写入日志（需编译期开启 NEGOTIO_LOCK_STATS）
+         */
+        void logLockStats();
+
+        /**
+         * @brief 将各子系统的分配统计及每次协商的分配次数写入日志（需编译期开启 NEGOTIO_ALLOC_STATS）
+         * @param total 截至目前的协商总数
+         */
+        void logAllocStats(uint32_t total);
     };
 
 } // namespace negotio
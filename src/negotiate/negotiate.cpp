@@ -1,12 +1,40 @@
 #include "../monitor/monitor.h"
 #include "negotiate.h"
-#include "../hash/hash.h"
+#include "../allocstat/allocstat.h"
+#include "probes.h"
 #include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <arpa/inet.h>
+#include <algorithm>
 #include <cstring>
 #include <chrono>
 #include <iostream>
 
 namespace negotio {
+    namespace {
+        // 会话已存在时长（纳秒），作为探针的计时参数；未生成探针时探针宏不求值参数，该函数不被调用
+        [[maybe_unused]] uint64_t sessionAgeNs(const NegotiationSession &session, const std::chrono::steady_clock::time_point now) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(now - session.startTime).count();
+        }
+
+        // 包头时间戳使用的时钟：steady_clock 毫秒数截断为 32 位
+        uint32_t packetClockMs(const std::chrono::steady_clock::time_point t) {
+            return static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count());
+        }
+
+        bool samePeer(const sockaddr_in &a, const sockaddr_in &b) {
+            return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+        }
+
+        // 响应方等待 CONFIRM 期间收到 R1 不同的请求：发起方已超时并重新发起，旧会话作废
+        bool restartsNegotiation(const NegotiationSession &session, const NegotiationPacket &packet) {
+            return session.state == NegotiateState::WAIT_CONFIRM
+                   && packet.payload.size() * sizeof(uint32_t) >= RANDOM_NUMBER
+                   && std::memcmp(session.random1.data(), packet.payload.data(), RANDOM_NUMBER) != 0;
+        }
+    }
+
     Negotiator::Negotiator() : monitor(nullptr) {
     }
 
@@ -20,6 +48,319 @@ namespace negotio {
         udpSender = sender;
     }
 
+    void Negotiator::setQuiet(const bool enabled) {
+        quiet = enabled;
+    }
+
+    std::ostream &Negotiator::trace() const {
+        // 没有缓冲区的流写入时只置 badbit；每个线程一个，各线程修改的流状态互不干扰
+        static thread_local std::ostream discard(nullptr);
+        return quiet ? discard : std::cout;
+    }
+
+    void Negotiator::setResumption(const bool enabled, const uint32_t lifetimeS) {
+        resumptionEnabled = enabled;
+        ticketLifetimeS = lifetimeS;
+    }
+
+    bool Negotiator::hasResumptionTicket(const uint32_t policy_id) {
+        const size_t idx = bucketIndex(policy_id);
+        std::lock_guard lock(sessionBuckets[idx].mtx);
+        const auto it = sessionBuckets[idx].tickets.find(policy_id);
+        return it != sessionBuckets[idx].tickets.end() && std::chrono::steady_clock::now() < it->second.expiresAt;
+    }
+
+    void Negotiator::setImplicitConfirm(const bool enabled) {
+        implicitConfirm = enabled;
+    }
+
+    void Negotiator::setStaleThreshold(const uint32_t timeoutMs) {
+        staleThresholdMs = timeoutMs;
+    }
+
+    void Negotiator::setSharedTable(SharedSessionTable *table) {
+        sharedTable = table;
+    }
+
+    void Negotiator::setConcurrencyLimiter(ConcurrencyLimiter *concurrencyLimiter, const size_t maxDeferredStarts) {
+        limiter = concurrencyLimiter;
+        maxDeferred = maxDeferredStarts;
+    }
+
+    size_t Negotiator::getDeferredCount() {
+        std::lock_guard lock(deferredMutex);
+        return deferred.size();
+    }
+
+    bool Negotiator::isNegotiating(const uint32_t policy_id) {
+        const size_t idx = bucketIndex(policy_id);
+        if (sessionBuckets[idx].inFlight.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard lock(sessionBuckets[idx].mtx);
+            if (sessionBuckets[idx].sessions.find(policy_id) != sessionBuckets[idx].sessions.end()) {
+                return true;
+            }
+        }
+        std::lock_guard lock(deferredMutex);
+        return deferredIds.contains(policy_id);
+    }
+
+    void Negotiator::putSession(SessionBucket &bucket, const NegotiationSession &session) const {
+        if (const auto it = bucket.sessions.find(session.policy_id); it != bucket.sessions.end()) {
+            if (limiter && it->second.admitted) {
+                limiter->cancel();
+            }
+            it->second = session;
+        } else if (!bucket.spareNode.empty()) {
+            bucket.spareNode.key() = session.policy_id;
+            bucket.spareNode.mapped() = session;
+            bucket.sessions.insert(std::move(bucket.spareNode));
+        } else {
+            bucket.sessions.emplace(session.policy_id, session);
+        }
+        bucket.inFlight.store(bucket.sessions.size(), std::memory_order_relaxed);
+    }
+
+    SessionMap::iterator Negotiator::retireSession(SessionBucket &bucket, const SessionMap::iterator it,
+                                                   const SessionEnd end,
+                                                   const std::chrono::steady_clock::time_point now) const {
+        if (limiter && it->second.admitted) {
+            switch (end) {
+                case SessionEnd::DONE:
+                    limiter->release(static_cast<uint32_t>(
+                        std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second.startTime).count()));
+                    break;
+                case SessionEnd::EXPIRED:
+                    limiter->releaseTimedOut();
+                    break;
+                case SessionEnd::CANCELLED:
+                    limiter->cancel();
+                    break;
+            }
+        }
+        const auto next = std::next(it);
+        bucket.spareNode = bucket.sessions.extract(it);
+        bucket.spareNode.mapped().wipe();
+        bucket.inFlight.store(bucket.sessions.size(), std::memory_order_relaxed);
+        return next;
+    }
+
+    ErrorCode Negotiator::deferNegotiation(const uint32_t policy_id, const sockaddr_in &peerAddr,
+                                           const RetryBudget &retry) {
+        std::lock_guard lock(deferredMutex);
+        if (deferredIds.contains(policy_id)) {
+            return ErrorCode::SUCCESS;
+        }
+        if (deferred.size() >= maxDeferred) {
+            std::cerr << "并发上限已满且延后队列已满，放弃发起协商, policy_id = " << policy_id << std::endl;
+            return ErrorCode::NEGOTIATION_FAILED;
+        }
+        deferred.push_back(DeferredStart{policy_id, peerAddr, retry});
+        deferredIds.insert(policy_id);
+        trace() << "[TRACE] 并发上限已满，延后发起协商, policy_id = " << policy_id << std::endl;
+        return ErrorCode::SUCCESS;
+    }
+
+    size_t Negotiator::expireSessions(const uint32_t timeoutMs) {
+        const auto now = std::chrono::steady_clock::now();
+        size_t expired = 0;
+        std::vector<DeferredStart> retries; // 超时后重新发起的本端协商，释放桶锁后发起
+        for (auto &bucket : sessionBuckets) {
+            if (bucket.inFlight.load(std::memory_order_relaxed) == 0) {
+                continue;
+            }
+            std::lock_guard lock(bucket.mtx);
+            for (auto it = bucket.sessions.begin(); it != bucket.sessions.end();) {
+                const NegotiationSession &session = it->second;
+                const uint32_t sessionTimeoutMs = session.retry.timeoutMs != 0 ? session.retry.timeoutMs : timeoutMs;
+                if (now - session.startTime < std::chrono::milliseconds(sessionTimeoutMs)) {
+                    ++it;
+                    continue;
+                }
+                const uint32_t policy_id = it->first;
+                NEGOTIO_PROBE3(negotiation__failed, policy_id, 0, static_cast<int>(ErrorCode::TIMEOUT));
+                if (monitor) {
+                    monitor->recordNegotiation(sessionTimeoutMs, false);
+                }
+                // 本端发起的协商（对端丢弃了请求或应答丢失）在重试次数内重新发起
+                if (session.state == NegotiateState::WAIT_R2 && session.retry.retries > 0) {
+                    retries.push_back(DeferredStart{policy_id, session.peerAddr,
+                                                    RetryBudget{session.retry.timeoutMs, session.retry.retries - 1}});
+                    trace() << "[TRACE] 协商超时, 重新发起, policy_id = " << policy_id
+                              << ", 剩余重试 = " << session.retry.retries - 1 << std::endl;
+                } else {
+                    trace() << "[TRACE] 协商超时, policy_id = " << policy_id << std::endl;
+                }
+                it = retireSession(bucket, it, SessionEnd::EXPIRED, now);
+                ++expired;
+            }
+        }
+        for (const DeferredStart &retry : retries) {
+            launchNegotiation(retry.policy_id, retry.peerAddr, retry.retry);
+        }
+
+        // 有空闲名额时按到达顺序发起延后的协商；名额被并发抢占时 startNegotiation 会重新排到队尾
+        while (limiter) {
+            DeferredStart next{};
+            {
+                std::lock_guard lock(deferredMutex);
+                if (deferred.empty() || limiter->getInFlight() >= limiter->getLimit()) {
+                    break;
+                }
+                next = deferred.front();
+                deferred.pop_front();
+                deferredIds.erase(next.policy_id);
+            }
+            launchNegotiation(next.policy_id, next.peerAddr, next.retry);
+        }
+        return expired;
+    }
+
+    void Negotiator::restoreSession(const ColdSession &session) {
+        const size_t idx = bucketIndex(session.policy_id);
+        std::lock_guard lock(sessionBuckets[idx].mtx);
+        sessionBuckets[idx].established.restore(session);
+    }
+
+    uint32_t Negotiator::establish(SessionBucket &bucket, const uint32_t policy_id, const SessionKey &key,
+                                   const bool confirmed, const uint32_t ticketStamp) const {
+        bucket.pendingResponses.erase(policy_id);
+        const uint32_t epoch = bucket.established.upsert(policy_id, key, confirmed, ticketStamp);
+        if (sharedTable && !sharedTable->storeSession(policy_id, epoch, key, confirmed)) {
+            std::cerr << "共享会话表已满，policy_id = " << policy_id << " 的密钥不会在进程重启后恢复" << std::endl;
+        }
+        return epoch;
+    }
+
+    bool Negotiator::confirmEstablished(SessionBucket &bucket, const uint32_t policy_id) const {
+        if (!bucket.established.markConfirmed(policy_id)) {
+            return false;
+        }
+        bucket.pendingResponses.erase(policy_id);
+        if (sharedTable) {
+            sharedTable->markConfirmed(policy_id);
+        }
+        return true;
+    }
+
+    void Negotiator::setKeyBatchSize(const uint32_t size) {
+        keyBatchSize = std::clamp<uint32_t>(size, 1, MAX_KEY_BATCH);
+    }
+
+    uint32_t Negotiator::localCapabilities() const {
+        uint32_t caps = implicitConfirm ? NEGOTIATE_CAP_IMPLICIT_CONFIRM : 0;
+        if (keyBatchSize > 1) {
+            caps |= NEGOTIATE_CAP_KEY_BATCH | keyBatchSize << 16;
+        }
+        return caps;
+    }
+
+    uint32_t Negotiator::acceptCapabilities(const uint32_t offered) const {
+        uint32_t accepted = implicitConfirm ? offered & NEGOTIATE_CAP_IMPLICIT_CONFIRM : 0;
+        if (const uint32_t batch = std::min(capKeyBatchSize(offered), keyBatchSize); batch > 1) {
+            accepted |= NEGOTIATE_CAP_KEY_BATCH | batch << 16;
+        }
+        return accepted;
+    }
+
+    void Negotiator::storeKeyBatch(SessionBucket &bucket, const uint32_t policy_id, const SessionKey &key,
+                                   const uint32_t size) {
+        if (size <= 1) {
+            bucket.keyBatches.erase(policy_id);
+            return;
+        }
+        KeyBatch &batch = bucket.keyBatches[policy_id];
+        batch.prk = extractKeyBatchSecret(key);
+        batch.size = size;
+        batch.next = 1;
+    }
+
+    ErrorCode Negotiator::rotateKey(const uint32_t policy_id) {
+        AllocScope allocScope(AllocTag::NEGOTIATE);
+        const size_t idx = bucketIndex(policy_id);
+        std::lock_guard lock(sessionBuckets[idx].mtx);
+        const auto it = sessionBuckets[idx].keyBatches.find(policy_id);
+        if (it == sessionBuckets[idx].keyBatches.end() || it->second.next >= it->second.size) {
+            return ErrorCode::NEGOTIATION_FAILED;
+        }
+        KeyBatch &batch = it->second;
+        SessionKey key = deriveBatchKey(batch.prk, policy_id, batch.next++);
+        // 批次密钥由协商密钥派生，为协商密钥签发的票据继续有效
+        const uint32_t epoch = establish(sessionBuckets[idx], policy_id, key, true,
+                                         sessionBuckets[idx].established.ticketStamp(policy_id));
+        secureWipe(key.data(), key.size());
+        trace() << "[TRACE] 本地轮换密钥, policy_id = " << policy_id << ", 纪元 = " << epoch
+                  << ", 批次剩余 = " << batch.size - batch.next << std::endl;
+        if (batch.next >= batch.size) {
+            sessionBuckets[idx].keyBatches.erase(it);
+        }
+        return ErrorCode::SUCCESS;
+    }
+
+    ErrorCode Negotiator::rekey(const uint32_t policy_id, const sockaddr_in &peerAddr) {
+        if (rotateKey(policy_id) == ErrorCode::SUCCESS) {
+            return ErrorCode::SUCCESS;
+        }
+        return startNegotiation(policy_id, peerAddr);
+    }
+
+    uint32_t Negotiator::remainingBatchKeys(const uint32_t policy_id) {
+        const size_t idx = bucketIndex(policy_id);
+        std::lock_guard lock(sessionBuckets[idx].mtx);
+        const auto it = sessionBuckets[idx].keyBatches.find(policy_id);
+        return it == sessionBuckets[idx].keyBatches.end() ? 0 : it->second.size - it->second.next;
+    }
+
+    bool Negotiator::confirmKey(const uint32_t policy_id) {
+        const size_t idx = bucketIndex(policy_id);
+        std::lock_guard lock(sessionBuckets[idx].mtx);
+        return confirmEstablished(sessionBuckets[idx], policy_id);
+    }
+
+    std::vector<uint8_t> Negotiator::responsePayload(const uint32_t policy_id, const SessionRandom &random2,
+                                                     const SessionKey &key, uint32_t &ticketStamp) const {
+        ResumptionTicket ticket{};
+        bool sealed = false;
+        ticketStamp = 0;
+        if (resumptionEnabled) {
+            ResumptionSecret secret = deriveResumptionSecret(key);
+            sealed = ticketSealer.seal(policy_id, secret, ticket, &ticketStamp);
+            secureWipe(secret.data(), secret.size());
+        }
+        if (!sealed) {
+            ticketStamp = 0;
+            return {random2.begin(), random2.end()};
+        }
+        std::vector<uint8_t> payload(RANDOM_NUMBER + TICKET_SIZE);
+        std::memcpy(payload.data(), random2.data(), RANDOM_NUMBER);
+        std::memcpy(payload.data() + RANDOM_NUMBER, ticket.data(), TICKET_SIZE);
+        return payload;
+    }
+
+    bool Negotiator::yieldToPeer(SessionBucket &bucket, const uint32_t policy_id,
+                                 const NegotiationPacket &packet) const {
+        const auto it = bucket.sessions.find(policy_id);
+        if (it == bucket.sessions.end() || it->second.state != NegotiateState::WAIT_R2
+            || packet.payload.size() * sizeof(uint32_t) < RANDOM_NUMBER
+            || std::memcmp(it->second.random1.data(), packet.payload.data(), RANDOM_NUMBER) >= 0) {
+            return false;
+        }
+        trace() << "[TRACE] 双方同时发起协商, 本端转为响应方, policy_id = " << policy_id << std::endl;
+        retireSession(bucket, it, SessionEnd::CANCELLED, std::chrono::steady_clock::now());
+        return true;
+    }
+
+    void Negotiator::storeTicket(SessionBucket &bucket, const NegotiationPacket &packet,
+                                 const SessionKey &key) const {
+        if (!resumptionEnabled || packet.payload.size() * sizeof(uint32_t) < RANDOM_NUMBER + TICKET_SIZE) {
+            return;
+        }
+        HeldTicket &held = bucket.tickets[packet.header.sequence];
+        std::memcpy(held.ticket.data(), reinterpret_cast<const uint8_t *>(packet.payload.data()) + RANDOM_NUMBER,
+                    TICKET_SIZE);
+        held.secret = deriveResumptionSecret(key);
+        held.expiresAt = std::chrono::steady_clock::now() + std::chrono::seconds(ticketLifetimeS);
+    }
+
     void Negotiator::sendAsync(const NegotiationPacket &packet, const sockaddr_in &peerAddr) const {
         std::thread([this, packet, peerAddr]() {
             if (udpSender) {
@@ -36,54 +377,108 @@ namespace negotio {
         return data;
     }
 
-    std::vector<uint8_t> Negotiator::computeKey(const std::vector<uint8_t> &random1,
-                                                const std::vector<uint8_t> &random2) {
-        std::vector<uint8_t> concat(RANDOM_NUMBER * 2);
-        std::memcpy(concat.data(), random1.data(), RANDOM_NUMBER);
-        std::memcpy(concat.data() + RANDOM_NUMBER, random2.data(), RANDOM_NUMBER);
-        return CalculateSHA256(concat);
+    SessionKey Negotiator::computeKey(const SessionRandom &random1, const SessionRandom &random2) {
+        uint8_t concat[RANDOM_NUMBER * 2];
+        std::memcpy(concat, random1.data(), RANDOM_NUMBER);
+        std::memcpy(concat + RANDOM_NUMBER, random2.data(), RANDOM_NUMBER);
+        SessionKey key{};
+        SHA256(concat, sizeof(concat), key.data());
+        secureWipe(concat, sizeof(concat));
+        return key;
     }
 
-    NegotiationPacket Negotiator::createPacket(PacketType type, uint32_t policy_id,
+    NegotiationPacket Negotiator::createPacket(const PacketType type, const uint32_t policy_id,
                                                const std::vector<uint8_t> &payloadData) {
+        return createPacket(type, policy_id, payloadData.data(), payloadData.size());
+    }
+
+    NegotiationPacket Negotiator::createPacket(const PacketType type, const uint32_t policy_id,
+                                               const uint8_t *payloadData, const size_t payloadBytes) {
         NegotiationPacket packet{};
         packet.header.magic = MAGIC_NUMBER;
         packet.header.type = type;
         packet.header.sequence = policy_id;
-        packet.header.timestamp = static_cast<uint32_t>(
-            std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now().time_since_epoch()
-            ).count()
-        );
-        packet.header.payload_len = payloadData.size() / sizeof(uint32_t);
-        if (!payloadData.empty()) {
+        packet.header.timestamp = packetClockMs(std::chrono::steady_clock::now());
+        packet.header.payload_len = payloadBytes / sizeof(uint32_t);
+        if (payloadBytes != 0) {
             packet.payload.resize(packet.header.payload_len);
-            std::memcpy(packet.payload.data(), payloadData.data(), payloadData.size());
+            std::memcpy(packet.payload.data(), payloadData, payloadBytes);
         }
         return packet;
     }
 
-    ErrorCode Negotiator::startNegotiation(uint32_t policy_id, const sockaddr_in &peerAddr) {
+    ErrorCode Negotiator::startNegotiation(const uint32_t policy_id, const sockaddr_in &peerAddr) {
+        return launchNegotiation(policy_id, peerAddr, RetryBudget{});
+    }
+
+    ErrorCode Negotiator::startNegotiation(const PolicyConfig &policy) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(policy.remote_port);
+        inet_pton(AF_INET, policy.remote_ip.c_str(), &addr.sin_addr);
+        return launchNegotiation(policy.policy_id, addr, RetryBudget{policy.timeout_ms, policy.retry_times});
+    }
+
+    ErrorCode Negotiator::launchNegotiation(const uint32_t policy_id, const sockaddr_in &peerAddr,
+                                            const RetryBudget &retry) {
+        AllocScope allocScope(AllocTag::NEGOTIATE);
         // 过滤无效的 policy_id
         if (policy_id == 0) {
-            std::cout << "[TRACE] 忽略无效 policy_id: 0 (startNegotiation)" << std::endl;
+            trace() << "[TRACE] 忽略无效 policy_id: 0 (startNegotiation)" << std::endl;
             return ErrorCode::INVALID_PARAM;
         }
+        if (limiter && !limiter->tryAcquire()) {
+            return deferNegotiation(policy_id, peerAddr, retry);
+        }
         NegotiationSession session;
         session.policy_id = policy_id;
         session.state = NegotiateState::WAIT_R2;
-        session.random1 = generateRandomData(RANDOM_NUMBER);
-        if (session.random1.empty()) return ErrorCode::MEMORY_ERROR;
+        session.peerAddr = peerAddr;
+        session.retry = retry;
+        session.admitted = limiter != nullptr;
+        if (RAND_bytes(session.random1.data(), RANDOM_NUMBER) != 1) {
+            if (limiter) {
+                limiter->cancel();
+            }
+            NEGOTIO_PROBE3(negotiation__failed, policy_id, static_cast<uint32_t>(PacketType::RANDOM1),
+                           static_cast<int>(ErrorCode::MEMORY_ERROR));
+            return ErrorCode::MEMORY_ERROR;
+        }
         session.startTime = std::chrono::steady_clock::now();
-        {
-            const size_t idx = bucketIndex(policy_id);
+        const size_t idx = bucketIndex(policy_id);
+
+        // 持有未过期的恢复票据时改发 RESUME：random1 后接票据，一个往返即可完成重新协商
+        std::optional<ResumptionTicket> ticket;
+        if (resumptionEnabled) {
             std::lock_guard lock(sessionBuckets[idx].mtx);
-            sessionBuckets[idx].sessions[policy_id] = session;
+            if (const auto it = sessionBuckets[idx].tickets.find(policy_id);
+                it != sessionBuckets[idx].tickets.end() && session.startTime < it->second.expiresAt) {
+                ticket = it->second.ticket;
+            }
         }
 
-        NegotiationPacket packet = createPacket(PacketType::RANDOM1, policy_id, session.random1);
+        // 负载在栈上拼接，数据包的负载是本次协商唯一的堆分配
+        NegotiationPacket packet;
+        uint8_t payload[RANDOM_NUMBER + TICKET_SIZE];
+        std::memcpy(payload, session.random1.data(), RANDOM_NUMBER);
+        if (ticket) {
+            std::memcpy(payload + RANDOM_NUMBER, ticket->data(), TICKET_SIZE);
+            packet = createPacket(PacketType::RESUME, policy_id, payload, RANDOM_NUMBER + TICKET_SIZE);
+        } else if (const uint32_t caps = localCapabilities(); caps != 0) {
+            std::memcpy(payload + RANDOM_NUMBER, &caps, sizeof(uint32_t));
+            packet = createPacket(PacketType::RANDOM1, policy_id, payload, RANDOM_NUMBER + sizeof(uint32_t));
+        } else {
+            packet = createPacket(PacketType::RANDOM1, policy_id, payload, RANDOM_NUMBER);
+        }
+        {
+            std::lock_guard lock(sessionBuckets[idx].mtx);
+            putSession(sessionBuckets[idx], session);
+        }
+        NEGOTIO_PROBE2(session__created, policy_id, 0);
+        NEGOTIO_PROBE4(state__change, policy_id, static_cast<int>(NegotiateState::INIT),
+                       static_cast<int>(NegotiateState::WAIT_R2), 0);
 
-        std::cout << "[TRACE] 发起协商: policy_id = " << policy_id << std::endl;
+        trace() << "[TRACE] 发起协商: policy_id = " << policy_id << std::endl;
 
         if (udpSender) {
             udpSender(packet, peerAddr);
@@ -91,99 +486,455 @@ namespace negotio {
         return ErrorCode::SUCCESS;
     }
 
+    std::optional<NegotiationSession> Negotiator::getSession(const uint32_t policy_id) {
+        const size_t idx = bucketIndex(policy_id);
+        // 桶内没有进行中的会话时无需加锁，直接读冷存储
+        if (sessionBuckets[idx].inFlight.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard lock(sessionBuckets[idx].mtx);
+            if (const auto it = sessionBuckets[idx].sessions.find(policy_id); it != sessionBuckets[idx].sessions.end()) {
+                return it->second;
+            }
+        }
+        // 会话只会从热表移入冷存储，释放锁后再读冷存储不会漏掉刚完成的协商
+        ColdSession cold{};
+        if (sessionBuckets[idx].established.read(policy_id, cold)) {
+            NegotiationSession session{};
+            session.policy_id = policy_id;
+            session.state = NegotiateState::DONE;
+            session.key = cold.key;
+            secureWipe(cold.key.data(), cold.key.size());
+            return session;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<ColdSession> Negotiator::getEstablishedKey(const uint32_t policy_id) const {
+        ColdSession cold{};
+        if (sessionBuckets[bucketIndex(policy_id)].established.read(policy_id, cold)) {
+            return cold;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<uint32_t> Negotiator::getKeyEpoch(const uint32_t policy_id) const {
+        ColdSession cold{};
+        if (!sessionBuckets[bucketIndex(policy_id)].established.read(policy_id, cold)) {
+            return std::nullopt;
+        }
+        secureWipe(cold.key.data(), cold.key.size());
+        return cold.epoch;
+    }
+
+    SessionTableStats Negotiator::getSessionTableStats() const {
+        SessionTableStats stats{0, 0, 0};
+        for (const auto &bucket : sessionBuckets) {
+            stats.hot += bucket.inFlight.load(std::memory_order_relaxed);
+            stats.cold += bucket.established.size();
+            stats.coldBytes += bucket.established.memoryBytes();
+        }
+        return stats;
+    }
+
+    void Negotiator::reserveSessions(const size_t expectedSessions) {
+        const size_t perBucket = expectedSessions / NUM_BUCKETS + 1;
+        for (auto &bucket : sessionBuckets) {
+            std::lock_guard lock(bucket.mtx);
+            bucket.sessions.reserve(perBucket);
+            bucket.established.reserve(perBucket);
+        }
+    }
+
+    ErrorCode Negotiator::respondFull(const uint32_t policy_id, const NegotiationPacket &packet,
+                                      const sockaddr_in &peerAddr, const std::chrono::steady_clock::time_point now) {
+        const size_t idx = bucketIndex(policy_id);
+        NegotiationSession session;
+        session.policy_id = policy_id;
+        session.state = NegotiateState::WAIT_CONFIRM;
+        session.startTime = now;
+        session.peerAddr = peerAddr;
+
+        if (packet.payload.size() * sizeof(uint32_t) < RANDOM_NUMBER) {
+            NEGOTIO_PROBE3(negotiation__failed, policy_id, static_cast<uint32_t>(packet.header.type),
+                           static_cast<int>(ErrorCode::INVALID_PARAM));
+            return ErrorCode::INVALID_PARAM;
+        }
+
+        // 发起方在 RANDOM1 中附带了能力字时，在 RANDOM2 末尾回应本端接受的能力
+        const bool offered = packet.header.type == PacketType::RANDOM1
+                             && packet.payload.size() * sizeof(uint32_t) >= RANDOM_NUMBER + sizeof(uint32_t);
+        const uint32_t accepted = offered ? acceptCapabilities(packet.payload[RANDOM_NUMBER / sizeof(uint32_t)]) : 0;
+        session.keyBatch = capKeyBatchSize(accepted);
+
+        // 三包流程需保留热表会话，超出并发上限时在计算密钥之前丢弃，按策略发起的对端会在超时后重新发起（见 expireSessions）
+        if (!(accepted & NEGOTIATE_CAP_IMPLICIT_CONFIRM) && limiter) {
+            if (!limiter->tryAcquire()) {
+                NEGOTIO_PROBE3(negotiation__failed, policy_id, static_cast<uint32_t>(packet.header.type),
+                               static_cast<int>(ErrorCode::NEGOTIATION_FAILED));
+                return ErrorCode::NEGOTIATION_FAILED;
+            }
+            session.admitted = true;
+        }
+
+        std::memcpy(session.random1.data(), packet.payload.data(), RANDOM_NUMBER);
+        if (RAND_bytes(session.random2.data(), RANDOM_NUMBER) != 1) {
+            if (session.admitted) {
+                limiter->cancel();
+            }
+            NEGOTIO_PROBE3(negotiation__failed, policy_id, static_cast<uint32_t>(packet.header.type),
+                           static_cast<int>(ErrorCode::MEMORY_ERROR));
+            return ErrorCode::MEMORY_ERROR;
+        }
+        session.key = computeKey(session.random1, session.random2);
+        NEGOTIO_PROBE2(key__computed, policy_id, sessionAgeNs(session, now));
+        std::vector<uint8_t> responseData;
+        if (udpSender) {
+            responseData = responsePayload(policy_id, session.random2, session.key, session.ticketStamp);
+            if (offered) {
+                const auto *cap = reinterpret_cast<const uint8_t *>(&accepted);
+                responseData.insert(responseData.end(), cap, cap + sizeof(uint32_t));
+            }
+        }
+
+        // 两包模式：发出 RANDOM2 即完成，不保留热表会话
+        if (accepted & NEGOTIATE_CAP_IMPLICIT_CONFIRM) {
+            NegotiationPacket response{};
+            if (udpSender) {
+                response = createPacket(PacketType::RANDOM2, policy_id, responseData);
+            }
+            {
+                std::lock_guard lock(sessionBuckets[idx].mtx);
+                if (sessionBuckets[idx].sessions.find(policy_id) != sessionBuckets[idx].sessions.end()) {
+                    return ErrorCode::SUCCESS;
+                }
+                establish(sessionBuckets[idx], policy_id, session.key, false, session.ticketStamp);
+                storeKeyBatch(sessionBuckets[idx], policy_id, session.key, session.keyBatch);
+                if (udpSender) {
+                    sessionBuckets[idx].pendingResponses.insert_or_assign(
+                        policy_id, PendingResponse{PacketType::RANDOM1, session.random1, std::move(responseData)});
+                }
+            }
+            NEGOTIO_PROBE4(state__change, policy_id, static_cast<int>(NegotiateState::INIT),
+                           static_cast<int>(NegotiateState::DONE), 0);
+            NEGOTIO_PROBE3(negotiation__done, policy_id, 1, 0);
+            if (monitor) {
+                monitor->recordNegotiation(0, true);
+                trace() << "[TRACE] responder 两包协商完成, policy_id = " << policy_id << std::endl;
+            }
+            if (udpSender) {
+                udpSender(response, peerAddr);
+            }
+            return ErrorCode::SUCCESS;
+        }
+
+        NegotiationPacket response{};
+        if (udpSender) {
+            response = createPacket(PacketType::RANDOM2, policy_id, responseData);
+        }
+        {
+            std::lock_guard lock(sessionBuckets[idx].mtx); // 锁住 sessionBuckets，更新会话信息
+            putSession(sessionBuckets[idx], session);
+        }
+        NEGOTIO_PROBE2(session__created, policy_id, 1);
+        NEGOTIO_PROBE4(state__change, policy_id, static_cast<int>(NegotiateState::INIT),
+                       static_cast<int>(NegotiateState::WAIT_CONFIRM), 0);
+
+        if (udpSender) {
+            udpSender(response, peerAddr);
+        }
+        return ErrorCode::SUCCESS;
+    }
+
     ErrorCode Negotiator::handlePacket(const NegotiationPacket &packet, const sockaddr_in &peerAddr) {
+        AllocScope allocScope(AllocTag::NEGOTIATE);
         const uint32_t policy_id = packet.header.sequence;
         // 过滤无效的 policy_id
         if (policy_id == 0) {
-            std::cout << "[TRACE] 忽略无效 policy_id: 0 (handlePacket)" << std::endl;
+            trace() << "[TRACE] 忽略无效 policy_id: 0 (handlePacket)" << std::endl;
             return ErrorCode::INVALID_PARAM;
         }
         const auto now = std::chrono::steady_clock::now();
         const size_t idx = bucketIndex(policy_id); // 缓存 sessionBuckets 索引
 
+        // 排队时延已超过协商超时的包所属的协商在发送方已经超时（按策略发起的会以新的随机数重新发起），
+        // 不做任何计算直接丢弃；时延基线只由与进行中的协商相符的包更新（见 PeerClockTracker::learn）
+        const uint32_t delayMs = peerClocks.observe(peerAddr, packet.header.timestamp, packetClockMs(now));
+        if (monitor) {
+            monitor->recordOneWayDelay(delayMs);
+        }
+        if (staleThresholdMs != 0 && delayMs > staleThresholdMs) {
+            NEGOTIO_PROBE3(packet__stale, policy_id, static_cast<uint32_t>(packet.header.type), delayMs);
+            if (monitor) {
+                monitor->recordStalePacket();
+            }
+            return ErrorCode::TIMEOUT;
+        }
+
         switch (packet.header.type) {
             case PacketType::RANDOM1: {
+                std::optional<NegotiationPacket> resend;
                 {
                     // 将锁定范围最小化，锁定后尽快释放
-                    std::lock_guard<std::mutex> lock(sessionBuckets[idx].mtx);
-                    if (sessionBuckets[idx].sessions.find(policy_id) != sessionBuckets[idx].sessions.end()) {
-                        // 已发起协商的发起方收到误发的 RANDOM1，忽略
-                        return ErrorCode::SUCCESS;
+                    std::lock_guard lock(sessionBuckets[idx].mtx);
+                    if (!yieldToPeer(sessionBuckets[idx], policy_id, packet)) {
+                        const auto hot = sessionBuckets[idx].sessions.find(policy_id);
+                        if (hot != sessionBuckets[idx].sessions.end() ? !restartsNegotiation(hot->second, packet)
+                                                                      : sessionBuckets[idx].established.contains(policy_id, true)) {
+                            // 同时发起且本端胜出、重传的 RANDOM1，或该策略已协商完成，忽略
+                            return ErrorCode::SUCCESS;
+                        }
+                        // 两包模式下密钥待确认：同一 R1 的重传说明 RANDOM2 丢失，原样重发，不重新派生密钥；
+                        // 不同的 R1 是发起方的新一轮协商，按完整协商应答
+                        const auto pending = sessionBuckets[idx].pendingResponses.find(policy_id);
+                        if (pending != sessionBuckets[idx].pendingResponses.end()
+                            && pending->second.request == PacketType::RANDOM1
+                            && packet.payload.size() * sizeof(uint32_t) >= RANDOM_NUMBER
+                            && std::memcmp(pending->second.random1.data(), packet.payload.data(), RANDOM_NUMBER) == 0) {
+                            resend = createPacket(PacketType::RANDOM2, policy_id, pending->second.response);
+                        }
                     }
                 }
+                if (resend) {
+                    trace() << "[TRACE] responder 收到重传的 RANDOM1, 重发 RANDOM2, policy_id = " << policy_id << std::endl;
+                    if (udpSender) {
+                        udpSender(*resend, peerAddr);
+                    }
+                    return ErrorCode::SUCCESS;
+                }
 
-                std::cout << "[TRACE] responder 收到 RANDOM1, 自动响应, policy_id = " << policy_id << std::endl;
-
-                NegotiationSession session;
-                session.policy_id = policy_id;
-                session.state = NegotiateState::WAIT_CONFIRM;
-                session.startTime = now;
+                trace() << "[TRACE] responder 收到 RANDOM1, 自动响应, policy_id = " << policy_id << std::endl;
+                return respondFull(policy_id, packet, peerAddr, now);
+            }
 
-                if (packet.payload.size() * sizeof(uint32_t) < RANDOM_NUMBER) {
+            case PacketType::RANDOM2: {
+                std::lock_guard lock(sessionBuckets[idx].mtx); // 锁住 sessionBuckets，处理 RANDOM2 包
+                auto it = sessionBuckets[idx].sessions.find(policy_id);
+                NegotiationSession *found = it == sessionBuckets[idx].sessions.end() ? nullptr : &it->second;
+                if (!found || found->state != NegotiateState::WAIT_R2
+                    || packet.payload.size() * sizeof(uint32_t) < RANDOM_NUMBER) {
+                    NEGOTIO_PROBE3(negotiation__failed, policy_id, static_cast<uint32_t>(PacketType::RANDOM2),
+                                   static_cast<int>(ErrorCode::INVALID_PARAM));
                     return ErrorCode::INVALID_PARAM;
                 }
 
-                session.random1.resize(RANDOM_NUMBER);
-                std::memcpy(session.random1.data(), packet.payload.data(), RANDOM_NUMBER);
-                session.random2 = generateRandomData(RANDOM_NUMBER);
+                NegotiationSession &session = *found;
+                if (samePeer(session.peerAddr, peerAddr)) {
+                    peerClocks.learn(peerAddr, packet.header.timestamp, packetClockMs(now));
+                }
+                std::memcpy(session.random2.data(), packet.payload.data(), RANDOM_NUMBER);
                 session.key = computeKey(session.random1, session.random2);
-                {
-                    std::lock_guard<std::mutex> lock(sessionBuckets[idx].mtx); // 锁住 sessionBuckets，更新会话信息
-                    sessionBuckets[idx].sessions[policy_id] = session;
+                NEGOTIO_PROBE2(key__computed, policy_id, sessionAgeNs(session, now));
+                session.state = NegotiateState::WAIT_CONFIRM;
+                NEGOTIO_PROBE4(state__change, policy_id, static_cast<int>(NegotiateState::WAIT_R2),
+                               static_cast<int>(NegotiateState::WAIT_CONFIRM), sessionAgeNs(session, now));
+
+                // RANDOM2 末尾的能力字：响应方回应了两包模式时省略 CONFIRM，批次大小以响应方接受的为准
+                const size_t payloadBytes = packet.payload.size() * sizeof(uint32_t);
+                const uint32_t acceptedCaps = payloadBytes == RANDOM_NUMBER + sizeof(uint32_t)
+                                              || payloadBytes == RANDOM_NUMBER + TICKET_SIZE + sizeof(uint32_t)
+                                                  ? packet.payload.back()
+                                                  : 0;
+                const bool implicitAck = implicitConfirm && (acceptedCaps & NEGOTIATE_CAP_IMPLICIT_CONFIRM);
+                if (udpSender && !implicitAck) {
+                    auto confirm = createPacket(PacketType::CONFIRM, policy_id, {});
+                    udpSender(confirm, peerAddr);
                 }
 
-                if (udpSender) {
-                    auto response = createPacket(PacketType::RANDOM2, policy_id, session.random2);
-                    udpSender(response, peerAddr);
+                session.state = NegotiateState::DONE;
+                NEGOTIO_PROBE4(state__change, policy_id, static_cast<int>(NegotiateState::WAIT_CONFIRM),
+                               static_cast<int>(NegotiateState::DONE), sessionAgeNs(session, now));
+                NEGOTIO_PROBE3(negotiation__done, policy_id, 0, sessionAgeNs(session, now));
+                if (monitor) {
+                    uint32_t duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - session.startTime).count();
+                    monitor->recordNegotiation(duration, true);
+                    trace() << "[TRACE] initiator 协商完成, 耗时: " << duration << "ms, policy_id = " << policy_id << std::endl;
                 }
 
+                // 协商完成：密钥移入冷存储，热表只保留进行中的会话
+                storeTicket(sessionBuckets[idx], packet, session.key);
+                storeKeyBatch(sessionBuckets[idx], policy_id, session.key,
+                              keyBatchSize > 1 ? capKeyBatchSize(acceptedCaps) : 1);
+                establish(sessionBuckets[idx], policy_id, session.key);
+                retireSession(sessionBuckets[idx], it, SessionEnd::DONE, now);
                 return ErrorCode::SUCCESS;
             }
 
-            case PacketType::RANDOM2: {
-                std::lock_guard<std::mutex> lock(sessionBuckets[idx].mtx); // 锁住 sessionBuckets，处理 RANDOM2 包
+            case PacketType::CONFIRM: {
+                std::lock_guard lock(sessionBuckets[idx].mtx); // 锁住 sessionBuckets，处理 CONFIRM 包
                 auto it = sessionBuckets[idx].sessions.find(policy_id);
-                if (it == sessionBuckets[idx].sessions.end()) return ErrorCode::INVALID_PARAM;
+                if (it == sessionBuckets[idx].sessions.end()) {
+                    if (sessionBuckets[idx].established.contains(policy_id)) {
+                        // 重复的 CONFIRM，会话已协商完成；两包模式下的待确认密钥就此确认
+                        confirmEstablished(sessionBuckets[idx], policy_id);
+                        return ErrorCode::SUCCESS;
+                    }
+                    NEGOTIO_PROBE3(negotiation__failed, policy_id, static_cast<uint32_t>(PacketType::CONFIRM),
+                                   static_cast<int>(ErrorCode::INVALID_PARAM));
+                    return ErrorCode::INVALID_PARAM;
+                }
 
                 NegotiationSession &session = it->second;
-                if (session.state != NegotiateState::WAIT_R2) return ErrorCode::INVALID_PARAM;
+                if (samePeer(session.peerAddr, peerAddr)) {
+                    peerClocks.learn(peerAddr, packet.header.timestamp, packetClockMs(now));
+                }
+                NEGOTIO_PROBE4(state__change, policy_id, static_cast<int>(session.state),
+                               static_cast<int>(NegotiateState::DONE), sessionAgeNs(session, now));
+                session.state = NegotiateState::DONE;
+                NEGOTIO_PROBE3(negotiation__done, policy_id, 1, sessionAgeNs(session, now));
 
-                if (packet.payload.size() * sizeof(uint32_t) < RANDOM_NUMBER) return ErrorCode::INVALID_PARAM;
+                if (monitor) {
+                    uint32_t duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - session.startTime).count();
+                    monitor->recordNegotiation(duration, true);
+                    trace() << "[TRACE] responder 协商完成, 耗时: " << duration << "ms, policy_id = " << policy_id << std::endl;
+                }
 
-                session.random2.resize(RANDOM_NUMBER);
-                std::memcpy(session.random2.data(), packet.payload.data(), RANDOM_NUMBER);
-                session.key = computeKey(session.random1, session.random2);
-                session.state = NegotiateState::WAIT_CONFIRM;
+                storeKeyBatch(sessionBuckets[idx], policy_id, session.key, session.keyBatch);
+                establish(sessionBuckets[idx], policy_id, session.key, true, session.ticketStamp);
+                retireSession(sessionBuckets[idx], it, SessionEnd::DONE, now);
+                return ErrorCode::SUCCESS;
+            }
 
-                if (udpSender) {
-                    auto confirm = createPacket(PacketType::CONFIRM, policy_id, {});
-                    udpSender(confirm, peerAddr);
+            case PacketType::RESUME: {
+                if (packet.payload.size() * sizeof(uint32_t) < RANDOM_NUMBER + TICKET_SIZE) {
+                    NEGOTIO_PROBE3(negotiation__failed, policy_id, static_cast<uint32_t>(PacketType::RESUME),
+                                   static_cast<int>(ErrorCode::INVALID_PARAM));
+                    return ErrorCode::INVALID_PARAM;
+                }
+                SessionRandom random1{};
+                std::memcpy(random1.data(), packet.payload.data(), RANDOM_NUMBER);
+                std::optional<NegotiationPacket> resend;
+                {
+                    std::lock_guard lock(sessionBuckets[idx].mtx);
+                    if (!yieldToPeer(sessionBuckets[idx], policy_id, packet)) {
+                        if (const auto hot = sessionBuckets[idx].sessions.find(policy_id);
+                            hot != sessionBuckets[idx].sessions.end() && !restartsNegotiation(hot->second, packet)) {
+                            // 同一策略已有进行中的协商（同时发起时本端胜出，或重传），忽略
+                            return ErrorCode::SUCCESS;
+                        }
+                    }
+                    // R1 相同的 RESUME 是 RESUME_ACK 丢失后的重传，原样重发，不重新派生密钥
+                    const auto pending = sessionBuckets[idx].pendingResponses.find(policy_id);
+                    if (pending != sessionBuckets[idx].pendingResponses.end()
+                        && pending->second.request == PacketType::RESUME
+                        && pending->second.random1 == random1) {
+                        resend = createPacket(PacketType::RESUME_ACK, policy_id, pending->second.response);
+                    }
+                }
+                if (resend) {
+                    trace() << "[TRACE] responder 收到重传的 RESUME, 重发 RESUME_ACK, policy_id = " << policy_id << std::endl;
+                    if (udpSender) {
+                        udpSender(*resend, peerAddr);
+                    }
+                    return ErrorCode::SUCCESS;
                 }
 
-                session.state = NegotiateState::DONE;
+                // 恢复密钥取自票据本身，票据序号再与已建立会话记录中的序号比对；无法解开时回退到完整协商
+                ResumptionSecret secret{};
+                uint32_t ticketStamp = 0;
+                const auto *ticket = reinterpret_cast<const uint8_t *>(packet.payload.data()) + RANDOM_NUMBER;
+                if (!resumptionEnabled || !ticketSealer.open(ticket, policy_id, ticketLifetimeS, secret, &ticketStamp)) {
+                    trace() << "[TRACE] responder 恢复票据无效, 回退完整协商, policy_id = " << policy_id << std::endl;
+                    return respondFull(policy_id, packet, peerAddr, now);
+                }
+
+                SessionRandom random2{};
+                if (RAND_bytes(random2.data(), RANDOM_NUMBER) != 1) {
+                    secureWipe(secret.data(), secret.size());
+                    NEGOTIO_PROBE3(negotiation__failed, policy_id, static_cast<uint32_t>(PacketType::RESUME),
+                                   static_cast<int>(ErrorCode::MEMORY_ERROR));
+                    return ErrorCode::MEMORY_ERROR;
+                }
+                SessionKey key = computeResumedKey(secret, random1, random2);
+                secureWipe(secret.data(), secret.size());
+                NEGOTIO_PROBE2(key__computed, policy_id, 0);
+                uint32_t issuedStamp = 0;
+                std::vector<uint8_t> responseData;
+                NegotiationPacket response{};
+                if (udpSender) {
+                    responseData = responsePayload(policy_id, random2, key, issuedStamp);
+                    response = createPacket(PacketType::RESUME_ACK, policy_id, responseData);
+                }
+                bool stored = false;
+                bool superseded = false;
+                {
+                    std::lock_guard lock(sessionBuckets[idx].mtx);
+                    if (const auto hot = sessionBuckets[idx].sessions.find(policy_id);
+                        hot != sessionBuckets[idx].sessions.end() && restartsNegotiation(hot->second, packet)) {
+                        // 发起方放弃了之前回退的完整协商，改用票据重新发起
+                        retireSession(sessionBuckets[idx], hot, SessionEnd::CANCELLED, now);
+                    }
+                    if (sessionBuckets[idx].sessions.find(policy_id) == sessionBuckets[idx].sessions.end()) {
+                        // 只接受为当前密钥签发的票据：已被使用过或已被更新的密钥取代的票据是重放
+                        superseded = sessionBuckets[idx].established.ticketStamp(policy_id) != ticketStamp;
+                        if (!superseded) {
+                            // 恢复得到的密钥不派生批次，旧批次随之作废；对端收到 RESUME_ACK 之前密钥待确认
+                            storeKeyBatch(sessionBuckets[idx], policy_id, key, 1);
+                            establish(sessionBuckets[idx], policy_id, key, false, issuedStamp);
+                            if (udpSender) {
+                                sessionBuckets[idx].pendingResponses.insert_or_assign(
+                                    policy_id, PendingResponse{PacketType::RESUME, random1, std::move(responseData)});
+                            }
+                            stored = true;
+                        }
+                    }
+                }
+                secureWipe(key.data(), key.size());
+                if (superseded) {
+                    trace() << "[TRACE] responder 恢复票据已被使用或已被取代, 回退完整协商, policy_id = " << policy_id << std::endl;
+                    NEGOTIO_PROBE3(negotiation__failed, policy_id, static_cast<uint32_t>(PacketType::RESUME),
+                                   static_cast<int>(ErrorCode::INVALID_PARAM));
+                    return respondFull(policy_id, packet, peerAddr, now);
+                }
+                if (!stored) {
+                    return ErrorCode::SUCCESS;
+                }
+                NEGOTIO_PROBE4(state__change, policy_id, static_cast<int>(NegotiateState::INIT),
+                               static_cast<int>(NegotiateState::DONE), 0);
+                NEGOTIO_PROBE3(negotiation__done, policy_id, 1, 0);
                 if (monitor) {
-                    uint32_t duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - session.startTime).count();
-                    monitor->recordNegotiation(duration, true);
-                    std::cout << "[TRACE] initiator 协商完成, 耗时: " << duration << "ms, policy_id = " << policy_id << std::endl;
+                    monitor->recordNegotiation(0, true);
+                    trace() << "[TRACE] responder 恢复协商完成, policy_id = " << policy_id << std::endl;
                 }
 
+                if (udpSender) {
+                    udpSender(response, peerAddr);
+                }
                 return ErrorCode::SUCCESS;
             }
 
-            case PacketType::CONFIRM: {
-                std::lock_guard<std::mutex> lock(sessionBuckets[idx].mtx); // 锁住 sessionBuckets，处理 CONFIRM 包
+            case PacketType::RESUME_ACK: {
+                std::lock_guard lock(sessionBuckets[idx].mtx);
                 auto it = sessionBuckets[idx].sessions.find(policy_id);
-                if (it == sessionBuckets[idx].sessions.end()) return ErrorCode::INVALID_PARAM;
+                const auto held = sessionBuckets[idx].tickets.find(policy_id);
+                if (it == sessionBuckets[idx].sessions.end() || it->second.state != NegotiateState::WAIT_R2
+                    || held == sessionBuckets[idx].tickets.end()
+                    || packet.payload.size() * sizeof(uint32_t) < RANDOM_NUMBER) {
+                    NEGOTIO_PROBE3(negotiation__failed, policy_id, static_cast<uint32_t>(PacketType::RESUME_ACK),
+                                   static_cast<int>(ErrorCode::INVALID_PARAM));
+                    return ErrorCode::INVALID_PARAM;
+                }
 
                 NegotiationSession &session = it->second;
+                if (samePeer(session.peerAddr, peerAddr)) {
+                    peerClocks.learn(peerAddr, packet.header.timestamp, packetClockMs(now));
+                }
+                std::memcpy(session.random2.data(), packet.payload.data(), RANDOM_NUMBER);
+                session.key = computeResumedKey(held->second.secret, session.random1, session.random2);
+                NEGOTIO_PROBE2(key__computed, policy_id, sessionAgeNs(session, now));
                 session.state = NegotiateState::DONE;
-
+                NEGOTIO_PROBE4(state__change, policy_id, static_cast<int>(NegotiateState::WAIT_R2),
+                               static_cast<int>(NegotiateState::DONE), sessionAgeNs(session, now));
+                NEGOTIO_PROBE3(negotiation__done, policy_id, 0, sessionAgeNs(session, now));
                 if (monitor) {
                     uint32_t duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - session.startTime).count();
                     monitor->recordNegotiation(duration, true);
-                    std::cout << "[TRACE] responder 协商完成, 耗时: " << duration << "ms, policy_id = " << policy_id << std::endl;
+                    trace() << "[TRACE] initiator 恢复协商完成, 耗时: " << duration << "ms, policy_id = " << policy_id << std::endl;
                 }
 
+                // 不需要 CONFIRM：响应方在回复 RESUME_ACK 时已完成
+                storeTicket(sessionBuckets[idx], packet, session.key);
+                storeKeyBatch(sessionBuckets[idx], policy_id, session.key, 1);
+                establish(sessionBuckets[idx], policy_id, session.key);
+                retireSession(sessionBuckets[idx], it, SessionEnd::DONE, now);
                 return ErrorCode::SUCCESS;
             }
 
@@ -9,14 +9,26 @@
 #define NEGOTIO_NEGOTIATE_H
 
 #include "common.h"
+#include "../lockstat/lockstat.h"
+#include "../sessionstore/sessionstore.h"
+#include "../ticket/ticket.h"
+#include "../keybatch/keybatch.h"
+#include "../peerclock/peerclock.h"
+#include "../sharedtable/sharedtable.h"
+#include "../concurrency/concurrency.h"
+#include "../lockedarena/lockedarena.h"
 #include <vector>
+#include <deque>
 #include <unordered_map>
+#include <unordered_set>
 #include <mutex>
 #include <optional>
 #include <chrono>
 #include <netinet/in.h>
 #include <array>
+#include <atomic>
 #include <functional>  // ✅ 新增
+#include <ostream>
 
 namespace negotio {
     // 协商状态定义
@@ -28,27 +40,112 @@ namespace negotio {
         FAILED
     };
 
+    // 本端发起的协商的超时与重试预算
+    struct RetryBudget {
+        uint32_t timeoutMs = 0; ///< 协商超时（毫秒），0 表示使用 expireSessions 的参数
+        uint32_t retries = 0;   ///< 超时后剩余的重新发起次数
+    };
+
     // 单个协商会话结构体
+    // 随机数与密钥内联存放：热表中的会话随节点位于锁定内存区，副本（如 getSession 的返回值）析构时清零
     struct NegotiationSession {
         uint32_t policy_id; ///< 策略ID，用作会话标识
         NegotiateState state; ///< 当前协商状态
-        std::vector<uint8_t> random1; ///< 发起方随机数 (32字节)
-        std::vector<uint8_t> random2; ///< 响应方随机数 (32字节)
-        std::vector<uint8_t> key; ///< 计算得到的共享密钥 (32字节)
+        SessionRandom random1{}; ///< 发起方随机数
+        SessionRandom random2{}; ///< 响应方随机数
+        SessionKey key{}; ///< 计算得到的共享密钥
         std::chrono::steady_clock::time_point startTime; ///< 协商开始时间
+        uint32_t keyBatch = 1; ///< 协商确定的密钥批次大小，1 表示不启用批量派生
+        uint32_t ticketStamp = 0; ///< 响应方为该密钥签发的恢复票据序号，0 表示未签发
+        sockaddr_in peerAddr{}; ///< 本端发起时的对端地址，超时重新发起时使用
+        RetryBudget retry{}; ///< 本端发起时的超时与剩余重试次数
+        bool admitted = false; ///< 是否占用了并发限制的在途名额
+
+        NegotiationSession() = default;
+        NegotiationSession(const NegotiationSession &) = default;
+        NegotiationSession &operator=(const NegotiationSession &) = default;
+
+        ~NegotiationSession() {
+            wipe();
+        }
+
+        /**
+         * @brief 清除随机数与密钥
+         */
+        void wipe() {
+            secureWipe(random1.data(), random1.size());
+            secureWipe(random2.data(), random2.size());
+            secureWipe(key.data(), key.size());
+        }
     };
 
     class Monitor;
 
+    // 发起方持有的恢复票据
+    struct HeldTicket {
+        ResumptionTicket ticket;                           ///< 响应方签发的加密票据（原样回传）
+        ResumptionSecret secret;                           ///< 由签发时的协商密钥推导的恢复密钥
+        std::chrono::steady_clock::time_point expiresAt;   ///< 本地过期时间
+    };
+
+    // 响应方已发出但密钥尚待确认的应答，同一 R1 的重传原样重发而不重新派生密钥
+    struct PendingResponse {
+        PacketType request;            ///< 触发应答的请求类型
+        SessionRandom random1;         ///< 请求携带的 R1
+        std::vector<uint8_t> response; ///< 已发出的应答负载
+    };
+
+    // 超出并发上限而延后发起的协商
+    struct DeferredStart {
+        uint32_t policy_id;
+        sockaddr_in peerAddr;
+        RetryBudget retry;
+    };
+
+    using SessionMap = LockedMap<uint32_t, NegotiationSession>;
+
     // 会话桶结构体，用于分桶管理会话，降低锁竞争
+    // 热表 sessions 只保存正在协商的会话，协商完成后密钥移入紧凑的冷存储 established
+    // established 与 inFlight 可不加锁读取，写入仍由 mtx 串行化
+    // tickets 保存本端作为发起方时收到的恢复票据，keyBatches 保存启用批量派生的策略的当前批次
+    // pendingResponses 保存待确认密钥对应的应答，密钥被确认或替换时删除
+    // 各表的节点与桶数组分配在锁定内存区（见 LockedArena）
+    // 退出热表的会话节点（已清零）保留一个在 spareNode 中，下一次写入热表时复用，稳态协商不再分配热表节点
     struct SessionBucket {
-        std::unordered_map<uint32_t, NegotiationSession> sessions;
-        std::mutex mtx;
+        SessionMap sessions;
+        SessionMap::node_type spareNode;
+        ColdSessionStore established;
+        LockedMap<uint32_t, HeldTicket> tickets;
+        LockedMap<uint32_t, KeyBatch> keyBatches;
+        LockedMap<uint32_t, PendingResponse> pendingResponses;
+        std::atomic<size_t> inFlight{0}; ///< sessions.size() 的镜像，供统计无锁读取
+        InstrumentedMutex mtx{"SessionBucket::mtx"};
+    };
+
+    // 会话表规模
+    struct SessionTableStats {
+        size_t hot;  ///< 正在协商的会话数
+        size_t cold; ///< 已协商完成的会话数
+        size_t coldBytes; ///< 冷存储占用的堆内存字节数
     };
 
     // 定义分桶数量
     static const size_t NUM_BUCKETS = 16;
 
+    // 协商能力位：RANDOM1 的 random1 之后、RANDOM2 的负载末尾各携带一个 uint32_t 能力字
+    // 低 16 位为能力标志，高 16 位为请求（RANDOM1）或接受（RANDOM2）的密钥批次大小
+    constexpr uint32_t NEGOTIATE_CAP_IMPLICIT_CONFIRM = 1u << 0; ///< 两包模式，省略 CONFIRM
+    constexpr uint32_t NEGOTIATE_CAP_KEY_BATCH = 1u << 1;        ///< 批量派生密钥
+
+    /**
+     * @brief 能力字中的密钥批次大小，未设置 NEGOTIATE_CAP_KEY_BATCH 时为 1
+     */
+    constexpr uint32_t capKeyBatchSize(const uint32_t caps) {
+        return (caps & NEGOTIATE_CAP_KEY_BATCH) && (caps >> 16) > 1 ? caps >> 16 : 1;
+    }
+
+    constexpr size_t DEFAULT_MAX_DEFERRED = 65536; ///< 超出并发上限而延后发起的协商最多排队数
+
     // 定义 UDP 发送器函数类型
     using UdpSenderFunc = std::function<void(const NegotiationPacket &, const sockaddr_in &)>;
 
@@ -70,6 +167,125 @@ namespace negotio {
 
         void sendAsync(const NegotiationPacket &packet, const sockaddr_in &peerAddr) const;
 
+        /**
+         * @brief 关闭本协商器的 [TRACE] 输出，用于启动预热等不对应真实会话的演练（默认开启输出）
+         */
+        void setQuiet(bool enabled);
+
+        /**
+         * @brief 设置会话恢复（默认开启）
+         *
+         * 开启时响应方随 RANDOM2 签发恢复票据，发起方在票据有效期内的重新协商改用 RESUME / RESUME_ACK 一个往返完成；
+         * 关闭时不签发票据，收到的 RESUME 按完整协商处理。
+         * @param enabled 是否开启
+         * @param ticketLifetimeS 票据有效期（秒）
+         */
+        void setResumption(bool enabled, uint32_t ticketLifetimeS = DEFAULT_TICKET_LIFETIME_S);
+
+        /**
+         * @brief 是否持有指定策略的有效恢复票据（发起方）
+         */
+        bool hasResumptionTicket(uint32_t policy_id);
+
+        /**
+         * @brief 设置两包协商模式（默认关闭）
+         *
+         * 开启后发起方在 RANDOM1 中提供 NEGOTIATE_CAP_IMPLICIT_CONFIRM；响应方同样开启时在 RANDOM2 中回应该能力，
+         * 并在发出 RANDOM2 时即完成协商，发起方收到 RANDOM2 后不再发送 CONFIRM。
+         * 响应方保存的密钥处于“待确认”状态，直到对端首次经认证地使用该密钥（confirmKey）或迟到的 CONFIRM。
+         * 待确认期间收到 R1 相同的 RANDOM1 视为重传，原样重发同一个 RANDOM2，R1 不同时视为新一轮协商。
+         * 任意一方未开启时退回三包流程。
+         */
+        void setImplicitConfirm(bool enabled);
+
+        /**
+         * @brief 设置过期包过滤阈值（默认 0，即不过滤）
+         *
+         * 根据包头时间戳按对端估计单向排队时延（见 PeerClockTracker），排队时延超过阈值的包所属的协商在发送方已经超时，
+         * 在任何密码学计算之前丢弃。时延估计始终记录到 Monitor。
+         * @param timeoutMs 阈值（毫秒），通常取协商超时
+         */
+        void setStaleThreshold(uint32_t timeoutMs);
+
+        /**
+         * @brief 设置进程间共享的会话表（多进程模式，默认不设置）
+         *
+         * 设置后每次写入冷存储（协商完成、本地轮换、确认）都同步写入共享表，工作进程崩溃重启后可用 restoreSession 恢复。
+         * 密钥批次的派生状态不写入共享表，恢复后 rekey 退回完整协商。
+         * @param table 共享会话表，生命周期需长于 Negotiator，传入 nullptr 关闭
+         */
+        void setSharedTable(SharedSessionTable *table);
+
+        /**
+         * @brief 按快照恢复一个已协商会话，保留其纪元（不写回共享表）
+         */
+        void restoreSession(const ColdSession &session);
+
+        /**
+         * @brief 设置自适应并发限制（默认不设置，即不限制）
+         *
+         * 设置后新建热表会话（本端发起、响应方三包流程）需先取得在途名额，会话完成、超时或被取消时归还，
+         * 完成耗时与超时作为样本反馈给限制器调整上限。两包模式与票据恢复的响应方不保留热表会话，不受限制。
+         * 超出上限时，本端发起的协商进入延后队列（队列已满时返回 NEGOTIATION_FAILED），由 expireSessions 在有名额时发起；
+         * 对端发起的 RANDOM1 / RESUME 直接丢弃，对端以 startNegotiation(const PolicyConfig &) 发起时会在超时后重新发起。
+         * 应在开始协商之前设置一次，之前创建的会话不占用名额。
+         * @param limiter 并发限制器，生命周期需长于 Negotiator，传入 nullptr 关闭
+         * @param maxDeferred 延后队列长度上限
+         */
+        void setConcurrencyLimiter(ConcurrencyLimiter *limiter, size_t maxDeferred = DEFAULT_MAX_DEFERRED);
+
+        /**
+         * @brief 删除已超过协商超时仍未完成的热表会话，并在并发上限允许时发起延后的协商，由主循环周期调用
+         *
+         * 本端发起且还有重试次数的超时会话以新的随机数重新发起（RANDOM1 或 RESUME）。
+         * @param timeoutMs 协商超时（毫秒），会话带有自己的超时（见 RetryBudget）时以会话的为准
+         * @return 本次删除的超时会话数
+         */
+        size_t expireSessions(uint32_t timeoutMs);
+
+        /**
+         * @brief 延后队列中等待发起的协商数
+         */
+        size_t getDeferredCount();
+
+        /**
+         * @brief 指定策略是否有正在进行的协商（热表中的会话或延后队列中等待发起的协商）
+         */
+        bool isNegotiating(uint32_t policy_id);
+
+        /**
+         * @brief 设置每次完整协商派生的密钥批次大小（默认 1，即不启用）
+         *
+         * 大于 1 时在 RANDOM1 能力字中请求该批次大小，响应方取双方配置的较小值并在 RANDOM2 中回应。
+         * 协商得到的密钥为批次的第一个密钥，其余 N-1 个密钥由 rotateKey 在本地按序派生。
+         * @param size 批次大小，上限 MAX_KEY_BATCH
+         */
+        void setKeyBatchSize(uint32_t size);
+
+        /**
+         * @brief 在本地轮换到批次中的下一个密钥（不发送任何数据包），密钥纪元加 1
+         *
+         * 双方按相同顺序轮换得到相同的密钥，轮换时机由上层约定（如按纪元或定时）。
+         * @return 成功返回 SUCCESS；未启用批量派生或批次已用完时返回 NEGOTIATION_FAILED，需要重新协商
+         */
+        ErrorCode rotateKey(uint32_t policy_id);
+
+        /**
+         * @brief 重新协商：批次内仍有密钥时在本地轮换，否则发起网络协商
+         */
+        ErrorCode rekey(uint32_t policy_id, const sockaddr_in &peerAddr);
+
+        /**
+         * @brief 当前批次中尚未使用的密钥数
+         */
+        uint32_t remainingBatchKeys(uint32_t policy_id);
+
+        /**
+         * @brief 确认对端已持有指定策略的密钥（如首次成功验证对端使用该密钥的报文后调用）
+         * @return 存在待确认密钥并已标记为确认时返回 true
+         */
+        bool confirmKey(uint32_t policy_id);
+
 
         /**
          * @brief 发起协商流程（发起者角色）
@@ -79,6 +295,13 @@ namespace negotio {
          */
         ErrorCode startNegotiation(uint32_t policy_id, const sockaddr_in &peerAddr);
 
+        /**
+         * @brief 按策略配置发起协商：超过策略的 timeout_ms 仍未完成时由 expireSessions 重新发起，最多 retry_times 次
+         * @param policy 策略配置，对端地址取 remote_ip / remote_port
+         * @return ErrorCode
+         */
+        ErrorCode startNegotiation(const PolicyConfig &policy);
+
         /**
          * @brief 处理接收到的数据包（响应或确认）
          * @param packet 接收到的数据包
@@ -89,19 +312,52 @@ namespace negotio {
 
         /**
          * @brief 获取指定会话信息（只读）
+         *
+         * 正在协商的会话优先返回（需短暂持有桶锁）；仅存在于冷存储中的已协商会话以 DONE 状态返回，
+         * 只包含 policy_id、state 与 key，该部分不加锁读取。
          * @param policy_id 策略ID
          * @return 若存在返回会话，否则返回 std::nullopt
          */
         std::optional<NegotiationSession> getSession(uint32_t policy_id);
 
+        /**
+         * @brief 读取指定策略当前生效的已协商密钥
+         *
+         * 不获取桶锁，基于冷存储的 seqlock 读取，与正在进行的协商并发时只会重试而不会阻塞协商线程；
+         * 返回的密钥与纪元总是来自同一次写入。
+         * @return 尚未协商完成时返回 std::nullopt
+         */
+        std::optional<ColdSession> getEstablishedKey(uint32_t policy_id) const;
+
+        /**
+         * @brief 获取指定策略当前生效的已协商密钥纪元（不加锁）
+         * @return 尚未协商完成时返回 std::nullopt
+         */
+        std::optional<uint32_t> getKeyEpoch(uint32_t policy_id) const;
+
+        /**
+         * @brief 统计热表与冷存储的规模（不加锁，各桶计数分别读取）
+         */
+        SessionTableStats getSessionTableStats() const;
+
+        /**
+         * @brief 按预期会话数为各会话桶预留哈希表空间，避免运行期扩容与首次触页
+         * @param expectedSessions 预期同时存在的会话数
+         */
+        void reserveSessions(size_t expectedSessions);
+
         // 将 generateRandomData 从 private 移到 public，以便性能测试中调用
         static std::vector<uint8_t> generateRandomData(size_t size);
 
         // 计算共享密钥：SHA256(random1 || random2)
-        static std::vector<uint8_t> computeKey(const std::vector<uint8_t> &random1,
-                                               const std::vector<uint8_t> &random2);
+        static SessionKey computeKey(const SessionRandom &random1, const SessionRandom &random2);
 
     private:
+        /**
+         * @brief [TRACE] 输出目标：静默时为丢弃一切写入的流，不修改全局 std::cout
+         */
+        [[nodiscard]] std::ostream &trace() const;
+
         // 分桶管理会话，每个桶独立加锁，减少锁竞争
         std::array<SessionBucket, NUM_BUCKETS> sessionBuckets;
 
@@ -109,6 +365,21 @@ namespace negotio {
 
         UdpSenderFunc udpSender; ///< ✅ UDP 发送回调函数
 
+        TicketSealer ticketSealer; ///< 恢复票据加解密（响应方）
+        bool resumptionEnabled = true;
+        bool implicitConfirm = false;
+        bool quiet = false;
+        uint32_t keyBatchSize = 1;
+        uint32_t staleThresholdMs = 0;
+        PeerClockTracker peerClocks;
+        SharedSessionTable *sharedTable = nullptr;
+        ConcurrencyLimiter *limiter = nullptr;
+        std::mutex deferredMutex;
+        std::deque<DeferredStart> deferred; ///< 超出并发上限而延后发起的协商
+        std::unordered_set<uint32_t> deferredIds; ///< 延后队列中的策略，同一策略只排队一次
+        size_t maxDeferred = DEFAULT_MAX_DEFERRED;
+        uint32_t ticketLifetimeS = DEFAULT_TICKET_LIFETIME_S;
+
         /**
          * @brief 根据 policy_id 获取对应的桶索引
          * @param policy_id 策略ID
@@ -127,6 +398,95 @@ namespace negotio {
          */
         static NegotiationPacket createPacket(PacketType type, uint32_t policy_id,
                                               const std::vector<uint8_t> &payloadData);
+
+        /**
+         * @brief 构造数据包，负载取自调用方的缓冲区（如栈上拼接的负载）
+         */
+        static NegotiationPacket createPacket(PacketType type, uint32_t policy_id, const uint8_t *payloadData,
+                                              size_t payloadBytes);
+
+        /**
+         * @brief 响应方完整协商：保存 WAIT_CONFIRM 会话并回复 RANDOM2
+         */
+        ErrorCode respondFull(uint32_t policy_id, const NegotiationPacket &packet, const sockaddr_in &peerAddr,
+                              std::chrono::steady_clock::time_point now);
+
+        /**
+         * @brief 构造响应方回复的负载：random2，开启会话恢复时后接为新密钥签发的票据
+         * @param ticketStamp 输出签发的票据序号，未签发时为 0
+         */
+        std::vector<uint8_t> responsePayload(uint32_t policy_id, const SessionRandom &random2,
+                                             const SessionKey &key, uint32_t &ticketStamp) const;
+
+        /**
+         * @brief 同时发起（glare）时的仲裁：本端正作为发起方等待 RANDOM2 时又收到对端的 RANDOM1 / RESUME
+         *
+         * 双方比较各自的 R1，R1 较小的一方放弃本端发起的会话转为响应方，较大的一方继续等待 RANDOM2。
+         * 双方比较的是同一对值，结论一致，无需等待超时。调用方需持有桶锁。
+         * @return 本端应转为响应方时返回 true（已删除本端的发起方会话）；无冲突或本端胜出时返回 false
+         */
+        bool yieldToPeer(SessionBucket &bucket, uint32_t policy_id, const NegotiationPacket &packet) const;
+
+        // 热表会话的结束方式，决定归还名额时反馈给并发限制器的样本
+        enum class SessionEnd {
+            DONE,      ///< 协商完成，耗时作为样本
+            EXPIRED,   ///< 协商超时
+            CANCELLED  ///< 被取消，不记录样本
+        };
+
+        /**
+         * @brief 写入热表（调用方需持有桶锁），被覆盖的旧会话占用的名额随之归还，新条目优先复用 spareNode
+         */
+        void putSession(SessionBucket &bucket, const NegotiationSession &session) const;
+
+        /**
+         * @brief 从热表删除会话并归还其占用的名额（调用方需持有桶锁），节点清零后留作 spareNode
+         * @return 被删除会话的下一个迭代器
+         */
+        SessionMap::iterator retireSession(SessionBucket &bucket, SessionMap::iterator it, SessionEnd end,
+                                           std::chrono::steady_clock::time_point now) const;
+
+        /**
+         * @brief 超出并发上限时将本端发起的协商放入延后队列
+         */
+        ErrorCode deferNegotiation(uint32_t policy_id, const sockaddr_in &peerAddr, const RetryBudget &retry);
+
+        /**
+         * @brief startNegotiation 的公共实现
+         */
+        ErrorCode launchNegotiation(uint32_t policy_id, const sockaddr_in &peerAddr, const RetryBudget &retry);
+
+        /**
+         * @brief 写入冷存储并同步到共享会话表（调用方需持有桶锁）
+         * @return 写入后的纪元
+         */
+        uint32_t establish(SessionBucket &bucket, uint32_t policy_id, const SessionKey &key,
+                           bool confirmed = true, uint32_t ticketStamp = 0) const;
+
+        /**
+         * @brief 将冷存储中的密钥标记为已确认并同步到共享会话表（调用方需持有桶锁）
+         */
+        bool confirmEstablished(SessionBucket &bucket, uint32_t policy_id) const;
+
+        /**
+         * @brief 本端作为发起方时在 RANDOM1 中提供的能力字（0 表示不附带能力字）
+         */
+        [[nodiscard]] uint32_t localCapabilities() const;
+
+        /**
+         * @brief 响应方根据发起方提供的能力字与本端配置确定接受的能力
+         */
+        [[nodiscard]] uint32_t acceptCapabilities(uint32_t offered) const;
+
+        /**
+         * @brief 以新协商的密钥开始一个批次；size <= 1 时清除旧批次（调用方需持有桶锁）
+         */
+        static void storeKeyBatch(SessionBucket &bucket, uint32_t policy_id, const SessionKey &key, uint32_t size);
+
+        /**
+         * @brief 保存响应方回复中携带的票据（调用方需持有桶锁）
+         */
+        void storeTicket(SessionBucket &bucket, const NegotiationPacket &packet, const SessionKey &key) const;
 #ifdef UNIT_TEST  // 仅在测试编译时定义
         friend class NegotiatorTest_FullNegotiationFlow_Test;
 #endif
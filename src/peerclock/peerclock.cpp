@@ -0,0 +1,85 @@
+/**
+ * @file peerclock.cpp
+ * @brief 对端时钟偏移与单向时延估计实现
+ */
+
+#include "peerclock.h"
+
+namespace negotio {
+    namespace {
+        // 32 位时间戳回绕：按差值的符号比较先后
+        bool before(const uint32_t a, const uint32_t b) {
+            return static_cast<int32_t>(a - b) < 0;
+        }
+    }
+
+    uint64_t PeerClockTracker::keyOf(const sockaddr_in &peer) {
+        return static_cast<uint64_t>(peer.sin_addr.s_addr) << 16 | peer.sin_port;
+    }
+
+    PeerClockTracker::Shard &PeerClockTracker::shardOf(const sockaddr_in &peer) {
+        return shards[(peer.sin_addr.s_addr ^ peer.sin_addr.s_addr >> 16 ^ peer.sin_port) % NUM_SHARDS];
+    }
+
+    const PeerClockTracker::Shard &PeerClockTracker::shardOf(const sockaddr_in &peer) const {
+        return shards[(peer.sin_addr.s_addr ^ peer.sin_addr.s_addr >> 16 ^ peer.sin_port) % NUM_SHARDS];
+    }
+
+    uint32_t PeerClockTracker::baselineOf(const PeerClock &clock) {
+        return before(clock.previousMin, clock.currentMin) ? clock.previousMin : clock.currentMin;
+    }
+
+    uint32_t PeerClockTracker::observe(const sockaddr_in &peer, const uint32_t remoteMs,
+                                       const uint32_t localMs) const {
+        const Shard &shard = shardOf(peer);
+        const uint32_t diff = localMs - remoteMs;
+
+        std::lock_guard lock(shard.mtx);
+        const auto it = shard.peers.find(keyOf(peer));
+        if (it == shard.peers.end()) {
+            return 0;
+        }
+        const uint32_t base = baselineOf(it->second);
+        const uint32_t delay = diff - base;
+        if (before(diff, base) || delay > PEER_CLOCK_RESET_MS) {
+            return 0;
+        }
+        return delay;
+    }
+
+    void PeerClockTracker::learn(const sockaddr_in &peer, const uint32_t remoteMs, const uint32_t localMs) {
+        Shard &shard = shardOf(peer);
+        const uint32_t diff = localMs - remoteMs;
+
+        std::lock_guard lock(shard.mtx);
+        const auto it = shard.peers.find(keyOf(peer));
+        if (it == shard.peers.end()) {
+            if (shard.peers.size() < PEER_CLOCK_MAX_PEERS / NUM_SHARDS) {
+                shard.peers.emplace(keyOf(peer), PeerClock{diff, diff, localMs});
+            }
+            return;
+        }
+
+        PeerClock &clock = it->second;
+        if (!before(diff, baselineOf(clock)) && diff - baselineOf(clock) > PEER_CLOCK_RESET_MS) {
+            clock = PeerClock{diff, diff, localMs};
+            return;
+        }
+        if (localMs - clock.windowStartMs >= PEER_CLOCK_WINDOW_MS) {
+            clock.previousMin = clock.currentMin;
+            clock.currentMin = diff;
+            clock.windowStartMs = localMs;
+        } else if (before(diff, clock.currentMin)) {
+            clock.currentMin = diff;
+        }
+    }
+
+    size_t PeerClockTracker::size() const {
+        size_t total = 0;
+        for (const auto &shard : shards) {
+            std::lock_guard lock(shard.mtx);
+            total += shard.peers.size();
+        }
+        return total;
+    }
+} // namespace negotio
@@ -0,0 +1,91 @@
+/**
+ * 对端时钟偏移与单向时延估计
+ *
+ * 数据包头的 timestamp 为发送方 steady_clock 的毫秒数（32 位，约 49 天回绕），双方时钟原点不同，
+ * 不能直接相减得到时延。对每个对端记录 差值 = 本端接收时间 - 对端发送时间（模 2^32），
+ * 一段时间内的最小差值即“时钟偏移 + 最小传播时延”，作为基线；
+ * 每个包的差值减去基线就是它相对于最快路径多花的时间（排队时延），这是该包实际时延的下界。
+ *
+ * 因此排队时延已超过协商超时的包可以确定是过期包（它所属的协商在发送方已经超时），无需做任何密码学计算即可丢弃。
+ * 基线按窗口滚动（取当前与上一窗口的最小值），以跟随双方时钟的缓慢漂移；
+ * 排队时延大到不可能是真实排队（对端重启导致时钟跳变）时重置该对端的基线。
+ *
+ * 包头时间戳不经认证，任何人都能伪造源地址发送时间戳超前的包。若所有包都参与基线，一个伪造包就能把基线压低，
+ * 此后该对端的正常包全部被判为过期。因此估计（observe）只读基线，基线只由 learn 更新，
+ * 调用方只对与本端进行中的协商相符的包（如本端发起后收到的 RANDOM2 / RESUME_ACK、等待中的 CONFIRM）调用 learn。
+ * 没有基线的对端不做估计。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_PEERCLOCK_H
+#define NEGOTIO_PEERCLOCK_H
+
+#include "../lockstat/lockstat.h"
+
+#include <array>
+#include <cstdint>
+#include <netinet/in.h>
+#include <unordered_map>
+
+namespace negotio {
+    constexpr uint32_t PEER_CLOCK_WINDOW_MS = 60000; ///< 基线窗口长度（毫秒）
+    constexpr uint32_t PEER_CLOCK_RESET_MS = 30000;  ///< 排队时延超过该值视为对端时钟跳变，重置基线
+    constexpr size_t PEER_CLOCK_MAX_PEERS = 65536;   ///< 最多跟踪的对端数，超出后新对端不做估计
+
+    class PeerClockTracker {
+    public:
+        /**
+         * @brief 估计一个数据包的单向排队时延，不修改基线
+         * @param peer 对端地址
+         * @param remoteMs 包头中的发送时间戳（对端毫秒时钟）
+         * @param localMs 本端接收时间（本端 steady_clock 毫秒，与 createPacket 使用同一时钟）
+         * @return 相对于基线的时延（毫秒）；没有基线、或时延大到像是对端时钟跳变时返回 0
+         */
+        uint32_t observe(const sockaddr_in &peer, uint32_t remoteMs, uint32_t localMs) const;
+
+        /**
+         * @brief 用一个可信的数据包（与进行中的协商相符）更新对端基线
+         *
+         * 对端的首个可信包建立基线；排队时延超过 PEER_CLOCK_RESET_MS（对端重启）时以该包重置基线。
+         */
+        void learn(const sockaddr_in &peer, uint32_t remoteMs, uint32_t localMs);
+
+        /**
+         * @brief 当前跟踪的对端数
+         */
+        [[nodiscard]] size_t size() const;
+
+    private:
+        // 单个对端的基线：当前窗口与上一窗口的最小差值
+        struct PeerClock {
+            uint32_t currentMin;
+            uint32_t previousMin;
+            uint32_t windowStartMs;
+        };
+
+        struct Shard {
+            mutable InstrumentedMutex mtx{"PeerClockTracker::mtx"};
+            std::unordered_map<uint64_t, PeerClock> peers;
+        };
+
+        static constexpr size_t NUM_SHARDS = 16;
+        std::array<Shard, NUM_SHARDS> shards;
+
+        static uint64_t keyOf(const sockaddr_in &peer);
+
+        Shard &shardOf(const sockaddr_in &peer);
+
+        const Shard &shardOf(const sockaddr_in &peer) const;
+
+        /**
+         * @brief 基线：当前与上一窗口最小差值中较小（更早）的一个
+         */
+        static uint32_t baselineOf(const PeerClock &clock);
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_PEERCLOCK_H
@@ -5,11 +5,15 @@
  */
 
 #include "policy.h"
+#include "../allocstat/allocstat.h"
 
 namespace negotio {
-    PolicyManager::PolicyManager() {
+    PolicyManager::PolicyManager() : PolicyManager(MAX_POLICIES) {
+    }
+
+    PolicyManager::PolicyManager(const uint32_t maxPolicies) : maxPolicies(maxPolicies) {
         // 可预留空间以减少重哈希开销
-        policies.reserve(MAX_POLICIES);
+        policies.reserve(maxPolicies);
     }
 
     PolicyManager::~PolicyManager() {
@@ -17,8 +21,9 @@ namespace negotio {
     }
 
     bool PolicyManager::addPolicy(const PolicyConfig &config) {
+        AllocScope allocScope(AllocTag::POLICY);
         std::lock_guard lock(policiesMutex);
-        if (policies.size() >= MAX_POLICIES) {
+        if (policies.size() >= maxPolicies) {
             return false;
         }
         // 若策略ID已存在，则不允许重复添加
@@ -30,6 +35,7 @@ namespace negotio {
     }
 
     bool PolicyManager::removePolicy(uint32_t policy_id) {
+        AllocScope allocScope(AllocTag::POLICY);
         std::lock_guard lock(policiesMutex);
         return policies.erase(policy_id) > 0;
     }
@@ -40,6 +46,7 @@ namespace negotio {
     }
 
     std::optional<PolicyConfig> PolicyManager::getPolicy(uint32_t policy_id) {
+        AllocScope allocScope(AllocTag::POLICY);
         std::lock_guard lock(policiesMutex);
         if (const auto it = policies.find(policy_id); it != policies.end()) {
             return it->second;
@@ -47,5 +54,19 @@ namespace negotio {
         return std::nullopt;
     }
 
+    size_t PolicyManager::size() {
+        std::lock_guard lock(policiesMutex);
+        return policies.size();
+    }
+
+    void PolicyManager::ensureCapacity(const uint32_t capacity) {
+        AllocScope allocScope(AllocTag::POLICY);
+        std::lock_guard lock(policiesMutex);
+        if (capacity > maxPolicies) {
+            maxPolicies = capacity;
+            policies.reserve(maxPolicies);
+        }
+    }
+
 } // namespace negotio
 
@@ -9,6 +9,7 @@
 #define NEGOTIO_POLICY_H
 
 #include "common.h"
+#include "../lockstat/lockstat.h"
 #include <unordered_map>
 #include <mutex>
 #include <optional>
@@ -21,6 +22,12 @@ namespace negotio {
     public:
         PolicyManager();
 
+        /**
+         * @brief 以指定容量上限构造策略管理器（用于内存基准等需要超出默认上限的场景）
+         * @param maxPolicies 最大策略数量
+         */
+        explicit PolicyManager(uint32_t maxPolicies);
+
         ~PolicyManager();
 
         /**
@@ -51,10 +58,23 @@ namespace negotio {
          */
         std::optional<PolicyConfig> getPolicy(uint32_t policy_id);
 
+        /**
+         * @brief 获取当前策略数量
+         * @return 策略数量
+         */
+        size_t size();
+
+        /**
+         * @brief 确保策略数量上限不小于指定值（只增不减），并预留哈希表空间
+         * @param capacity 需要容纳的策略数量
+         */
+        void ensureCapacity(uint32_t capacity);
+
     private:
         std::unordered_map<uint32_t, PolicyConfig> policies; ///< 存储策略的容器
-        std::mutex policiesMutex; ///< 保护容器的互斥锁
-        static constexpr uint32_t MAX_POLICIES = 4096; ///< 最大支持策略数量
+        InstrumentedMutex policiesMutex{"PolicyManager::policiesMutex"}; ///< 保护容器的互斥锁
+        static constexpr uint32_t MAX_POLICIES = MAX_POLICY_COUNT; ///< 默认最大支持策略数量
+        uint32_t maxPolicies; ///< 当前实例的策略数量上限
     };
 } // namespace negotio
 
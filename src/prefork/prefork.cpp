@@ -0,0 +1,320 @@
+/**
+ * @file prefork.cpp
+ * @brief 多进程监督实现
+ */
+
+#include "prefork.h"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <thread>
+#include <poll.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace negotio {
+    namespace {
+        // 孵化进程发给监督进程的报告：工作进程新的 PID（已退出为 -1）及是否为崩溃后的重启
+        struct WorkerReport {
+            uint32_t index;
+            pid_t pid;
+            uint32_t restarted;
+        };
+
+        void sendReport(const int statusFd, const uint32_t index, const pid_t pid, const bool restarted) {
+            const WorkerReport report{index, pid, restarted ? 1u : 0u};
+            send(statusFd, &report, sizeof(report), MSG_NOSIGNAL);
+        }
+    }
+
+    PreforkSupervisor::PreforkSupervisor(PreforkWorkerMain workerMain, const PreforkOptions options)
+        : workerMain(std::move(workerMain)), options(options) {
+        if (this->options.workers == 0) {
+            this->options.workers = 1;
+        }
+    }
+
+    PreforkSupervisor::~PreforkSupervisor() {
+        stop();
+        for (const Worker &worker : workers) {
+            if (worker.supervisorFd != -1) {
+                close(worker.supervisorFd);
+            }
+            if (worker.workerFd != -1) {
+                close(worker.workerFd);
+            }
+        }
+    }
+
+    bool PreforkSupervisor::start() {
+        if (!workers.empty()) {
+            return false;
+        }
+        workers.resize(options.workers);
+        for (Worker &worker : workers) {
+            int fds[2];
+            if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) == -1) {
+                std::cerr << "创建控制套接字对失败" << std::endl;
+                return false;
+            }
+            worker.supervisorFd = fds[0];
+            worker.workerFd = fds[1];
+        }
+        int statusFds[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, statusFds) == -1) {
+            std::cerr << "创建孵化进程报告套接字对失败" << std::endl;
+            return false;
+        }
+
+        const pid_t supervisorPid = getpid();
+        const pid_t pid = fork();
+        if (pid == -1) {
+            std::cerr << "fork 孵化进程失败" << std::endl;
+            close(statusFds[0]);
+            close(statusFds[1]);
+            return false;
+        }
+        if (pid == 0) {
+            // 监督进程退出时孵化进程收到 SIGTERM，按 stop 的流程停止工作进程
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            if (getppid() != supervisorPid) {
+                _exit(1);
+            }
+            close(statusFds[0]);
+            zygoteMain(statusFds[1]);
+        }
+        zygotePid = pid;
+        reportFd = statusFds[0];
+        close(statusFds[1]);
+        // 工作进程一端只由孵化进程持有
+        for (Worker &worker : workers) {
+            close(worker.workerFd);
+            worker.workerFd = -1;
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.startTimeoutMs);
+        for (uint32_t started = 0; started < options.workers;) {
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            bool restarted = false;
+            const ErrorCode received = readReport(remaining > 0 ? static_cast<int>(remaining) : 0, restarted);
+            if (received == ErrorCode::SUCCESS) {
+                ++started;
+            } else if (received == ErrorCode::SOCKET_ERROR || remaining <= 0) {
+                std::cerr << "孵化进程未能启动全部工作进程" << std::endl;
+                stop();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void PreforkSupervisor::zygoteMain(const int statusFd) {
+        for (const Worker &worker : workers) {
+            close(worker.supervisorFd);
+        }
+        // SIGCHLD 与 SIGTERM 改为同步等待，工作进程 fork 后恢复原信号掩码
+        sigset_t waited;
+        sigemptyset(&waited);
+        sigaddset(&waited, SIGCHLD);
+        sigaddset(&waited, SIGTERM);
+        sigset_t workerMask;
+        sigprocmask(SIG_BLOCK, &waited, &workerMask);
+
+        for (uint32_t i = 0; i < options.workers; ++i) {
+            if ((workers[i].pid = spawn(i, statusFd, workerMask)) == -1) {
+                _exit(1);
+            }
+            sendReport(statusFd, i, workers[i].pid, false);
+        }
+
+        while (true) {
+            // 带超时等待：即使 SIGCHLD 合并或丢失，也会周期回收
+            const timespec timeout{0, 100 * 1000 * 1000};
+            if (sigtimedwait(&waited, nullptr, &timeout) == SIGTERM) {
+                break;
+            }
+            int status = 0;
+            pid_t pid;
+            while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+                for (uint32_t i = 0; i < workers.size(); ++i) {
+                    if (workers[i].pid != pid) {
+                        continue;
+                    }
+                    workers[i].pid = -1;
+                    const bool crashed = WIFSIGNALED(status) || (WIFEXITED(status) && WEXITSTATUS(status) != 0);
+                    if (crashed) {
+                        if (WIFSIGNALED(status)) {
+                            std::cerr << "工作进程 " << i << " (pid " << pid << ") 被信号 " << WTERMSIG(status)
+                                      << " 终止，正在重启" << std::endl;
+                        } else {
+                            std::cerr << "工作进程 " << i << " (pid " << pid << ") 退出码 " << WEXITSTATUS(status)
+                                      << "，正在重启" << std::endl;
+                        }
+                        workers[i].pid = spawn(i, statusFd, workerMask);
+                    }
+                    sendReport(statusFd, i, workers[i].pid, workers[i].pid != -1);
+                    break;
+                }
+            }
+        }
+
+        for (const Worker &worker : workers) {
+            if (worker.pid > 0) {
+                kill(worker.pid, SIGTERM);
+            }
+        }
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.stopTimeoutMs);
+        for (Worker &worker : workers) {
+            while (worker.pid > 0) {
+                if (waitpid(worker.pid, nullptr, WNOHANG) != 0) {
+                    worker.pid = -1;
+                } else if (std::chrono::steady_clock::now() >= deadline) {
+                    kill(worker.pid, SIGKILL);
+                    waitpid(worker.pid, nullptr, 0);
+                    worker.pid = -1;
+                } else {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+            }
+        }
+        // 不返回调用方：孵化进程不应执行监督进程的析构与 atexit 处理
+        _exit(0);
+    }
+
+    pid_t PreforkSupervisor::spawn(const uint32_t index, const int statusFd, const sigset_t &workerMask) {
+        const pid_t zygote = getpid();
+        const pid_t pid = fork();
+        if (pid == -1) {
+            std::cerr << "fork 工作进程 " << index << " 失败" << std::endl;
+            return -1;
+        }
+        if (pid == 0) {
+            // 孵化进程退出时工作进程随之退出，避免遗留无人监督的进程
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            if (getppid() != zygote) {
+                _exit(1);
+            }
+            sigprocmask(SIG_SETMASK, &workerMask, nullptr);
+            close(statusFd);
+            for (uint32_t i = 0; i < workers.size(); ++i) {
+                if (i != index) {
+                    close(workers[i].workerFd);
+                }
+            }
+            _exit(workerMain(index, workers[index].workerFd));
+        }
+        return pid;
+    }
+
+    bool PreforkSupervisor::forward(const uint32_t policy_id, const std::string &command) {
+        if (workers.empty() || command.empty() || command.size() > MAX_CONTROL_MESSAGE) {
+            return false;
+        }
+        const int fd = workers[ownerOf(policy_id)].supervisorFd;
+        return send(fd, command.data(), command.size(), MSG_DONTWAIT | MSG_NOSIGNAL)
+               == static_cast<ssize_t>(command.size());
+    }
+
+    ErrorCode PreforkSupervisor::readReport(const int timeoutMs, bool &restarted) {
+        if (reportFd == -1) {
+            return ErrorCode::SOCKET_ERROR;
+        }
+        pollfd pfd{reportFd, POLLIN, 0};
+        const int ready = poll(&pfd, 1, timeoutMs);
+        if (ready == 0 || (ready < 0 && errno == EINTR)) {
+            return ErrorCode::TIMEOUT;
+        }
+        WorkerReport report{};
+        const ssize_t received = ready < 0 ? -1 : recv(reportFd, &report, sizeof(report), MSG_DONTWAIT);
+        if (received < 0 && (errno == EAGAIN || errno == EINTR)) {
+            return ErrorCode::TIMEOUT;
+        }
+        if (received != static_cast<ssize_t>(sizeof(report)) || report.index >= workers.size()) {
+            return ErrorCode::SOCKET_ERROR;
+        }
+        workers[report.index].pid = report.pid;
+        restarted = report.restarted != 0;
+        return ErrorCode::SUCCESS;
+    }
+
+    size_t PreforkSupervisor::superviseOnce() {
+        if (stopping.load(std::memory_order_relaxed) || zygotePid <= 0) {
+            return 0;
+        }
+        size_t restarted = 0;
+        bool wasRestart = false;
+        ErrorCode received;
+        while ((received = readReport(0, wasRestart)) == ErrorCode::SUCCESS) {
+            if (wasRestart) {
+                restarts.fetch_add(1, std::memory_order_relaxed);
+                ++restarted;
+            }
+        }
+        if (received == ErrorCode::SOCKET_ERROR && waitpid(zygotePid, nullptr, WNOHANG) == zygotePid) {
+            std::cerr << "孵化进程 (pid " << zygotePid << ") 意外退出，工作进程不再重启" << std::endl;
+            zygotePid = -1;
+            for (Worker &worker : workers) {
+                worker.pid = -1;
+            }
+        }
+        return restarted;
+    }
+
+    void PreforkSupervisor::stop() {
+        if (stopping.exchange(true)) {
+            return;
+        }
+        if (zygotePid > 0) {
+            // 孵化进程按 stopTimeoutMs 停止工作进程，这里多等一秒再强制结束它
+            kill(zygotePid, SIGTERM);
+            const auto deadline = std::chrono::steady_clock::now()
+                                  + std::chrono::milliseconds(options.stopTimeoutMs + 1000);
+            while (waitpid(zygotePid, nullptr, WNOHANG) == 0) {
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    kill(zygotePid, SIGKILL);
+                    waitpid(zygotePid, nullptr, 0);
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            zygotePid = -1;
+        }
+        if (reportFd != -1) {
+            close(reportFd);
+            reportFd = -1;
+        }
+        for (Worker &worker : workers) {
+            worker.pid = -1;
+        }
+    }
+
+    pid_t PreforkSupervisor::workerPid(const uint32_t index) const {
+        return index < workers.size() ? workers[index].pid : -1;
+    }
+
+    ErrorCode PreforkSupervisor::receiveCommand(const int controlFd, std::string &out, const int timeoutMs) {
+        pollfd pfd{controlFd, POLLIN, 0};
+        const int ready = poll(&pfd, 1, timeoutMs);
+        if (ready == 0 || (ready < 0 && errno == EINTR)) {
+            return ErrorCode::TIMEOUT;
+        }
+        if (ready < 0) {
+            return ErrorCode::SOCKET_ERROR;
+        }
+        out.resize(MAX_CONTROL_MESSAGE);
+        const ssize_t received = recv(controlFd, out.data(), out.size(), MSG_DONTWAIT);
+        if (received < 0 && (errno == EAGAIN || errno == EINTR)) {
+            return ErrorCode::TIMEOUT;
+        }
+        if (received <= 0) {
+            return ErrorCode::SOCKET_ERROR;
+        }
+        out.resize(static_cast<size_t>(received));
+        return ErrorCode::SUCCESS;
+    }
+} // namespace negotio
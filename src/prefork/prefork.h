@@ -0,0 +1,157 @@
+/**
+ * 多进程（prefork）监督
+ *
+ * 单进程模式下一次崩溃会丢掉全部正在进行的协商，所有线程也共用同一个堆。多进程模式由监督进程 fork 出 N 个工作进程：
+ * - start 时（监督进程尚未启动其它线程）先 fork 一个单线程的孵化进程，由它 fork 与重启工作进程；
+ *   多线程的监督进程此后不再 fork，工作进程不会继承其它线程持有的锁，也不会继承之后创建的控制监听套接字；
+ * - 监督进程在 fork 之前创建 N 个绑定同一端口的 SO_REUSEPORT 套接字并挂载按 policy_id 选择分片的 cBPF 程序，
+ *   工作进程 i 只处理第 i 个套接字，即 policy_id % N == i 的策略；
+ * - 监督进程持有全部套接字，工作进程崩溃时其套接字仍留在组内，组内顺序与分流结果不变，
+ *   崩溃期间到达的数据包在套接字缓冲区中等待重启后的工作进程处理；
+ * - 控制命令由监督进程解码后写入共享策略表，再经每个工作进程一对 SOCK_SEQPACKET 套接字转发给所属工作进程；
+ * - 已协商会话与策略保存在共享内存中（见 SharedSessionTable），重启的工作进程从中恢复自己负责的部分。
+ *
+ * 工作进程以非 0 状态退出或被信号终止时视为崩溃，由孵化进程重新 fork 并把新 PID 报告给监督进程，
+ * superviseOnce 读取这些报告；stop 之后的退出不再重启。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_PREFORK_H
+#define NEGOTIO_PREFORK_H
+
+#include "common.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace negotio {
+    constexpr size_t MAX_CONTROL_MESSAGE = 64 * 1024; ///< 转发给工作进程的单条控制命令最大长度
+
+    // 多进程参数
+    struct PreforkOptions {
+        uint32_t workers = 4;         ///< 工作进程数
+        uint32_t stopTimeoutMs = 2000; ///< stop 时等待工作进程退出的时间，超时后 SIGKILL
+        uint32_t startTimeoutMs = 5000; ///< start 时等待孵化进程报告全部工作进程 PID 的时间
+    };
+
+    /**
+     * @brief 工作进程入口，返回值作为进程退出码（非 0 视为崩溃并重启）
+     * @param workerIndex 工作进程序号，负责 policy_id % workers == workerIndex 的策略
+     * @param controlFd 接收控制命令的套接字，用 PreforkSupervisor::receiveCommand 读取
+     */
+    using PreforkWorkerMain = std::function<int(uint32_t workerIndex, int controlFd)>;
+
+    class PreforkSupervisor {
+    public:
+        PreforkSupervisor(PreforkWorkerMain workerMain, PreforkOptions options);
+
+        ~PreforkSupervisor();
+
+        PreforkSupervisor(const PreforkSupervisor &) = delete;
+        PreforkSupervisor &operator=(const PreforkSupervisor &) = delete;
+
+        /**
+         * @brief 创建控制套接字对，fork 孵化进程并等待它 fork 出全部工作进程
+         *
+         * 必须在监督进程启动其它线程、创建不应被工作进程继承的描述符之前调用。
+         * @return 孵化进程或任一工作进程创建失败时返回 false
+         */
+        bool start();
+
+        /**
+         * @brief 将控制命令转发给负责该策略的工作进程（不阻塞）
+         *
+         * 工作进程重启期间命令在套接字缓冲区中等待；缓冲区已满时丢弃并返回 false。
+         * @param policy_id 策略ID，决定目标工作进程
+         * @param command 命令文本
+         */
+        bool forward(uint32_t policy_id, const std::string &command);
+
+        /**
+         * @brief 读取孵化进程关于工作进程退出与重启的报告，由监督进程主循环周期调用
+         * @return 本次读到的重启次数
+         */
+        size_t superviseOnce();
+
+        /**
+         * @brief 通知孵化进程向全部工作进程发送 SIGTERM 并等待退出，超时后 SIGKILL
+         */
+        void stop();
+
+        /**
+         * @brief 孵化进程仍在运行；它意外退出后工作进程随之退出，不再有进程负责重启
+         */
+        [[nodiscard]] bool isAlive() const {
+            return zygotePid > 0;
+        }
+
+        [[nodiscard]] uint32_t ownerOf(const uint32_t policy_id) const {
+            return policy_id % options.workers;
+        }
+
+        [[nodiscard]] uint32_t workerCount() const {
+            return options.workers;
+        }
+
+        /**
+         * @brief 工作进程当前的 PID，未运行时返回 -1
+         */
+        [[nodiscard]] pid_t workerPid(uint32_t index) const;
+
+        [[nodiscard]] uint64_t getRestarts() const {
+            return restarts.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 工作进程读取一条控制命令
+         * @param controlFd 工作进程入口收到的控制套接字
+         * @param out 命令文本
+         * @param timeoutMs 等待时间
+         * @return 收到命令返回 SUCCESS；超时返回 TIMEOUT；监督进程已退出返回 SOCKET_ERROR
+         */
+        static ErrorCode receiveCommand(int controlFd, std::string &out, int timeoutMs);
+
+    private:
+        struct Worker {
+            pid_t pid = -1;
+            int supervisorFd = -1; ///< 监督进程一端，forward 写入
+            int workerFd = -1;     ///< 工作进程一端，由孵化进程跨重启保留，未读取的命令不会丢失
+        };
+
+        /**
+         * @brief 孵化进程主体：fork 全部工作进程，之后只等待 SIGCHLD 重启崩溃者、等待 SIGTERM 停止，不返回
+         */
+        [[noreturn]] void zygoteMain(int statusFd);
+
+        /**
+         * @brief 由孵化进程 fork 一个工作进程
+         * @return 工作进程 PID，失败返回 -1
+         */
+        pid_t spawn(uint32_t index, int statusFd, const sigset_t &workerMask);
+
+        /**
+         * @brief 读取一条孵化进程的报告并更新工作进程 PID
+         * @return 读到报告返回 SUCCESS；暂无报告返回 TIMEOUT；孵化进程已退出返回 SOCKET_ERROR
+         */
+        ErrorCode readReport(int timeoutMs, bool &restarted);
+
+        PreforkWorkerMain workerMain;
+        PreforkOptions options;
+        std::vector<Worker> workers;
+        pid_t zygotePid = -1;
+        int reportFd = -1; ///< 接收孵化进程报告的一端
+        std::atomic<bool> stopping{false};
+        std::atomic<uint64_t> restarts{0};
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_PREFORK_H
@@ -0,0 +1,315 @@
+/**
+ * @file profiler.cpp
+ * @brief 内置采样 CPU 分析器实现
+ */
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fstream>
+#include <map>
+#include <sys/time.h>
+#include <unordered_map>
+
+namespace negotio {
+    namespace {
+        // 跳过 record、onSignal 与内核信号返回跳板三帧，第一帧即被中断的指令
+        constexpr int SKIPPED_FRAMES = 3;
+
+        // profile.proto 所需的最小 protobuf 编码
+        class ProtoWriter {
+        public:
+            void varint(uint64_t value) {
+                while (value >= 0x80) {
+                    buf.push_back(static_cast<uint8_t>(value | 0x80));
+                    value >>= 7;
+                }
+                buf.push_back(static_cast<uint8_t>(value));
+            }
+
+            void uint64Field(const uint32_t field, const uint64_t value) {
+                if (value == 0) {
+                    return;
+                }
+                varint(static_cast<uint64_t>(field) << 3);
+                varint(value);
+            }
+
+            void bytesField(const uint32_t field, const void *data, const size_t len) {
+                varint(static_cast<uint64_t>(field) << 3 | 2);
+                varint(len);
+                const auto *bytes = static_cast<const uint8_t *>(data);
+                buf.insert(buf.end(), bytes, bytes + len);
+            }
+
+            void messageField(const uint32_t field, const ProtoWriter &message) {
+                bytesField(field, message.buf.data(), message.buf.size());
+            }
+
+            void packedField(const uint32_t field, const std::vector<uint64_t> &values) {
+                ProtoWriter packed;
+                for (const uint64_t value : values) {
+                    packed.varint(value);
+                }
+                messageField(field, packed);
+            }
+
+            std::vector<uint8_t> buf;
+        };
+
+        // 字符串表，下标 0 固定为空串
+        class StringTable {
+        public:
+            StringTable() {
+                intern("");
+            }
+
+            uint64_t intern(const std::string &s) {
+                const auto [it, inserted] = index.try_emplace(s, strings.size());
+                if (inserted) {
+                    strings.push_back(s);
+                }
+                return it->second;
+            }
+
+            std::vector<std::string> strings;
+
+        private:
+            std::unordered_map<std::string, uint64_t> index;
+        };
+
+        // 可执行映射（/proc/self/maps 中带文件名的 r-xp 段）
+        struct MappingInfo {
+            uint64_t start;
+            uint64_t limit;
+            uint64_t offset;
+            std::string file;
+        };
+
+        std::vector<MappingInfo> readExecutableMappings() {
+            std::vector<MappingInfo> mappings;
+            std::ifstream maps("/proc/self/maps");
+            std::string line;
+            while (std::getline(maps, line)) {
+                unsigned long long start = 0;
+                unsigned long long limit = 0;
+                unsigned long long offset = 0;
+                char perms[8] = {};
+                int pathPos = 0;
+                if (std::sscanf(line.c_str(), "%llx-%llx %7s %llx %*s %*s %n", &start, &limit, perms, &offset,
+                                &pathPos) < 4 || perms[2] != 'x' || pathPos <= 0
+                    || pathPos >= static_cast<int>(line.size()) || line[pathPos] != '/') {
+                    continue;
+                }
+                mappings.push_back({start, limit, offset, line.substr(pathPos)});
+            }
+            return mappings;
+        }
+
+        std::string symbolName(const void *address) {
+            Dl_info info{};
+            if (dladdr(address, &info) == 0 || info.dli_sname == nullptr) {
+                return {};
+            }
+            int status = 0;
+            char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            std::string name = status == 0 && demangled ? demangled : info.dli_sname;
+            std::free(demangled);
+            return name;
+        }
+
+        uint64_t realtimeNs() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+    }
+
+    Profiler &Profiler::instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    bool Profiler::start(uint32_t frequencyHz, const size_t maxSamples) {
+        std::lock_guard lock(controlMutex);
+        if (running.load(std::memory_order_acquire) || maxSamples == 0) {
+            return false;
+        }
+        frequencyHz = std::min(std::max<uint32_t>(frequencyHz, 1), MAX_PROFILE_HZ);
+        samples.reset(new Sample[maxSamples]());
+        capacity = maxSamples;
+        next.store(0, std::memory_order_relaxed);
+        dropped.store(0, std::memory_order_relaxed);
+        periodNs = 1000000000ull / frequencyHz;
+        startTimeNs = realtimeNs();
+
+        // 首次调用 backtrace 会加载 libgcc_s，放在信号处理函数之外完成
+        void *warm[2];
+        backtrace(warm, 2);
+
+        struct sigaction action{};
+        action.sa_handler = &Profiler::onSignal;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, nullptr) != 0) {
+            return false;
+        }
+        running.store(true, std::memory_order_release);
+
+        itimerval timer{};
+        timer.it_interval.tv_sec = 0;
+        timer.it_interval.tv_usec = static_cast<suseconds_t>(1000000 / frequencyHz);
+        timer.it_value = timer.it_interval;
+        if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+            running.store(false, std::memory_order_release);
+            signal(SIGPROF, SIG_IGN);
+            return false;
+        }
+        return true;
+    }
+
+    bool Profiler::stop(std::vector<uint8_t> &out) {
+        std::lock_guard lock(controlMutex);
+        if (!running.load(std::memory_order_acquire)) {
+            return false;
+        }
+        constexpr itimerval disabled{};
+        setitimer(ITIMER_PROF, &disabled, nullptr);
+        running.store(false, std::memory_order_release);
+        // 槽位数组保留到下次 start，迟到的信号不会写入已释放的内存
+
+        // 按调用栈聚合
+        std::map<std::vector<uint64_t>, uint64_t> stacks;
+        const size_t recorded = std::min(next.load(std::memory_order_acquire), capacity);
+        for (size_t i = 0; i < recorded; ++i) {
+            const Sample &sample = samples[i];
+            if (!sample.ready.load(std::memory_order_acquire) || sample.depth <= SKIPPED_FRAMES) {
+                continue;
+            }
+            std::vector<uint64_t> stack;
+            for (uint32_t d = SKIPPED_FRAMES; d < sample.depth; ++d) {
+                // 调用者帧记录的是返回地址，减 1 落回调用指令
+                const auto pc = reinterpret_cast<uint64_t>(sample.frames[d]);
+                stack.push_back(d == SKIPPED_FRAMES ? pc : pc - 1);
+            }
+            ++stacks[stack];
+        }
+
+        StringTable strings;
+        const std::vector<MappingInfo> mappings = readExecutableMappings();
+        std::unordered_map<uint64_t, uint64_t> locationIds;   // 地址 -> location id
+        std::unordered_map<std::string, uint64_t> functionIds; // 函数名 -> function id
+        ProtoWriter profile;
+        ProtoWriter locations;
+        ProtoWriter functions;
+
+        const auto valueType = [&](const char *type, const char *unit) {
+            ProtoWriter vt;
+            vt.uint64Field(1, strings.intern(type));
+            vt.uint64Field(2, strings.intern(unit));
+            return vt;
+        };
+        profile.messageField(1, valueType("samples", "count"));
+        profile.messageField(1, valueType("cpu", "nanoseconds"));
+
+        for (const auto &[stack, count] : stacks) {
+            std::vector<uint64_t> ids;
+            for (const uint64_t address : stack) {
+                auto [it, inserted] = locationIds.try_emplace(address, locationIds.size() + 1);
+                if (inserted) {
+                    ProtoWriter location;
+                    location.uint64Field(1, it->second);
+                    for (size_t m = 0; m < mappings.size(); ++m) {
+                        if (address >= mappings[m].start && address < mappings[m].limit) {
+                            location.uint64Field(2, m + 1);
+                            break;
+                        }
+                    }
+                    location.uint64Field(3, address);
+                    if (const std::string name = symbolName(reinterpret_cast<void *>(address)); !name.empty()) {
+                        auto [fn, added] = functionIds.try_emplace(name, functionIds.size() + 1);
+                        if (added) {
+                            ProtoWriter function;
+                            function.uint64Field(1, fn->second);
+                            function.uint64Field(2, strings.intern(name));
+                            function.uint64Field(3, strings.intern(name));
+                            functions.messageField(5, function);
+                        }
+                        ProtoWriter lineInfo;
+                        lineInfo.uint64Field(1, fn->second);
+                        location.messageField(4, lineInfo);
+                    }
+                    locations.messageField(4, location);
+                }
+                ids.push_back(it->second);
+            }
+            ProtoWriter sample;
+            sample.packedField(1, ids);
+            sample.packedField(2, {count, count * periodNs});
+            profile.messageField(2, sample);
+        }
+
+        for (size_t m = 0; m < mappings.size(); ++m) {
+            ProtoWriter mapping;
+            mapping.uint64Field(1, m + 1);
+            mapping.uint64Field(2, mappings[m].start);
+            mapping.uint64Field(3, mappings[m].limit);
+            mapping.uint64Field(4, mappings[m].offset);
+            mapping.uint64Field(5, strings.intern(mappings[m].file));
+            mapping.uint64Field(7, functionIds.empty() ? 0 : 1); // has_functions
+            profile.messageField(3, mapping);
+        }
+        profile.buf.insert(profile.buf.end(), locations.buf.begin(), locations.buf.end());
+        profile.buf.insert(profile.buf.end(), functions.buf.begin(), functions.buf.end());
+        for (const std::string &s : strings.strings) {
+            profile.bytesField(6, s.data(), s.size());
+        }
+        profile.uint64Field(9, startTimeNs);
+        profile.uint64Field(10, realtimeNs() - startTimeNs);
+        profile.messageField(11, valueType("cpu", "nanoseconds"));
+        profile.uint64Field(12, periodNs);
+        out = std::move(profile.buf);
+        return true;
+    }
+
+    bool Profiler::stop(const std::string &path) {
+        std::vector<uint8_t> data;
+        if (!stop(data)) {
+            return false;
+        }
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        return static_cast<bool>(file);
+    }
+
+    uint64_t Profiler::getSamples() const {
+        return std::min(next.load(std::memory_order_relaxed), capacity);
+    }
+
+    void Profiler::onSignal(int) {
+        const int savedErrno = errno;
+        if (Profiler &profiler = instance(); profiler.running.load(std::memory_order_acquire)) {
+            profiler.record();
+        }
+        errno = savedErrno;
+    }
+
+    void Profiler::record() {
+        const size_t idx = next.fetch_add(1, std::memory_order_relaxed);
+        if (idx >= capacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Sample &sample = samples[idx];
+        sample.depth = static_cast<uint32_t>(backtrace(sample.frames, PROFILE_MAX_DEPTH));
+        sample.ready.store(true, std::memory_order_release);
+    }
+} // namespace negotio
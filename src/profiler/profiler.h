@@ -0,0 +1,108 @@
+/**
+ * 内置采样 CPU 分析器
+ *
+ * 生产容器中往往无法运行 perf，这里用 setitimer(ITIMER_PROF) 按进程 CPU 时间定时发送 SIGPROF，
+ * 内核把信号投递给正在消耗 CPU 的线程，信号处理函数在该线程上用 backtrace() 记录调用栈，
+ * 因此 UDP 接收、handlePacket、控制分片等所有线程都会按各自的 CPU 占用被采样。
+ *
+ * 信号处理函数只做一次原子自增和一次定长拷贝：样本写入启动时预分配的定长槽位数组（无锁追加），
+ * 槽位用完后后续样本计入丢弃数。停止时按调用栈聚合，并用 dladdr 符号化后输出 pprof（profile.proto，未压缩）：
+ *   go tool pprof -top negotio.pprof
+ * 可执行文件需以 -rdynamic 链接（CMake ENABLE_EXPORTS）才能解析出非导出函数名；未解析的地址仍带有映射信息，
+ * pprof 可以配合二进制文件自行符号化。
+ *
+ * 通过控制命令启停：
+ *   {"action": "profile_start", "frequency_hz": 99}
+ *   {"action": "profile_stop", "path": "/tmp/negotio.pprof"}
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_PROFILER_H
+#define NEGOTIO_PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace negotio {
+    constexpr uint32_t DEFAULT_PROFILE_HZ = 99;        ///< 默认采样频率
+    constexpr uint32_t MAX_PROFILE_HZ = 1000;          ///< 采样频率上限
+    constexpr size_t PROFILE_MAX_DEPTH = 32;           ///< 单个样本最多记录的栈帧数
+    constexpr size_t DEFAULT_PROFILE_SAMPLES = 16384;  ///< 默认样本槽位数
+
+    /**
+     * @brief 进程内采样分析器（SIGPROF 为进程级资源，因此只有一个实例）
+     */
+    class Profiler {
+    public:
+        static Profiler &instance();
+
+        Profiler(const Profiler &) = delete;
+        Profiler &operator=(const Profiler &) = delete;
+
+        /**
+         * @brief 开始采样
+         * @param frequencyHz 每秒 CPU 时间的采样次数，范围 [1, MAX_PROFILE_HZ]
+         * @param maxSamples 样本槽位数，用完后丢弃后续样本
+         * @return 已在采样或定时器设置失败时返回 false
+         */
+        bool start(uint32_t frequencyHz = DEFAULT_PROFILE_HZ, size_t maxSamples = DEFAULT_PROFILE_SAMPLES);
+
+        /**
+         * @brief 停止采样并输出 pprof 数据
+         * @param out 输出 profile.proto 编码的数据
+         * @return 未在采样时返回 false
+         */
+        bool stop(std::vector<uint8_t> &out);
+
+        /**
+         * @brief 停止采样并将 pprof 数据写入文件
+         * @return 未在采样或写文件失败时返回 false
+         */
+        bool stop(const std::string &path);
+
+        [[nodiscard]] bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+        /**
+         * @brief 本轮已记录的样本数
+         */
+        [[nodiscard]] uint64_t getSamples() const;
+
+        /**
+         * @brief 本轮因槽位用完而丢弃的样本数
+         */
+        [[nodiscard]] uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    private:
+        // 单个样本：ready 在写完栈帧后置位，停止时只读取已写完的槽位
+        struct Sample {
+            std::atomic<bool> ready;
+            uint32_t depth;
+            void *frames[PROFILE_MAX_DEPTH];
+        };
+
+        Profiler() = default;
+
+        static void onSignal(int);
+
+        [[gnu::noinline]] void record();
+
+        std::mutex controlMutex; ///< 串行化 start / stop
+        std::atomic<bool> running{false};
+        std::unique_ptr<Sample[]> samples;
+        size_t capacity = 0;
+        std::atomic<size_t> next{0};
+        std::atomic<uint64_t> dropped{0};
+        uint64_t periodNs = 0;
+        uint64_t startTimeNs = 0;
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_PROFILER_H
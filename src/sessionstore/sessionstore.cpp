@@ -0,0 +1,311 @@
+/**
+ * @file sessionstore.cpp
+ * @brief 已协商会话冷存储实现
+ */
+
+#include "sessionstore.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace negotio {
+    namespace {
+        constexpr size_t MIN_SLOTS = 16;
+        constexpr size_t MIN_CHUNK_DIRECTORY = 4;
+
+        size_t nextPowerOfTwo(size_t n) {
+            size_t p = MIN_SLOTS;
+            while (p < n) {
+                p <<= 1;
+            }
+            return p;
+        }
+    }
+
+    ColdSessionStore::ColdSessionStore() = default;
+
+    ColdSessionStore::~ColdSessionStore() = default;
+
+    size_t ColdSessionStore::homeSlot(const uint32_t policy_id, const size_t mask) {
+        // Fibonacci 散列：连续的 policy_id 也能均匀分布
+        return static_cast<size_t>((policy_id * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    }
+
+    const ColdSessionStore::Record *ColdSessionStore::recordAt(const uint32_t index) const {
+        const ChunkDirectory *dir = directory.load(std::memory_order_acquire);
+        const Record *chunk = dir->chunks[index / RECORDS_PER_CHUNK].load(std::memory_order_acquire);
+        return chunk + index % RECORDS_PER_CHUNK;
+    }
+
+    void ColdSessionStore::writeRecord(Record &record, const uint32_t policy_id, const uint32_t epoch,
+                                       const uint32_t flags, const uint8_t *key) {
+        // seqlock 写入：序号置为奇数 → 写数据 → 序号置为下一个偶数
+        const uint32_t seq = record.seq.load(std::memory_order_relaxed);
+        record.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        record.policyId.store(policy_id, std::memory_order_relaxed);
+        record.epoch.store(epoch, std::memory_order_relaxed);
+        record.flags.store(flags, std::memory_order_relaxed);
+        for (size_t i = 0; i < record.keyWords.size(); ++i) {
+            uint64_t word = 0;
+            if (key) {
+                std::memcpy(&word, key + i * sizeof(uint64_t), sizeof(uint64_t));
+            }
+            record.keyWords[i].store(word, std::memory_order_relaxed);
+        }
+        record.seq.store(seq + 2, std::memory_order_release);
+    }
+
+    ColdSessionStore::Record &ColdSessionStore::allocateRecord(uint32_t &index) {
+        if (!freeList.empty()) {
+            index = freeList.back();
+            freeList.pop_back();
+            return const_cast<Record &>(*recordAt(index));
+        }
+
+        index = recordCount++;
+        if (index >= chunkStorage.size() * RECORDS_PER_CHUNK) {
+            addChunk();
+        }
+        return const_cast<Record &>(*recordAt(index));
+    }
+
+    void ColdSessionStore::addChunk() {
+        const size_t chunkIndex = chunkStorage.size();
+        ChunkDirectory *dir = directory.load(std::memory_order_relaxed);
+        if (!dir || chunkIndex >= dir->capacity) {
+            // 块目录扩容：复制块指针后发布新目录，旧目录保留给仍在读取的读方
+            auto grown = std::make_unique<ChunkDirectory>();
+            grown->capacity = dir ? dir->capacity * 2 : MIN_CHUNK_DIRECTORY;
+            grown->chunks = makeLockedArray<std::atomic<Record *>>(grown->capacity);
+            for (size_t i = 0; dir && i < dir->capacity; ++i) {
+                grown->chunks[i].store(dir->chunks[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            allocatedBytes.fetch_add(grown->capacity * sizeof(std::atomic<Record *>), std::memory_order_relaxed);
+            dir = grown.get();
+            directories.push_back(std::move(grown));
+            directory.store(dir, std::memory_order_release);
+        }
+        chunkStorage.push_back(makeLockedArray<Record>(RECORDS_PER_CHUNK));
+        allocatedBytes.fetch_add(RECORDS_PER_CHUNK * sizeof(Record), std::memory_order_relaxed);
+        dir->chunks[chunkIndex].store(chunkStorage.back().get(), std::memory_order_release);
+    }
+
+    void ColdSessionStore::rehash(const size_t slotCount) {
+        auto rebuilt = std::make_unique<SlotTable>();
+        rebuilt->mask = slotCount - 1;
+        rebuilt->slots = makeLockedArray<std::atomic<uint32_t>>(slotCount);
+        for (size_t i = 0; i < slotCount; ++i) {
+            rebuilt->slots[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+        }
+
+        // 只迁移有效条目，墓碑在此被清除
+        size_t live = 0;
+        if (const SlotTable *old = table.load(std::memory_order_relaxed)) {
+            for (size_t i = 0; i <= old->mask; ++i) {
+                const uint32_t ref = old->slots[i].load(std::memory_order_relaxed);
+                if (ref == EMPTY_SLOT || ref == TOMBSTONE) {
+                    continue;
+                }
+                const uint32_t policy_id = recordAt(ref - 1)->policyId.load(std::memory_order_relaxed);
+                size_t slot = homeSlot(policy_id, rebuilt->mask);
+                while (rebuilt->slots[slot].load(std::memory_order_relaxed) != EMPTY_SLOT) {
+                    slot = (slot + 1) & rebuilt->mask;
+                }
+                rebuilt->slots[slot].store(ref, std::memory_order_relaxed);
+                ++live;
+            }
+        }
+        usedSlots = live;
+        allocatedBytes.fetch_add(slotCount * sizeof(std::atomic<uint32_t>), std::memory_order_relaxed);
+        table.store(rebuilt.get(), std::memory_order_release);
+        tables.push_back(std::move(rebuilt));
+    }
+
+    void ColdSessionStore::reserve(const size_t entries) {
+        while (chunkStorage.size() * RECORDS_PER_CHUNK < entries) {
+            addChunk();
+        }
+        const SlotTable *current = table.load(std::memory_order_relaxed);
+        if (const size_t wanted = nextPowerOfTwo(entries * 2); !current || wanted > current->mask + 1) {
+            rehash(wanted);
+        }
+    }
+
+    uint32_t ColdSessionStore::upsert(const uint32_t policy_id, const SessionKey &key, const bool confirmed,
+                                      const uint32_t ticketStamp) {
+        return store(policy_id, key.data(), (confirmed ? FLAG_CONFIRMED : 0) | ticketStamp << TICKET_STAMP_SHIFT, 0);
+    }
+
+    void ColdSessionStore::restore(const ColdSession &session) {
+        store(session.policy_id, session.key.data(),
+              (session.confirmed ? FLAG_CONFIRMED : 0) | session.ticketStamp << TICKET_STAMP_SHIFT,
+              std::max<uint32_t>(session.epoch, 1));
+    }
+
+    uint32_t ColdSessionStore::store(const uint32_t policy_id, const uint8_t *key, const uint32_t flags,
+                                     const uint32_t epoch) {
+        const SlotTable *current = table.load(std::memory_order_relaxed);
+        if (!current || (usedSlots + 1) * 2 > current->mask + 1) {
+            rehash(nextPowerOfTwo((liveCount.load(std::memory_order_relaxed) + 1) * 2));
+            current = table.load(std::memory_order_relaxed);
+        }
+
+        size_t insertAt = current->mask + 1;
+        for (size_t slot = homeSlot(policy_id, current->mask);; slot = (slot + 1) & current->mask) {
+            const uint32_t ref = current->slots[slot].load(std::memory_order_relaxed);
+            if (ref == EMPTY_SLOT) {
+                if (insertAt > current->mask) {
+                    insertAt = slot;
+                }
+                break;
+            }
+            if (ref == TOMBSTONE) {
+                if (insertAt > current->mask) {
+                    insertAt = slot;
+                }
+                continue;
+            }
+            auto &record = const_cast<Record &>(*recordAt(ref - 1));
+            if (record.policyId.load(std::memory_order_relaxed) == policy_id) {
+                const uint32_t next = epoch != 0 ? epoch : record.epoch.load(std::memory_order_relaxed) + 1;
+                writeRecord(record, policy_id, next, flags, key);
+                return next;
+            }
+        }
+
+        // 新条目：先写完记录，再以 release 发布索引槽，读方看到槽位时记录必然完整
+        uint32_t index = 0;
+        Record &record = allocateRecord(index);
+        const uint32_t first = epoch != 0 ? epoch : 1;
+        writeRecord(record, policy_id, first, flags, key);
+        if (current->slots[insertAt].load(std::memory_order_relaxed) == EMPTY_SLOT) {
+            ++usedSlots;
+        }
+        current->slots[insertAt].store(index + 1, std::memory_order_release);
+        liveCount.fetch_add(1, std::memory_order_relaxed);
+        return first;
+    }
+
+    bool ColdSessionStore::erase(const uint32_t policy_id) {
+        const SlotTable *current = table.load(std::memory_order_relaxed);
+        if (!current) {
+            return false;
+        }
+        for (size_t slot = homeSlot(policy_id, current->mask);; slot = (slot + 1) & current->mask) {
+            const uint32_t ref = current->slots[slot].load(std::memory_order_relaxed);
+            if (ref == EMPTY_SLOT) {
+                return false;
+            }
+            if (ref == TOMBSTONE) {
+                continue;
+            }
+            auto &record = const_cast<Record &>(*recordAt(ref - 1));
+            if (record.policyId.load(std::memory_order_relaxed) == policy_id) {
+                // 先发布墓碑再清空记录：读方要么读到旧快照，要么因 policy_id 不符而重新探测
+                current->slots[slot].store(TOMBSTONE, std::memory_order_release);
+                writeRecord(record, 0, 0, 0, nullptr);
+                freeList.push_back(ref - 1);
+                liveCount.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    ColdSessionStore::Record *ColdSessionStore::findRecord(const uint32_t policy_id) const {
+        const SlotTable *current = table.load(std::memory_order_relaxed);
+        if (!current) {
+            return nullptr;
+        }
+        for (size_t slot = homeSlot(policy_id, current->mask);; slot = (slot + 1) & current->mask) {
+            const uint32_t ref = current->slots[slot].load(std::memory_order_relaxed);
+            if (ref == EMPTY_SLOT) {
+                return nullptr;
+            }
+            if (ref == TOMBSTONE) {
+                continue;
+            }
+            if (const Record *record = recordAt(ref - 1);
+                record->policyId.load(std::memory_order_relaxed) == policy_id) {
+                return const_cast<Record *>(record);
+            }
+        }
+    }
+
+    bool ColdSessionStore::contains(const uint32_t policy_id, const bool confirmedOnly) const {
+        const Record *record = findRecord(policy_id);
+        return record && (!confirmedOnly || (record->flags.load(std::memory_order_relaxed) & FLAG_CONFIRMED));
+    }
+
+    uint32_t ColdSessionStore::ticketStamp(const uint32_t policy_id) const {
+        const Record *record = findRecord(policy_id);
+        return record ? record->flags.load(std::memory_order_relaxed) >> TICKET_STAMP_SHIFT : 0;
+    }
+
+    bool ColdSessionStore::markConfirmed(const uint32_t policy_id) {
+        Record *record = findRecord(policy_id);
+        const uint32_t flags = record ? record->flags.load(std::memory_order_relaxed) : 0;
+        if (!record || (flags & FLAG_CONFIRMED)) {
+            return false;
+        }
+        uint8_t key[KEY_SIZE];
+        for (size_t i = 0; i < record->keyWords.size(); ++i) {
+            const uint64_t word = record->keyWords[i].load(std::memory_order_relaxed);
+            std::memcpy(key + i * sizeof(uint64_t), &word, sizeof(uint64_t));
+        }
+        writeRecord(*record, policy_id, record->epoch.load(std::memory_order_relaxed), flags | FLAG_CONFIRMED, key);
+        return true;
+    }
+
+    bool ColdSessionStore::read(const uint32_t policy_id, ColdSession &out) const {
+        for (;;) {
+            const SlotTable *current = table.load(std::memory_order_acquire);
+            if (!current) {
+                return false;
+            }
+
+            const Record *record = nullptr;
+            for (size_t slot = homeSlot(policy_id, current->mask);; slot = (slot + 1) & current->mask) {
+                const uint32_t ref = current->slots[slot].load(std::memory_order_acquire);
+                if (ref == EMPTY_SLOT) {
+                    return false;
+                }
+                if (ref == TOMBSTONE) {
+                    continue;
+                }
+                const Record *candidate = recordAt(ref - 1);
+                if (candidate->policyId.load(std::memory_order_relaxed) == policy_id) {
+                    record = candidate;
+                    break;
+                }
+            }
+
+            // seqlock 读取：序号为偶数且前后一致时快照有效
+            const uint32_t before = record->seq.load(std::memory_order_acquire);
+            if (before & 1u) {
+                continue;
+            }
+            const uint32_t id = record->policyId.load(std::memory_order_relaxed);
+            const uint32_t epoch = record->epoch.load(std::memory_order_relaxed);
+            const uint32_t flags = record->flags.load(std::memory_order_relaxed);
+            std::array<uint64_t, KEY_SIZE / sizeof(uint64_t)> words{};
+            for (size_t i = 0; i < words.size(); ++i) {
+                words[i] = record->keyWords[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (record->seq.load(std::memory_order_relaxed) != before) {
+                continue;
+            }
+            // 记录在探测与读取之间被删除或复用，重新探测
+            if (id != policy_id) {
+                continue;
+            }
+            out.policy_id = id;
+            out.epoch = epoch;
+            out.confirmed = (flags & FLAG_CONFIRMED) != 0;
+            out.ticketStamp = flags >> TICKET_STAMP_SHIFT;
+            std::memcpy(out.key.data(), words.data(), KEY_SIZE);
+            return true;
+        }
+    }
+} // namespace negotio
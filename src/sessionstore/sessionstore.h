@@ -0,0 +1,180 @@
+/**
+ * 已协商会话的冷存储
+ *
+ * 协商完成（DONE）的会话不再需要 random1、random2 与 startTime，只保留 policy_id → (密钥, 纪元, 票据序号)。
+ * ColdSessionStore 将这些条目紧凑地存放在分块的记录数组中，并用开放寻址（线性探测）的索引表定位，
+ * 每条目 48 字节记录 + 不超过 16 字节索引，且没有逐节点的堆分配。
+ * 记录块、索引表与块目录均分配在锁定内存区（LockedArena，已初始化时），密钥不会被换出。
+ * 热表（unordered_map）因此只包含正在协商的会话，即使已建立数百万个密钥也能保持在缓存中。
+ *
+ * 并发模型：
+ * - 写操作（upsert / erase / reserve）由所属 SessionBucket 的互斥锁串行化；
+ * - 读操作 read() 不加锁，可与写操作并发执行：每条记录带有 seqlock 序号，读到写入中或前后不一致的记录时重试，
+ *   读方从不阻塞写方。为保证读方持有的指针始终有效，记录按块分配且地址固定，
+ *   索引表与块目录扩容时旧版本保留到存储析构时才释放（总量不超过当前版本的大小）。
+ *   删除使用墓碑标记，被删除的记录可被复用，读方通过校验 policy_id 识别。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_SESSIONSTORE_H
+#define NEGOTIO_SESSIONSTORE_H
+
+#include "common.h"
+#include "../lockedarena/lockedarena.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace negotio {
+    // 冷存储中已协商会话的快照
+    struct ColdSession {
+        uint32_t policy_id;                  ///< 策略ID
+        uint32_t epoch;                      ///< 密钥纪元，每次重新协商完成后递增，从 1 开始
+        std::array<uint8_t, KEY_SIZE> key;   ///< 共享密钥
+        bool confirmed;                      ///< 对端是否已确认持有该密钥（两包模式下待隐式确认时为 false）
+        uint32_t ticketStamp = 0;            ///< 响应方为该密钥签发的恢复票据序号，0 表示没有有效票据
+    };
+
+    class ColdSessionStore {
+    public:
+        ColdSessionStore();
+
+        ~ColdSessionStore();
+
+        ColdSessionStore(const ColdSessionStore &) = delete;
+        ColdSessionStore &operator=(const ColdSessionStore &) = delete;
+
+        /**
+         * @brief 写入或更新一个已协商会话（写方，需持有桶锁）
+         * @param policy_id 策略ID
+         * @param key 共享密钥
+         * @param confirmed 对端是否已确认持有该密钥
+         * @param ticketStamp 为该密钥签发的恢复票据序号（31 位），0 表示没有有效票据
+         * @return 写入后的纪元（新条目为 1，已存在时在原纪元基础上加 1）
+         */
+        uint32_t upsert(uint32_t policy_id, const SessionKey &key, bool confirmed = true, uint32_t ticketStamp = 0);
+
+        /**
+         * @brief 按快照原样写入一个已协商会话，保留其纪元（写方，需持有桶锁）
+         *
+         * 用于从进程间共享的会话表恢复：重启的工作进程沿用崩溃前的纪元，对端看到的密钥序号保持连续。
+         */
+        void restore(const ColdSession &session);
+
+        /**
+         * @brief 将已协商会话标记为已确认（写方，需持有桶锁）
+         * @return 条目存在且此前未确认时返回 true
+         */
+        bool markConfirmed(uint32_t policy_id);
+
+        /**
+         * @brief 删除已协商会话（写方，需持有桶锁）
+         * @return 存在并删除时返回 true
+         */
+        bool erase(uint32_t policy_id);
+
+        /**
+         * @brief 预留容量（写方，需持有桶锁）
+         */
+        void reserve(size_t entries);
+
+        /**
+         * @brief 无锁读取已协商会话，可在任意线程与写方并发调用
+         * @param policy_id 策略ID
+         * @param out 读取到的一致快照
+         * @return 存在时返回 true
+         */
+        bool read(uint32_t policy_id, ColdSession &out) const;
+
+        /**
+         * @brief 是否存在指定会话（写方在持锁时使用，不需要 seqlock 重试）
+         * @param policy_id 策略ID
+         * @param confirmedOnly 为 true 时只匹配已确认的会话
+         */
+        [[nodiscard]] bool contains(uint32_t policy_id, bool confirmedOnly = false) const;
+
+        /**
+         * @brief 当前密钥对应的恢复票据序号（写方在持锁时使用），不存在或没有有效票据时返回 0
+         */
+        [[nodiscard]] uint32_t ticketStamp(uint32_t policy_id) const;
+
+        [[nodiscard]] size_t size() const {
+            return liveCount.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 当前占用的堆内存字节数（记录块 + 索引表 + 块目录，含保留的旧版本）
+         */
+        [[nodiscard]] size_t memoryBytes() const {
+            return allocatedBytes.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr size_t RECORDS_PER_CHUNK = 256;
+        static constexpr uint32_t EMPTY_SLOT = 0;          ///< 索引表中存放“记录下标 + 1”，0 表示空槽
+        static constexpr uint32_t TOMBSTONE = UINT32_MAX;  ///< 已删除
+        static constexpr uint32_t FLAG_CONFIRMED = 1u << 0;
+        static constexpr uint32_t TICKET_STAMP_SHIFT = 1; ///< flags 的其余 31 位存放恢复票据序号
+
+        // 单条记录：seqlock 序号 + 数据，数据字段均为原子变量，读方的并发读取没有数据竞争
+        struct alignas(16) Record {
+            std::atomic<uint32_t> seq{0};
+            std::atomic<uint32_t> policyId{0};
+            std::atomic<uint32_t> epoch{0};
+            std::atomic<uint32_t> flags{0};
+            std::array<std::atomic<uint64_t>, KEY_SIZE / sizeof(uint64_t)> keyWords{};
+        };
+
+        struct SlotTable {
+            size_t mask;
+            LockedArray<std::atomic<uint32_t>> slots;
+        };
+
+        struct ChunkDirectory {
+            size_t capacity;
+            LockedArray<std::atomic<Record *>> chunks;
+        };
+
+        std::atomic<SlotTable *> table{nullptr};
+        std::atomic<ChunkDirectory *> directory{nullptr};
+        // 所有版本的索引表、块目录与记录块，析构时统一释放
+        std::vector<std::unique_ptr<SlotTable>> tables;
+        std::vector<std::unique_ptr<ChunkDirectory>> directories;
+        std::vector<LockedArray<Record>> chunkStorage;
+
+        uint32_t recordCount = 0;        ///< 已使用过的记录数（高水位）
+        std::vector<uint32_t> freeList;  ///< 可复用的已删除记录
+        size_t usedSlots = 0;            ///< 非空槽位数（含墓碑）
+        std::atomic<size_t> liveCount{0};
+        std::atomic<size_t> allocatedBytes{0};
+
+        [[nodiscard]] const Record *recordAt(uint32_t index) const;
+
+        [[nodiscard]] Record *findRecord(uint32_t policy_id) const;
+
+        Record &allocateRecord(uint32_t &index);
+
+        void addChunk();
+
+        void rehash(size_t slotCount);
+
+        static size_t homeSlot(uint32_t policy_id, size_t mask);
+
+        /**
+         * @brief upsert 与 restore 的公共实现，epoch 为 0 时在原纪元基础上加 1（新条目为 1）
+         */
+        uint32_t store(uint32_t policy_id, const uint8_t *key, uint32_t flags, uint32_t epoch);
+
+        static void writeRecord(Record &record, uint32_t policy_id, uint32_t epoch, uint32_t flags, const uint8_t *key);
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_SESSIONSTORE_H
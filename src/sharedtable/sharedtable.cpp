@@ -0,0 +1,451 @@
+/**
+ * @file sharedtable.cpp
+ * @brief 进程间共享的会话与策略表实现
+ */
+
+#include "sharedtable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace negotio {
+    namespace {
+        constexpr uint32_t FLAG_CONFIRMED = 1u << 0;
+        constexpr size_t MIN_STRIPE_SLOTS = 8;
+
+        size_t stripeSlotsFor(const size_t capacity) {
+            // 每个条带按 1/2 负载因子分配，另留出条带间分布不均的余量
+            const size_t perStripe = (capacity + SHARED_TABLE_STRIPES - 1) / SHARED_TABLE_STRIPES;
+            size_t slots = MIN_STRIPE_SLOTS;
+            while (slots < perStripe * 2) {
+                slots <<= 1;
+            }
+            return slots;
+        }
+
+        size_t maxLive(const size_t slots) {
+            return slots - slots / 4;
+        }
+
+        size_t alignUp(const size_t n) {
+            return (n + 63) & ~static_cast<size_t>(63);
+        }
+
+    }
+
+    // 条带锁：持锁进程崩溃时修复条带后继续使用
+    class SharedSessionTable::StripeLock {
+    public:
+        StripeLock(const SharedSessionTable &table, const size_t index) : mtx(&table.stripe(index).mtx) {
+            const int rc = pthread_mutex_lock(mtx);
+            if (rc == EOWNERDEAD) {
+                table.repairStripe(index);
+                pthread_mutex_consistent(mtx);
+                table.header().recoveredLocks.fetch_add(1, std::memory_order_relaxed);
+            } else if (rc != 0) {
+                mtx = nullptr;
+            }
+        }
+
+        ~StripeLock() {
+            if (mtx) {
+                pthread_mutex_unlock(mtx);
+            }
+        }
+
+        StripeLock(const StripeLock &) = delete;
+        StripeLock &operator=(const StripeLock &) = delete;
+
+        [[nodiscard]] bool owns() const {
+            return mtx != nullptr;
+        }
+
+    private:
+        pthread_mutex_t *mtx;
+    };
+
+    template<typename Slot>
+    size_t SharedSessionTable::probe(Slot *slots, const size_t mask, const uint32_t policy_id, bool &found) {
+        found = false;
+        size_t insertAt = mask + 1;
+        for (size_t n = 0, slot = homeSlot(policy_id, mask); n <= mask; ++n, slot = (slot + 1) & mask) {
+            const uint32_t state = slots[slot].state.load(std::memory_order_relaxed);
+            if (state == SLOT_EMPTY) {
+                return insertAt <= mask ? insertAt : slot;
+            }
+            if (state == SLOT_LIVE && slots[slot].policyId == policy_id) {
+                found = true;
+                return slot;
+            }
+            if (state != SLOT_LIVE && insertAt > mask) {
+                insertAt = slot;
+            }
+        }
+        return insertAt;
+    }
+
+    template size_t SharedSessionTable::probe(SessionSlot *, size_t, uint32_t, bool &);
+    template size_t SharedSessionTable::probe(PolicySlot *, size_t, uint32_t, bool &);
+
+    SharedSessionTable::~SharedSessionTable() {
+        close();
+    }
+
+    size_t SharedSessionTable::stripeOf(const uint32_t policy_id) {
+        return static_cast<size_t>((policy_id * 0x9E3779B97F4A7C15ull) >> 32) % SHARED_TABLE_STRIPES;
+    }
+
+    size_t SharedSessionTable::homeSlot(const uint32_t policy_id, const size_t mask) {
+        // 低位已用于选择条带，槽位取其余高位
+        return static_cast<size_t>((policy_id * 0x9E3779B97F4A7C15ull) >> 36) & mask;
+    }
+
+    SharedSessionTable::Header &SharedSessionTable::header() const {
+        return *reinterpret_cast<Header *>(base);
+    }
+
+    SharedSessionTable::Stripe &SharedSessionTable::stripe(const size_t index) const {
+        return reinterpret_cast<Stripe *>(base + sizeof(Header))[index];
+    }
+
+    SharedSessionTable::SessionSlot *SharedSessionTable::sessionsOf(const size_t stripeIndex) const {
+        const size_t offset = sizeof(Header) + sizeof(Stripe) * SHARED_TABLE_STRIPES;
+        return reinterpret_cast<SessionSlot *>(base + offset) + stripeIndex * sessionSlots;
+    }
+
+    SharedSessionTable::PolicySlot *SharedSessionTable::policiesOf(const size_t stripeIndex) const {
+        const size_t offset = alignUp(sizeof(Header) + sizeof(Stripe) * SHARED_TABLE_STRIPES
+                                      + sizeof(SessionSlot) * SHARED_TABLE_STRIPES * sessionSlots);
+        return reinterpret_cast<PolicySlot *>(base + offset) + stripeIndex * policySlots;
+    }
+
+    bool SharedSessionTable::create(const std::string &path, const size_t sessionCapacity, const size_t policyCapacity) {
+        static_assert(sizeof(SessionSlot) == 48, "共享会话槽布局变化需同步递增 SHARED_TABLE_VERSION");
+        static_assert(sizeof(PolicySlot) == 64, "共享策略槽布局变化需同步递增 SHARED_TABLE_VERSION");
+        static_assert(std::atomic<uint32_t>::is_always_lock_free, "槽位状态需要跨进程无锁原子操作");
+        if (base) {
+            return false;
+        }
+        sessionSlots = stripeSlotsFor(sessionCapacity);
+        policySlots = stripeSlotsFor(policyCapacity);
+        const size_t size = alignUp(sizeof(Header) + sizeof(Stripe) * SHARED_TABLE_STRIPES
+                                    + sizeof(SessionSlot) * SHARED_TABLE_STRIPES * sessionSlots)
+                            + sizeof(PolicySlot) * SHARED_TABLE_STRIPES * policySlots;
+
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            std::cerr << "无法创建共享会话表 " << path << std::endl;
+            return false;
+        }
+        // 先取得排他锁再清空内容：另一个运行中的实例持有锁时不能截断它的表，也不能删除它的段文件
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            std::cerr << "共享会话表 " << path << " 正被另一个实例使用" << std::endl;
+            ::close(fd);
+            return false;
+        }
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            std::cerr << "无法设置共享会话表大小 " << path << std::endl;
+            ::close(fd);
+            unlink(path.c_str());
+            return false;
+        }
+        void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "无法映射共享会话表 " << path << std::endl;
+            unlink(path.c_str());
+            ::close(fd);
+            return false;
+        }
+        lockFd = fd;
+
+        // ftruncate 得到的新文件内容为全 0，所有槽位初始即为 SLOT_EMPTY
+        base = static_cast<uint8_t *>(mapped);
+        mappedSize = size;
+        filePath = path;
+        creatorPid = getpid();
+
+        Header &h = *new(base) Header{};
+        h.version = SHARED_TABLE_VERSION;
+        h.stripes = SHARED_TABLE_STRIPES;
+        h.sessionSlots = sessionSlots;
+        h.policySlots = policySlots;
+
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        for (size_t i = 0; i < SHARED_TABLE_STRIPES; ++i) {
+            Stripe &s = *new(&stripe(i)) Stripe{};
+            pthread_mutex_init(&s.mtx, &attr);
+        }
+        pthread_mutexattr_destroy(&attr);
+
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(h.magic, SHARED_TABLE_MAGIC, sizeof(h.magic));
+        return true;
+    }
+
+    bool SharedSessionTable::lockInMemory() const {
+        return base && mlock2(base, mappedSize, MLOCK_ONFAULT) == 0;
+    }
+
+    void SharedSessionTable::close() {
+        if (!base) {
+            return;
+        }
+        munmap(base, mappedSize);
+        // 工作进程继承了映射但不拥有段文件，只有创建方删除
+        if (getpid() == creatorPid) {
+            unlink(filePath.c_str());
+        }
+        ::close(lockFd);
+        lockFd = -1;
+        base = nullptr;
+        mappedSize = 0;
+    }
+
+    void SharedSessionTable::repairStripe(const size_t stripeIndex) const {
+        uint32_t sessions = 0;
+        SessionSlot *sessionArray = sessionsOf(stripeIndex);
+        for (size_t i = 0; i < sessionSlots; ++i) {
+            uint32_t state = sessionArray[i].state.load(std::memory_order_relaxed);
+            if (state == SLOT_WRITING) {
+                sessionArray[i].state.store(state = SLOT_TOMBSTONE, std::memory_order_relaxed);
+            }
+            sessions += state == SLOT_LIVE;
+        }
+        uint32_t policies = 0;
+        PolicySlot *policyArray = policiesOf(stripeIndex);
+        for (size_t i = 0; i < policySlots; ++i) {
+            uint32_t state = policyArray[i].state.load(std::memory_order_relaxed);
+            if (state == SLOT_WRITING) {
+                policyArray[i].state.store(state = SLOT_TOMBSTONE, std::memory_order_relaxed);
+            }
+            policies += state == SLOT_LIVE;
+        }
+        stripe(stripeIndex).sessions.store(sessions, std::memory_order_relaxed);
+        stripe(stripeIndex).policies.store(policies, std::memory_order_relaxed);
+    }
+
+    bool SharedSessionTable::storeSession(const uint32_t policy_id, const uint32_t epoch,
+                                          const SessionKey &key, const bool confirmed) {
+        if (!base) {
+            return false;
+        }
+        const size_t index = stripeOf(policy_id);
+        const StripeLock lock(*this, index);
+        if (!lock.owns()) {
+            return false;
+        }
+        SessionSlot *slots = sessionsOf(index);
+        bool found = false;
+        const size_t slot = probe(slots, sessionSlots - 1, policy_id, found);
+        Stripe &s = stripe(index);
+        if (!found && (slot >= sessionSlots || s.sessions.load(std::memory_order_relaxed) >= maxLive(sessionSlots))) {
+            return false;
+        }
+        SessionSlot &entry = slots[slot];
+        entry.state.store(SLOT_WRITING, std::memory_order_release);
+        entry.policyId = policy_id;
+        entry.epoch = epoch;
+        entry.flags = confirmed ? FLAG_CONFIRMED : 0;
+        std::memcpy(entry.key, key.data(), KEY_SIZE);
+        entry.state.store(SLOT_LIVE, std::memory_order_release);
+        if (!found) {
+            s.sessions.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    bool SharedSessionTable::markConfirmed(const uint32_t policy_id) {
+        if (!base) {
+            return false;
+        }
+        const size_t index = stripeOf(policy_id);
+        const StripeLock lock(*this, index);
+        if (!lock.owns()) {
+            return false;
+        }
+        SessionSlot *slots = sessionsOf(index);
+        bool found = false;
+        const size_t slot = probe(slots, sessionSlots - 1, policy_id, found);
+        if (found) {
+            slots[slot].flags |= FLAG_CONFIRMED;
+        }
+        return found;
+    }
+
+    bool SharedSessionTable::loadSession(const uint32_t policy_id, ColdSession &out) {
+        if (!base) {
+            return false;
+        }
+        const size_t index = stripeOf(policy_id);
+        const StripeLock lock(*this, index);
+        if (!lock.owns()) {
+            return false;
+        }
+        const SessionSlot *slots = sessionsOf(index);
+        bool found = false;
+        const size_t slot = probe(slots, sessionSlots - 1, policy_id, found);
+        if (found) {
+            out.policy_id = policy_id;
+            out.epoch = slots[slot].epoch;
+            out.confirmed = (slots[slot].flags & FLAG_CONFIRMED) != 0;
+            out.ticketStamp = 0; // 票据密钥只在签发进程内有效，恢复的密钥没有可用的票据
+            std::memcpy(out.key.data(), slots[slot].key, KEY_SIZE);
+        }
+        return found;
+    }
+
+    bool SharedSessionTable::eraseSession(const uint32_t policy_id) {
+        if (!base) {
+            return false;
+        }
+        const size_t index = stripeOf(policy_id);
+        const StripeLock lock(*this, index);
+        if (!lock.owns()) {
+            return false;
+        }
+        SessionSlot *slots = sessionsOf(index);
+        bool found = false;
+        const size_t slot = probe(slots, sessionSlots - 1, policy_id, found);
+        if (found) {
+            std::memset(slots[slot].key, 0, sizeof(slots[slot].key));
+            slots[slot].state.store(SLOT_TOMBSTONE, std::memory_order_release);
+            stripe(index).sessions.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return found;
+    }
+
+    bool SharedSessionTable::storePolicy(const PolicyConfig &policy) {
+        if (!base || policy.remote_ip.size() >= SHARED_TABLE_IP_LEN) {
+            return false;
+        }
+        const size_t index = stripeOf(policy.policy_id);
+        const StripeLock lock(*this, index);
+        if (!lock.owns()) {
+            return false;
+        }
+        PolicySlot *slots = policiesOf(index);
+        bool found = false;
+        const size_t slot = probe(slots, policySlots - 1, policy.policy_id, found);
+        Stripe &s = stripe(index);
+        if (!found && (slot >= policySlots || s.policies.load(std::memory_order_relaxed) >= maxLive(policySlots))) {
+            return false;
+        }
+        PolicySlot &entry = slots[slot];
+        entry.state.store(SLOT_WRITING, std::memory_order_release);
+        entry.policyId = policy.policy_id;
+        entry.timeoutMs = policy.timeout_ms;
+        entry.retryTimes = policy.retry_times;
+        entry.remotePort = policy.remote_port;
+        std::memset(entry.remoteIp, 0, sizeof(entry.remoteIp));
+        std::memcpy(entry.remoteIp, policy.remote_ip.data(), policy.remote_ip.size());
+        entry.state.store(SLOT_LIVE, std::memory_order_release);
+        if (!found) {
+            s.policies.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    bool SharedSessionTable::loadPolicy(const uint32_t policy_id, PolicyConfig &out) {
+        if (!base) {
+            return false;
+        }
+        const size_t index = stripeOf(policy_id);
+        const StripeLock lock(*this, index);
+        if (!lock.owns()) {
+            return false;
+        }
+        const PolicySlot *slots = policiesOf(index);
+        bool found = false;
+        const size_t slot = probe(slots, policySlots - 1, policy_id, found);
+        if (found) {
+            out.policy_id = policy_id;
+            out.remote_ip = slots[slot].remoteIp;
+            out.remote_port = slots[slot].remotePort;
+            out.timeout_ms = slots[slot].timeoutMs;
+            out.retry_times = slots[slot].retryTimes;
+        }
+        return found;
+    }
+
+    std::vector<ColdSession> SharedSessionTable::snapshotSessions() {
+        std::vector<ColdSession> out;
+        if (!base) {
+            return out;
+        }
+        out.reserve(sessionCount());
+        for (size_t index = 0; index < SHARED_TABLE_STRIPES; ++index) {
+            const StripeLock lock(*this, index);
+            if (!lock.owns()) {
+                continue;
+            }
+            const SessionSlot *slots = sessionsOf(index);
+            for (size_t i = 0; i < sessionSlots; ++i) {
+                if (slots[i].state.load(std::memory_order_relaxed) != SLOT_LIVE) {
+                    continue;
+                }
+                ColdSession session{};
+                session.policy_id = slots[i].policyId;
+                session.epoch = slots[i].epoch;
+                session.confirmed = (slots[i].flags & FLAG_CONFIRMED) != 0;
+                std::memcpy(session.key.data(), slots[i].key, KEY_SIZE);
+                out.push_back(session);
+            }
+        }
+        return out;
+    }
+
+    std::vector<PolicyConfig> SharedSessionTable::snapshotPolicies() {
+        std::vector<PolicyConfig> out;
+        if (!base) {
+            return out;
+        }
+        out.reserve(policyCount());
+        for (size_t index = 0; index < SHARED_TABLE_STRIPES; ++index) {
+            const StripeLock lock(*this, index);
+            if (!lock.owns()) {
+                continue;
+            }
+            const PolicySlot *slots = policiesOf(index);
+            for (size_t i = 0; i < policySlots; ++i) {
+                if (slots[i].state.load(std::memory_order_relaxed) != SLOT_LIVE) {
+                    continue;
+                }
+                out.push_back(PolicyConfig{slots[i].policyId, slots[i].remoteIp, slots[i].remotePort,
+                                           slots[i].timeoutMs, slots[i].retryTimes});
+            }
+        }
+        return out;
+    }
+
+    size_t SharedSessionTable::sessionCount() const {
+        size_t total = 0;
+        for (size_t i = 0; base && i < SHARED_TABLE_STRIPES; ++i) {
+            total += stripe(i).sessions.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    size_t SharedSessionTable::policyCount() const {
+        size_t total = 0;
+        for (size_t i = 0; base && i < SHARED_TABLE_STRIPES; ++i) {
+            total += stripe(i).policies.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    uint64_t SharedSessionTable::getRecoveredLocks() const {
+        return base ? header().recoveredLocks.load(std::memory_order_relaxed) : 0;
+    }
+} // namespace negotio
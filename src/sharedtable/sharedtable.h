@@ -0,0 +1,217 @@
+/**
+ * 进程间共享的会话与策略表
+ *
+ * 多进程（prefork）模式下，监督进程在 fork 工作进程之前创建一个共享内存段，
+ * 其中保存已协商会话（policy_id → 密钥、纪元、确认状态）与策略配置。工作进程在每次写入本地冷存储时同步写入该表，
+ * 崩溃后由监督进程重新拉起的工作进程从表中恢复自己负责的会话与策略，已建立的密钥不会随进程一起丢失。
+ *
+ * 布局：段头 + SHARED_TABLE_STRIPES 个条带，每个条带有独立的会话槽数组与策略槽数组（开放寻址、线性探测），
+ * 容量在创建时固定，运行期不扩容也不做堆分配。
+ *
+ * 同步：每个条带一把进程间共享的健壮互斥锁（PTHREAD_PROCESS_SHARED + PTHREAD_MUTEX_ROBUST）。
+ * 持锁进程崩溃后，下一个加锁方得到 EOWNERDEAD，先修复条带再将锁标记为一致：
+ * 写入槽位时先置为“写入中”，写完再置为有效，修复时丢弃仍处于写入中的槽位并重新统计条目数，
+ * 因此崩溃只会丢失正在写入的那一条记录，不会留下半条密钥。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_SHAREDTABLE_H
+#define NEGOTIO_SHAREDTABLE_H
+
+#include "common.h"
+#include "../sessionstore/sessionstore.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <sys/types.h>
+
+#ifdef UNIT_TEST
+class SharedTableTest_RecoversLockHeldByCrashedProcess_Test;
+#endif
+
+namespace negotio {
+    constexpr char SHARED_TABLE_MAGIC[8] = {'N', 'G', 'O', 'S', 'H', 'T', 'B', '\0'};
+    constexpr uint32_t SHARED_TABLE_VERSION = 1;
+    constexpr size_t SHARED_TABLE_STRIPES = 16;       ///< 条带数，每个条带一把进程间互斥锁
+    constexpr size_t SHARED_TABLE_IP_LEN = 46;        ///< 策略远端地址最大长度（含结尾 '\0'，INET6_ADDRSTRLEN）
+    constexpr size_t DEFAULT_SHARED_SESSIONS = 65536; ///< 默认会话容量
+    constexpr size_t DEFAULT_SHARED_POLICIES = MAX_POLICY_COUNT; ///< 默认策略容量
+
+    class SharedSessionTable {
+    public:
+        SharedSessionTable() = default;
+
+        ~SharedSessionTable();
+
+        SharedSessionTable(const SharedSessionTable &) = delete;
+        SharedSessionTable &operator=(const SharedSessionTable &) = delete;
+
+        /**
+         * @brief 创建共享内存段并初始化各条带的进程间互斥锁
+         *
+         * 应在 fork 工作进程之前调用，子进程继承同一映射。段文件在表关闭前一直持有 flock 排他锁：
+         * 同一路径已被另一个实例使用时返回 false，不会截断其正在使用的表；上次异常退出遗留的段文件会被清空后重用。
+         * @param path 段文件路径，建议放在 tmpfs（如 /dev/shm）上
+         * @param sessionCapacity 最多保存的会话数
+         * @param policyCapacity 最多保存的策略数
+         * @return 成功返回 true
+         */
+        bool create(const std::string &path, size_t sessionCapacity = DEFAULT_SHARED_SESSIONS,
+                    size_t policyCapacity = DEFAULT_SHARED_POLICIES);
+
+        /**
+         * @brief 解除映射；创建方同时删除段文件
+         */
+        void close();
+
+        /**
+         * @brief 写入或覆盖一个已协商会话
+         * @return 表已满或未打开时返回 false
+         */
+        bool storeSession(uint32_t policy_id, uint32_t epoch, const SessionKey &key, bool confirmed);
+
+        /**
+         * @brief 将已协商会话标记为已确认
+         * @return 条目存在时返回 true
+         */
+        bool markConfirmed(uint32_t policy_id);
+
+        /**
+         * @brief 读取一个已协商会话
+         * @return 存在时返回 true
+         */
+        bool loadSession(uint32_t policy_id, ColdSession &out);
+
+        /**
+         * @brief 删除一个已协商会话
+         * @return 存在并删除时返回 true
+         */
+        bool eraseSession(uint32_t policy_id);
+
+        /**
+         * @brief 写入或覆盖一条策略配置
+         * @return 表已满、未打开或远端地址过长时返回 false
+         */
+        bool storePolicy(const PolicyConfig &policy);
+
+        /**
+         * @brief 读取一条策略配置
+         * @return 存在时返回 true
+         */
+        bool loadPolicy(uint32_t policy_id, PolicyConfig &out);
+
+        /**
+         * @brief 复制全部会话（逐条带加锁，用于工作进程重启后的恢复）
+         */
+        std::vector<ColdSession> snapshotSessions();
+
+        /**
+         * @brief 复制全部策略（逐条带加锁）
+         */
+        std::vector<PolicyConfig> snapshotPolicies();
+
+        [[nodiscard]] size_t sessionCount() const;
+
+        [[nodiscard]] size_t policyCount() const;
+
+        /**
+         * @brief 从崩溃的持锁进程手中恢复条带锁的次数
+         */
+        [[nodiscard]] uint64_t getRecoveredLocks() const;
+
+        [[nodiscard]] bool isOpen() const {
+            return base != nullptr;
+        }
+
+        /**
+         * @brief 将本进程对共享表的映射锁定在内存中（MLOCK_ONFAULT，只锁定已触碰的页）
+         * @return 锁定成功返回 true
+         */
+        bool lockInMemory() const;
+
+    private:
+        struct alignas(64) Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t stripes;
+            uint64_t sessionSlots;                 ///< 每个条带的会话槽数
+            uint64_t policySlots;                  ///< 每个条带的策略槽数
+            std::atomic<uint64_t> recoveredLocks;  ///< 从崩溃进程恢复条带锁的次数
+        };
+
+        struct alignas(64) Stripe {
+            pthread_mutex_t mtx;
+            std::atomic<uint32_t> sessions;  ///< 有效会话数（持锁写，统计时无锁读）
+            std::atomic<uint32_t> policies;  ///< 有效策略数
+        };
+
+        struct SessionSlot {
+            std::atomic<uint32_t> state;
+            uint32_t policyId;
+            uint32_t epoch;
+            uint32_t flags;
+            uint8_t key[KEY_SIZE];
+        };
+
+        struct PolicySlot {
+            std::atomic<uint32_t> state;
+            uint32_t policyId;
+            uint32_t timeoutMs;
+            uint32_t retryTimes;
+            uint16_t remotePort;
+            char remoteIp[SHARED_TABLE_IP_LEN];
+        };
+
+        class StripeLock;
+
+        static constexpr uint32_t SLOT_EMPTY = 0;
+        static constexpr uint32_t SLOT_LIVE = 1;
+        static constexpr uint32_t SLOT_TOMBSTONE = 2;
+        static constexpr uint32_t SLOT_WRITING = 3; ///< 持锁写入中，持锁进程崩溃后由 repairStripe 丢弃
+
+        uint8_t *base = nullptr;
+        size_t mappedSize = 0;
+        std::string filePath;
+        pid_t creatorPid = 0;
+        int lockFd = -1; ///< 段文件描述符，持有 flock 排他锁直到 close
+        size_t sessionSlots = 0; ///< 每个条带的会话槽数（2 的幂）
+        size_t policySlots = 0;  ///< 每个条带的策略槽数（2 的幂）
+
+        [[nodiscard]] Header &header() const;
+
+        [[nodiscard]] Stripe &stripe(size_t index) const;
+
+        [[nodiscard]] SessionSlot *sessionsOf(size_t stripeIndex) const;
+
+        [[nodiscard]] PolicySlot *policiesOf(size_t stripeIndex) const;
+
+        /**
+         * @brief 持锁进程崩溃后修复条带：丢弃写入中的槽位并重新统计条目数
+         */
+        void repairStripe(size_t stripeIndex) const;
+
+        static size_t stripeOf(uint32_t policy_id);
+
+        static size_t homeSlot(uint32_t policy_id, size_t mask);
+
+        /**
+         * @brief 在条带的槽数组中线性探测（调用方需持有条带锁）
+         * @return policy_id 所在槽；不存在时 found 为 false，返回可插入的槽（条带已满时返回 mask + 1）
+         */
+        template<typename Slot>
+        static size_t probe(Slot *slots, size_t mask, uint32_t policy_id, bool &found);
+#ifdef UNIT_TEST
+        friend class ::SharedTableTest_RecoversLockHeldByCrashedProcess_Test;
+#endif
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_SHAREDTABLE_H
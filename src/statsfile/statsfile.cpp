@@ -0,0 +1,157 @@
+/**
+ * @file statsfile.cpp
+ * @brief 内存映射统计文件实现
+ */
+
+#include "statsfile.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace negotio {
+    namespace {
+        constexpr size_t STATS_FILE_SIZE = sizeof(StatsFileHeader) + sizeof(StatsPayload);
+
+        static_assert(sizeof(StatsFileHeader) == 64, "StatsFileHeader 布局变化需同步递增 STATS_FILE_VERSION");
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "seqlock 序号需要跨进程无锁原子操作");
+    }
+
+    StatsFileWriter::~StatsFileWriter() {
+        close();
+    }
+
+    bool StatsFileWriter::open(const std::string &path) {
+        if (header) {
+            return false;
+        }
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cerr << "无法创建统计文件 " << path << std::endl;
+            return false;
+        }
+        if (ftruncate(fd, static_cast<off_t>(STATS_FILE_SIZE)) != 0) {
+            std::cerr << "无法设置统计文件大小 " << path << std::endl;
+            ::close(fd);
+            return false;
+        }
+        void *mapped = mmap(nullptr, STATS_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "无法映射统计文件 " << path << std::endl;
+            return false;
+        }
+
+        // ftruncate 得到的新文件内容为全 0，负载初始即为空快照
+        header = new(mapped) StatsFileHeader{};
+        payload = reinterpret_cast<StatsPayload *>(static_cast<uint8_t *>(mapped) + sizeof(StatsFileHeader));
+        mappedSize = STATS_FILE_SIZE;
+        filePath = path;
+
+        header->version = STATS_FILE_VERSION;
+        header->payloadSize = sizeof(StatsPayload);
+        header->pid = getpid();
+        header->startTimeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        header->sequence.store(0, std::memory_order_relaxed);
+        // 魔数最后写入：读取方看到魔数时其余字段均已就绪
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header->magic, STATS_FILE_MAGIC, sizeof(header->magic));
+        return true;
+    }
+
+    void StatsFileWriter::close() {
+        if (!header) {
+            return;
+        }
+        munmap(header, mappedSize);
+        unlink(filePath.c_str());
+        header = nullptr;
+        payload = nullptr;
+        mappedSize = 0;
+    }
+
+    void StatsFileWriter::publish(const StatsPayload &snapshot) {
+        if (!header) {
+            return;
+        }
+        const uint64_t seq = header->sequence.load(std::memory_order_relaxed);
+        header->sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(payload, &snapshot, sizeof(StatsPayload));
+        header->sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    StatsFileReader::~StatsFileReader() {
+        close();
+    }
+
+    bool StatsFileReader::open(const std::string &path) {
+        if (header) {
+            return false;
+        }
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < STATS_FILE_SIZE) {
+            ::close(fd);
+            return false;
+        }
+        void *mapped = mmap(nullptr, STATS_FILE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        const auto *mappedHeader = static_cast<const StatsFileHeader *>(mapped);
+        if (std::memcmp(mappedHeader->magic, STATS_FILE_MAGIC, sizeof(STATS_FILE_MAGIC)) != 0
+            || mappedHeader->version != STATS_FILE_VERSION
+            || mappedHeader->payloadSize != sizeof(StatsPayload)) {
+            munmap(mapped, STATS_FILE_SIZE);
+            return false;
+        }
+        header = mappedHeader;
+        payload = reinterpret_cast<const StatsPayload *>(static_cast<const uint8_t *>(mapped) + sizeof(StatsFileHeader));
+        mappedSize = STATS_FILE_SIZE;
+        return true;
+    }
+
+    void StatsFileReader::close() {
+        if (!header) {
+            return;
+        }
+        munmap(const_cast<StatsFileHeader *>(header), mappedSize);
+        header = nullptr;
+        payload = nullptr;
+        mappedSize = 0;
+    }
+
+    bool StatsFileReader::read(StatsPayload &out, const int maxRetries) const {
+        if (!header) {
+            return false;
+        }
+        for (int attempt = 0; attempt < maxRetries; ++attempt) {
+            const uint64_t before = header->sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::memcpy(&out, payload, sizeof(StatsPayload));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header->sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int64_t StatsFileReader::writerPid() const {
+        return header ? header->pid : 0;
+    }
+} // namespace negotio
@@ -0,0 +1,172 @@
+/**
+ * 内存映射统计文件
+ *
+ * Monitor 定期将计数器与直方图发布到一个版本化的内存映射文件（类似 JVM 的 hsperfdata），
+ * 外部采集程序以只读方式 mmap 同一文件并直接读取，不需要与 Negotio 进行任何系统调用交互。
+ *
+ * 一致性通过 seqlock 保证：写入方（单线程）在写入负载前后各递增一次序号，序号为奇数表示正在写入；
+ * 读取方在复制负载前后读取序号，两次相同且为偶数时快照有效，否则重试。
+ *
+ * 文件布局：StatsFileHeader（64 字节）+ StatsPayload，均为本机字节序。
+ * 负载结构变化时必须递增 STATS_FILE_VERSION。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_STATSFILE_H
+#define NEGOTIO_STATSFILE_H
+
+#include "../lockstat/lockstat.h"
+#include "../allocstat/allocstat.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace negotio {
+    constexpr char STATS_FILE_MAGIC[8] = {'N', 'G', 'O', 'S', 'T', 'A', 'T', '\0'};
+    constexpr uint32_t STATS_FILE_VERSION = 4;
+    constexpr size_t STATS_LATENCY_BUCKETS = 16; ///< 协商耗时直方图桶数
+    constexpr size_t STATS_MAX_LOCK_SITES = 16;  ///< 统计文件中最多保存的锁位点数
+    constexpr size_t STATS_NAME_LEN = 48;        ///< 锁位点名称最大长度（含结尾 '\0'）
+
+    // 统计文件头，readers 先校验 magic/version/payloadSize 再读取负载
+    struct alignas(64) StatsFileHeader {
+        char magic[8];                  ///< 文件魔数 "NGOSTAT"
+        uint32_t version;               ///< 格式版本
+        uint32_t payloadSize;           ///< sizeof(StatsPayload)
+        int64_t pid;                    ///< 写入进程 PID
+        uint64_t startTimeNs;           ///< 写入方启动时间（CLOCK_REALTIME，纳秒）
+        std::atomic<uint64_t> sequence; ///< seqlock 序号，奇数表示正在写入
+    };
+
+    // 单个锁位点的统计
+    struct StatsLockSite {
+        char name[STATS_NAME_LEN];
+        uint64_t acquisitions;
+        uint64_t contended;
+        uint64_t waitNs;
+        uint64_t maxWaitNs;
+        uint64_t waitHistogram[LOCK_WAIT_BUCKETS];
+    };
+
+    // 统计负载，整体按 seqlock 发布
+    struct StatsPayload {
+        uint64_t updateTimeNs;            ///< 最近一次发布时间（CLOCK_REALTIME，纳秒）
+        uint64_t totalNegotiations;       ///< 协商总数
+        uint64_t successfulNegotiations;  ///< 成功协商数
+        uint64_t totalLatencyMs;          ///< 成功协商累计耗时（毫秒）
+        uint64_t latencyHistogram[STATS_LATENCY_BUCKETS]; ///< 协商耗时直方图，桶边界见 latencyBucketOf
+        uint32_t bootstrapTotal;          ///< 启动策略总数（未配置引导时为 0）
+        uint32_t bootstrapStarted;        ///< 启动策略已发起协商数
+        uint32_t bootstrapCompleted;      ///< 启动策略已完成协商数
+        uint32_t reserved;
+        uint32_t lockSiteCount;           ///< lockSites 中的有效条目数
+        uint32_t allocTagCount;           ///< allocByTag 中的有效条目数（NEGOTIO_ALLOC_STATS 关闭时为 0）
+        uint64_t stalePackets;            ///< 排队时延超过协商超时而被丢弃的包数
+        uint64_t oneWayDelayHistogram[STATS_LATENCY_BUCKETS]; ///< 单向排队时延直方图，桶边界同 latencyHistogram
+        uint32_t concurrencyLimit;        ///< 自适应并发上限（未开启并发限制时为 0）
+        uint32_t concurrencyInFlight;     ///< 占用名额的在途协商数
+        uint32_t concurrencyWindowMs;     ///< 最近一个窗口的协商耗时 p90（毫秒），UINT32_MAX 表示超时
+        uint32_t concurrencyTargetMs;     ///< 时延目标（毫秒）
+        uint64_t admissionRejected;       ///< 超出并发上限而被延后或丢弃的协商数
+        StatsLockSite lockSites[STATS_MAX_LOCK_SITES];
+        AllocCounters allocByTag[ALLOC_TAG_COUNT];
+    };
+
+    /**
+     * @brief 协商耗时所在的直方图桶：桶 0 为 0 ms，桶 i (i >= 1) 覆盖 [2^(i-1), 2^i) ms，最后一个桶不设上界
+     */
+    constexpr size_t latencyBucketOf(const uint64_t durationMs) {
+        size_t bucket = 0;
+        for (uint64_t v = durationMs; v != 0 && bucket < STATS_LATENCY_BUCKETS - 1; v >>= 1) {
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    /**
+     * @brief 统计文件写入方（单线程调用 publish）
+     */
+    class StatsFileWriter {
+    public:
+        StatsFileWriter() = default;
+
+        ~StatsFileWriter();
+
+        StatsFileWriter(const StatsFileWriter &) = delete;
+        StatsFileWriter &operator=(const StatsFileWriter &) = delete;
+
+        /**
+         * @brief 创建（或覆盖）统计文件并映射到内存
+         * @param path 文件路径，建议放在 tmpfs（如 /dev/shm）上避免回写磁盘
+         * @return 成功返回 true
+         */
+        bool open(const std::string &path);
+
+        /**
+         * @brief 解除映射并删除统计文件
+         */
+        void close();
+
+        /**
+         * @brief 以 seqlock 方式发布一份完整快照
+         */
+        void publish(const StatsPayload &payload);
+
+        [[nodiscard]] bool isOpen() const {
+            return header != nullptr;
+        }
+
+    private:
+        StatsFileHeader *header = nullptr;
+        StatsPayload *payload = nullptr;
+        size_t mappedSize = 0;
+        std::string filePath;
+    };
+
+    /**
+     * @brief 统计文件读取方，可在任意进程中使用
+     */
+    class StatsFileReader {
+    public:
+        StatsFileReader() = default;
+
+        ~StatsFileReader();
+
+        StatsFileReader(const StatsFileReader &) = delete;
+        StatsFileReader &operator=(const StatsFileReader &) = delete;
+
+        /**
+         * @brief 以只读方式映射统计文件并校验文件头
+         * @param path 文件路径
+         * @return 成功返回 true；魔数、版本或负载大小不匹配时返回 false
+         */
+        bool open(const std::string &path);
+
+        void close();
+
+        /**
+         * @brief 读取一致的快照
+         * @param out 输出快照
+         * @param maxRetries 写入方持续写入时的最大重试次数
+         * @return 成功返回 true，重试耗尽返回 false
+         */
+        bool read(StatsPayload &out, int maxRetries = 1000) const;
+
+        /**
+         * @brief 写入进程的 PID
+         */
+        [[nodiscard]] int64_t writerPid() const;
+
+    private:
+        const StatsFileHeader *header = nullptr;
+        const StatsPayload *payload = nullptr;
+        size_t mappedSize = 0;
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_STATSFILE_H
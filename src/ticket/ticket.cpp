@@ -0,0 +1,146 @@
+/**
+ * @file ticket.cpp
+ * @brief 会话恢复票据实现
+ */
+
+#include "ticket.h"
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+namespace negotio {
+    namespace {
+        constexpr char RESUMPTION_LABEL[] = "negotio resumption";
+
+        struct CipherCtxDeleter {
+            void operator()(EVP_CIPHER_CTX *ctx) const {
+                EVP_CIPHER_CTX_free(ctx);
+            }
+        };
+
+        using CipherCtx = std::unique_ptr<EVP_CIPHER_CTX, CipherCtxDeleter>;
+
+        // 离开作用域时清除栈上的票据明文（含恢复密钥）
+        struct PlaintextWipe {
+            uint8_t *bytes;
+
+            ~PlaintextWipe() {
+                secureWipe(bytes, TICKET_PLAINTEXT_SIZE);
+            }
+        };
+
+        uint32_t nowSeconds() {
+            return std::chrono::duration_cast<std::chrono::duration<uint32_t>>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+    }
+
+    ResumptionSecret deriveResumptionSecret(const SessionKey &key) {
+        uint8_t input[sizeof(RESUMPTION_LABEL) - 1 + KEY_SIZE];
+        std::memcpy(input, RESUMPTION_LABEL, sizeof(RESUMPTION_LABEL) - 1);
+        std::memcpy(input + sizeof(RESUMPTION_LABEL) - 1, key.data(), KEY_SIZE);
+        ResumptionSecret secret{};
+        SHA256(input, sizeof(input), secret.data());
+        secureWipe(input, sizeof(input));
+        return secret;
+    }
+
+    SessionKey computeResumedKey(const ResumptionSecret &secret, const SessionRandom &random1,
+                                 const SessionRandom &random2) {
+        uint8_t input[KEY_SIZE + RANDOM_NUMBER * 2];
+        std::memcpy(input, secret.data(), KEY_SIZE);
+        std::memcpy(input + KEY_SIZE, random1.data(), RANDOM_NUMBER);
+        std::memcpy(input + KEY_SIZE + RANDOM_NUMBER, random2.data(), RANDOM_NUMBER);
+        SessionKey key{};
+        SHA256(input, sizeof(input), key.data());
+        secureWipe(input, sizeof(input));
+        return key;
+    }
+
+    TicketSealer::TicketSealer() {
+        RAND_bytes(key.get(), KEY_SIZE);
+    }
+
+    TicketSealer::TicketSealer(const std::array<uint8_t, KEY_SIZE> &ticketKey) {
+        std::memcpy(key.get(), ticketKey.data(), KEY_SIZE);
+    }
+
+    bool TicketSealer::seal(const uint32_t policy_id, const ResumptionSecret &secret, ResumptionTicket &out,
+                            uint32_t *stamp) const {
+        uint8_t plaintext[TICKET_PLAINTEXT_SIZE];
+        const uint32_t issuedAt = nowSeconds();
+        uint32_t ticketStamp = nextStamp.fetch_add(1, std::memory_order_relaxed) & STAMP_MASK;
+        if (ticketStamp == 0) {
+            ticketStamp = nextStamp.fetch_add(1, std::memory_order_relaxed) & STAMP_MASK;
+        }
+        std::memcpy(plaintext, &policy_id, sizeof(policy_id));
+        std::memcpy(plaintext + sizeof(policy_id), &issuedAt, sizeof(issuedAt));
+        std::memcpy(plaintext + sizeof(policy_id) + sizeof(issuedAt), &ticketStamp, sizeof(ticketStamp));
+        std::memcpy(plaintext + sizeof(policy_id) + sizeof(issuedAt) + sizeof(ticketStamp), secret.data(),
+                    secret.size());
+        const PlaintextWipe wipe{plaintext};
+        if (stamp) {
+            *stamp = ticketStamp;
+        }
+
+        uint8_t *nonce = out.data();
+        uint8_t *ciphertext = nonce + TICKET_NONCE_SIZE;
+        uint8_t *tag = ciphertext + TICKET_PLAINTEXT_SIZE;
+        if (RAND_bytes(nonce, TICKET_NONCE_SIZE) != 1) {
+            return false;
+        }
+
+        const CipherCtx ctx(EVP_CIPHER_CTX_new());
+        int len = 0;
+        return ctx
+               && EVP_EncryptInit_ex(ctx.get(), EVP_aes_256_gcm(), nullptr, key.get(), nonce) == 1
+               && EVP_EncryptUpdate(ctx.get(), nullptr, &len, reinterpret_cast<const uint8_t *>(&policy_id),
+                                    sizeof(policy_id)) == 1
+               && EVP_EncryptUpdate(ctx.get(), ciphertext, &len, plaintext, TICKET_PLAINTEXT_SIZE) == 1
+               && EVP_EncryptFinal_ex(ctx.get(), ciphertext + len, &len) == 1
+               && EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG, TICKET_TAG_SIZE, tag) == 1;
+    }
+
+    bool TicketSealer::open(const uint8_t *ticket, const uint32_t policy_id, const uint32_t lifetimeS,
+                            ResumptionSecret &secret, uint32_t *stamp) const {
+        const uint8_t *nonce = ticket;
+        const uint8_t *ciphertext = nonce + TICKET_NONCE_SIZE;
+        const uint8_t *tag = ciphertext + TICKET_PLAINTEXT_SIZE;
+        uint8_t plaintext[TICKET_PLAINTEXT_SIZE];
+        const PlaintextWipe wipe{plaintext};
+
+        const CipherCtx ctx(EVP_CIPHER_CTX_new());
+        int len = 0;
+        if (!ctx
+            || EVP_DecryptInit_ex(ctx.get(), EVP_aes_256_gcm(), nullptr, key.get(), nonce) != 1
+            || EVP_DecryptUpdate(ctx.get(), nullptr, &len, reinterpret_cast<const uint8_t *>(&policy_id),
+                                 sizeof(policy_id)) != 1
+            || EVP_DecryptUpdate(ctx.get(), plaintext, &len, ciphertext, TICKET_PLAINTEXT_SIZE) != 1
+            || EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_TAG, TICKET_TAG_SIZE, const_cast<uint8_t *>(tag)) != 1
+            || EVP_DecryptFinal_ex(ctx.get(), plaintext + len, &len) != 1) {
+            return false;
+        }
+
+        uint32_t ticketPolicy = 0;
+        uint32_t issuedAt = 0;
+        uint32_t ticketStamp = 0;
+        std::memcpy(&ticketPolicy, plaintext, sizeof(ticketPolicy));
+        std::memcpy(&issuedAt, plaintext + sizeof(ticketPolicy), sizeof(issuedAt));
+        std::memcpy(&ticketStamp, plaintext + sizeof(ticketPolicy) + sizeof(issuedAt), sizeof(ticketStamp));
+        const uint32_t now = nowSeconds();
+        if (ticketPolicy != policy_id || issuedAt > now + 1 || now - issuedAt > lifetimeS) {
+            return false;
+        }
+        std::memcpy(secret.data(), plaintext + sizeof(ticketPolicy) + sizeof(issuedAt) + sizeof(ticketStamp),
+                    secret.size());
+        if (stamp) {
+            *stamp = ticketStamp;
+        }
+        return true;
+    }
+} // namespace negotio
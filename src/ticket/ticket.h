@@ -0,0 +1,101 @@
+/**
+ * 会话恢复票据
+ *
+ * 响应方在完整协商中随 RANDOM2 下发一张加密票据，票据内容只有响应方能解开：
+ *   明文   = policy_id(4) | 签发时间(4，CLOCK_REALTIME 秒) | 票据序号(4) | 恢复密钥(32)
+ *   票据   = nonce(12) | AES-256-GCM(明文)(44) | tag(16)，附加认证数据为 policy_id
+ * 恢复密钥 = SHA256("negotio resumption" || 协商密钥)，发起方用自己算出的协商密钥独立推导，
+ * 因此票据本身不携带可直接使用的密钥，只有完成过协商的一方才能用它恢复。
+ *
+ * 之后的重新协商中，发起方在 RESUME 包里同时携带 R1 与票据；响应方解开票据即可得到恢复密钥，
+ * 密钥无需从会话状态中查找（只查已建立记录中的票据序号，见下），新密钥 = SHA256(恢复密钥 || R1 || R2)，
+ * 一个往返（RESUME / RESUME_ACK）即可完成。
+ * 票据无法解开（过期、进程重启后票据密钥变化、篡改）时响应方回退到完整的三包协商。
+ * 票据序号是签发方内唯一的 31 位非零值，响应方在冷存储中记录为当前密钥签发的票据序号，
+ * 已被使用或已被更新的密钥取代的票据序号不再相符，重放的 RESUME 因此不会被接受。
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_TICKET_H
+#define NEGOTIO_TICKET_H
+
+#include "common.h"
+#include "../lockedarena/lockedarena.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace negotio {
+    constexpr size_t TICKET_NONCE_SIZE = 12;
+    constexpr size_t TICKET_TAG_SIZE = 16;
+    constexpr size_t TICKET_PLAINTEXT_SIZE = sizeof(uint32_t) * 3 + KEY_SIZE;
+    constexpr size_t TICKET_SIZE = TICKET_NONCE_SIZE + TICKET_PLAINTEXT_SIZE + TICKET_TAG_SIZE; ///< 72 字节
+    constexpr uint32_t DEFAULT_TICKET_LIFETIME_S = 3600; ///< 票据默认有效期（秒）
+
+    static_assert(TICKET_SIZE % sizeof(uint32_t) == 0, "票据需按 uint32_t 放入数据包负载");
+
+    using ResumptionTicket = std::array<uint8_t, TICKET_SIZE>;
+    using ResumptionSecret = std::array<uint8_t, KEY_SIZE>;
+
+    /**
+     * @brief 由协商密钥推导恢复密钥
+     */
+    ResumptionSecret deriveResumptionSecret(const SessionKey &key);
+
+    /**
+     * @brief 恢复协商的新密钥：SHA256(恢复密钥 || random1 || random2)
+     */
+    SessionKey computeResumedKey(const ResumptionSecret &secret, const SessionRandom &random1,
+                                 const SessionRandom &random2);
+
+    /**
+     * @brief 票据加解密（响应方使用），密钥在构造时随机生成，只在本进程内有效
+     *
+     * 票据密钥分配在锁定内存区（见 LockedArena），不会换出到磁盘，析构时清零。
+     */
+    class TicketSealer {
+    public:
+        TicketSealer();
+
+        /**
+         * @brief 使用指定票据密钥（多个进程共享票据时使用）
+         */
+        explicit TicketSealer(const std::array<uint8_t, KEY_SIZE> &ticketKey);
+
+        /**
+         * @brief 为指定策略签发票据
+         * @param policy_id 策略ID
+         * @param secret 恢复密钥
+         * @param out 输出票据
+         * @param stamp 不为空时输出票据序号
+         * @return 加密失败时返回 false
+         */
+        bool seal(uint32_t policy_id, const ResumptionSecret &secret, ResumptionTicket &out,
+                  uint32_t *stamp = nullptr) const;
+
+        /**
+         * @brief 解开票据
+         * @param ticket 票据
+         * @param policy_id 期望的策略ID（与附加认证数据及明文中的 policy_id 比对）
+         * @param lifetimeS 有效期（秒）
+         * @param secret 输出恢复密钥
+         * @param stamp 不为空时输出票据序号
+         * @return 认证失败、策略不符或已过期时返回 false
+         */
+        bool open(const uint8_t *ticket, uint32_t policy_id, uint32_t lifetimeS, ResumptionSecret &secret,
+                  uint32_t *stamp = nullptr) const;
+
+    private:
+        static constexpr uint32_t STAMP_MASK = 0x7FFFFFFFu;
+
+        LockedArray<uint8_t> key = makeLockedArray<uint8_t>(KEY_SIZE);
+        mutable std::atomic<uint32_t> nextStamp{1};
+    };
+} // namespace negotio
+
+#endif // NEGOTIO_TICKET_H
@@ -10,16 +10,55 @@
  */
 
 #include "udp.h"
+#include "../capture/capture.h"
+#include "../allocstat/allocstat.h"
+#include "probes.h"
 
 #include <unistd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
 #include <cstring>
 #include <fcntl.h>
 #include <sys/select.h>
+#include <sys/uio.h>
 #include <linux/udp.h>
+#include <linux/filter.h>
 
 namespace negotio {
+    namespace {
+        constexpr size_t DATAGRAM_BUFFER_BYTES = 4096;
+
+        // 线程复用的收发缓冲区：数据报缓冲区与 mmsghdr 数组只在批大小增长时扩容
+        struct IoBuffers {
+            std::vector<std::vector<uint8_t>> datagrams;
+            std::vector<iovec> iovecs;
+            std::vector<sockaddr_in> addrs;
+            std::vector<mmsghdr> messages;
+
+            void reserve(const size_t count) {
+                if (datagrams.size() < count) {
+                    datagrams.resize(count);
+                }
+                iovecs.resize(count);
+                addrs.assign(count, sockaddr_in{});
+                messages.assign(count, mmsghdr{});
+            }
+        };
+
+        IoBuffers &recvBuffers() {
+            static thread_local IoBuffers buffers;
+            return buffers;
+        }
+
+        IoBuffers &sendBuffers() {
+            static thread_local IoBuffers buffers;
+            return buffers;
+        }
+    }
+
     UdpSocket::UdpSocket() : sockfd(-1) {
     }
 
@@ -30,6 +69,10 @@ namespace negotio {
     }
 
     ErrorCode UdpSocket::init(uint16_t port) {
+        return init(port, UdpSocketOptions{});
+    }
+
+    ErrorCode UdpSocket::init(uint16_t port, const UdpSocketOptions &options) {
         sockfd = socket(AF_INET, SOCK_DGRAM, 0);
         if (sockfd == -1) {
             return ErrorCode::SOCKET_ERROR;
@@ -48,6 +91,14 @@ namespace negotio {
             close(sockfd);
             return ErrorCode::SOCKET_ERROR;
         }
+        if (options.reusePort && setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1) {
+            close(sockfd);
+            return ErrorCode::SOCKET_ERROR;
+        }
+        // 内核在 SO_REUSEPORT 组内优先选择 incoming_cpu 与当前软中断所在核一致的套接字
+        if (options.incomingCpu >= 0) {
+            setsockopt(sockfd, SOL_SOCKET, SO_INCOMING_CPU, &options.incomingCpu, sizeof(options.incomingCpu));
+        }
 
         // 绑定地址
         sockaddr_in localAddr = {};
@@ -73,10 +124,76 @@ namespace negotio {
         return ErrorCode::SUCCESS;
     }
 
+    ErrorCode UdpSocket::attachCpuSteering(const uint32_t firstCpu, const uint32_t shards) const {
+        if (sockfd == -1 || shards == 0) {
+            return ErrorCode::INVALID_PARAM;
+        }
+        // A = 当前 CPU; A = (A - firstCpu) % shards; 返回 A 作为组内套接字序号
+        sock_filter code[] = {
+            {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+            {BPF_ALU | BPF_SUB | BPF_K, 0, 0, firstCpu},
+            {BPF_ALU | BPF_MOD | BPF_K, 0, 0, shards},
+            {BPF_RET | BPF_A, 0, 0, 0},
+        };
+        sock_fprog program{};
+        program.len = sizeof(code) / sizeof(code[0]);
+        program.filter = code;
+        if (setsockopt(sockfd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == -1) {
+            return ErrorCode::SOCKET_ERROR;
+        }
+        return ErrorCode::SUCCESS;
+    }
+
+    ErrorCode UdpSocket::attachPolicySteering(const uint32_t shards) const {
+        if (sockfd == -1 || shards == 0) {
+            return ErrorCode::INVALID_PARAM;
+        }
+        // reuseport 程序看到的数据从 UDP 负载开始；包头按本机字节序序列化，policy_id 即 header.sequence
+        constexpr uint32_t offset = offsetof(PacketHeader, sequence);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        sock_filter code[] = {
+            {BPF_LD | BPF_W | BPF_ABS, 0, 0, offset},
+            {BPF_ALU | BPF_MOD | BPF_K, 0, 0, shards},
+            {BPF_RET | BPF_A, 0, 0, 0},
+        };
+#else
+        // BPF_W 按网络字节序读取，小端主机逐字节拼出 policy_id；越界读取时程序返回 0
+        sock_filter code[] = {
+            {BPF_LD | BPF_B | BPF_ABS, 0, 0, offset + 3},
+            {BPF_ALU | BPF_LSH | BPF_K, 0, 0, 24},
+            {BPF_MISC | BPF_TAX, 0, 0, 0},
+            {BPF_LD | BPF_B | BPF_ABS, 0, 0, offset + 2},
+            {BPF_ALU | BPF_LSH | BPF_K, 0, 0, 16},
+            {BPF_ALU | BPF_OR | BPF_X, 0, 0, 0},
+            {BPF_MISC | BPF_TAX, 0, 0, 0},
+            {BPF_LD | BPF_B | BPF_ABS, 0, 0, offset + 1},
+            {BPF_ALU | BPF_LSH | BPF_K, 0, 0, 8},
+            {BPF_ALU | BPF_OR | BPF_X, 0, 0, 0},
+            {BPF_MISC | BPF_TAX, 0, 0, 0},
+            {BPF_LD | BPF_B | BPF_ABS, 0, 0, offset},
+            {BPF_ALU | BPF_OR | BPF_X, 0, 0, 0},
+            {BPF_ALU | BPF_MOD | BPF_K, 0, 0, shards},
+            {BPF_RET | BPF_A, 0, 0, 0},
+        };
+#endif
+        sock_fprog program{};
+        program.len = sizeof(code) / sizeof(code[0]);
+        program.filter = code;
+        if (setsockopt(sockfd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == -1) {
+            return ErrorCode::SOCKET_ERROR;
+        }
+        return ErrorCode::SUCCESS;
+    }
+
     ErrorCode UdpSocket::sendPacket(const NegotiationPacket &packet, sockaddr_in &addr) {
+        AllocScope allocScope(AllocTag::UDP);
         std::lock_guard lock(sendMutex);
         // 使用线程局部的缓冲区,避免频繁分配
-        static thread_local std::vector<uint8_t> buffer;
+        IoBuffers &buffers = sendBuffers();
+        if (buffers.datagrams.empty()) {
+            buffers.reserve(1);
+        }
+        std::vector<uint8_t> &buffer = buffers.datagrams[0];
         buffer.clear();
         if (const ssize_t bytes = serializePacket(packet, buffer); bytes == -1) {
             return ErrorCode::INVALID_PARAM;
@@ -85,10 +202,63 @@ namespace negotio {
                                         reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)); sent < 0) {
             return ErrorCode::SOCKET_ERROR;
         }
+        NEGOTIO_PROBE3(packet__sent, packet.header.sequence, static_cast<uint32_t>(packet.header.type),
+                       buffer.size());
         return ErrorCode::SUCCESS;
     }
 
+    ErrorCode UdpSocket::sendBuffer(const uint8_t *data, const size_t len, sockaddr_in &addr) {
+        std::lock_guard lock(sendMutex);
+        if (sendto(sockfd, data, len, 0, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+            return ErrorCode::SOCKET_ERROR;
+        }
+        return ErrorCode::SUCCESS;
+    }
+
+    size_t UdpSocket::sendPackets(const std::vector<AddressedPacket> &packets) {
+        AllocScope allocScope(AllocTag::UDP);
+        std::lock_guard lock(sendMutex);
+        // 序列化缓冲区与消息头按线程复用，只在批大小增长时扩容
+        IoBuffers &io = sendBuffers();
+        const size_t count = packets.size();
+        io.reserve(count);
+        auto &buffers = io.datagrams;
+        auto &iovecs = io.iovecs;
+        auto &messages = io.messages;
+        for (size_t i = 0; i < count; ++i) {
+            buffers[i].clear();
+            serializePacket(packets[i].first, buffers[i]);
+            iovecs[i].iov_base = buffers[i].data();
+            iovecs[i].iov_len = buffers[i].size();
+            messages[i].msg_hdr.msg_name = const_cast<sockaddr_in *>(&packets[i].second);
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            messages[i].msg_hdr.msg_iov = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        size_t next = 0;
+        size_t sent = 0;
+        while (next < count) {
+            const int ret = sendmmsg(sockfd, messages.data() + next, static_cast<unsigned int>(count - next), 0);
+            if (ret <= 0) {
+                if (ret < 0 && errno == EINTR) {
+                    continue;
+                }
+                // 与 sendPacket 一样不重试：跳过被拒绝的数据包，其余继续发送
+                ++next;
+                continue;
+            }
+            for (size_t i = next; i < next + static_cast<size_t>(ret); ++i) {
+                NEGOTIO_PROBE3(packet__sent, packets[i].first.header.sequence,
+                               static_cast<uint32_t>(packets[i].first.header.type), buffers[i].size());
+            }
+            next += static_cast<size_t>(ret);
+            sent += static_cast<size_t>(ret);
+        }
+        return sent;
+    }
+
     ErrorCode UdpSocket::recvPacket(NegotiationPacket &packet, sockaddr_in &addr, int timeout_ms) const {
+        AllocScope allocScope(AllocTag::UDP);
         fd_set readfds;
         FD_ZERO(&readfds);
         FD_SET(sockfd, &readfds);
@@ -103,20 +273,82 @@ namespace negotio {
             return ErrorCode::TIMEOUT;
         }
 
-        std::vector<uint8_t> buffer(4096);
+        IoBuffers &buffers = recvBuffers();
+        if (buffers.datagrams.empty()) {
+            buffers.reserve(1);
+        }
+        std::vector<uint8_t> &buffer = buffers.datagrams[0];
+        buffer.resize(DATAGRAM_BUFFER_BYTES);
         socklen_t addrLen = sizeof(addr);
         const ssize_t received = recvfrom(sockfd, buffer.data(), buffer.size(), 0,
                                           reinterpret_cast<struct sockaddr *>(&addr), &addrLen);
         if (received == -1) {
             return ErrorCode::SOCKET_ERROR;
         }
+        if (captureWriter) {
+            captureWriter->record(buffer.data(), static_cast<size_t>(received), addr);
+        }
         buffer.resize(received);
         if (const ssize_t deserialize = deserializePacket(buffer, packet); deserialize < 0) {
             return ErrorCode::INVALID_PARAM;
         }
+        NEGOTIO_PROBE3(packet__received, packet.header.sequence, static_cast<uint32_t>(packet.header.type),
+                       static_cast<size_t>(received));
         return ErrorCode::SUCCESS;
     }
 
+    size_t UdpSocket::recvPackets(std::vector<AddressedPacket> &packets, const size_t maxPackets) const {
+        AllocScope allocScope(AllocTag::UDP);
+        if (maxPackets == 0) {
+            return 0;
+        }
+        IoBuffers &io = recvBuffers();
+        io.reserve(maxPackets);
+        auto &buffers = io.datagrams;
+        auto &iovecs = io.iovecs;
+        auto &addrs = io.addrs;
+        auto &messages = io.messages;
+        for (size_t i = 0; i < maxPackets; ++i) {
+            buffers[i].resize(DATAGRAM_BUFFER_BYTES);
+            iovecs[i].iov_base = buffers[i].data();
+            iovecs[i].iov_len = buffers[i].size();
+            messages[i].msg_hdr.msg_name = &addrs[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            messages[i].msg_hdr.msg_iov = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        const int received = recvmmsg(sockfd, messages.data(), static_cast<unsigned int>(maxPackets), MSG_DONTWAIT,
+                                      nullptr);
+        if (received <= 0) {
+            return 0;
+        }
+        for (int i = 0; i < received; ++i) {
+            const size_t len = messages[i].msg_len;
+            if (captureWriter) {
+                captureWriter->record(buffers[i].data(), len, addrs[i]);
+            }
+            buffers[i].resize(len);
+            NegotiationPacket packet;
+            if (deserializePacket(buffers[i], packet) < 0) {
+                continue;
+            }
+            NEGOTIO_PROBE3(packet__received, packet.header.sequence, static_cast<uint32_t>(packet.header.type), len);
+            packets.emplace_back(std::move(packet), addrs[i]);
+        }
+        return static_cast<size_t>(received);
+    }
+
+    void UdpSocket::prefaultBuffers(const size_t batch) {
+        AllocScope allocScope(AllocTag::UDP);
+        for (IoBuffers *io : {&recvBuffers(), &sendBuffers()}) {
+            io->reserve(std::max<size_t>(batch, 1));
+            for (auto &datagram : io->datagrams) {
+                // resize 写零，数据报缓冲区的页在此缺页
+                datagram.resize(DATAGRAM_BUFFER_BYTES);
+            }
+        }
+    }
+
     ssize_t UdpSocket::serializePacket(const NegotiationPacket &packet, std::vector<uint8_t> &buffer) {
         // 序列化格式: PacketHeader 固定大小 + payload 长度 * sizeof(uint32_t)
         constexpr size_t headerSize = sizeof(PacketHeader);
@@ -13,14 +13,25 @@
 #include <cstdint>
 #include <mutex>
 #include <unistd.h>
+#include <utility>
 #include <vector>
+#include <netinet/in.h>
 
 #include "common.h"
-
-struct sockaddr_in;
+#include "../lockstat/lockstat.h"
 
 namespace negotio {
     struct NegotiationPacket;
+    class CaptureWriter;
+
+    // 批量收发的数据包及其对端地址
+    using AddressedPacket = std::pair<NegotiationPacket, sockaddr_in>;
+
+    // 接收分片选项：多个 RX 线程各持一个 SO_REUSEPORT 套接字时使用
+    struct UdpSocketOptions {
+        bool reusePort = false; ///< 开启 SO_REUSEPORT，同一端口可绑定多个套接字
+        int incomingCpu = -1;   ///< SO_INCOMING_CPU，设为处理该套接字的 RX 线程所绑定的核，-1 表示不设置
+    };
 
     class UdpSocket {
     public:
@@ -29,15 +40,18 @@ namespace negotio {
         ~UdpSocket();
 
         // 移动构造函数
-        UdpSocket(UdpSocket&& other) noexcept : sockfd(other.sockfd) {
+        UdpSocket(UdpSocket&& other) noexcept : sockfd(other.sockfd), captureWriter(other.captureWriter) {
             other.sockfd = -1;
+            other.captureWriter = nullptr;
         };
         // 移动赋值函数
         UdpSocket& operator=(UdpSocket&& other) noexcept {
             if (this != &other) {
                 close(sockfd);
                 sockfd = other.sockfd;
+                captureWriter = other.captureWriter;
                 other.sockfd = -1;
+                other.captureWriter = nullptr;
             }
             return *this;
         }
@@ -49,6 +63,36 @@ namespace negotio {
          */
         ErrorCode init(uint16_t port);
 
+        /**
+         * @brief 按接收分片选项初始化 UDP 套接字, 绑定到指定端口
+         * @param port 绑定端口号
+         * @param options 分片选项
+         * @return 成功返回 ErrorCode::SUCCESS, 否则返回相应错误代码
+         */
+        ErrorCode init(uint16_t port, const UdpSocketOptions &options);
+
+        /**
+         * @brief 为本套接字所在的 SO_REUSEPORT 组挂载按 CPU 选择分片的 cBPF 程序
+         *
+         * 组内第 i 个绑定的套接字接收软中断运行在 firstCpu + i 号核上的数据包，其余核按 (cpu - firstCpu) % shards 分配，
+         * 使数据包在收到它的核上处理。需在组内所有套接字绑定完成后调用，对组内任一套接字调用一次即可。
+         * @param firstCpu 第 0 个分片的 RX 线程所绑定的核
+         * @param shards 分片数（组内套接字数）
+         * @return 成功返回 ErrorCode::SUCCESS，内核不支持时返回 ErrorCode::SOCKET_ERROR（内核仍按 SO_INCOMING_CPU 优先本核套接字）
+         */
+        ErrorCode attachCpuSteering(uint32_t firstCpu, uint32_t shards) const;
+
+        /**
+         * @brief 为本套接字所在的 SO_REUSEPORT 组挂载按 policy_id 选择分片的 cBPF 程序
+         *
+         * 数据包交给组内第 (policy_id % shards) 个绑定的套接字，同一策略的 RANDOM1/RANDOM2/CONFIRM 始终由同一个
+         * 分片（多进程模式下为同一个工作进程）处理，发起方收到的应答也回到发起它的进程。
+         * 过短的数据报交给第 0 个套接字。需在组内所有套接字绑定完成后调用，对组内任一套接字调用一次即可。
+         * @param shards 分片数（组内套接字数）
+         * @return 成功返回 ErrorCode::SUCCESS，内核不支持时返回 ErrorCode::SOCKET_ERROR
+         */
+        ErrorCode attachPolicySteering(uint32_t shards) const;
+
         /**
          * @brief 发送数据包到指定地址
          * @param packet 协商数据包
@@ -57,6 +101,22 @@ namespace negotio {
          */
         ErrorCode sendPacket(const NegotiationPacket &packet, sockaddr_in &addr);
 
+        /**
+         * @brief 发送原始字节到指定地址（用于回放抓包中的原始数据报）
+         * @param data 数据报内容
+         * @param len 数据报长度
+         * @param addr 对端地址结构
+         * @return 成功返回 ErrorCode::SUCCESS, 否则返回相应错误代码
+         */
+        ErrorCode sendBuffer(const uint8_t *data, size_t len, sockaddr_in &addr);
+
+        /**
+         * @brief 以一次 sendmmsg 发送一批数据包
+         * @param packets 数据包及其对端地址
+         * @return 已发送的数据包数，内核拒绝其余数据包时小于 packets.size()
+         */
+        size_t sendPackets(const std::vector<AddressedPacket> &packets);
+
         /**
          * @brief 接收数据包
          * @param packet 输出参数，接到的数据包
@@ -66,15 +126,33 @@ namespace negotio {
          */
         ErrorCode recvPacket(NegotiationPacket &packet, sockaddr_in &addr, int timeout_ms = 10) const;
 
+        /**
+         * @brief 以一次 recvmmsg 非阻塞地接收至多 maxPackets 个数据报
+         * @param packets 输出参数，追加解析成功的数据包及其发送方地址
+         * @param maxPackets 本次最多接收的数据报数
+         * @return 读取的数据报数（含解析失败的），等于 maxPackets 说明缓冲区中可能仍有积压；无数据或出错时返回 0
+         */
+        size_t recvPackets(std::vector<AddressedPacket> &packets, size_t maxPackets) const;
+
         /**
          * @brief 获取套接字文件描述符
          * @return 套接字文件描述符
          */
         [[nodiscard]] int getSocketFd() const { return sockfd; }
 
-    private:
-        int sockfd;
-        std::mutex sendMutex;
+        /**
+         * @brief 设置抓包写入器，设置后每个接收到的数据报都会被记录（传入 nullptr 关闭）
+         * @param writer 抓包写入器，生命周期需长于套接字的接收调用
+         */
+        void setCaptureWriter(CaptureWriter *writer) { captureWriter = writer; }
+
+        /**
+         * @brief 预先分配并触碰当前线程的收发缓冲区（数据报缓冲区、iovec 与 mmsghdr 数组），应在收发线程入口调用
+         *
+         * 内核套接字缓冲区按数据报在软中断中分配，无法从用户态预先触碰；这里预热的是每次收发复用的用户态缓冲区。
+         * @param batch 预期的最大批大小（recvPackets / sendPackets 一次处理的数据报数）
+         */
+        static void prefaultBuffers(size_t batch = 1);
 
         /**
          * @brief 将 NegotiationPacket 序列化到缓冲区
@@ -91,5 +169,10 @@ namespace negotio {
          * @return 字节数，失败返回负值
          */
         static ssize_t deserializePacket(const std::vector<uint8_t> &buffer, NegotiationPacket &packet);
+
+    private:
+        int sockfd;
+        InstrumentedMutex sendMutex{"UdpSocket::sendMutex"};
+        CaptureWriter *captureWriter = nullptr; ///< 可选的抓包写入器
     };
 }
@@ -37,7 +37,7 @@ namespace negotio {
     bool UnixSocketServer::init(const std::string &path) {
         socketPath = path;
         unlink(socketPath.c_str());
-        sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
         if (sockfd == -1) {
             std::cerr << "创建Unix域套接字失败" << std::endl;
             return false;
@@ -102,7 +102,7 @@ namespace negotio {
             for (int i = 0; i < nfds; ++i) {
                 if (events[i].data.fd == sockfd) {
                     while (true) {
-                        int clientFd = accept(sockfd, nullptr, nullptr);
+                        int clientFd = accept4(sockfd, nullptr, nullptr, SOCK_CLOEXEC);
                         if (clientFd == -1) {
                             if (errno == EAGAIN || errno == EWOULDBLOCK)
                                 break;
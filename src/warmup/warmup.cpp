@@ -0,0 +1,99 @@
+/**
+ * @file warmup.cpp
+ * @brief 启动预热实现
+ */
+
+#include "warmup.h"
+#include "../negotiate/negotiate.h"
+#include "../udp/udp.h"
+
+#include <alloca.h>
+#include <chrono>
+#include <memory>
+#include <netinet/in.h>
+#include <openssl/rand.h>
+
+namespace negotio {
+    namespace {
+        constexpr size_t PAGE_SIZE_BYTES = 4096;
+
+        // 发送回调：经过真实的序列化与反序列化后交给对端，顺带预热编解码路径
+        UdpSenderFunc loopbackSender(NegotiationPacket &outbox) {
+            return [&outbox](const NegotiationPacket &packet, const sockaddr_in &) {
+                static thread_local std::vector<uint8_t> buffer;
+                buffer.clear();
+                if (UdpSocket::serializePacket(packet, buffer) > 0) {
+                    UdpSocket::deserializePacket(buffer, outbox);
+                }
+            };
+        }
+
+        uint64_t rehearseNegotiation(Negotiator &initiator, Negotiator &responder, const uint32_t policyId,
+                                     NegotiationPacket &toResponder, NegotiationPacket &toInitiator,
+                                     const sockaddr_in &peer) {
+            const auto start = std::chrono::steady_clock::now();
+            initiator.startNegotiation(policyId, peer);      // → RANDOM1
+            responder.handlePacket(toResponder, peer);        // → RANDOM2
+            initiator.handlePacket(toInitiator, peer);        // → CONFIRM
+            responder.handlePacket(toResponder, peer);
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    void prefaultStack(const size_t bytes) {
+        auto *stack = static_cast<volatile uint8_t *>(alloca(bytes));
+        for (size_t offset = 0; offset < bytes; offset += PAGE_SIZE_BYTES) {
+            stack[offset] = 0;
+        }
+    }
+
+    WarmupReport warmUp(Negotiator &negotiator, const WarmupOptions &options) {
+        WarmupReport report{};
+        const auto start = std::chrono::steady_clock::now();
+
+        prefaultStack(options.stackBytes);
+        negotiator.reserveSessions(options.expectedSessions);
+
+        // OpenSSL DRBG 首次使用时需要从内核获取种子并初始化
+        uint8_t entropy[RANDOM_NUMBER];
+        for (int i = 0; i < 4; ++i) {
+            RAND_bytes(entropy, sizeof(entropy));
+        }
+        SessionRandom random1{};
+        SessionRandom random2{};
+        RAND_bytes(random1.data(), RANDOM_NUMBER);
+        RAND_bytes(random2.data(), RANDOM_NUMBER);
+        for (uint32_t i = 0; i < options.hashIterations; ++i) {
+            Negotiator::computeKey(random1, random2);
+        }
+
+        // 演练协商器的 [TRACE] 输出没有意义，只关闭这两个协商器的输出，不改动其它线程共用的 std::cout
+        {
+            const auto initiator = std::make_unique<Negotiator>();
+            const auto responder = std::make_unique<Negotiator>();
+            initiator->setQuiet(true);
+            responder->setQuiet(true);
+            NegotiationPacket toResponder{};
+            NegotiationPacket toInitiator{};
+            initiator->setUdpSender(loopbackSender(toResponder));
+            responder->setUdpSender(loopbackSender(toInitiator));
+            sockaddr_in peer{};
+            peer.sin_family = AF_INET;
+            peer.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            for (uint32_t round = 0; round < options.negotiationRounds; ++round) {
+                const uint64_t ns = rehearseNegotiation(*initiator, *responder, round + 1,
+                                                        toResponder, toInitiator, peer);
+                if (round == 0) {
+                    report.firstNegotiationNs = ns;
+                }
+                report.lastNegotiationNs = ns;
+            }
+        }
+
+        report.elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        return report;
+    }
+} // namespace negotio
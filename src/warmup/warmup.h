@@ -0,0 +1,60 @@
+/**
+ * 启动预热
+ *
+ * 在 UDP 接收线程启动之前执行，使第一次协商与稳态协商一样快：
+ * 1. 为会话表预留空间，避免运行期扩容与首次触页
+ * 2. 预先初始化 OpenSSL 随机数生成器（首次调用需从内核取种子）并运行 SHA256 计算
+ * 3. 在独立的 Negotiator 上完整执行若干次发起方与响应方流程，
+ *    预热协商代码路径、数据包编解码与各处惰性初始化的静态对象，不影响真实会话表
+ * 4. 预先触碰线程栈页（mlockall 失败时栈页仍需按需缺页）
+ * 5. 接收线程入口另外调用 UdpSocket::prefaultBuffers，预先分配并触碰各自的收发缓冲区；
+ *    内核套接字缓冲区按数据报在软中断中分配，无法从用户态预先触碰
+ *
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+#pragma once
+#ifndef NEGOTIO_WARMUP_H
+#define NEGOTIO_WARMUP_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace negotio {
+    class Negotiator;
+
+    constexpr size_t DEFAULT_WARMUP_STACK_BYTES = 256 * 1024;
+
+    // 预热参数
+    struct WarmupOptions {
+        size_t expectedSessions = 4096;  ///< 预期同时存在的会话数，用于预留会话表
+        uint32_t hashIterations = 256;   ///< SHA256 预热次数
+        uint32_t negotiationRounds = 64; ///< 发起方 + 响应方完整流程的演练次数
+        size_t stackBytes = DEFAULT_WARMUP_STACK_BYTES; ///< 当前线程预先触碰的栈大小
+    };
+
+    // 预热结果
+    struct WarmupReport {
+        uint64_t elapsedUs;          ///< 预热总耗时（微秒）
+        uint64_t firstNegotiationNs; ///< 第一次演练协商耗时（纳秒）
+        uint64_t lastNegotiationNs;  ///< 最后一次演练协商耗时（纳秒）
+    };
+
+    /**
+     * @brief 执行启动预热
+     * @param negotiator 正式使用的协商器，仅为其预留会话表，不写入会话
+     * @param options 预热参数
+     * @return 预热结果
+     */
+    WarmupReport warmUp(Negotiator &negotiator, const WarmupOptions &options);
+
+    /**
+     * @brief 预先触碰当前线程的栈页，应在工作线程入口调用
+     * @param bytes 触碰的栈大小，需小于线程栈上限
+     */
+    void prefaultStack(size_t bytes = DEFAULT_WARMUP_STACK_BYTES);
+} // namespace negotio
+
+#endif // NEGOTIO_WARMUP_H
@@ -0,0 +1,273 @@
+/**
+ * contention_benchmark.cpp
+ *
+ * 线程扩展与键倾斜竞争基准：
+ * 1. 线程数从 1 按 2 倍递增到 N（默认 2 × hardware_concurrency）
+ * 2. policy_id 分布：uniform（均匀随机）、contiguous（每线程连续区间）、
+ *    stride-16（步长 16，全部落入同一会话桶）、zipfian（Zipf 分布热点）
+ * 3. 每次操作执行完整三包流程（startNegotiation → RANDOM2 → CONFIRM）
+ * 4. 报告吞吐量、单次操作延迟分位数以及会话表的锁等待时间（需开启 NEGOTIO_LOCK_STATS）
+ *
+ * 用法：NegotioContentionBenchmark [--max-threads N] [--ops 20000] [--keys 4096] [--zipf 0.99]
+ *
+ * 注意：本基准仅调用 Negotiator 接口，不执行真实网络 I/O。
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+
+#include "../src/negotiate/negotiate.h"
+#include "../src/lockstat/lockstat.h"
+#include "utils/bench_util.h"
+#include "common.h"
+
+using namespace negotio;
+using namespace std::chrono;
+
+namespace {
+    enum class KeyDistribution {
+        UNIFORM,
+        CONTIGUOUS,
+        STRIDE16,
+        ZIPFIAN
+    };
+
+    const char *distributionName(KeyDistribution dist) {
+        switch (dist) {
+            case KeyDistribution::UNIFORM: return "uniform";
+            case KeyDistribution::CONTIGUOUS: return "contiguous";
+            case KeyDistribution::STRIDE16: return "stride-16";
+            case KeyDistribution::ZIPFIAN: return "zipfian";
+        }
+        return "unknown";
+    }
+
+    struct BenchOptions {
+        unsigned int maxThreads = 0;
+        uint32_t opsPerThread = 20000;
+        uint32_t keySpace = 4096;
+        double zipfSkew = 0.99;
+    };
+
+    // 单个线程的统计结果
+    struct ThreadResult {
+        std::vector<uint32_t> latenciesNs;
+        uint32_t errors = 0;
+    };
+
+    sockaddr_in dummyAddr{};
+
+    // 获取会话表（所有 SessionBucket::mtx）的锁统计
+    LockSiteStats sessionLockStats() {
+        for (auto &site : getLockStats()) {
+            if (site.name == "SessionBucket::mtx") {
+                return site;
+            }
+        }
+        return LockSiteStats{};
+    }
+
+    // 预先生成 Zipf 分布的累积分布函数（rank 1 最热）
+    std::vector<double> buildZipfCdf(uint32_t keySpace, double skew) {
+        std::vector<double> cdf(keySpace);
+        double sum = 0;
+        for (uint32_t i = 0; i < keySpace; ++i) {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), skew);
+            cdf[i] = sum;
+        }
+        for (auto &v : cdf) {
+            v /= sum;
+        }
+        return cdf;
+    }
+
+    // 为线程生成 policy_id 序列（在计时前完成，避免随机数生成计入延迟）
+    std::vector<uint32_t> generateKeys(KeyDistribution dist, unsigned int threadIdx, unsigned int numThreads,
+                                       const BenchOptions &opts, const std::vector<double> &zipfCdf) {
+        std::vector<uint32_t> keys(opts.opsPerThread);
+        std::mt19937 rng(threadIdx * 7919 + 17);
+        switch (dist) {
+            case KeyDistribution::UNIFORM: {
+                std::uniform_int_distribution<uint32_t> uniform(1, opts.keySpace);
+                for (auto &k : keys) k = uniform(rng);
+                break;
+            }
+            case KeyDistribution::CONTIGUOUS: {
+                const uint32_t range = std::max<uint32_t>(1, opts.keySpace / numThreads);
+                const uint32_t base = threadIdx * range + 1;
+                for (uint32_t i = 0; i < opts.opsPerThread; ++i) keys[i] = base + i % range;
+                break;
+            }
+            case KeyDistribution::STRIDE16: {
+                const uint32_t slots = std::max<uint32_t>(1, opts.keySpace / NUM_BUCKETS);
+                std::uniform_int_distribution<uint32_t> uniform(1, slots);
+                for (auto &k : keys) k = static_cast<uint32_t>(uniform(rng) * NUM_BUCKETS);
+                break;
+            }
+            case KeyDistribution::ZIPFIAN: {
+                std::uniform_real_distribution<double> unit(0.0, 1.0);
+                for (auto &k : keys) {
+                    const auto it = std::lower_bound(zipfCdf.begin(), zipfCdf.end(), unit(rng));
+                    k = static_cast<uint32_t>(it - zipfCdf.begin()) + 1;
+                }
+                break;
+            }
+        }
+        return keys;
+    }
+
+    NegotiationPacket makePacket(PacketType type, uint32_t policyId, const std::vector<uint8_t> &payload) {
+        NegotiationPacket packet{};
+        packet.header.magic = MAGIC_NUMBER;
+        packet.header.type = type;
+        packet.header.sequence = policyId;
+        packet.header.timestamp = static_cast<uint32_t>(
+            duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+        packet.header.payload_len = payload.size() / sizeof(uint32_t);
+        packet.payload.resize(packet.header.payload_len);
+        if (!payload.empty()) {
+            std::memcpy(packet.payload.data(), payload.data(), payload.size());
+        }
+        return packet;
+    }
+
+    void runWorker(Negotiator &negotiator, const std::vector<uint32_t> &keys, ThreadResult &result) {
+        result.latenciesNs.reserve(keys.size());
+        const std::vector<uint8_t> random2 = Negotiator::generateRandomData(RANDOM_NUMBER);
+        for (const uint32_t policyId : keys) {
+            const auto opStart = steady_clock::now();
+            bool ok = negotiator.startNegotiation(policyId, dummyAddr) == ErrorCode::SUCCESS;
+            ok = ok && negotiator.handlePacket(makePacket(PacketType::RANDOM2, policyId, random2), dummyAddr)
+                       == ErrorCode::SUCCESS;
+            ok = ok && negotiator.handlePacket(makePacket(PacketType::CONFIRM, policyId, {}), dummyAddr)
+                       == ErrorCode::SUCCESS;
+            result.latenciesNs.push_back(static_cast<uint32_t>(
+                duration_cast<nanoseconds>(steady_clock::now() - opStart).count()));
+            if (!ok) {
+                // 热点键上其他线程可能已推进或覆盖会话状态
+                ++result.errors;
+            }
+        }
+    }
+
+    void runCase(KeyDistribution dist, unsigned int numThreads, const BenchOptions &opts,
+                 const std::vector<double> &zipfCdf) {
+        std::vector<std::vector<uint32_t>> keys;
+        for (unsigned int t = 0; t < numThreads; ++t) {
+            keys.push_back(generateKeys(dist, t, numThreads, opts, zipfCdf));
+        }
+        std::vector<ThreadResult> results(numThreads);
+        auto negotiator = std::make_unique<Negotiator>();
+        resetLockStats();
+
+        steady_clock::duration elapsed{};
+        {
+            benchutils::ScopedSilence silence;
+            std::vector<std::thread> threads;
+            const auto start = steady_clock::now();
+            for (unsigned int t = 0; t < numThreads; ++t) {
+                threads.emplace_back(runWorker, std::ref(*negotiator), std::cref(keys[t]), std::ref(results[t]));
+            }
+            for (auto &t : threads) {
+                t.join();
+            }
+            elapsed = steady_clock::now() - start;
+        }
+
+        std::vector<uint32_t> latencies;
+        uint64_t errors = 0;
+        for (auto &r : results) {
+            latencies.insert(latencies.end(), r.latenciesNs.begin(), r.latenciesNs.end());
+            errors += r.errors;
+        }
+        const LockSiteStats lockStats = sessionLockStats();
+        const uint64_t totalOps = latencies.size();
+        const double seconds = duration_cast<duration<double>>(elapsed).count();
+        const double p50 = benchutils::percentile(latencies, 0.50) / 1000.0;
+        const double p99 = benchutils::percentile(latencies, 0.99) / 1000.0;
+        const double p999 = benchutils::percentile(latencies, 0.999) / 1000.0;
+
+        std::cout << std::left << std::setw(12) << distributionName(dist)
+                  << std::right << std::setw(8) << numThreads
+                  << std::fixed << std::setprecision(0)
+                  << std::setw(14) << totalOps / seconds
+                  << std::setprecision(1)
+                  << std::setw(10) << p50
+                  << std::setw(10) << p99
+                  << std::setw(10) << p999
+                  << std::setw(12) << lockStats.waitNs / 1e6
+                  << std::setprecision(0)
+                  << std::setw(12) << static_cast<double>(lockStats.waitNs) / std::max<uint64_t>(1, totalOps)
+                  << std::setw(13) << lockStats.waitPercentileNs(0.99)
+                  << std::setprecision(2)
+                  << std::setw(11) << 100.0 * lockStats.contended / std::max<uint64_t>(1, lockStats.acquisitions) << "%"
+                  << std::setw(9) << errors << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--max-threads" && i + 1 < argc) {
+            opts.maxThreads = static_cast<unsigned int>(std::stoul(argv[++i]));
+        } else if (arg == "--ops" && i + 1 < argc) {
+            opts.opsPerThread = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--keys" && i + 1 < argc) {
+            opts.keySpace = std::max<uint32_t>(NUM_BUCKETS, static_cast<uint32_t>(std::stoul(argv[++i])));
+        } else if (arg == "--zipf" && i + 1 < argc) {
+            opts.zipfSkew = std::stod(argv[++i]);
+        } else {
+            std::cerr << "用法: " << argv[0]
+                      << " [--max-threads N] [--ops 20000] [--keys 4096] [--zipf 0.99]" << std::endl;
+            return 2;
+        }
+    }
+    if (opts.maxThreads == 0) {
+        const unsigned int hw = std::thread::hardware_concurrency();
+        opts.maxThreads = hw == 0 ? 8 : hw * 2;
+    }
+
+    dummyAddr.sin_family = AF_INET;
+    dummyAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (!lockStatsEnabled()) {
+        std::cout << "注意：未开启 NEGOTIO_LOCK_STATS，锁等待列恒为 0" << std::endl;
+    }
+    const std::vector<double> zipfCdf = buildZipfCdf(opts.keySpace, opts.zipfSkew);
+    std::cout << "每线程操作数: " << opts.opsPerThread << ", 键空间: " << opts.keySpace
+              << ", 会话桶数: " << NUM_BUCKETS << ", 最大线程数: " << opts.maxThreads << std::endl;
+    std::cout << std::left << std::setw(12) << "dist"
+              << std::right << std::setw(8) << "threads"
+              << std::setw(14) << "ops/s"
+              << std::setw(10) << "p50(us)"
+              << std::setw(10) << "p99(us)"
+              << std::setw(10) << "p999(us)"
+              << std::setw(12) << "wait(ms)"
+              << std::setw(12) << "wait/op(ns)"
+              << std::setw(13) << "wait p99(ns)"
+              << std::setw(12) << "contended"
+              << std::setw(9) << "errors" << std::endl;
+
+    for (const auto dist : {KeyDistribution::UNIFORM, KeyDistribution::CONTIGUOUS,
+                            KeyDistribution::STRIDE16, KeyDistribution::ZIPFIAN}) {
+        for (unsigned int threads = 1;; threads *= 2) {
+            threads = std::min(threads, opts.maxThreads);
+            runCase(dist, threads, opts, zipfCdf);
+            if (threads == opts.maxThreads) {
+                break;
+            }
+        }
+    }
+    return 0;
+}
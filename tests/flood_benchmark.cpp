@@ -0,0 +1,307 @@
+/**
+ * flood_benchmark.cpp
+ *
+ * RANDOM1 洪泛基准：
+ * 1. 在回环地址上启动一个真实的 Negotio 响应方（UdpSocket + Negotiator，接收线程内联处理数据包）
+ * 2. 洪泛线程轮流使用多个源端口，向响应方发送随机 policy_id 的 RANDOM1 包
+ *    （每个伪造的 RANDOM1 都会让响应方分配会话并执行 RAND_bytes + SHA-256）
+ * 3. 一个独立的合法客户端以固定速率发起真实协商，测量 RANDOM1 发出到 RANDOM2 处理完成的延迟
+ * 4. 每秒输出合法协商的 p50/p99 延迟、超时数、响应方处理包数、RSS 增长与 CPU 占用
+ *
+ * 用法：NegotioFloodBenchmark [--duration 10] [--flood-rate 20000] [--flood-sources 8]
+ *                             [--legit-rate 200] [--no-flood]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "../src/negotiate/negotiate.h"
+#include "../src/udp/udp.h"
+#include "utils/bench_util.h"
+#include "common.h"
+
+using namespace negotio;
+using namespace std::chrono;
+
+namespace {
+    struct FloodOptions {
+        uint32_t durationSec = 10;
+        uint32_t floodRate = 20000;   ///< 洪泛总速率（包/秒），0 表示不限速
+        uint32_t floodSources = 8;    ///< 洪泛源套接字数量
+        uint32_t legitRate = 200;     ///< 合法协商速率（次/秒）
+        bool flood = true;
+    };
+
+    // 合法协商使用高位 policy_id，避免与洪泛的随机 id 冲突
+    constexpr uint32_t LEGIT_ID_BASE = 0x80000000u;
+    constexpr uint32_t PENDING_SLOTS = 1u << 16;
+    constexpr int64_t LEGIT_TIMEOUT_NS = 1'000'000'000;
+
+    std::atomic<bool> running{true};
+
+    int64_t nowNs() {
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    uint64_t cpuTimeUs() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<uint64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ull
+               + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    }
+
+    uint16_t boundPort(const UdpSocket &socket) {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        getsockname(socket.getSocketFd(), reinterpret_cast<sockaddr *>(&addr), &len);
+        return ntohs(addr.sin_port);
+    }
+
+    // 接收循环：epoll 等待后尽量读空套接字，再逐包交给 Negotiator 处理
+    void receiveLoop(UdpSocket &socket, Negotiator &negotiator, const std::function<void(const NegotiationPacket &)> &onHandled) {
+        const int epollFd = epoll_create1(0);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = socket.getSocketFd();
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, socket.getSocketFd(), &ev);
+        while (running) {
+            epoll_event events[1];
+            if (epoll_wait(epollFd, events, 1, 10) <= 0) {
+                continue;
+            }
+            NegotiationPacket packet;
+            sockaddr_in srcAddr{};
+            while (socket.recvPacket(packet, srcAddr, 0) == ErrorCode::SUCCESS) {
+                if (negotiator.handlePacket(packet, srcAddr) == ErrorCode::SUCCESS && onHandled) {
+                    onHandled(packet);
+                }
+            }
+        }
+        close(epollFd);
+    }
+
+    void floodLoop(const sockaddr_in target, uint32_t sources, uint32_t rate, std::atomic<uint64_t> &sent) {
+        std::vector<std::unique_ptr<UdpSocket>> sockets;
+        for (uint32_t i = 0; i < sources; ++i) {
+            auto socket = std::make_unique<UdpSocket>();
+            if (socket->init(0) == ErrorCode::SUCCESS) {
+                sockets.push_back(std::move(socket));
+            }
+        }
+        if (sockets.empty()) {
+            std::cerr << "洪泛套接字初始化失败" << std::endl;
+            return;
+        }
+        std::mt19937 rng(12345);
+        std::uniform_int_distribution<uint32_t> idDist(1, LEGIT_ID_BASE - 1);
+        NegotiationPacket packet{};
+        packet.header.magic = MAGIC_NUMBER;
+        packet.header.type = PacketType::RANDOM1;
+        packet.header.payload_len = RANDOM_NUMBER / sizeof(uint32_t);
+        packet.payload.resize(packet.header.payload_len);
+
+        sockaddr_in addr = target;
+        const auto start = steady_clock::now();
+        uint64_t count = 0;
+        while (running) {
+            packet.header.sequence = idDist(rng);
+            packet.header.timestamp = static_cast<uint32_t>(nowNs() / 1'000'000);
+            for (auto &word : packet.payload) word = rng();
+            sockets[count % sockets.size()]->sendPacket(packet, addr);
+            ++count;
+            sent.fetch_add(1, std::memory_order_relaxed);
+            if (rate != 0) {
+                // 按目标速率节流
+                const auto due = start + nanoseconds(count * 1'000'000'000ull / rate);
+                if (due > steady_clock::now()) {
+                    std::this_thread::sleep_until(due);
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    FloodOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--duration" && i + 1 < argc) {
+            opts.durationSec = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--flood-rate" && i + 1 < argc) {
+            opts.floodRate = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--flood-sources" && i + 1 < argc) {
+            opts.floodSources = std::max<uint32_t>(1, static_cast<uint32_t>(std::stoul(argv[++i])));
+        } else if (arg == "--legit-rate" && i + 1 < argc) {
+            opts.legitRate = std::max<uint32_t>(1, static_cast<uint32_t>(std::stoul(argv[++i])));
+        } else if (arg == "--no-flood") {
+            opts.flood = false;
+        } else {
+            std::cerr << "用法: " << argv[0] << " [--duration 10] [--flood-rate 20000] [--flood-sources 8]"
+                      << " [--legit-rate 200] [--no-flood]" << std::endl;
+            return 2;
+        }
+    }
+
+    // 响应方
+    UdpSocket responderSocket;
+    if (responderSocket.init(0) != ErrorCode::SUCCESS) {
+        std::cerr << "响应方 UDP 初始化失败" << std::endl;
+        return 1;
+    }
+    Negotiator responder;
+    responder.setUdpSender([&responderSocket](const NegotiationPacket &pkt, const sockaddr_in &addr) {
+        responderSocket.sendPacket(pkt, const_cast<sockaddr_in &>(addr));
+    });
+    sockaddr_in responderAddr{};
+    responderAddr.sin_family = AF_INET;
+    responderAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    responderAddr.sin_port = htons(boundPort(responderSocket));
+    std::atomic<uint64_t> responderHandled{0};
+
+    // 合法客户端
+    UdpSocket clientSocket;
+    if (clientSocket.init(0) != ErrorCode::SUCCESS) {
+        std::cerr << "客户端 UDP 初始化失败" << std::endl;
+        return 1;
+    }
+    Negotiator client;
+    client.setUdpSender([&clientSocket](const NegotiationPacket &pkt, const sockaddr_in &addr) {
+        clientSocket.sendPacket(pkt, const_cast<sockaddr_in &>(addr));
+    });
+
+    // 待完成协商的发起时间（按 policy_id 低位索引），0 表示空闲
+    std::vector<std::atomic<int64_t>> pendingStart(PENDING_SLOTS);
+    std::mutex windowMutex;
+    std::vector<uint32_t> windowLatenciesUs;
+    uint64_t windowCompleted = 0;
+
+    // 协商路径的 TRACE 日志写入 std::cout，这里将其屏蔽，报告统一输出到 std::cerr
+    benchutils::ScopedSilence silence;
+    std::thread responderThread([&]() {
+        receiveLoop(responderSocket, responder, [&](const NegotiationPacket &) {
+            responderHandled.fetch_add(1, std::memory_order_relaxed);
+        });
+    });
+    std::thread clientRxThread([&]() {
+        receiveLoop(clientSocket, client, [&](const NegotiationPacket &packet) {
+            if (packet.header.type != PacketType::RANDOM2) {
+                return;
+            }
+            const int64_t started = pendingStart[packet.header.sequence % PENDING_SLOTS].exchange(0);
+            if (started == 0) {
+                return;
+            }
+            std::lock_guard lock(windowMutex);
+            windowLatenciesUs.push_back(static_cast<uint32_t>((nowNs() - started) / 1000));
+            ++windowCompleted;
+        });
+    });
+    std::atomic<uint64_t> floodSent{0};
+    std::vector<std::thread> floodThreads;
+    if (opts.flood) {
+        floodThreads.emplace_back(floodLoop, responderAddr, opts.floodSources, opts.floodRate, std::ref(floodSent));
+    }
+    std::thread legitThread([&]() {
+        const auto start = steady_clock::now();
+        for (uint64_t n = 0; running; ++n) {
+            const uint32_t policyId = LEGIT_ID_BASE + static_cast<uint32_t>(n % (LEGIT_ID_BASE - 1)) + 1;
+            pendingStart[policyId % PENDING_SLOTS].store(nowNs());
+            client.startNegotiation(policyId, responderAddr);
+            std::this_thread::sleep_until(start + nanoseconds((n + 1) * 1'000'000'000ull / opts.legitRate));
+        }
+    });
+
+    std::cerr << std::left << std::setw(6) << "sec"
+              << std::right << std::setw(10) << "done"
+              << std::setw(10) << "timeout"
+              << std::setw(10) << "p50(us)"
+              << std::setw(10) << "p99(us)"
+              << std::setw(12) << "flood pps"
+              << std::setw(12) << "rx pps"
+              << std::setw(12) << "rss(MiB)"
+              << std::setw(10) << "cpu%" << std::endl;
+
+    const uint64_t baseRss = benchutils::readRssBytes();
+    uint64_t lastCpu = cpuTimeUs();
+    uint64_t lastFlood = 0;
+    uint64_t lastHandled = 0;
+    auto lastTick = steady_clock::now();
+    std::vector<uint32_t> allLatenciesUs;
+    uint64_t totalTimeouts = 0;
+    for (uint32_t sec = 1; sec <= opts.durationSec; ++sec) {
+        std::this_thread::sleep_until(lastTick + seconds(1));
+        const auto tick = steady_clock::now();
+        const double wall = duration_cast<duration<double>>(tick - lastTick).count();
+        lastTick = tick;
+
+        // 超过 1 秒未完成的合法协商计为超时
+        uint64_t timeouts = 0;
+        const int64_t deadline = nowNs() - LEGIT_TIMEOUT_NS;
+        for (auto &slot : pendingStart) {
+            int64_t started = slot.load();
+            if (started != 0 && started < deadline && slot.compare_exchange_strong(started, 0)) {
+                ++timeouts;
+            }
+        }
+        totalTimeouts += timeouts;
+
+        std::vector<uint32_t> latencies;
+        uint64_t completed;
+        {
+            std::lock_guard lock(windowMutex);
+            latencies.swap(windowLatenciesUs);
+            completed = windowCompleted;
+            windowCompleted = 0;
+        }
+        allLatenciesUs.insert(allLatenciesUs.end(), latencies.begin(), latencies.end());
+
+        const uint64_t cpu = cpuTimeUs();
+        const uint64_t flood = floodSent.load();
+        const uint64_t handled = responderHandled.load();
+        std::cerr << std::left << std::setw(6) << sec
+                  << std::right << std::setw(10) << completed
+                  << std::setw(10) << timeouts
+                  << std::setw(10) << benchutils::percentile(latencies, 0.50)
+                  << std::setw(10) << benchutils::percentile(latencies, 0.99)
+                  << std::fixed << std::setprecision(0)
+                  << std::setw(12) << (flood - lastFlood) / wall
+                  << std::setw(12) << (handled - lastHandled) / wall
+                  << std::setprecision(1)
+                  << std::setw(12) << (static_cast<double>(benchutils::readRssBytes()) - baseRss) / (1024 * 1024)
+                  << std::setw(10) << 100.0 * (cpu - lastCpu) / (wall * 1e6) << std::endl;
+        lastCpu = cpu;
+        lastFlood = flood;
+        lastHandled = handled;
+    }
+
+    running = false;
+    legitThread.join();
+    for (auto &t : floodThreads) {
+        t.join();
+    }
+    responderThread.join();
+    clientRxThread.join();
+
+    const uint64_t totalCompleted = allLatenciesUs.size();
+    std::cerr << "合法协商完成: " << totalCompleted << ", 超时: " << totalTimeouts
+              << ", 总体 p99: " << benchutils::percentile(allLatenciesUs, 0.99) << " us"
+              << ", RSS 增长: " << (static_cast<double>(benchutils::readRssBytes()) - baseRss) / (1024 * 1024)
+              << " MiB" << std::endl;
+    return 0;
+}
@@ -0,0 +1,207 @@
+/**
+ * memory_benchmark.cpp
+ *
+ * 内存占用基准：
+ * 1. 将会话表（Negotiator）与策略表（PolicyManager）分别填充到指定规模（默认 4096 / 100000 / 1000000）
+ * 2. 会话分两个阶段统计：发起后（WAIT_R2，仅含 random1）与协商完成后（DONE，含 random1/random2/key）
+ * 3. 每个阶段报告 RSS 增量、分配器字节增量以及每条目字节数
+ * 4. 与 configs/config.json 中 performance 段配置的预算比较，超出预算时返回非零退出码
+ *
+ * 用法：NegotioMemoryBenchmark [--config configs/config.json] [--sizes 4096,100000,1000000]
+ *
+ * 注意：本基准不执行真实网络 I/O，未设置 UDP 发送器。
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <netinet/in.h>
+#include <malloc.h>
+
+#include "../src/negotiate/negotiate.h"
+#include "../src/policy/policy.h"
+#include "utils/bench_util.h"
+#include "nlohmann/json.hpp"
+#include "common.h"
+
+using namespace negotio;
+using json = nlohmann::json;
+
+namespace {
+    // 预算配置（来自 config.json 的 performance 段）
+    struct MemoryBudget {
+        uint64_t maxMemoryBytes = 500ull * 1024 * 1024;
+        uint64_t sessionBudgetBytes = 0; // 0 表示不检查
+        uint64_t policyBudgetBytes = 0;
+    };
+
+    // 一次测量快照
+    struct MemorySample {
+        uint64_t rss;
+        uint64_t allocated;
+    };
+
+    MemorySample sample() {
+        return {benchutils::readRssBytes(), benchutils::readAllocatorBytes()};
+    }
+
+    MemoryBudget loadBudget(const std::string &path) {
+        MemoryBudget budget;
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "无法打开配置文件 " << path << "，使用默认预算" << std::endl;
+            return budget;
+        }
+        try {
+            json config;
+            file >> config;
+            const auto &perf = config.at("performance");
+            budget.maxMemoryBytes = perf.value("max_memory_mb", 500u) * 1024ull * 1024ull;
+            budget.sessionBudgetBytes = perf.value("session_budget_bytes", 0u);
+            budget.policyBudgetBytes = perf.value("policy_budget_bytes", 0u);
+        } catch (const std::exception &e) {
+            std::cerr << "解析配置文件失败: " << e.what() << "，使用默认预算" << std::endl;
+        }
+        return budget;
+    }
+
+    // 输出一行报告，返回是否在预算之内
+    bool report(const std::string &subsystem, uint32_t entries, const MemorySample &before,
+                const MemorySample &after, uint64_t budgetPerEntry) {
+        const auto allocDelta = static_cast<int64_t>(after.allocated - before.allocated);
+        const auto rssDelta = static_cast<int64_t>(after.rss - before.rss);
+        const double allocPerEntry = static_cast<double>(allocDelta) / entries;
+        const double rssPerEntry = static_cast<double>(rssDelta) / entries;
+        const bool withinBudget = budgetPerEntry == 0 || allocPerEntry <= static_cast<double>(budgetPerEntry);
+
+        std::cout << std::left << std::setw(24) << subsystem
+                  << std::right << std::setw(10) << entries
+                  << std::setw(14) << allocDelta / 1024 << " KiB"
+                  << std::setw(14) << rssDelta / 1024 << " KiB"
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(12) << allocPerEntry << " B"
+                  << std::setw(12) << rssPerEntry << " B";
+        if (budgetPerEntry != 0) {
+            std::cout << "  (预算 " << budgetPerEntry << " B" << (withinBudget ? ", OK)" : ", 超出!)");
+        }
+        std::cout << std::endl;
+        return withinBudget;
+    }
+
+    NegotiationPacket makeRandom2Packet(uint32_t policyId) {
+        NegotiationPacket packet{};
+        packet.header.magic = MAGIC_NUMBER;
+        packet.header.type = PacketType::RANDOM2;
+        packet.header.sequence = policyId;
+        packet.header.payload_len = RANDOM_NUMBER / sizeof(uint32_t);
+        packet.payload.assign(RANDOM_NUMBER / sizeof(uint32_t), policyId);
+        return packet;
+    }
+
+    PolicyConfig makePolicy(uint32_t policyId) {
+        PolicyConfig cfg;
+        cfg.policy_id = policyId;
+        cfg.remote_ip = "10.0.0.1";
+        cfg.remote_port = 5000;
+        cfg.timeout_ms = DEFAULT_TIMEOUT_MS;
+        cfg.retry_times = DEFAULT_RETRY_TIMES;
+        return cfg;
+    }
+
+    // 测量会话表，返回是否在预算之内
+    bool measureSessions(uint32_t entries, const MemoryBudget &budget, uint64_t &peakRss) {
+        sockaddr_in dummyAddr{};
+        dummyAddr.sin_family = AF_INET;
+        dummyAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        malloc_trim(0);
+        const MemorySample base = sample();
+        auto negotiator = std::make_unique<Negotiator>();
+        {
+            benchutils::ScopedSilence silence;
+            for (uint32_t id = 1; id <= entries; ++id) {
+                negotiator->startNegotiation(id, dummyAddr);
+            }
+        }
+        const MemorySample inFlight = sample();
+        {
+            benchutils::ScopedSilence silence;
+            for (uint32_t id = 1; id <= entries; ++id) {
+                negotiator->handlePacket(makeRandom2Packet(id), dummyAddr);
+            }
+        }
+        const MemorySample established = sample();
+        peakRss = std::max(peakRss, established.rss);
+
+        const bool okInFlight = report("session (WAIT_R2)", entries, base, inFlight, 0);
+        const bool okDone = report("session (DONE)", entries, base, established, budget.sessionBudgetBytes);
+        negotiator.reset();
+        return okInFlight && okDone;
+    }
+
+    // 测量策略表，返回是否在预算之内
+    bool measurePolicies(uint32_t entries, const MemoryBudget &budget, uint64_t &peakRss) {
+        malloc_trim(0);
+        const MemorySample base = sample();
+        auto manager = std::make_unique<PolicyManager>(entries);
+        for (uint32_t id = 1; id <= entries; ++id) {
+            manager->addPolicy(makePolicy(id));
+        }
+        const MemorySample filled = sample();
+        peakRss = std::max(peakRss, filled.rss);
+
+        const bool ok = report("policy", entries, base, filled, budget.policyBudgetBytes);
+        manager.reset();
+        return ok;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string configPath = "configs/config.json";
+    std::vector<uint32_t> sizes = {4096, 100000, 1000000};
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc) {
+            configPath = argv[++i];
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            sizes = benchutils::parseSizeList(argv[++i]);
+        } else {
+            std::cerr << "用法: " << argv[0] << " [--config path] [--sizes 4096,100000,1000000]" << std::endl;
+            return 2;
+        }
+    }
+
+    const MemoryBudget budget = loadBudget(configPath);
+    std::cout << "sizeof(NegotiationSession) = " << sizeof(NegotiationSession)
+              << " B, sizeof(PolicyConfig) = " << sizeof(PolicyConfig) << " B" << std::endl;
+    std::cout << std::left << std::setw(24) << "subsystem"
+              << std::right << std::setw(10) << "entries"
+              << std::setw(18) << "allocator"
+              << std::setw(18) << "rss"
+              << std::setw(14) << "alloc/entry"
+              << std::setw(14) << "rss/entry" << std::endl;
+
+    bool ok = true;
+    uint64_t peakRss = benchutils::readRssBytes();
+    for (const uint32_t entries : sizes) {
+        if (entries == 0) {
+            continue;
+        }
+        ok = measureSessions(entries, budget, peakRss) && ok;
+        ok = measurePolicies(entries, budget, peakRss) && ok;
+    }
+
+    std::cout << "峰值 RSS: " << peakRss / (1024 * 1024) << " MiB (上限 "
+              << budget.maxMemoryBytes / (1024 * 1024) << " MiB)" << std::endl;
+    if (peakRss > budget.maxMemoryBytes) {
+        std::cout << "峰值 RSS 超出上限" << std::endl;
+        ok = false;
+    }
+    std::cout << (ok ? "内存预算检查通过" : "内存预算检查失败") << std::endl;
+    return ok ? 0 : 1;
+}
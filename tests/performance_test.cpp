@@ -23,6 +23,7 @@
 
 #include "../src/negotiate/negotiate.h"
 #include "../src/monitor/monitor.h"
+#include "../src/lockstat/lockstat.h"
 #include "common.h" // 包含 ErrorCode、MAGIC_NUMBER、PacketType、RANDOM_NUMBER 等定义
 #include <openssl/rand.h>
 
@@ -117,6 +118,13 @@ int main() {
               << ", 总耗时: " << totalMs << " ms, 平均每次协商耗时: "
               << static_cast<double>(totalMs) / totalSessions << " ms" << std::endl;
 
+    // 输出各锁位点的竞争情况（需开启 NEGOTIO_LOCK_STATS）
+    for (const auto &site : getLockStats()) {
+        std::cout << "锁位点: " << site.name << ", 获取次数: " << site.acquisitions
+                  << ", 竞争次数: " << site.contended << ", 累计等待: " << site.waitNs / 1000 << " us"
+                  << ", 等待 p99: " << site.waitPercentileNs(0.99) / 1000 << " us" << std::endl;
+    }
+
     monitor.stop();
     return 0;
 }
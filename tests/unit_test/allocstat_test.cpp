@@ -0,0 +1,122 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/allocstat_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/allocstat/allocstat.h"
+#include "../../src/negotiate/negotiate.h"
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+
+using namespace negotio;
+
+namespace {
+    // 稳态下一次完整协商（发起 → RANDOM2 → CONFIRM）允许的最大堆分配次数。
+    // 目标是零分配热路径：热路径每减少一次分配，都应同步下调该值。
+    // 协商完成的会话移入冷存储后，热表节点留在桶中供下一次协商复用，随机数与密钥内联在节点中。
+    constexpr uint64_t kMaxSteadyStateAllocsPerNegotiation = 4;
+
+    NegotiationPacket makePacket(PacketType type, uint32_t policyId, size_t payloadWords) {
+        NegotiationPacket packet{};
+        packet.header.magic = MAGIC_NUMBER;
+        packet.header.type = type;
+        packet.header.sequence = policyId;
+        packet.header.payload_len = static_cast<uint32_t>(payloadWords);
+        packet.payload.assign(payloadWords, 0x5A5A5A5A);
+        return packet;
+    }
+}
+
+// 标签作用域：分配计入当前线程，统计随分配增长
+TEST(AllocStatTest, CountsAllocationsOnCurrentThread) {
+    if (!allocStatsEnabled()) {
+        GTEST_SKIP() << "NEGOTIO_ALLOC_STATS 未开启";
+    }
+    const AllocCounters before = currentThreadAllocCounters();
+    {
+        AllocScope scope(AllocTag::POLICY);
+        auto buffer = std::make_unique<uint8_t[]>(100);
+        buffer[0] = 1;
+    }
+    const AllocCounters after = currentThreadAllocCounters();
+    EXPECT_EQ(after.allocations - before.allocations, 1u);
+    EXPECT_GE(after.bytes - before.bytes, 100u);
+    EXPECT_EQ(after.frees - before.frees, 1u);
+    EXPECT_GE(getAllocStatsByTag()[static_cast<size_t>(AllocTag::POLICY)].allocations, 1u);
+}
+
+// 释放计入分配时的子系统，而不是释放时所在的作用域
+TEST(AllocStatTest, AttributesFreesToAllocatingTag) {
+    if (!allocStatsEnabled()) {
+        GTEST_SKIP() << "NEGOTIO_ALLOC_STATS 未开启";
+    }
+    constexpr auto control = static_cast<size_t>(AllocTag::CONTROL);
+    constexpr auto monitor = static_cast<size_t>(AllocTag::MONITOR);
+    const auto before = getAllocStatsByTag();
+    std::unique_ptr<uint64_t[]> buffer;
+    struct alignas(64) Line {
+        uint8_t bytes[64];
+    };
+    std::unique_ptr<Line> line;
+    {
+        AllocScope scope(AllocTag::CONTROL);
+        buffer = std::make_unique<uint64_t[]>(8);
+        line = std::make_unique<Line>();
+    }
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(line.get()) % 64, 0u);
+    {
+        AllocScope scope(AllocTag::MONITOR);
+        buffer.reset();
+        line.reset();
+    }
+    const auto after = getAllocStatsByTag();
+    EXPECT_EQ(after[control].allocations - before[control].allocations, 2u);
+    EXPECT_EQ(after[control].frees - before[control].frees, 2u);
+    EXPECT_EQ(after[monitor].frees - before[monitor].frees, 0u);
+}
+
+// 稳态热路径分配次数不得超过预算
+TEST(AllocStatTest, SteadyStateNegotiationAllocationBudget) {
+    if (!allocStatsEnabled()) {
+        GTEST_SKIP() << "NEGOTIO_ALLOC_STATS 未开启";
+    }
+    sockaddr_in peer{};
+    peer.sin_family = AF_INET;
+    peer.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    Negotiator negotiator;
+    negotiator.setUdpSender([](const NegotiationPacket &, const sockaddr_in &) {});
+    constexpr uint32_t policyId = 7;
+    const NegotiationPacket random2 = makePacket(PacketType::RANDOM2, policyId, RANDOM_NUMBER / sizeof(uint32_t));
+    const NegotiationPacket confirm = makePacket(PacketType::CONFIRM, policyId, 0);
+
+    // 预热：建立会话表条目，使后续迭代处于稳态
+    for (int i = 0; i < 4; ++i) {
+        negotiator.startNegotiation(policyId, peer);
+        negotiator.handlePacket(random2, peer);
+        negotiator.handlePacket(confirm, peer);
+    }
+
+    constexpr int kIterations = 100;
+    const AllocCounters before = currentThreadAllocCounters();
+    for (int i = 0; i < kIterations; ++i) {
+        negotiator.startNegotiation(policyId, peer);
+        negotiator.handlePacket(random2, peer);
+        negotiator.handlePacket(confirm, peer);
+    }
+    const AllocCounters after = currentThreadAllocCounters();
+    const double perNegotiation = static_cast<double>(after.allocations - before.allocations) / kIterations;
+    std::cout << "稳态每次协商分配次数: " << perNegotiation << std::endl;
+    EXPECT_LE(perNegotiation, static_cast<double>(kMaxSteadyStateAllocsPerNegotiation));
+}
+
+TEST(AllocStatTest, TagNames) {
+    EXPECT_STREQ(allocTagName(AllocTag::UDP), "udp");
+    EXPECT_STREQ(allocTagName(AllocTag::NEGOTIATE), "negotiate");
+    EXPECT_STREQ(allocTagName(AllocTag::CONTROL), "control");
+}
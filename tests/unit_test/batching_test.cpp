@@ -0,0 +1,89 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/batching_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/batching/batching.h"
+#include <chrono>
+
+using namespace negotio;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+namespace {
+    BatchOptions stageOptions() {
+        BatchOptions options;
+        options.minBatch = 1;
+        options.maxBatch = 64;
+        options.maxDelayUs = 200;
+        return options;
+    }
+}
+
+// 低速到达时逐个处理，不等待
+TEST(BatchingTest, StaysUnbatchedWhenIdle) {
+    AdaptiveBatcher batcher(stageOptions());
+    auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i) {
+        batcher.observe(1, 0, now);
+        now += milliseconds(100);
+    }
+    EXPECT_EQ(batcher.getBatchSize(), 1u);
+    EXPECT_EQ(batcher.getDeadlineUs(), 0u);
+    EXPECT_NEAR(batcher.getArrivalRate(), 10.0, 0.5);
+}
+
+// 高速到达时每次最多翻倍增长到上界，期限为攒满一批的预计时间
+TEST(BatchingTest, GrowsWithArrivalRate) {
+    AdaptiveBatcher batcher(stageOptions());
+    auto now = std::chrono::steady_clock::now();
+    batcher.observe(1, 0, now);
+    uint32_t previous = batcher.getBatchSize();
+    for (int i = 0; i < 10; ++i) {
+        now += microseconds(10);
+        batcher.observe(10, 0, now); // 每秒 100 万个
+        EXPECT_LE(batcher.getBatchSize(), previous * 2);
+        previous = batcher.getBatchSize();
+    }
+    EXPECT_EQ(batcher.getBatchSize(), 64u);
+    EXPECT_EQ(batcher.getDeadlineUs(), 64u);
+}
+
+// 有积压时即使估计速率很低也增大批大小
+TEST(BatchingTest, GrowsOnBacklog) {
+    AdaptiveBatcher batcher(stageOptions());
+    auto now = std::chrono::steady_clock::now();
+    batcher.observe(1, 1, now);
+    EXPECT_EQ(batcher.getBatchSize(), 2u);
+    now += milliseconds(100);
+    batcher.observe(2, 1, now);
+    EXPECT_EQ(batcher.getBatchSize(), 4u);
+    EXPECT_EQ(batcher.getDeadlineUs(), 200u); // 攒满需要的时间超过上界
+}
+
+// 负载下降后逐步减半回到逐个处理
+TEST(BatchingTest, ShrinksGraduallyWhenLoadDrops) {
+    AdaptiveBatcher batcher(stageOptions());
+    auto now = std::chrono::steady_clock::now();
+    batcher.observe(1, 0, now);
+    for (int i = 0; i < 10; ++i) {
+        now += microseconds(10);
+        batcher.observe(10, 0, now);
+    }
+    ASSERT_EQ(batcher.getBatchSize(), 64u);
+
+    uint32_t previous = batcher.getBatchSize();
+    for (int i = 0; i < 60; ++i) {
+        now += milliseconds(10);
+        batcher.observe(1, 0, now);
+        EXPECT_LE(batcher.getBatchSize(), previous);
+        EXPECT_GE(batcher.getBatchSize() * 2, previous);
+        previous = batcher.getBatchSize();
+    }
+    EXPECT_EQ(batcher.getBatchSize(), 1u);
+    EXPECT_EQ(batcher.getDeadlineUs(), 0u);
+}
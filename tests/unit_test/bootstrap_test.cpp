@@ -0,0 +1,187 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/bootstrap_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/bootstrap/bootstrap.h"
+#include "../../src/negotiate/negotiate.h"
+#include "../../src/policy/policy.h"
+#include "../../src/monitor/monitor.h"
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+using namespace negotio;
+
+namespace {
+    std::string writePolicyFile(const char *name, uint32_t count, uint32_t highPriorityEvery) {
+        const std::string path = (fs::temp_directory_path()
+                                  / (std::string(name) + "_" + std::to_string(getpid()) + ".jsonl")).string();
+        std::ofstream out(path);
+        for (uint32_t id = 1; id <= count; ++id) {
+            out << R"({"policy_id": )" << id
+                << R"(, "remote_ip": "127.0.0.1", "remote_port": 5000, "timeout_ms": 100, "retry_times": 3)";
+            if (highPriorityEvery != 0 && id % highPriorityEvery == 0) {
+                out << R"(, "priority": 5)";
+            }
+            out << "}\n";
+        }
+        return path;
+    }
+}
+
+// 并行解析、跳过非法行并按优先级排序
+TEST(BootstrapTest, LoadSortsByPriorityAndSkipsInvalidLines) {
+    const std::string path = writePolicyFile("bootstrap_load", 100, 10);
+    {
+        std::ofstream out(path, std::ios::app);
+        out << "not json\n";
+        out << R"({"policy_id": 0, "remote_ip": "127.0.0.1", "remote_port": 1, "timeout_ms": 1, "retry_times": 1})" << "\n";
+        out << R"({"policy_id": 500, "remote_ip": "bad-ip", "remote_port": 1, "timeout_ms": 1, "retry_times": 1})" << "\n";
+    }
+    std::vector<StartupPolicy> policies;
+    ASSERT_TRUE(loadStartupPolicies(path, 4, policies));
+    ASSERT_EQ(policies.size(), 100u);
+    // 高优先级在前，同优先级保持文件顺序
+    for (size_t i = 0; i < 10; ++i) {
+        EXPECT_EQ(policies[i].priority, 5u);
+        EXPECT_EQ(policies[i].config.policy_id, (i + 1) * 10);
+    }
+    EXPECT_EQ(policies[10].config.policy_id, 1u);
+    EXPECT_EQ(policies[10].priority, 0u);
+    fs::remove(path);
+}
+
+TEST(BootstrapTest, LoadMissingFileFails) {
+    std::vector<StartupPolicy> policies;
+    EXPECT_FALSE(loadStartupPolicies("/nonexistent/startup.jsonl", 2, policies));
+}
+
+// 对端即时响应时全部完成，且波次规模逐步增大
+TEST(BootstrapTest, NegotiatesAllPoliciesInWaves) {
+    const std::string path = writePolicyFile("bootstrap_waves", 300, 0);
+    PolicyManager policyManager;
+    Negotiator initiator;
+    Negotiator responder;
+    Monitor monitor;
+    // 同步环回：发起方发出的包直接交给响应方处理，反之亦然
+    initiator.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &addr) {
+        responder.handlePacket(packet, addr);
+    });
+    responder.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &addr) {
+        initiator.handlePacket(packet, addr);
+    });
+
+    BootstrapOptions options;
+    options.policyFile = path;
+    options.loaderThreads = 3;
+    options.initialWaveSize = 20;
+    options.maxWaveSize = 200;
+    options.waveIntervalMs = 10;
+    Bootstrapper bootstrapper(policyManager, initiator, &monitor, options);
+    bootstrapper.start();
+    bootstrapper.join();
+
+    const BootstrapProgress progress = bootstrapper.progress();
+    EXPECT_TRUE(progress.finished);
+    EXPECT_EQ(progress.total, 300u);
+    EXPECT_EQ(progress.started, 300u);
+    EXPECT_EQ(progress.completed, 300u);
+    EXPECT_GT(progress.waveSize, options.initialWaveSize);
+    EXPECT_EQ(policyManager.size(), 300u);
+    fs::remove(path);
+}
+
+// 启动策略数超过默认策略上限时按策略集扩容，全部写入并完成协商
+TEST(BootstrapTest, GrowsPolicyTableBeyondDefaultLimit) {
+    const uint32_t count = MAX_POLICY_COUNT + 500;
+    const std::string path = writePolicyFile("bootstrap_large", count, 0);
+    PolicyManager policyManager;
+    Negotiator initiator;
+    Negotiator responder;
+    initiator.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &addr) {
+        responder.handlePacket(packet, addr);
+    });
+    responder.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &addr) {
+        initiator.handlePacket(packet, addr);
+    });
+
+    BootstrapOptions options;
+    options.policyFile = path;
+    options.initialWaveSize = 1000;
+    options.maxWaveSize = 8000;
+    options.waveIntervalMs = 10;
+    Bootstrapper bootstrapper(policyManager, initiator, nullptr, options);
+    bootstrapper.start();
+    bootstrapper.join();
+
+    const BootstrapProgress progress = bootstrapper.progress();
+    EXPECT_EQ(policyManager.size(), count);
+    EXPECT_EQ(progress.total, count);
+    EXPECT_EQ(progress.completed, count);
+    fs::remove(path);
+}
+
+// 被对端丢弃的协商在超时后重新排队，直到完成
+TEST(BootstrapTest, RequeuesFailedNegotiations) {
+    const std::string path = writePolicyFile("bootstrap_retry", 50, 0);
+    PolicyManager policyManager;
+    Negotiator initiator;
+    Negotiator responder;
+    std::unordered_set<uint32_t> dropped;
+    // 每个策略的第一个 RANDOM1 丢失
+    initiator.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &addr) {
+        if (dropped.insert(packet.header.sequence).second) {
+            return;
+        }
+        responder.handlePacket(packet, addr);
+    });
+    responder.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &addr) {
+        initiator.handlePacket(packet, addr);
+    });
+
+    BootstrapOptions options;
+    options.policyFile = path;
+    options.initialWaveSize = 50;
+    options.waveIntervalMs = 10;
+    Bootstrapper bootstrapper(policyManager, initiator, nullptr, options);
+    bootstrapper.start();
+    bootstrapper.join();
+
+    const BootstrapProgress progress = bootstrapper.progress();
+    EXPECT_TRUE(progress.finished);
+    EXPECT_EQ(progress.started, 50u);
+    EXPECT_EQ(progress.retried, 50u);
+    EXPECT_EQ(progress.completed, 50u);
+    EXPECT_EQ(progress.abandoned, 0u);
+    fs::remove(path);
+}
+
+// 用尽 retry_times 次重试后放弃
+TEST(BootstrapTest, AbandonsAfterRetryBudget) {
+    const std::string path = writePolicyFile("bootstrap_abandon", 5, 0);
+    PolicyManager policyManager;
+    Negotiator initiator;
+    initiator.setUdpSender([](const NegotiationPacket &, const sockaddr_in &) {
+    });
+
+    BootstrapOptions options;
+    options.policyFile = path;
+    options.waveIntervalMs = 10;
+    Bootstrapper bootstrapper(policyManager, initiator, nullptr, options);
+    bootstrapper.start();
+    bootstrapper.join();
+
+    const BootstrapProgress progress = bootstrapper.progress();
+    EXPECT_TRUE(progress.finished);
+    EXPECT_EQ(progress.completed, 0u);
+    EXPECT_EQ(progress.retried, 5u * 3);
+    EXPECT_EQ(progress.abandoned, 5u);
+    fs::remove(path);
+}
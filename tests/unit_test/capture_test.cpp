@@ -0,0 +1,129 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/capture_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/capture/capture.h"
+#include <arpa/inet.h>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+
+using namespace negotio;
+
+namespace {
+    std::string tempCapturePath() {
+        return "/tmp/test_negotio_capture_" + std::to_string(getpid()) + ".ncap";
+    }
+
+    sockaddr_in makeAddr(const char *ip, uint16_t port) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, ip, &addr.sin_addr);
+        return addr;
+    }
+}
+
+// 写入后读回，内容、源地址与顺序应保持一致
+TEST(CaptureTest, WriteAndReadBack) {
+    const std::string path = tempCapturePath();
+    {
+        CaptureWriter writer(16);
+        ASSERT_TRUE(writer.open(path));
+        for (uint8_t i = 0; i < 10; ++i) {
+            std::vector<uint8_t> data(20 + i, i);
+            EXPECT_TRUE(writer.record(data.data(), data.size(), makeAddr("10.0.0.1", 5000 + i)));
+        }
+        writer.close();
+        EXPECT_EQ(writer.getRecorded(), 10u);
+    }
+
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path));
+    CaptureRecord record;
+    uint64_t lastTimestamp = 0;
+    for (uint8_t i = 0; i < 10; ++i) {
+        ASSERT_TRUE(reader.next(record));
+        EXPECT_EQ(record.data.size(), 20u + i);
+        EXPECT_EQ(record.data.front(), i);
+        EXPECT_EQ(ntohs(record.src.sin_port), 5000 + i);
+        EXPECT_EQ(record.src.sin_addr.s_addr, makeAddr("10.0.0.1", 0).sin_addr.s_addr);
+        EXPECT_GE(record.timestampNs, lastTimestamp);
+        lastTimestamp = record.timestampNs;
+    }
+    EXPECT_FALSE(reader.next(record));
+
+    // 再次打开同一个读取器时关闭旧文件，从头读取
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.data.front(), 0);
+    std::filesystem::remove(path);
+}
+
+// 超过 snaplen 的数据报被截断，但保留原始长度
+TEST(CaptureTest, TruncatesToSnaplen) {
+    const std::string path = tempCapturePath();
+    {
+        CaptureWriter writer;
+        ASSERT_TRUE(writer.open(path));
+        std::vector<uint8_t> data(CAPTURE_SNAPLEN + 100, 0xAB);
+        EXPECT_TRUE(writer.record(data.data(), data.size(), makeAddr("127.0.0.1", 1)));
+    }
+
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path));
+    CaptureRecord record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.data.size(), CAPTURE_SNAPLEN);
+    EXPECT_EQ(record.originalLen, CAPTURE_SNAPLEN + 100);
+    std::filesystem::remove(path);
+}
+
+// 多个生产者并发记录时不丢失、不损坏记录
+TEST(CaptureTest, ConcurrentProducers) {
+    const std::string path = tempCapturePath();
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 2000;
+    uint64_t dropped = 0;
+    {
+        CaptureWriter writer(1 << 15);
+        ASSERT_TRUE(writer.open(path));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&writer, t]() {
+                std::vector<uint8_t> data(32, static_cast<uint8_t>(t));
+                for (int i = 0; i < kPerThread; ++i) {
+                    writer.record(data.data(), data.size(), makeAddr("127.0.0.1", static_cast<uint16_t>(t)));
+                }
+            });
+        }
+        for (auto &th : threads) {
+            th.join();
+        }
+        writer.close();
+        dropped = writer.getDropped();
+        EXPECT_EQ(writer.getRecorded() + dropped, static_cast<uint64_t>(kThreads * kPerThread));
+    }
+
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path));
+    CaptureRecord record;
+    uint64_t count = 0;
+    while (reader.next(record)) {
+        ASSERT_EQ(record.data.size(), 32u);
+        EXPECT_EQ(record.data.front(), ntohs(record.src.sin_port));
+        ++count;
+    }
+    EXPECT_EQ(count + dropped, static_cast<uint64_t>(kThreads * kPerThread));
+    std::filesystem::remove(path);
+}
+
+TEST(CaptureTest, RejectsInvalidFile) {
+    CaptureReader reader;
+    EXPECT_FALSE(reader.open("/this/path/should/not/exist.ncap"));
+}
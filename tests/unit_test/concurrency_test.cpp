@@ -0,0 +1,258 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/concurrency_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/concurrency/concurrency.h"
+#include "../../src/negotiate/negotiate.h"
+#include <chrono>
+#include <netinet/in.h>
+#include <thread>
+#include <utility>
+
+using namespace negotio;
+
+namespace {
+    ConcurrencyLimitOptions smallWindow(const uint32_t initialLimit) {
+        ConcurrencyLimitOptions options;
+        options.targetLatencyMs = 100;
+        options.initialLimit = initialLimit;
+        options.minLimit = 4;
+        options.maxLimit = 1000;
+        options.windowSamples = 20;
+        return options;
+    }
+
+    // 占满上限后按给定耗时完成一个窗口的协商（其中 timedOut 个超时），其余在途协商取消
+    void runFullWindow(ConcurrencyLimiter &limiter, const uint32_t latencyMs, const uint32_t timedOut = 0) {
+        uint32_t acquired = 0;
+        while (limiter.tryAcquire()) {
+            ++acquired;
+        }
+        ASSERT_GE(acquired, 20u);
+        for (uint32_t i = 0; i < 20; ++i) {
+            if (i < timedOut) {
+                limiter.releaseTimedOut();
+            } else {
+                limiter.release(latencyMs);
+            }
+        }
+        for (uint32_t i = 20; i < acquired; ++i) {
+            limiter.cancel();
+        }
+    }
+}
+
+TEST(ConcurrencyTest, AdmitsUpToLimit) {
+    ConcurrencyLimiter limiter(smallWindow(16));
+    for (int i = 0; i < 16; ++i) {
+        ASSERT_TRUE(limiter.tryAcquire());
+    }
+    EXPECT_FALSE(limiter.tryAcquire());
+    EXPECT_EQ(limiter.getInFlight(), 16u);
+    EXPECT_EQ(limiter.getRejected(), 1u);
+    limiter.cancel();
+    EXPECT_TRUE(limiter.tryAcquire());
+}
+
+// 余量越大增幅越大，超出目标时乘性减小
+TEST(ConcurrencyTest, GrowsWithHeadroomAndBacksOffOnMiss) {
+    ConcurrencyLimiter fast(smallWindow(100));
+    runFullWindow(fast, 0);
+    EXPECT_EQ(fast.getLimit(), 110u); // +sqrt(100)
+    EXPECT_EQ(fast.getWindowLatencyMs(), 0u);
+
+    ConcurrencyLimiter nearTarget(smallWindow(100));
+    runFullWindow(nearTarget, 95);
+    EXPECT_EQ(nearTarget.getLimit(), 101u);
+
+    ConcurrencyLimiter slow(smallWindow(100));
+    runFullWindow(slow, 150);
+    EXPECT_EQ(slow.getLimit(), 80u);
+    EXPECT_EQ(slow.getWindowLatencyMs(), 150u);
+
+    // 反复超出目标也不低于下界
+    for (int i = 0; i < 400; ++i) {
+        ASSERT_TRUE(slow.tryAcquire());
+        slow.release(200);
+    }
+    EXPECT_EQ(slow.getLimit(), 4u);
+}
+
+// 少量超时（丢包）不影响 p90，大量超时视为超出目标
+// 时延目标为 0 时按 1 ms 处理，上限按有限的余量调整
+TEST(ConcurrencyTest, ZeroTargetIsClampedToOneMillisecond) {
+    ConcurrencyLimitOptions options = smallWindow(100);
+    options.targetLatencyMs = 0;
+    ConcurrencyLimiter limiter(options);
+    EXPECT_EQ(limiter.getTargetLatencyMs(), 1u);
+
+    runFullWindow(limiter, 0);
+    EXPECT_EQ(limiter.getLimit(), 110u); // 余量为 1，增大 sqrt(100)
+    runFullWindow(limiter, 1);
+    EXPECT_EQ(limiter.getLimit(), 111u); // 恰好达到目标，增大 1
+    runFullWindow(limiter, 2);
+    EXPECT_EQ(limiter.getLimit(), 88u);  // 超出目标，乘以 0.8
+}
+
+TEST(ConcurrencyTest, TimeoutsCountAgainstTarget) {
+    ConcurrencyLimiter lossy(smallWindow(100));
+    runFullWindow(lossy, 10, 1);
+    EXPECT_GT(lossy.getLimit(), 100u);
+
+    ConcurrencyLimiter stalled(smallWindow(100));
+    runFullWindow(stalled, 10, 5);
+    EXPECT_EQ(stalled.getLimit(), 80u);
+    EXPECT_EQ(stalled.getWindowLatencyMs(), ConcurrencyLimiter::TIMED_OUT);
+}
+
+// 负载远低于上限时不增大
+TEST(ConcurrencyTest, HoldsLimitWhenUnderused) {
+    ConcurrencyLimiter limiter(smallWindow(100));
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_TRUE(limiter.tryAcquire());
+        limiter.release(1);
+    }
+    EXPECT_EQ(limiter.getLimit(), 100u);
+}
+
+// 超出上限的本端发起协商延后，有名额时由 expireSessions 发起
+TEST(ConcurrencyTest, NegotiatorDefersStartsBeyondLimit) {
+    ConcurrencyLimitOptions options = smallWindow(4);
+    options.maxLimit = 4;
+    ConcurrencyLimiter limiter(options);
+    Negotiator initiator;
+    Negotiator responder;
+    std::vector<std::pair<NegotiationPacket, bool>> inFlight; // 数据包及其是否发往响应方
+    initiator.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &) {
+        inFlight.emplace_back(packet, true);
+    });
+    responder.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &) {
+        inFlight.emplace_back(packet, false);
+    });
+    initiator.setConcurrencyLimiter(&limiter, 2);
+    sockaddr_in peer{};
+    peer.sin_family = AF_INET;
+
+    for (uint32_t id = 1; id <= 6; ++id) {
+        EXPECT_EQ(initiator.startNegotiation(id, peer), ErrorCode::SUCCESS);
+    }
+    EXPECT_EQ(initiator.startNegotiation(7, peer), ErrorCode::NEGOTIATION_FAILED); // 延后队列已满
+    EXPECT_EQ(initiator.getSessionTableStats().hot, 4u);
+    EXPECT_EQ(initiator.getDeferredCount(), 2u);
+    EXPECT_EQ(limiter.getInFlight(), 4u);
+
+    auto deliver = [&] {
+        while (!inFlight.empty()) {
+            const auto batch = std::exchange(inFlight, {});
+            for (const auto &[packet, toResponder] : batch) {
+                (toResponder ? responder : initiator).handlePacket(packet, peer);
+            }
+        }
+    };
+    deliver();
+    EXPECT_EQ(limiter.getInFlight(), 0u);
+    EXPECT_EQ(initiator.expireSessions(100), 0u);
+    EXPECT_EQ(initiator.getDeferredCount(), 0u);
+    deliver();
+    for (uint32_t id = 1; id <= 6; ++id) {
+        EXPECT_TRUE(initiator.getEstablishedKey(id).has_value()) << "policy " << id;
+    }
+    EXPECT_FALSE(initiator.getEstablishedKey(7).has_value());
+    EXPECT_EQ(limiter.getInFlight(), 0u);
+}
+
+// 响应方超出上限时丢弃 RANDOM1；超时会话被删除并归还名额
+TEST(ConcurrencyTest, NegotiatorShedsAndExpires) {
+    ConcurrencyLimitOptions options = smallWindow(4);
+    options.maxLimit = 4;
+    ConcurrencyLimiter limiter(options);
+    Negotiator initiator;
+    Negotiator responder;
+    std::vector<NegotiationPacket> toResponder;
+    initiator.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &) {
+        toResponder.push_back(packet);
+    });
+    responder.setConcurrencyLimiter(&limiter);
+    sockaddr_in peer{};
+    peer.sin_family = AF_INET;
+
+    for (uint32_t id = 1; id <= 6; ++id) {
+        ASSERT_EQ(initiator.startNegotiation(id, peer), ErrorCode::SUCCESS);
+    }
+    size_t shed = 0;
+    for (const auto &packet : toResponder) {
+        if (responder.handlePacket(packet, peer) == ErrorCode::NEGOTIATION_FAILED) {
+            ++shed;
+        }
+    }
+    EXPECT_EQ(shed, 2u);
+    EXPECT_EQ(responder.getSessionTableStats().hot, 4u);
+    EXPECT_EQ(limiter.getRejected(), 2u);
+
+    // 对端未发送 CONFIRM：超时后删除会话，名额归还
+    EXPECT_EQ(responder.expireSessions(1000), 0u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(responder.expireSessions(10), 4u);
+    EXPECT_EQ(responder.getSessionTableStats().hot, 0u);
+    EXPECT_EQ(limiter.getInFlight(), 0u);
+    EXPECT_EQ(responder.handlePacket(toResponder[4], peer), ErrorCode::SUCCESS);
+}
+
+// 被响应方丢弃的协商在发起方超时后重新发起，最终完成；重试次数用完后不再发起
+TEST(ConcurrencyTest, ShedNegotiationCompletesAfterRetry) {
+    ConcurrencyLimitOptions options = smallWindow(4);
+    options.maxLimit = 4;
+    ConcurrencyLimiter limiter(options);
+    Negotiator initiator;
+    Negotiator responder;
+    std::vector<std::pair<NegotiationPacket, bool>> inFlight; // 数据包及其是否发往响应方
+    initiator.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &) {
+        inFlight.emplace_back(packet, true);
+    });
+    responder.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &) {
+        inFlight.emplace_back(packet, false);
+    });
+    responder.setConcurrencyLimiter(&limiter);
+    sockaddr_in peer{};
+    peer.sin_family = AF_INET;
+
+    // 先让响应方积压 4 个等待 CONFIRM 的会话，随后的 RANDOM1 全部被丢弃
+    for (uint32_t id = 1; id <= 6; ++id) {
+        const PolicyConfig policy{id, "127.0.0.1", 5000, 10, id == 6 ? 0u : 2u};
+        ASSERT_EQ(initiator.startNegotiation(policy), ErrorCode::SUCCESS);
+    }
+    size_t shed = 0;
+    for (const auto &[packet, toResponder] : std::exchange(inFlight, {})) {
+        if (responder.handlePacket(packet, peer) == ErrorCode::NEGOTIATION_FAILED) {
+            ++shed;
+        }
+    }
+    ASSERT_EQ(shed, 2u);
+    auto deliver = [&] {
+        while (!inFlight.empty()) {
+            const auto batch = std::exchange(inFlight, {});
+            for (const auto &[packet, toResponder] : batch) {
+                (toResponder ? responder : initiator).handlePacket(packet, peer);
+            }
+        }
+    };
+    deliver();
+    EXPECT_EQ(limiter.getInFlight(), 0u);
+    EXPECT_FALSE(initiator.getEstablishedKey(5).has_value());
+
+    // 超过策略的 timeout_ms：有重试次数的重新发起，全局超时参数不影响带超时的会话
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(initiator.expireSessions(1000), 2u);
+    deliver();
+    for (uint32_t id = 1; id <= 5; ++id) {
+        EXPECT_TRUE(initiator.getEstablishedKey(id).has_value()) << "policy " << id;
+        EXPECT_EQ(initiator.getSession(id)->key, responder.getSession(id)->key) << "policy " << id;
+    }
+    EXPECT_FALSE(initiator.getEstablishedKey(6).has_value());
+    EXPECT_EQ(initiator.getSessionTableStats().hot, 0u);
+}
@@ -0,0 +1,107 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/control_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/control/control.h"
+#include "../../src/policy/policy.h"
+#include "../../src/negotiate/negotiate.h"
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace negotio;
+
+namespace {
+    ControlCommand addCommand(const uint32_t policy_id, const uint16_t port) {
+        ControlCommand command{};
+        command.action = ControlAction::ADD;
+        command.policy = {policy_id, "127.0.0.1", port, 100, 3};
+        return command;
+    }
+}
+
+TEST(ControlTest, DecodeAddCommand) {
+    ControlCommand command{};
+    ASSERT_TRUE(decodeControlCommand(
+        R"({"action": "add", "policy": {"policy_id": 1234, "remote_ip": "192.168.1.10", "remote_port": 5000, "timeout_ms": 100, "retry_times": 3}})",
+        command));
+    EXPECT_EQ(command.action, ControlAction::ADD);
+    EXPECT_EQ(command.policy.policy_id, 1234u);
+    EXPECT_EQ(command.policy.remote_ip, "192.168.1.10");
+    EXPECT_EQ(command.policy.remote_port, 5000);
+}
+
+TEST(ControlTest, DecodeRejectsInvalidCommands) {
+    ControlCommand command{};
+    EXPECT_FALSE(decodeControlCommand("not json", command));
+    EXPECT_FALSE(decodeControlCommand(R"({"action": "remove", "policy": {}})", command));
+    EXPECT_FALSE(decodeControlCommand(
+        R"({"action": "add", "policy": {"policy_id": 0, "remote_ip": "10.0.0.1", "remote_port": 1, "timeout_ms": 1, "retry_times": 1}})",
+        command));
+    EXPECT_FALSE(decodeControlCommand(
+        R"({"action": "add", "policy": {"policy_id": 5, "remote_ip": "bad-ip", "remote_port": 1, "timeout_ms": 1, "retry_times": 1}})",
+        command));
+}
+
+// 同一策略的命令按分派顺序执行，不同策略分布到各分片
+TEST(ControlTest, PreservesPerPolicyOrder) {
+    std::mutex mtx;
+    std::map<uint32_t, std::vector<uint16_t>> seen; // policy_id -> 执行顺序（以端口作为序号）
+    std::set<std::thread::id> workers;
+    ControlDispatcherOptions options;
+    options.workerThreads = 4;
+    options.maxQueuedPerShard = 8; // 小队列，覆盖背压路径
+    ControlDispatcher dispatcher([&](const ControlCommand &command) {
+        std::lock_guard lock(mtx);
+        seen[command.policy.policy_id].push_back(command.policy.remote_port);
+        workers.insert(std::this_thread::get_id());
+    }, options);
+    dispatcher.start();
+
+    constexpr uint32_t kPolicies = 32;
+    constexpr uint16_t kCommandsPerPolicy = 50;
+    for (uint16_t seq = 0; seq < kCommandsPerPolicy; ++seq) {
+        for (uint32_t id = 1; id <= kPolicies; ++id) {
+            ASSERT_TRUE(dispatcher.dispatch(addCommand(id, seq)));
+        }
+    }
+    dispatcher.stop();
+
+    EXPECT_EQ(dispatcher.getExecuted(), kPolicies * kCommandsPerPolicy);
+    ASSERT_EQ(seen.size(), kPolicies);
+    for (const auto &[id, order] : seen) {
+        ASSERT_EQ(order.size(), kCommandsPerPolicy) << "policy_id = " << id;
+        for (uint16_t seq = 0; seq < kCommandsPerPolicy; ++seq) {
+            EXPECT_EQ(order[seq], seq) << "policy_id = " << id;
+        }
+    }
+    EXPECT_EQ(workers.size(), options.workerThreads);
+    EXPECT_FALSE(dispatcher.dispatch(addCommand(1, 0)));
+}
+
+// 分片执行 add：写入策略表并发起协商
+TEST(ControlTest, ExecutesAddOnWorkers) {
+    PolicyManager policyManager;
+    Negotiator negotiator;
+    ControlDispatcher dispatcher([&](const ControlCommand &command) {
+        executeControlCommand(command, policyManager, negotiator);
+    }, ControlDispatcherOptions{});
+    dispatcher.start();
+    for (uint32_t id = 1; id <= 64; ++id) {
+        dispatcher.dispatch(addCommand(id, 6000));
+    }
+    dispatcher.stop();
+
+    for (uint32_t id = 1; id <= 64; ++id) {
+        EXPECT_TRUE(policyManager.getPolicy(id).has_value()) << "policy_id = " << id;
+        const auto session = negotiator.getSession(id);
+        ASSERT_TRUE(session.has_value()) << "policy_id = " << id;
+        EXPECT_EQ(session->state, NegotiateState::WAIT_R2);
+    }
+}
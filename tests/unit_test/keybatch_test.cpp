@@ -0,0 +1,43 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/keybatch_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/keybatch/keybatch.h"
+
+using namespace negotio;
+
+namespace {
+    SessionKey filledKey(const uint8_t value) {
+        SessionKey key{};
+        key.fill(value);
+        return key;
+    }
+}
+
+// 派生结果确定且依赖于首个密钥、策略ID与序号
+TEST(KeyBatchTest, DerivationIsDeterministicAndDistinct) {
+    const KeyBatchSecret prk = extractKeyBatchSecret(filledKey(0x5A));
+    EXPECT_EQ(prk, extractKeyBatchSecret(filledKey(0x5A)));
+    EXPECT_NE(prk, extractKeyBatchSecret(filledKey(0x5B)));
+
+    const SessionKey key = deriveBatchKey(prk, 7, 1);
+    EXPECT_EQ(key.size(), KEY_SIZE);
+    EXPECT_EQ(key, deriveBatchKey(prk, 7, 1));
+    EXPECT_NE(key, deriveBatchKey(prk, 7, 2));
+    EXPECT_NE(key, deriveBatchKey(prk, 8, 1));
+}
+
+// 与独立的 HKDF-SHA256 实现对照：K = 全零，policy_id = 1，序号 2
+TEST(KeyBatchTest, MatchesHkdfReference) {
+    const KeyBatchSecret prk = extractKeyBatchSecret(filledKey(0));
+    const SessionKey expected = {
+        0x3e, 0xbc, 0x34, 0xb1, 0x0a, 0xbf, 0xc0, 0xbf, 0x46, 0xf2, 0x60, 0x65, 0x7d, 0xde, 0x9c, 0xbd,
+        0x9a, 0x7b, 0xee, 0x6a, 0xc1, 0x6a, 0x32, 0xab, 0xd5, 0x2c, 0x81, 0xa2, 0x83, 0x0f, 0xec, 0x3e,
+    };
+    EXPECT_EQ(deriveBatchKey(prk, 1, 2), expected);
+}
@@ -0,0 +1,111 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/localtransport_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/localtransport/localtransport.h"
+#include "../../src/negotiate/negotiate.h"
+#include <arpa/inet.h>
+#include <filesystem>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using namespace negotio;
+
+namespace {
+    sockaddr_in addrOf(const char *ip, const uint16_t port) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        inet_pton(AF_INET, ip, &addr.sin_addr);
+        addr.sin_port = htons(port);
+        return addr;
+    }
+
+    std::string makeSocketDir() {
+        const fs::path dir = fs::temp_directory_path() / ("negotio_local_" + std::to_string(getpid()));
+        fs::create_directories(dir);
+        return dir.string();
+    }
+}
+
+TEST(LocalTransportTest, SocketPathRoundTrip) {
+    const sockaddr_in addr = addrOf("172.17.0.3", 5000);
+    const std::string path = LocalTransport::socketPath("/run/negotio", addr);
+    EXPECT_EQ(path, "/run/negotio/negotio-172.17.0.3-5000.sock");
+
+    sockaddr_in parsed{};
+    ASSERT_TRUE(LocalTransport::parseSocketPath(path, parsed));
+    EXPECT_EQ(parsed.sin_addr.s_addr, addr.sin_addr.s_addr);
+    EXPECT_EQ(parsed.sin_port, addr.sin_port);
+
+    EXPECT_FALSE(LocalTransport::parseSocketPath("/tmp/other.sock", parsed));
+    EXPECT_FALSE(LocalTransport::parseSocketPath("/run/negotio/negotio-1.2.3-5000.sock", parsed));
+    EXPECT_FALSE(LocalTransport::parseSocketPath("/run/negotio/negotio-1.2.3.4-70000.sock", parsed));
+}
+
+TEST(LocalTransportTest, SelectsByAddressClass) {
+    LocalTransport transport;
+    ASSERT_TRUE(transport.addLocalSubnet("127.0.0.0/8"));
+    ASSERT_TRUE(transport.addLocalSubnet("172.17.0.0/16"));
+    ASSERT_TRUE(transport.addLocalSubnet("10.1.2.3"));
+    EXPECT_FALSE(transport.addLocalSubnet("10.0.0.0/33"));
+    EXPECT_FALSE(transport.addLocalSubnet("bad/8"));
+
+    EXPECT_TRUE(transport.isLocal(addrOf("127.0.0.1", 1)));
+    EXPECT_TRUE(transport.isLocal(addrOf("172.17.200.9", 1)));
+    EXPECT_TRUE(transport.isLocal(addrOf("10.1.2.3", 1)));
+    EXPECT_FALSE(transport.isLocal(addrOf("10.1.2.4", 1)));
+    EXPECT_FALSE(transport.isLocal(addrOf("192.168.1.10", 1)));
+}
+
+// 两个实例经本地套接字完成协商，对端地址与 UDP 下相同；对端不存在时发送失败以便回退
+TEST(LocalTransportTest, NegotiatesOverUnixDatagrams) {
+    const std::string dir = makeSocketDir();
+    const sockaddr_in addrA = addrOf("172.17.0.2", 5000);
+    const sockaddr_in addrB = addrOf("172.17.0.3", 5000);
+    LocalTransport a;
+    LocalTransport b;
+    ASSERT_EQ(a.init(dir, addrA), ErrorCode::SUCCESS);
+    ASSERT_EQ(b.init(dir, addrB), ErrorCode::SUCCESS);
+    EXPECT_EQ(a.sendPacket(NegotiationPacket{}, addrOf("172.17.0.9", 5000)), ErrorCode::SOCKET_ERROR);
+
+    Negotiator initiator;
+    Negotiator responder;
+    initiator.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &addr) {
+        a.sendPacket(packet, addr);
+    });
+    responder.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &addr) {
+        b.sendPacket(packet, addr);
+    });
+    ASSERT_EQ(initiator.startNegotiation(41, addrB), ErrorCode::SUCCESS);
+
+    // 交替收包直到双方都没有待处理的数据包
+    for (int idle = 0; idle < 2;) {
+        NegotiationPacket packet;
+        sockaddr_in from{};
+        bool progressed = false;
+        if (b.recvPacket(packet, from, 20) == ErrorCode::SUCCESS) {
+            EXPECT_EQ(from.sin_addr.s_addr, addrA.sin_addr.s_addr);
+            EXPECT_EQ(from.sin_port, addrA.sin_port);
+            responder.handlePacket(packet, from);
+            progressed = true;
+        }
+        if (a.recvPacket(packet, from, 20) == ErrorCode::SUCCESS) {
+            EXPECT_EQ(from.sin_addr.s_addr, addrB.sin_addr.s_addr);
+            initiator.handlePacket(packet, from);
+            progressed = true;
+        }
+        idle = progressed ? 0 : idle + 1;
+    }
+
+    const auto keyA = initiator.getEstablishedKey(41);
+    const auto keyB = responder.getEstablishedKey(41);
+    ASSERT_TRUE(keyA.has_value());
+    ASSERT_TRUE(keyB.has_value());
+    EXPECT_EQ(keyA->key, keyB->key);
+    fs::remove_all(dir);
+}
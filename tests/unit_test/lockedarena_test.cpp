@@ -0,0 +1,77 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/lockedarena_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/lockedarena/lockedarena.h"
+#include "../../src/sessionstore/sessionstore.h"
+#include <algorithm>
+#include <vector>
+
+using namespace negotio;
+
+namespace {
+    // 锁定内存区每个进程只初始化一次，本文件的用例共用同一个 8 MB 区域
+    LockedArena &arena() {
+        LockedArena &instance = LockedArena::instance();
+        EXPECT_TRUE(instance.init(8 * 1024 * 1024));
+        return instance;
+    }
+}
+
+TEST(LockedArenaTest, ReusesZeroedBlocks) {
+    LockedArena &region = arena();
+    ASSERT_TRUE(region.isMapped());
+    EXPECT_GE(region.getCapacity(), 8u * 1024 * 1024);
+
+    auto *first = static_cast<uint8_t *>(region.allocate(24, alignof(uint64_t)));
+    ASSERT_TRUE(region.contains(first));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(first) % 32, 0u);
+    std::fill_n(first, 24, 0xAB);
+    const size_t used = region.getUsedBytes();
+    region.deallocate(first, 24, alignof(uint64_t));
+    EXPECT_EQ(region.getUsedBytes(), used - 32);
+
+    // 同一尺寸类复用刚释放的块，旧内容已清零
+    auto *second = static_cast<uint8_t *>(region.allocate(30, 1));
+    EXPECT_EQ(second, first);
+    for (size_t i = 0; i < 30; ++i) {
+        ASSERT_EQ(second[i], 0) << "byte " << i;
+    }
+    region.deallocate(second, 30, 1);
+}
+
+// 热表与冷存储的节点、记录块分配在锁定内存区
+TEST(LockedArenaTest, BacksSessionTables) {
+    LockedArena &region = arena();
+    LockedMap<uint32_t, uint64_t> map;
+    map.emplace(1, 2);
+    EXPECT_TRUE(region.contains(&map.find(1)->second));
+
+    const size_t used = region.getUsedBytes();
+    {
+        ColdSessionStore store;
+        SessionKey key{};
+        key.fill(0x5A);
+        store.upsert(7, key);
+        EXPECT_GT(region.getUsedBytes(), used);
+        ColdSession session{};
+        ASSERT_TRUE(store.read(7, session));
+        EXPECT_EQ(session.key[0], 0x5A);
+    }
+    EXPECT_EQ(region.getUsedBytes(), used);
+}
+
+TEST(LockedArenaTest, FallsBackToHeap) {
+    LockedArena &region = arena();
+    const uint64_t before = region.getFallbacks();
+    void *large = region.allocate(LOCKED_ARENA_MAX_BLOCK + 1, 16);
+    ASSERT_NE(large, nullptr);
+    EXPECT_FALSE(region.contains(large));
+    EXPECT_EQ(region.getFallbacks(), before + 1);
+    region.deallocate(large, LOCKED_ARENA_MAX_BLOCK + 1, 16);
+}
@@ -0,0 +1,72 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/lockstat_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/lockstat/lockstat.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace negotio;
+
+namespace {
+    LockSiteStats findSite(const std::string &name) {
+        for (auto &site : getLockStats()) {
+            if (site.name == name) {
+                return site;
+            }
+        }
+        return LockSiteStats{};
+    }
+}
+
+// 同名互斥锁共享同一个锁位点
+TEST(LockStatTest, SameNameSharesSite) {
+    EXPECT_EQ(LockSite::get("LockStatTest::shared"), LockSite::get("LockStatTest::shared"));
+    EXPECT_NE(LockSite::get("LockStatTest::shared"), LockSite::get("LockStatTest::other"));
+}
+
+// 获取与竞争等待被记录到对应锁位点
+TEST(LockStatTest, RecordsAcquisitionsAndWaits) {
+    if (!lockStatsEnabled()) {
+        GTEST_SKIP() << "NEGOTIO_LOCK_STATS 未开启";
+    }
+    InstrumentedMutex mutex("LockStatTest::mutex");
+    resetLockStats();
+
+    {
+        std::lock_guard lock(mutex);
+    }
+    EXPECT_EQ(findSite("LockStatTest::mutex").acquisitions, 1u);
+    EXPECT_EQ(findSite("LockStatTest::mutex").contended, 0u);
+
+    std::unique_lock holder(mutex);
+    std::thread waiter([&mutex]() {
+        std::lock_guard lock(mutex);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    holder.unlock();
+    waiter.join();
+
+    const LockSiteStats stats = findSite("LockStatTest::mutex");
+    EXPECT_EQ(stats.acquisitions, 3u);
+    EXPECT_EQ(stats.contended, 1u);
+    EXPECT_GE(stats.waitNs, 10'000'000u);
+    EXPECT_GE(stats.maxWaitNs, stats.waitNs);
+    EXPECT_GE(stats.waitPercentileNs(0.99), stats.waitNs);
+}
+
+// 分位数估计返回所在直方图桶的上界
+TEST(LockStatTest, WaitPercentileFromHistogram) {
+    LockSiteStats stats{};
+    stats.contended = 100;
+    stats.waitHistogram[10] = 90;  // [1024, 2048) ns
+    stats.waitHistogram[20] = 10;  // [1 ms, 2 ms)
+    EXPECT_EQ(stats.waitPercentileNs(0.5), 2048u);
+    EXPECT_EQ(stats.waitPercentileNs(0.95), 2u << 20);
+}
@@ -4,130 +4,397 @@
  * @since v1.0.0
  */
 
-#pragma once
-#ifndef NEGOTIO_NEGOTIATE_H
-#define NEGOTIO_NEGOTIATE_H
-
-#include "common.h"
-#include <vector>
-#include <unordered_map>
-#include <mutex>
-#include <optional>
-#include <chrono>
+// tests/unit_test/negotiate_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/negotiate/negotiate.h"
+#include <algorithm>
 #include <netinet/in.h>
-#include <array>
-#include <functional>
-
-namespace negotio {
-    // 协商状态定义
-    enum class NegotiateState {
-        INIT,
-        WAIT_R2,
-        WAIT_CONFIRM,
-        DONE,
-        FAILED
-    };
+#include <utility>
 
-    // 单个协商会话结构体
-    struct NegotiationSession {
-        uint32_t policy_id; ///< 策略ID，用作会话标识
-        NegotiateState state; ///< 当前协商状态
-        std::vector<uint8_t> random1; ///< 发起方随机数 (32字节)
-        std::vector<uint8_t> random2; ///< 响应方随机数 (32字节)
-        std::vector<uint8_t> key; ///< 计算得到的共享密钥 (32字节)
-        std::chrono::steady_clock::time_point startTime; ///< 协商开始时间
-    };
+using namespace negotio;
 
-    class Monitor;
+namespace {
+    // 发起方与响应方通过同步回调直接互发数据包
+    struct NegotiatorPair {
+        Negotiator initiator;
+        Negotiator responder;
+        sockaddr_in peer{};
+        std::vector<PacketType> sent; ///< 双方发出的数据包类型，按发送顺序
 
-    // 会话桶结构体，用于分桶管理会话，降低锁竞争
-    struct SessionBucket {
-        std::unordered_map<uint32_t, NegotiationSession> sessions;
-        std::mutex mtx;
+        NegotiatorPair() {
+            peer.sin_family = AF_INET;
+            peer.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            initiator.setUdpSender([this](const NegotiationPacket &packet, const sockaddr_in &addr) {
+                sent.push_back(packet.header.type);
+                responder.handlePacket(packet, addr);
+            });
+            responder.setUdpSender([this](const NegotiationPacket &packet, const sockaddr_in &addr) {
+                sent.push_back(packet.header.type);
+                initiator.handlePacket(packet, addr);
+            });
+        }
     };
+}
+
+// 完整协商后双方得到相同密钥
+TEST(NegotiatorTest, FullNegotiationFlow) {
+    NegotiatorPair pair;
+    ASSERT_EQ(pair.initiator.startNegotiation(42, pair.peer), ErrorCode::SUCCESS);
+
+    const auto initiatorSession = pair.initiator.getSession(42);
+    const auto responderSession = pair.responder.getSession(42);
+    ASSERT_TRUE(initiatorSession.has_value());
+    ASSERT_TRUE(responderSession.has_value());
+    EXPECT_EQ(initiatorSession->state, NegotiateState::DONE);
+    EXPECT_EQ(responderSession->state, NegotiateState::DONE);
+    EXPECT_EQ(initiatorSession->key.size(), KEY_SIZE);
+    EXPECT_EQ(initiatorSession->key, responderSession->key);
+}
+
+// 协商完成的会话移入冷存储，热表只保留进行中的会话
+TEST(NegotiatorTest, DoneSessionsMoveToColdStore) {
+    NegotiatorPair pair;
+    Negotiator pending;
+    pending.startNegotiation(7, pair.peer); // 无发送回调，停留在 WAIT_R2
+    for (uint32_t id = 1; id <= 100; ++id) {
+        pair.initiator.startNegotiation(id, pair.peer);
+    }
+
+    const SessionTableStats stats = pair.initiator.getSessionTableStats();
+    EXPECT_EQ(stats.hot, 0u);
+    EXPECT_EQ(stats.cold, 100u);
+    EXPECT_GT(stats.coldBytes, 0u);
+    EXPECT_EQ(pair.responder.getSessionTableStats().cold, 100u);
+
+    const SessionTableStats pendingStats = pending.getSessionTableStats();
+    EXPECT_EQ(pendingStats.hot, 1u);
+    EXPECT_EQ(pendingStats.cold, 0u);
+    EXPECT_EQ(pending.getSession(7)->state, NegotiateState::WAIT_R2);
+    EXPECT_FALSE(pending.getKeyEpoch(7).has_value());
+}
+
+// 重新协商时旧密钥在新密钥生效前保持可用，完成后纪元递增
+TEST(NegotiatorTest, RenegotiationBumpsEpoch) {
+    NegotiatorPair pair;
+    pair.initiator.startNegotiation(9, pair.peer);
+    ASSERT_EQ(pair.initiator.getKeyEpoch(9), 1u);
+    const SessionKey firstKey = pair.initiator.getSession(9)->key;
+
+    // 响应方不参与第二轮，手工模拟 RANDOM2
+    Negotiator &initiator = pair.initiator;
+    initiator.setUdpSender(nullptr);
+    ASSERT_EQ(initiator.startNegotiation(9, pair.peer), ErrorCode::SUCCESS);
+    EXPECT_EQ(initiator.getSession(9)->state, NegotiateState::WAIT_R2);
+    EXPECT_EQ(initiator.getKeyEpoch(9), 1u);
+
+    NegotiationPacket random2{};
+    random2.header.magic = MAGIC_NUMBER;
+    random2.header.type = PacketType::RANDOM2;
+    random2.header.sequence = 9;
+    random2.header.payload_len = RANDOM_NUMBER / sizeof(uint32_t);
+    random2.payload.assign(RANDOM_NUMBER / sizeof(uint32_t), 0x01020304);
+    ASSERT_EQ(initiator.handlePacket(random2, pair.peer), ErrorCode::SUCCESS);
 
-    // 定义分桶数量
-    static const size_t NUM_BUCKETS = 16;
-
-    // 定义 UDP 发送器函数类型
-    using UdpSenderFunc = std::function<void(const NegotiationPacket &, const sockaddr_in &)>;
-
-    class Negotiator {
-    public:
-        Negotiator();
-
-        ~Negotiator();
-
-        void setMonitor(Monitor *m);
-
-        // 定义 UDP 发送器函数类型（重新声明）
-        using UdpSenderFunc = std::function<void(const NegotiationPacket &, const sockaddr_in &)>;
-
-        void setUdpSender(const UdpSenderFunc &sender);
-
-        void sendAsync(const NegotiationPacket &packet, const sockaddr_in &peerAddr) const;
-
-        /**
-         * @brief 发起协商流程（发起者角色）
-         * @param policy_id 策略ID，同时作为会话标识
-         * @param peerAddr 对端地址（UDP）
-         * @return ErrorCode
-         */
-        ErrorCode startNegotiation(uint32_t policy_id, const sockaddr_in &peerAddr);
-
-        /**
-         * @brief 处理接收到的数据包（响应或确认）
-         * @param packet 接收到的数据包
-         * @param addr 发送方地址（UDP）
-         * @return ErrorCode
-         */
-        ErrorCode handlePacket(const NegotiationPacket &packet, const sockaddr_in &addr);
-
-        /**
-         * @brief 获取指定会话信息（只读）
-         * @param policy_id 策略ID
-         * @return 若存在返回会话，否则返回 std::nullopt
-         */
-        std::optional<NegotiationSession> getSession(uint32_t policy_id);
-
-        // 将 generateRandomData 从 private 移到 public，以便性能测试中调用
-        static std::vector<uint8_t> generateRandomData(size_t size);
-
-        // 计算共享密钥：SHA256(random1 || random2)
-        static std::vector<uint8_t> computeKey(const std::vector<uint8_t> &random1,
-                                               const std::vector<uint8_t> &random2);
-
-#ifdef UNIT_TEST
-    public:
-#else
-
-    private:
-#endif
-        /**
-         * @brief 构造数据包
-         * @param type 数据包类型
-         * @param policy_id 策略ID
-         * @param payloadData payload 数据（可以为空）
-         * @return 构造好的 NegotiationPacket
-         */
-        static NegotiationPacket createPacket(PacketType type, uint32_t policy_id,
-                                              const std::vector<uint8_t> &payloadData);
-
-    private:
-        // 分桶管理会话，每个桶独立加锁，减少锁竞争
-        std::array<SessionBucket, NUM_BUCKETS> sessionBuckets;
-        Monitor *monitor;
-        UdpSenderFunc udpSender; ///< UDP 发送回调函数
-
-        /**
-         * @brief 根据 policy_id 获取对应的桶索引
-         * @param policy_id 策略ID
-         * @return 桶索引
-         */
-        static size_t bucketIndex(uint32_t policy_id) {
-            return policy_id % NUM_BUCKETS;
+    EXPECT_EQ(initiator.getKeyEpoch(9), 2u);
+    EXPECT_EQ(initiator.getSession(9)->state, NegotiateState::DONE);
+    EXPECT_NE(initiator.getSession(9)->key, firstKey);
+    EXPECT_EQ(initiator.getSessionTableStats().hot, 0u);
+}
+
+// 重复的 CONFIRM 不重复计数，未知会话的 CONFIRM 报错
+TEST(NegotiatorTest, ConfirmHandling) {
+    NegotiatorPair pair;
+    pair.initiator.startNegotiation(5, pair.peer);
+
+    NegotiationPacket confirm{};
+    confirm.header.magic = MAGIC_NUMBER;
+    confirm.header.type = PacketType::CONFIRM;
+    confirm.header.sequence = 5;
+    EXPECT_EQ(pair.responder.handlePacket(confirm, pair.peer), ErrorCode::SUCCESS);
+    confirm.header.sequence = 6;
+    EXPECT_EQ(pair.responder.handlePacket(confirm, pair.peer), ErrorCode::INVALID_PARAM);
+}
+
+// 持有恢复票据的重新协商只需 RESUME / RESUME_ACK 一个往返
+TEST(NegotiatorTest, ResumptionTicketGivesOneRoundTrip) {
+    NegotiatorPair pair;
+    pair.initiator.startNegotiation(11, pair.peer);
+    EXPECT_EQ(pair.sent, (std::vector{PacketType::RANDOM1, PacketType::RANDOM2, PacketType::CONFIRM}));
+    ASSERT_TRUE(pair.initiator.hasResumptionTicket(11));
+    const SessionKey firstKey = pair.initiator.getSession(11)->key;
+
+    pair.sent.clear();
+    ASSERT_EQ(pair.initiator.startNegotiation(11, pair.peer), ErrorCode::SUCCESS);
+    EXPECT_EQ(pair.sent, (std::vector{PacketType::RESUME, PacketType::RESUME_ACK}));
+
+    const auto initiatorSession = pair.initiator.getSession(11);
+    const auto responderSession = pair.responder.getSession(11);
+    ASSERT_TRUE(initiatorSession.has_value());
+    ASSERT_TRUE(responderSession.has_value());
+    EXPECT_EQ(initiatorSession->state, NegotiateState::DONE);
+    EXPECT_EQ(initiatorSession->key, responderSession->key);
+    EXPECT_NE(initiatorSession->key, firstKey);
+    EXPECT_EQ(pair.initiator.getKeyEpoch(11), 2u);
+    EXPECT_EQ(pair.responder.getKeyEpoch(11), 2u);
+    EXPECT_EQ(pair.responder.getSessionTableStats().hot, 0u);
+
+    // RESUME_ACK 携带新票据，可继续恢复
+    pair.sent.clear();
+    pair.initiator.startNegotiation(11, pair.peer);
+    EXPECT_EQ(pair.sent.size(), 2u);
+    EXPECT_EQ(pair.initiator.getKeyEpoch(11), 3u);
+    EXPECT_EQ(pair.initiator.getSession(11)->key, pair.responder.getSession(11)->key);
+}
+
+// 响应方无法解开票据（如进程重启后票据密钥变化）时回退到完整协商
+TEST(NegotiatorTest, InvalidTicketFallsBackToFullNegotiation) {
+    NegotiatorPair pair;
+    pair.initiator.startNegotiation(12, pair.peer);
+    ASSERT_TRUE(pair.initiator.hasResumptionTicket(12));
+
+    Negotiator restarted;
+    pair.responder.setUdpSender(nullptr);
+    std::vector<PacketType> sent;
+    pair.initiator.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &addr) {
+        sent.push_back(packet.header.type);
+        restarted.handlePacket(packet, addr);
+    });
+    restarted.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &addr) {
+        sent.push_back(packet.header.type);
+        pair.initiator.handlePacket(packet, addr);
+    });
+    pair.initiator.startNegotiation(12, pair.peer);
+
+    EXPECT_EQ(sent, (std::vector{PacketType::RESUME, PacketType::RANDOM2, PacketType::CONFIRM}));
+    EXPECT_EQ(pair.initiator.getSession(12)->key, restarted.getSession(12)->key);
+    EXPECT_EQ(pair.initiator.getKeyEpoch(12), 2u);
+}
+
+// 票据只对签发它的密钥有效：重放已使用过的 RESUME 回退到完整协商，不改变当前密钥
+TEST(NegotiatorTest, ReplayedResumeIsRejected) {
+    NegotiatorPair pair;
+    std::vector<NegotiationPacket> resumes;
+    pair.initiator.setUdpSender([&pair, &resumes](const NegotiationPacket &packet, const sockaddr_in &addr) {
+        pair.sent.push_back(packet.header.type);
+        if (packet.header.type == PacketType::RESUME) {
+            resumes.push_back(packet);
         }
-    };
-} // namespace negotio
+        pair.responder.handlePacket(packet, addr);
+    });
+    pair.initiator.startNegotiation(14, pair.peer);
+    ASSERT_EQ(pair.initiator.startNegotiation(14, pair.peer), ErrorCode::SUCCESS);
+    ASSERT_EQ(resumes.size(), 1u);
+    EXPECT_FALSE(pair.responder.getEstablishedKey(14)->confirmed); // 恢复得到的密钥待确认
+
+    // R1 相同的重传收到原样重发的 RESUME_ACK，不重新派生密钥
+    pair.sent.clear();
+    EXPECT_EQ(pair.responder.handlePacket(resumes[0], pair.peer), ErrorCode::SUCCESS);
+    EXPECT_EQ(pair.sent, std::vector{PacketType::RESUME_ACK});
+    EXPECT_EQ(pair.responder.getKeyEpoch(14), 2u);
+
+    ASSERT_EQ(pair.initiator.startNegotiation(14, pair.peer), ErrorCode::SUCCESS);
+    ASSERT_EQ(resumes.size(), 2u);
+    const SessionKey current = pair.responder.getEstablishedKey(14)->key;
+    ASSERT_EQ(pair.initiator.getSession(14)->key, current);
+
+    // 替换 R1 后重用已使用过的票据：按无效票据回退到完整协商
+    NegotiationPacket forged = resumes[1];
+    forged.payload[0] ^= 1;
+    pair.sent.clear();
+    pair.responder.handlePacket(forged, pair.peer);
+    EXPECT_EQ(pair.sent, std::vector{PacketType::RANDOM2});
+    EXPECT_EQ(pair.responder.getKeyEpoch(14), 3u);
+    EXPECT_EQ(pair.responder.getEstablishedKey(14)->key, current);
+
+    // 重放更早的 RESUME 同样不改变密钥
+    pair.responder.handlePacket(resumes[0], pair.peer);
+    EXPECT_EQ(pair.responder.getKeyEpoch(14), 3u);
+    EXPECT_EQ(pair.responder.getEstablishedKey(14)->key, current);
+}
+
+// 关闭会话恢复时不签发票据
+TEST(NegotiatorTest, ResumptionDisabled) {
+    NegotiatorPair pair;
+    pair.initiator.setResumption(false);
+    pair.responder.setResumption(false);
+    pair.initiator.startNegotiation(13, pair.peer);
+    EXPECT_FALSE(pair.initiator.hasResumptionTicket(13));
+    EXPECT_EQ(pair.initiator.getSession(13)->state, NegotiateState::DONE);
+}
+
+// 双方开启两包模式：RANDOM1 / RANDOM2 后双方完成，响应方密钥待隐式确认
+TEST(NegotiatorTest, ImplicitConfirmTwoPackets) {
+    NegotiatorPair pair;
+    pair.initiator.setImplicitConfirm(true);
+    pair.responder.setImplicitConfirm(true);
+    ASSERT_EQ(pair.initiator.startNegotiation(21, pair.peer), ErrorCode::SUCCESS);
+    EXPECT_EQ(pair.sent, (std::vector{PacketType::RANDOM1, PacketType::RANDOM2}));
+
+    const auto responderKey = pair.responder.getEstablishedKey(21);
+    ASSERT_TRUE(responderKey.has_value());
+    EXPECT_FALSE(responderKey->confirmed);
+    EXPECT_TRUE(pair.initiator.getEstablishedKey(21)->confirmed);
+    EXPECT_EQ(pair.initiator.getSession(21)->key, pair.responder.getSession(21)->key);
+    EXPECT_EQ(pair.responder.getSessionTableStats().hot, 0u);
+    EXPECT_TRUE(pair.initiator.hasResumptionTicket(21));
+
+    // 首次经认证地使用密钥即确认
+    EXPECT_TRUE(pair.responder.confirmKey(21));
+    EXPECT_FALSE(pair.responder.confirmKey(21));
+    EXPECT_TRUE(pair.responder.getEstablishedKey(21)->confirmed);
+}
+
+// 待确认期间发起方以新的 R1 重新发起时重新协商；任一方未开启时退回三包
+TEST(NegotiatorTest, ImplicitConfirmRetransmitAndFallback) {
+    NegotiatorPair pair;
+    pair.initiator.setImplicitConfirm(true);
+    pair.responder.setImplicitConfirm(true);
+    pair.initiator.setResumption(false);
+    pair.initiator.startNegotiation(22, pair.peer);
+    pair.initiator.startNegotiation(22, pair.peer); // 新一轮协商
+    EXPECT_EQ(pair.responder.getKeyEpoch(22), 2u);
+    EXPECT_EQ(pair.initiator.getSession(22)->key, pair.responder.getSession(22)->key);
+
+    NegotiatorPair legacy;
+    legacy.initiator.setImplicitConfirm(true);
+    legacy.initiator.startNegotiation(23, legacy.peer);
+    EXPECT_EQ(legacy.sent, (std::vector{PacketType::RANDOM1, PacketType::RANDOM2, PacketType::CONFIRM}));
+    EXPECT_TRUE(legacy.responder.getEstablishedKey(23)->confirmed);
+    EXPECT_EQ(legacy.initiator.getSession(23)->key, legacy.responder.getSession(23)->key);
+}
+
+// 两包模式下重复的 RANDOM1 得到同一个 RANDOM2，响应方不重新派生密钥
+TEST(NegotiatorTest, ImplicitConfirmDuplicateRandom1) {
+    Negotiator initiator;
+    Negotiator responder;
+    initiator.setImplicitConfirm(true);
+    responder.setImplicitConfirm(true);
+    initiator.setResumption(false);
+    sockaddr_in peer{};
+    peer.sin_family = AF_INET;
+    peer.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    std::vector<NegotiationPacket> toResponder;
+    std::vector<NegotiationPacket> toInitiator;
+    initiator.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &) {
+        toResponder.push_back(packet);
+    });
+    responder.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &) {
+        toInitiator.push_back(packet);
+    });
+
+    ASSERT_EQ(initiator.startNegotiation(26, peer), ErrorCode::SUCCESS);
+    ASSERT_EQ(toResponder.size(), 1u);
+    ASSERT_EQ(responder.handlePacket(toResponder[0], peer), ErrorCode::SUCCESS);
+    const SessionKey key = responder.getSession(26)->key;
+    ASSERT_EQ(responder.handlePacket(toResponder[0], peer), ErrorCode::SUCCESS); // 第一个 RANDOM2 丢失
+    ASSERT_EQ(toInitiator.size(), 2u);
+    EXPECT_EQ(toInitiator[1].header.type, PacketType::RANDOM2);
+    EXPECT_EQ(toInitiator[1].payload, toInitiator[0].payload);
+    EXPECT_EQ(responder.getKeyEpoch(26), 1u);
+    EXPECT_EQ(responder.getSession(26)->key, key);
+    EXPECT_FALSE(responder.getEstablishedKey(26)->confirmed);
+
+    ASSERT_EQ(initiator.handlePacket(toInitiator[1], peer), ErrorCode::SUCCESS);
+    EXPECT_EQ(initiator.getSession(26)->key, key);
+    EXPECT_EQ(toResponder.size(), 1u); // 两包模式不发送 CONFIRM
+}
+
+// 批量派生：一次协商后双方在本地轮换出相同的密钥序列，不发送任何数据包
+TEST(NegotiatorTest, KeyBatchRotatesLocally) {
+    NegotiatorPair pair;
+    pair.initiator.setKeyBatchSize(4);
+    pair.responder.setKeyBatchSize(8);
+    ASSERT_EQ(pair.initiator.startNegotiation(24, pair.peer), ErrorCode::SUCCESS);
+    const size_t packets = pair.sent.size();
+
+    // 批次大小取双方较小值
+    EXPECT_EQ(pair.initiator.remainingBatchKeys(24), 3u);
+    EXPECT_EQ(pair.responder.remainingBatchKeys(24), 3u);
+
+    std::vector<SessionKey> seen{pair.initiator.getSession(24)->key};
+    for (uint32_t i = 0; i < 3; ++i) {
+        ASSERT_EQ(pair.initiator.rotateKey(24), ErrorCode::SUCCESS);
+        ASSERT_EQ(pair.responder.rotateKey(24), ErrorCode::SUCCESS);
+        const auto key = pair.initiator.getSession(24)->key;
+        EXPECT_EQ(key, pair.responder.getSession(24)->key);
+        EXPECT_EQ(std::count(seen.begin(), seen.end(), key), 0);
+        seen.push_back(key);
+    }
+    EXPECT_EQ(pair.sent.size(), packets);
+    EXPECT_EQ(pair.initiator.getKeyEpoch(24), 4u);
+    EXPECT_EQ(pair.responder.getKeyEpoch(24), 4u);
+
+    // 批次用完后需要重新协商，rekey 自动回退到网络协商并开始新批次
+    EXPECT_EQ(pair.initiator.rotateKey(24), ErrorCode::NEGOTIATION_FAILED);
+    EXPECT_EQ(pair.initiator.remainingBatchKeys(24), 0u);
+    ASSERT_EQ(pair.initiator.rekey(24, pair.peer), ErrorCode::SUCCESS);
+    EXPECT_GT(pair.sent.size(), packets);
+    EXPECT_EQ(pair.initiator.getSession(24)->key, pair.responder.getSession(24)->key);
+}
+
+// 任一方未开启批量派生时不建立批次；两包模式下同样生效
+TEST(NegotiatorTest, KeyBatchNegotiation) {
+    NegotiatorPair legacy;
+    legacy.initiator.setKeyBatchSize(4);
+    legacy.initiator.startNegotiation(25, legacy.peer);
+    EXPECT_EQ(legacy.initiator.remainingBatchKeys(25), 0u);
+    EXPECT_EQ(legacy.responder.remainingBatchKeys(25), 0u);
+    EXPECT_EQ(legacy.initiator.rotateKey(25), ErrorCode::NEGOTIATION_FAILED);
+
+    NegotiatorPair pair;
+    pair.initiator.setImplicitConfirm(true);
+    pair.responder.setImplicitConfirm(true);
+    pair.initiator.setKeyBatchSize(2);
+    pair.responder.setKeyBatchSize(2);
+    pair.initiator.startNegotiation(26, pair.peer);
+    EXPECT_EQ(pair.sent, (std::vector{PacketType::RANDOM1, PacketType::RANDOM2}));
+    ASSERT_EQ(pair.initiator.rotateKey(26), ErrorCode::SUCCESS);
+    ASSERT_EQ(pair.responder.rotateKey(26), ErrorCode::SUCCESS);
+    EXPECT_EQ(pair.initiator.getSession(26)->key, pair.responder.getSession(26)->key);
+}
+
+// 双方同时发起同一策略的协商：R1 较小的一方转为响应方，无需等待超时
+TEST(NegotiatorTest, SimultaneousOpenResolvesWithoutTimeout) {
+    for (const bool implicit : {false, true}) {
+        Negotiator a;
+        Negotiator b;
+        std::vector<NegotiationPacket> toA;
+        std::vector<NegotiationPacket> toB;
+        a.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &) { toB.push_back(packet); });
+        b.setUdpSender([&](const NegotiationPacket &packet, const sockaddr_in &) { toA.push_back(packet); });
+        a.setImplicitConfirm(implicit);
+        b.setImplicitConfirm(implicit);
+        sockaddr_in peer{};
+        peer.sin_family = AF_INET;
+
+        // 两个 RANDOM1 在途中交错
+        ASSERT_EQ(a.startNegotiation(27, peer), ErrorCode::SUCCESS);
+        ASSERT_EQ(b.startNegotiation(27, peer), ErrorCode::SUCCESS);
+        while (!toA.empty() || !toB.empty()) {
+            const auto forA = std::exchange(toA, {});
+            const auto forB = std::exchange(toB, {});
+            for (const auto &packet : forA) {
+                a.handlePacket(packet, peer);
+            }
+            for (const auto &packet : forB) {
+                b.handlePacket(packet, peer);
+            }
+        }
+
+        const auto keyA = a.getEstablishedKey(27);
+        const auto keyB = b.getEstablishedKey(27);
+        ASSERT_TRUE(keyA.has_value()) << "implicit = " << implicit;
+        ASSERT_TRUE(keyB.has_value()) << "implicit = " << implicit;
+        EXPECT_EQ(keyA->key, keyB->key);
+        EXPECT_EQ(a.getSessionTableStats().hot, 0u);
+        EXPECT_EQ(b.getSessionTableStats().hot, 0u);
+    }
+}
 
-#endif // NEGOTIO_NEGOTIATE_H
+TEST(NegotiatorTest, RejectsInvalidPolicyId) {
+    Negotiator negotiator;
+    sockaddr_in peer{};
+    EXPECT_EQ(negotiator.startNegotiation(0, peer), ErrorCode::INVALID_PARAM);
+    EXPECT_FALSE(negotiator.getSession(0).has_value());
+}
@@ -0,0 +1,131 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/peerclock_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/peerclock/peerclock.h"
+#include "../../src/negotiate/negotiate.h"
+
+using namespace negotio;
+
+namespace {
+    sockaddr_in peerAt(const uint32_t ip, const uint16_t port) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(ip);
+        addr.sin_port = htons(port);
+        return addr;
+    }
+}
+
+// 时钟原点任意（含回绕）：基线为最小差值，时延为相对基线的增量
+TEST(PeerClockTest, EstimatesDelayAboveBaseline) {
+    PeerClockTracker tracker;
+    const sockaddr_in peer = peerAt(0x0A000001, 5000);
+    const uint32_t remote = 0xFFFFFF00u; // 对端时钟即将回绕
+    const uint32_t local = 1000;
+
+    EXPECT_EQ(tracker.observe(peer, remote, local + 5), 0u); // 没有基线时不估计
+    tracker.learn(peer, remote, local + 5);                    // 首个可信包建立基线（传播时延 5 ms）
+    EXPECT_EQ(tracker.observe(peer, remote + 100, local + 105), 0u);
+    EXPECT_EQ(tracker.observe(peer, remote + 200, local + 285), 80u); // 排队 80 ms
+    tracker.learn(peer, remote + 300, local + 303);                     // 更快的路径降低基线
+    EXPECT_EQ(tracker.observe(peer, remote + 400, local + 405), 2u);
+
+    // 不同对端互不影响
+    tracker.learn(peerAt(0x0A000002, 5000), 7, 9);
+    EXPECT_EQ(tracker.observe(peerAt(0x0A000002, 5000), 107, 109), 0u);
+    EXPECT_EQ(tracker.size(), 2u);
+}
+
+// 只估计不学习：时间戳超前的伪造包不会压低基线
+TEST(PeerClockTest, ObserveDoesNotMoveBaseline) {
+    PeerClockTracker tracker;
+    const sockaddr_in peer = peerAt(0x0A000001, 5000);
+    tracker.learn(peer, 1000, 2000);
+    EXPECT_EQ(tracker.observe(peer, 6000, 2100), 0u); // 伪造：时间戳超前 5 秒
+    EXPECT_EQ(tracker.observe(peer, 1100, 2100), 0u); // 正常包仍按原基线估计
+    EXPECT_EQ(tracker.observe(peer, 1100, 2160), 60u);
+    EXPECT_EQ(tracker.size(), 1u);
+}
+
+// 对端时钟跳变（重启）时重置基线，而不是把之后所有的包都当作过期包
+TEST(PeerClockTest, ResetsOnClockJump) {
+    PeerClockTracker tracker;
+    const sockaddr_in peer = peerAt(0x0A000001, 5000);
+    tracker.learn(peer, 50000, 1000);
+    EXPECT_EQ(tracker.observe(peer, 10, 2000), 0u); // 时延大到不可能是排队，不判为过期
+    tracker.learn(peer, 10, 2000);
+    EXPECT_EQ(tracker.observe(peer, 110, 2150), 50u);
+}
+
+// 排队时延超过阈值的包在处理前被丢弃
+TEST(PeerClockTest, NegotiatorDropsStalePackets) {
+    Negotiator responder;
+    responder.setStaleThreshold(100);
+    const sockaddr_in peer = peerAt(0x7F000001, 6000);
+    NegotiationPacket packet{};
+    packet.header.magic = MAGIC_NUMBER;
+    packet.header.type = PacketType::RANDOM1;
+    packet.payload.assign(RANDOM_NUMBER / sizeof(uint32_t), 0x01010101);
+
+    // 以当前时间戳建立基线：RANDOM1 不参与基线，与等待中的会话相符的 CONFIRM 才参与
+    const uint32_t now = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    packet.header.sequence = 31;
+    packet.header.timestamp = now;
+    ASSERT_EQ(responder.handlePacket(packet, peer), ErrorCode::SUCCESS);
+    NegotiationPacket confirm = packet;
+    confirm.header.type = PacketType::CONFIRM;
+    confirm.payload.clear();
+    ASSERT_EQ(responder.handlePacket(confirm, peer), ErrorCode::SUCCESS);
+
+    // 发送于 500 ms 之前的包
+    packet.header.sequence = 32;
+    packet.header.timestamp = now - 500;
+    EXPECT_EQ(responder.handlePacket(packet, peer), ErrorCode::TIMEOUT);
+    EXPECT_FALSE(responder.getSession(32).has_value());
+
+    // 未开启过滤时照常处理
+    responder.setStaleThreshold(0);
+    EXPECT_EQ(responder.handlePacket(packet, peer), ErrorCode::SUCCESS);
+    EXPECT_TRUE(responder.getSession(32).has_value());
+}
+
+// 伪造源地址、时间戳超前的包不能让该对端之后的正常包被当作过期包丢弃
+TEST(PeerClockTest, SpoofedTimestampCannotPoisonBaseline) {
+    Negotiator responder;
+    responder.setStaleThreshold(100);
+    const sockaddr_in peer = peerAt(0x7F000001, 6001);
+    NegotiationPacket packet{};
+    packet.header.magic = MAGIC_NUMBER;
+    packet.header.type = PacketType::RANDOM1;
+    packet.payload.assign(RANDOM_NUMBER / sizeof(uint32_t), 0x02020202);
+    const uint32_t now = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+
+    packet.header.sequence = 41;
+    packet.header.timestamp = now;
+    ASSERT_EQ(responder.handlePacket(packet, peer), ErrorCode::SUCCESS);
+    NegotiationPacket confirm = packet;
+    confirm.header.type = PacketType::CONFIRM;
+    confirm.payload.clear();
+    ASSERT_EQ(responder.handlePacket(confirm, peer), ErrorCode::SUCCESS);
+
+    // 伪造包：时间戳超前 5 秒，且不对应任何进行中的协商
+    packet.header.sequence = 42;
+    packet.header.timestamp = now + 5000;
+    responder.handlePacket(packet, peer);
+    confirm.header.sequence = 43;
+    confirm.header.timestamp = now + 5000;
+    EXPECT_EQ(responder.handlePacket(confirm, peer), ErrorCode::INVALID_PARAM);
+
+    packet.header.sequence = 44;
+    packet.header.timestamp = now;
+    EXPECT_EQ(responder.handlePacket(packet, peer), ErrorCode::SUCCESS);
+    EXPECT_TRUE(responder.getSession(44).has_value());
+}
@@ -0,0 +1,151 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/prefork_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/prefork/prefork.h"
+#include "../../src/sharedtable/sharedtable.h"
+#include <chrono>
+#include <csignal>
+#include <fcntl.h>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using namespace negotio;
+
+namespace {
+    std::string tablePath(const std::string &name) {
+        return (fs::temp_directory_path() / ("negotio_" + name + "_" + std::to_string(getpid()))).string();
+    }
+
+    bool waitUntil(const std::function<bool()> &condition, const int timeoutMs = 3000) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (condition()) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return condition();
+    }
+
+    // 工作进程：启动时将 1000 + 序号 的纪元加 1 记录启动次数，之后把收到的命令（策略ID）记为“序号 + 1”纪元的会话
+    int recordingWorker(SharedSessionTable &table, const uint32_t index, const int controlFd) {
+        ColdSession marker{};
+        const uint32_t starts = table.loadSession(1000 + index, marker) ? marker.epoch + 1 : 1;
+        table.storeSession(1000 + index, starts, SessionKey{}, true);
+        std::string command;
+        while (true) {
+            const ErrorCode received = PreforkSupervisor::receiveCommand(controlFd, command, 100);
+            if (received == ErrorCode::SOCKET_ERROR) {
+                return 0;
+            }
+            if (received == ErrorCode::SUCCESS) {
+                table.storeSession(static_cast<uint32_t>(std::stoul(command)), index + 1,
+                                   SessionKey{}, true);
+            }
+        }
+    }
+}
+
+TEST(PreforkTest, ForwardsCommandsToOwningWorker) {
+    SharedSessionTable table;
+    ASSERT_TRUE(table.create(tablePath("prefork_forward")));
+    PreforkSupervisor supervisor([&table](const uint32_t index, const int controlFd) {
+        return recordingWorker(table, index, controlFd);
+    }, PreforkOptions{2, 2000});
+    ASSERT_TRUE(supervisor.start());
+    EXPECT_GT(supervisor.workerPid(0), 0);
+    EXPECT_GT(supervisor.workerPid(1), 0);
+
+    for (uint32_t policyId = 10; policyId < 14; ++policyId) {
+        ASSERT_TRUE(supervisor.forward(policyId, std::to_string(policyId)));
+    }
+    ASSERT_TRUE(waitUntil([&table] { return table.sessionCount() == 6; }));
+    for (uint32_t policyId = 10; policyId < 14; ++policyId) {
+        ColdSession session{};
+        ASSERT_TRUE(table.loadSession(policyId, session));
+        EXPECT_EQ(session.epoch, supervisor.ownerOf(policyId) + 1) << "policy " << policyId;
+    }
+
+    supervisor.stop();
+    EXPECT_EQ(supervisor.workerPid(0), -1);
+    EXPECT_EQ(supervisor.getRestarts(), 0u);
+}
+
+TEST(PreforkTest, RestartsCrashedWorkerWithSharedState) {
+    SharedSessionTable table;
+    ASSERT_TRUE(table.create(tablePath("prefork_restart")));
+    PreforkSupervisor supervisor([&table](const uint32_t index, const int controlFd) {
+        return recordingWorker(table, index, controlFd);
+    }, PreforkOptions{2, 2000});
+    ASSERT_TRUE(supervisor.start());
+    ASSERT_TRUE(waitUntil([&table] { return table.sessionCount() == 2; }));
+    ASSERT_TRUE(supervisor.forward(4, "4"));
+    ASSERT_TRUE(waitUntil([&table] { return table.sessionCount() == 3; }));
+
+    const pid_t crashed = supervisor.workerPid(0);
+    ASSERT_EQ(kill(crashed, SIGKILL), 0);
+    ASSERT_TRUE(waitUntil([&supervisor] {
+        supervisor.superviseOnce();
+        return supervisor.getRestarts() == 1;
+    }));
+    EXPECT_NE(supervisor.workerPid(0), crashed);
+    EXPECT_GT(supervisor.workerPid(0), 0);
+
+    // 重启的工作进程看到崩溃前写入的状态，控制套接字也继续可用
+    ColdSession marker{};
+    ASSERT_TRUE(waitUntil([&table, &marker] { return table.loadSession(1000, marker) && marker.epoch == 2; }));
+    ColdSession session{};
+    EXPECT_TRUE(table.loadSession(4, session));
+    ASSERT_TRUE(supervisor.forward(6, "6"));
+    ASSERT_TRUE(waitUntil([&table, &session] { return table.loadSession(6, session); }));
+    EXPECT_EQ(session.epoch, 1u);
+
+    // 正常停止后的退出不会被当作崩溃重启
+    supervisor.stop();
+    EXPECT_EQ(supervisor.superviseOnce(), 0u);
+    EXPECT_EQ(supervisor.getRestarts(), 1u);
+}
+
+// 重启由 start 时 fork 的孵化进程完成：监督进程之后打开的描述符（如控制监听套接字）不会被工作进程继承
+TEST(PreforkTest, RestartedWorkerDoesNotInheritLaterDescriptors) {
+    constexpr int LATE_FD = 900;
+    SharedSessionTable table;
+    ASSERT_TRUE(table.create(tablePath("prefork_inherit")));
+    PreforkSupervisor supervisor([&table](const uint32_t index, const int controlFd) {
+        const bool inherited = fcntl(LATE_FD, F_GETFD) != -1;
+        table.storeSession(2000 + index, inherited ? 2 : 1, SessionKey{}, true);
+        return recordingWorker(table, index, controlFd);
+    }, PreforkOptions{1, 2000});
+    ASSERT_TRUE(supervisor.start());
+    ASSERT_TRUE(waitUntil([&table] { return table.sessionCount() == 2; }));
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(dup2(fds[0], LATE_FD), LATE_FD);
+    const pid_t crashed = supervisor.workerPid(0);
+    ASSERT_EQ(kill(crashed, SIGKILL), 0);
+    ASSERT_TRUE(waitUntil([&supervisor] {
+        supervisor.superviseOnce();
+        return supervisor.getRestarts() == 1;
+    }));
+    ColdSession marker{};
+    ASSERT_TRUE(waitUntil([&table, &marker] { return table.loadSession(1000, marker) && marker.epoch == 2; }));
+    ColdSession inherited{};
+    ASSERT_TRUE(table.loadSession(2000, inherited));
+    EXPECT_EQ(inherited.epoch, 1u);
+
+    supervisor.stop();
+    EXPECT_FALSE(supervisor.isAlive());
+    close(LATE_FD);
+    close(fds[0]);
+    close(fds[1]);
+}
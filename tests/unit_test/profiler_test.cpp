@@ -0,0 +1,74 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/profiler_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/profiler/profiler.h"
+#include "../../src/control/control.h"
+#include <chrono>
+#include <ctime>
+#include <string>
+
+using namespace negotio;
+
+// 消耗约 durationMs 的线程 CPU 时间，供采样命中
+[[gnu::noinline]] uint64_t burnCpuForProfiler(const int durationMs) {
+    timespec begin{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &begin);
+    volatile uint64_t acc = 0;
+    for (;;) {
+        for (int i = 0; i < 100000; ++i) {
+            acc = acc * 6364136223846793005ull + 1442695040888963407ull;
+        }
+        timespec now{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        if ((now.tv_sec - begin.tv_sec) * 1000 + (now.tv_nsec - begin.tv_nsec) / 1000000 >= durationMs) {
+            return acc;
+        }
+    }
+}
+
+TEST(ProfilerTest, SamplesHotFunctionIntoPprof) {
+    Profiler &profiler = Profiler::instance();
+    ASSERT_TRUE(profiler.start(MAX_PROFILE_HZ));
+    EXPECT_FALSE(profiler.start());
+    burnCpuForProfiler(300);
+
+    std::vector<uint8_t> pprof;
+    ASSERT_TRUE(profiler.stop(pprof));
+    EXPECT_FALSE(profiler.isRunning());
+    EXPECT_GT(profiler.getSamples(), 10u);
+    EXPECT_EQ(profiler.getDropped(), 0u);
+
+    // 函数名与样本类型写入字符串表
+    const std::string bytes(pprof.begin(), pprof.end());
+    EXPECT_NE(bytes.find("burnCpuForProfiler"), std::string::npos);
+    EXPECT_NE(bytes.find("nanoseconds"), std::string::npos);
+    EXPECT_FALSE(profiler.stop(pprof));
+}
+
+TEST(ProfilerTest, DropsSamplesWhenSlotsRunOut) {
+    Profiler &profiler = Profiler::instance();
+    ASSERT_TRUE(profiler.start(MAX_PROFILE_HZ, 4));
+    burnCpuForProfiler(100);
+    std::vector<uint8_t> pprof;
+    ASSERT_TRUE(profiler.stop(pprof));
+    EXPECT_EQ(profiler.getSamples(), 4u);
+    EXPECT_GT(profiler.getDropped(), 0u);
+}
+
+TEST(ProfilerTest, DecodesProfileCommands) {
+    ControlCommand command{};
+    ASSERT_TRUE(decodeControlCommand(R"({"action": "profile_start", "frequency_hz": 250})", command));
+    EXPECT_EQ(command.action, ControlAction::PROFILE_START);
+    EXPECT_EQ(command.profileHz, 250u);
+    EXPECT_EQ(command.policy.policy_id, 0u);
+
+    ASSERT_TRUE(decodeControlCommand(R"({"action": "profile_stop", "path": "/tmp/x.pprof"})", command));
+    EXPECT_EQ(command.action, ControlAction::PROFILE_STOP);
+    EXPECT_EQ(command.profilePath, "/tmp/x.pprof");
+}
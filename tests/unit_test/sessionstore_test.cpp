@@ -0,0 +1,154 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/sessionstore_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/sessionstore/sessionstore.h"
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+using namespace negotio;
+
+namespace {
+    SessionKey keyFor(uint32_t id) {
+        SessionKey key{};
+        for (size_t i = 0; i < key.size(); ++i) {
+            key[i] = static_cast<uint8_t>(id + i);
+        }
+        return key;
+    }
+}
+
+TEST(ColdSessionStoreTest, UpsertReadErase) {
+    ColdSessionStore store;
+    ColdSession entry{};
+    EXPECT_FALSE(store.read(1, entry));
+    EXPECT_EQ(store.upsert(1, keyFor(1)), 1u);
+    EXPECT_EQ(store.upsert(1, keyFor(2)), 2u);
+    ASSERT_TRUE(store.read(1, entry));
+    EXPECT_EQ(entry.policy_id, 1u);
+    EXPECT_EQ(entry.epoch, 2u);
+    EXPECT_EQ(entry.key[0], keyFor(2)[0]);
+    EXPECT_TRUE(store.contains(1));
+    EXPECT_EQ(store.size(), 1u);
+    EXPECT_TRUE(store.erase(1));
+    EXPECT_FALSE(store.erase(1));
+    EXPECT_FALSE(store.read(1, entry));
+    EXPECT_FALSE(store.contains(1));
+    EXPECT_EQ(store.size(), 0u);
+}
+
+// 票据序号随密钥写入，确认时保留，写入新密钥时被替换
+TEST(ColdSessionStoreTest, TicketStampFollowsKey) {
+    ColdSessionStore store;
+    ColdSession entry{};
+    store.upsert(1, keyFor(1), false, 0x7FFFFFFFu);
+    EXPECT_EQ(store.ticketStamp(1), 0x7FFFFFFFu);
+    EXPECT_TRUE(store.markConfirmed(1));
+    ASSERT_TRUE(store.read(1, entry));
+    EXPECT_TRUE(entry.confirmed);
+    EXPECT_EQ(entry.ticketStamp, 0x7FFFFFFFu);
+
+    store.upsert(1, keyFor(2));
+    EXPECT_EQ(store.ticketStamp(1), 0u);
+    EXPECT_EQ(store.ticketStamp(2), 0u);
+}
+
+// 随机插入/删除与 std::unordered_map 对照
+TEST(ColdSessionStoreTest, MatchesReferenceMap) {
+    ColdSessionStore store;
+    std::unordered_map<uint32_t, uint32_t> reference; // policy_id -> epoch
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<uint32_t> ids(1, 5000);
+    for (int op = 0; op < 50000; ++op) {
+        const uint32_t id = ids(rng);
+        if (rng() % 3 == 0) {
+            EXPECT_EQ(store.erase(id), reference.erase(id) > 0);
+        } else {
+            EXPECT_EQ(store.upsert(id, keyFor(id)), ++reference[id]);
+        }
+    }
+    ASSERT_EQ(store.size(), reference.size());
+    for (uint32_t id = 1; id <= 5000; ++id) {
+        ColdSession entry{};
+        const bool found = store.read(id, entry);
+        const auto it = reference.find(id);
+        if (it == reference.end()) {
+            EXPECT_FALSE(found);
+        } else {
+            ASSERT_TRUE(found);
+            EXPECT_EQ(entry.epoch, it->second);
+            EXPECT_EQ(entry.key[KEY_SIZE - 1], static_cast<uint8_t>(id + KEY_SIZE - 1));
+        }
+    }
+}
+
+// 预留后插入不再扩容
+TEST(ColdSessionStoreTest, ReserveAvoidsGrowth) {
+    ColdSessionStore store;
+    store.reserve(1000);
+    const size_t reserved = store.memoryBytes();
+    for (uint32_t id = 1; id <= 1000; ++id) {
+        store.upsert(id, keyFor(id));
+    }
+    EXPECT_EQ(store.memoryBytes(), reserved);
+    // 48 字节记录 + 负载因子 1/2 的 4 字节索引槽，另有块粒度的余量
+    EXPECT_LE(reserved / 1000, 64u);
+}
+
+// 读方与持续改写密钥、插入新条目（触发索引表与块目录扩容）的写方并发，读到的快照必须一致
+TEST(ColdSessionStoreTest, ConcurrentReadsNeverTorn) {
+    ColdSessionStore store;
+    constexpr uint32_t kHotIds = 64;
+    for (uint32_t id = 1; id <= kHotIds; ++id) {
+        store.upsert(id, keyFor(id));
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> torn{0};
+    std::atomic<uint64_t> reads{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; ++t) {
+        readers.emplace_back([&, t]() {
+            ColdSession entry{};
+            for (uint32_t i = t; !stop.load(std::memory_order_relaxed); ++i) {
+                const uint32_t id = i % kHotIds + 1;
+                if (!store.read(id, entry)) {
+                    ++torn; // 已存在的条目在改写期间不应消失
+                    continue;
+                }
+                // 第 n 次写入的密钥为 keyFor(id + n - 1)，密钥与纪元必须来自同一次写入
+                const SessionKey expected = keyFor(id + entry.epoch - 1);
+                if (entry.policy_id != id || !std::equal(expected.begin(), expected.end(), entry.key.begin())) {
+                    ++torn;
+                }
+                ++reads;
+            }
+        });
+    }
+
+    uint32_t nextId = 1000;
+    for (uint32_t round = 1; round <= 200; ++round) {
+        for (uint32_t id = 1; id <= kHotIds; ++id) {
+            store.upsert(id, keyFor(id + round));
+        }
+        for (int i = 0; i < 50; ++i, ++nextId) {
+            store.upsert(nextId, keyFor(nextId));
+        }
+        std::this_thread::yield();
+    }
+    stop = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(torn.load(), 0u);
+    EXPECT_GT(reads.load(), 0u);
+    EXPECT_EQ(store.size(), kHotIds + 200u * 50u);
+}
@@ -0,0 +1,164 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/sharedtable_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/sharedtable/sharedtable.h"
+#include <filesystem>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using namespace negotio;
+
+namespace {
+    std::string tablePath(const std::string &name) {
+        return (fs::temp_directory_path() / ("negotio_" + name + "_" + std::to_string(getpid()))).string();
+    }
+
+    SessionKey keyOf(const uint8_t seed) {
+        SessionKey key{};
+        for (size_t i = 0; i < key.size(); ++i) {
+            key[i] = static_cast<uint8_t>(seed + i);
+        }
+        return key;
+    }
+}
+
+TEST(SharedTableTest, StoresSessionsAndPolicies) {
+    SharedSessionTable table;
+    const std::string path = tablePath("shared_basic");
+    ASSERT_TRUE(table.create(path, 64, 64));
+    EXPECT_TRUE(fs::exists(path));
+
+    ASSERT_TRUE(table.storeSession(7, 3, keyOf(1), false));
+    ColdSession session{};
+    ASSERT_TRUE(table.loadSession(7, session));
+    EXPECT_EQ(session.epoch, 3u);
+    EXPECT_FALSE(session.confirmed);
+    EXPECT_EQ(session.key, keyOf(1));
+
+    EXPECT_TRUE(table.markConfirmed(7));
+    ASSERT_TRUE(table.storeSession(7, 4, keyOf(2), true));
+    ASSERT_TRUE(table.loadSession(7, session));
+    EXPECT_EQ(session.epoch, 4u);
+    EXPECT_TRUE(session.confirmed);
+    EXPECT_EQ(table.sessionCount(), 1u);
+
+    EXPECT_TRUE(table.eraseSession(7));
+    EXPECT_FALSE(table.loadSession(7, session));
+    EXPECT_FALSE(table.markConfirmed(7));
+    EXPECT_EQ(table.sessionCount(), 0u);
+
+    ASSERT_TRUE(table.storePolicy(PolicyConfig{42, "192.168.1.10", 5000, 100, 3}));
+    PolicyConfig policy{};
+    ASSERT_TRUE(table.loadPolicy(42, policy));
+    EXPECT_EQ(policy.remote_ip, "192.168.1.10");
+    EXPECT_EQ(policy.remote_port, 5000);
+    EXPECT_EQ(policy.timeout_ms, 100u);
+    EXPECT_EQ(policy.retry_times, 3u);
+    EXPECT_FALSE(table.storePolicy(PolicyConfig{43, std::string(SHARED_TABLE_IP_LEN, '1'), 5000, 100, 3}));
+    EXPECT_EQ(table.policyCount(), 1u);
+
+    table.close();
+    EXPECT_FALSE(fs::exists(path));
+}
+
+TEST(SharedTableTest, RejectsNewEntriesWhenFull) {
+    SharedSessionTable table;
+    ASSERT_TRUE(table.create(tablePath("shared_full"), 64, 16));
+
+    uint32_t stored = 0;
+    while (stored < 10000 && table.storeSession(stored, 1, keyOf(0), true)) {
+        ++stored;
+    }
+    EXPECT_GE(stored, 64u);
+    EXPECT_LT(stored, 10000u);
+    EXPECT_EQ(table.sessionCount(), stored);
+    // 已存在的条目仍可覆盖
+    EXPECT_TRUE(table.storeSession(0, 2, keyOf(0), true));
+    EXPECT_EQ(table.snapshotSessions().size(), stored);
+}
+
+// 同一路径已被另一个实例使用时拒绝创建，不会截断其正在使用的表
+TEST(SharedTableTest, RefusesTableInUse) {
+    const std::string path = tablePath("shared_in_use");
+    SharedSessionTable first;
+    ASSERT_TRUE(first.create(path, 64, 16));
+    ASSERT_TRUE(first.storeSession(3, 7, keyOf(3), true));
+
+    SharedSessionTable second;
+    EXPECT_FALSE(second.create(path, 64, 16));
+    ColdSession session{};
+    ASSERT_TRUE(first.loadSession(3, session));
+    EXPECT_EQ(session.epoch, 7u);
+    EXPECT_TRUE(fs::exists(path));
+
+    first.close();
+    ASSERT_TRUE(second.create(path, 64, 16));
+    EXPECT_EQ(second.sessionCount(), 0u);
+}
+
+TEST(SharedTableTest, VisibleAcrossFork) {
+    SharedSessionTable table;
+    ASSERT_TRUE(table.create(tablePath("shared_fork")));
+
+    const pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+        const bool ok = table.storeSession(9, 5, keyOf(9), true)
+                        && table.storePolicy(PolicyConfig{9, "10.0.0.9", 6000, 50, 1});
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    ColdSession session{};
+    ASSERT_TRUE(table.loadSession(9, session));
+    EXPECT_EQ(session.epoch, 5u);
+    const auto policies = table.snapshotPolicies();
+    ASSERT_EQ(policies.size(), 1u);
+    EXPECT_EQ(policies[0].remote_ip, "10.0.0.9");
+    // 子进程不是创建方，其析构不会删除段文件
+    EXPECT_TRUE(table.isOpen());
+}
+
+TEST(SharedTableTest, RecoversLockHeldByCrashedProcess) {
+    SharedSessionTable table;
+    ASSERT_TRUE(table.create(tablePath("shared_crash"), 64, 16));
+    ASSERT_TRUE(table.storeSession(1, 1, keyOf(1), true));
+    ASSERT_TRUE(table.storeSession(2, 1, keyOf(2), true));
+
+    // 子进程在持有条带锁、改写会话 2 的中途退出
+    const pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+        const size_t index = SharedSessionTable::stripeOf(2);
+        pthread_mutex_lock(&table.stripe(index).mtx);
+        bool found = false;
+        const size_t slot = SharedSessionTable::probe(table.sessionsOf(index), table.sessionSlots - 1, 2, found);
+        if (!found) {
+            _exit(1);
+        }
+        table.sessionsOf(index)[slot].state.store(SharedSessionTable::SLOT_WRITING);
+        table.sessionsOf(index)[slot].key[0] ^= 0xFF;
+        _exit(0);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    // 下一个加锁方修复条带：写了一半的会话 2 被丢弃，条带锁继续可用
+    ColdSession session{};
+    EXPECT_FALSE(table.loadSession(2, session));
+    EXPECT_EQ(table.getRecoveredLocks(), 1u);
+    EXPECT_TRUE(table.storeSession(2, 2, keyOf(2), true));
+    EXPECT_TRUE(table.loadSession(1, session));
+    EXPECT_EQ(table.sessionCount(), 2u);
+}
@@ -0,0 +1,145 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/statsfile_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/statsfile/statsfile.h"
+#include "../../src/monitor/monitor.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using namespace negotio;
+using namespace std::chrono_literals;
+
+namespace {
+    std::string tempStatsPath(const char *name) {
+        return (fs::temp_directory_path() / (std::string(name) + "_" + std::to_string(getpid()) + ".stats")).string();
+    }
+}
+
+// 写入后读取得到相同快照
+TEST(StatsFileTest, PublishAndRead) {
+    const std::string path = tempStatsPath("statsfile_roundtrip");
+    StatsFileWriter writer;
+    ASSERT_TRUE(writer.open(path));
+
+    StatsPayload published{};
+    published.totalNegotiations = 42;
+    published.successfulNegotiations = 40;
+    published.totalLatencyMs = 80;
+    published.latencyHistogram[latencyBucketOf(2)] = 40;
+    writer.publish(published);
+
+    StatsFileReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_EQ(reader.writerPid(), getpid());
+    StatsPayload read{};
+    ASSERT_TRUE(reader.read(read));
+    EXPECT_EQ(read.totalNegotiations, 42u);
+    EXPECT_EQ(read.successfulNegotiations, 40u);
+    EXPECT_EQ(read.totalLatencyMs, 80u);
+    EXPECT_EQ(read.latencyHistogram[2], 40u);
+
+    // 关闭写入方后文件被删除
+    writer.close();
+    EXPECT_FALSE(fs::exists(path));
+}
+
+// 拒绝非统计文件
+TEST(StatsFileTest, RejectsInvalidFile) {
+    const std::string path = tempStatsPath("statsfile_invalid");
+    {
+        std::ofstream out(path, std::ios::binary);
+        const std::string junk(sizeof(StatsFileHeader) + sizeof(StatsPayload), 'x');
+        out << junk;
+    }
+    StatsFileReader reader;
+    EXPECT_FALSE(reader.open(path));
+    StatsPayload read{};
+    EXPECT_FALSE(reader.read(read));
+    fs::remove(path);
+}
+
+// 并发写入时读取方只会看到完整快照
+TEST(StatsFileTest, ReaderSeesConsistentSnapshots) {
+    const std::string path = tempStatsPath("statsfile_seqlock");
+    StatsFileWriter writer;
+    ASSERT_TRUE(writer.open(path));
+    StatsFileReader reader;
+    ASSERT_TRUE(reader.open(path));
+
+    std::atomic<bool> stop{false};
+    std::thread writerThread([&]() {
+        StatsPayload payload{};
+        for (uint64_t v = 1; !stop.load(); ++v) {
+            payload.totalNegotiations = v;
+            payload.successfulNegotiations = v;
+            payload.totalLatencyMs = v;
+            for (auto &bucket : payload.latencyHistogram) {
+                bucket = v;
+            }
+            writer.publish(payload);
+        }
+    });
+
+    uint64_t lastSeen = 0;
+    for (int i = 0; i < 20000; ++i) {
+        StatsPayload read{};
+        if (!reader.read(read)) {
+            continue;
+        }
+        ASSERT_EQ(read.successfulNegotiations, read.totalNegotiations);
+        ASSERT_EQ(read.totalLatencyMs, read.totalNegotiations);
+        ASSERT_EQ(read.latencyHistogram[STATS_LATENCY_BUCKETS - 1], read.totalNegotiations);
+        ASSERT_GE(read.totalNegotiations, lastSeen);
+        lastSeen = read.totalNegotiations;
+    }
+    stop = true;
+    writerThread.join();
+}
+
+// 耗时直方图桶边界
+TEST(StatsFileTest, LatencyBuckets) {
+    EXPECT_EQ(latencyBucketOf(0), 0u);
+    EXPECT_EQ(latencyBucketOf(1), 1u);
+    EXPECT_EQ(latencyBucketOf(2), 2u);
+    EXPECT_EQ(latencyBucketOf(3), 2u);
+    EXPECT_EQ(latencyBucketOf(4), 3u);
+    EXPECT_EQ(latencyBucketOf(UINT64_MAX), STATS_LATENCY_BUCKETS - 1);
+}
+
+// Monitor 周期性发布计数器
+TEST(StatsFileTest, MonitorPublishesCounters) {
+    const std::string path = tempStatsPath("statsfile_monitor");
+    {
+        Monitor monitor;
+        ASSERT_TRUE(monitor.enableStatsFile(path, 10));
+        monitor.start();
+        monitor.recordNegotiation(3, true);
+        monitor.recordNegotiation(0, false);
+
+        StatsFileReader reader;
+        ASSERT_TRUE(reader.open(path));
+        StatsPayload read{};
+        for (int i = 0; i < 100 && read.totalNegotiations < 2; ++i) {
+            std::this_thread::sleep_for(10ms);
+            ASSERT_TRUE(reader.read(read));
+        }
+        EXPECT_EQ(read.totalNegotiations, 2u);
+        EXPECT_EQ(read.successfulNegotiations, 1u);
+        EXPECT_EQ(read.latencyHistogram[latencyBucketOf(3)], 1u);
+        monitor.stop();
+    }
+    EXPECT_FALSE(fs::exists(path));
+}
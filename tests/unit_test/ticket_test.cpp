@@ -0,0 +1,81 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/ticket_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/ticket/ticket.h"
+
+using namespace negotio;
+
+namespace {
+    template<typename T>
+    T filled(const uint8_t value) {
+        T bytes{};
+        bytes.fill(value);
+        return bytes;
+    }
+
+    ResumptionSecret sampleSecret() {
+        return deriveResumptionSecret(filled<SessionKey>(0x5A));
+    }
+}
+
+TEST(TicketTest, SealAndOpenRoundTrip) {
+    const TicketSealer sealer;
+    ResumptionTicket ticket{};
+    ASSERT_TRUE(sealer.seal(42, sampleSecret(), ticket));
+
+    ResumptionSecret opened{};
+    ASSERT_TRUE(sealer.open(ticket.data(), 42, DEFAULT_TICKET_LIFETIME_S, opened));
+    EXPECT_EQ(opened, sampleSecret());
+}
+
+// 每张票据的序号非零且互不相同，解开时原样取回
+TEST(TicketTest, StampsAreUnique) {
+    const TicketSealer sealer;
+    ResumptionTicket first{};
+    ResumptionTicket second{};
+    uint32_t firstStamp = 0;
+    uint32_t secondStamp = 0;
+    ASSERT_TRUE(sealer.seal(42, sampleSecret(), first, &firstStamp));
+    ASSERT_TRUE(sealer.seal(42, sampleSecret(), second, &secondStamp));
+    EXPECT_NE(firstStamp, 0u);
+    EXPECT_NE(firstStamp, secondStamp);
+
+    ResumptionSecret opened{};
+    uint32_t openedStamp = 0;
+    ASSERT_TRUE(sealer.open(second.data(), 42, DEFAULT_TICKET_LIFETIME_S, opened, &openedStamp));
+    EXPECT_EQ(openedStamp, secondStamp);
+}
+
+TEST(TicketTest, RejectsWrongPolicyKeyOrTampering) {
+    const TicketSealer sealer;
+    ResumptionTicket ticket{};
+    ASSERT_TRUE(sealer.seal(42, sampleSecret(), ticket));
+    ResumptionSecret opened{};
+
+    EXPECT_FALSE(sealer.open(ticket.data(), 43, DEFAULT_TICKET_LIFETIME_S, opened));
+    EXPECT_FALSE(TicketSealer().open(ticket.data(), 42, DEFAULT_TICKET_LIFETIME_S, opened));
+
+    ResumptionTicket tampered = ticket;
+    tampered[TICKET_NONCE_SIZE + 5] ^= 0x01;
+    EXPECT_FALSE(sealer.open(tampered.data(), 42, DEFAULT_TICKET_LIFETIME_S, opened));
+}
+
+// 同一恢复密钥、不同随机数得到不同的新密钥；恢复密钥本身不等于协商密钥
+TEST(TicketTest, ResumedKeyDerivation) {
+    const auto key = filled<SessionKey>(0x5A);
+    const ResumptionSecret secret = deriveResumptionSecret(key);
+    EXPECT_FALSE(std::equal(secret.begin(), secret.end(), key.begin()));
+
+    const auto r1 = filled<SessionRandom>(1);
+    const auto r2 = filled<SessionRandom>(2);
+    const auto r3 = filled<SessionRandom>(3);
+    EXPECT_EQ(computeResumedKey(secret, r1, r2).size(), KEY_SIZE);
+    EXPECT_EQ(computeResumedKey(secret, r1, r2), computeResumedKey(secret, r1, r2));
+    EXPECT_NE(computeResumedKey(secret, r1, r2), computeResumedKey(secret, r1, r3));
+}
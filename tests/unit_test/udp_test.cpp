@@ -8,7 +8,11 @@
 
 #include <gtest/gtest.h>
 #include "../../src/udp/udp.h"
+#include "../../src/allocstat/allocstat.h"
 #include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
 #include <thread>
 
 using namespace negotio;
@@ -79,3 +83,152 @@ TEST(UdpSocketTest, ReceiveTimeout) {
     ErrorCode result = receiver.recvPacket(packet, from, 100); // 设置短超时
     EXPECT_EQ(result, ErrorCode::TIMEOUT); // 应该超时
 }
+
+// SO_REUSEPORT 分片：数据包交给与收包核对应的分片（回环流量的软中断运行在发送线程所在的核上）
+TEST(UdpSocketTest, ReusePortSteersToLocalShard) {
+    const int cpu = sched_getcpu();
+    ASSERT_GE(cpu, 0);
+    cpu_set_t one;
+    CPU_ZERO(&one);
+    CPU_SET(cpu, &one);
+
+    constexpr uint16_t port = 7790;
+    constexpr int kShards = 2;
+    UdpSocket shards[kShards];
+    for (int i = 0; i < kShards; ++i) {
+        UdpSocketOptions options;
+        options.reusePort = true;
+        options.incomingCpu = cpu + i;
+        ASSERT_EQ(shards[i].init(port, options), ErrorCode::SUCCESS);
+        int incomingCpu = -1;
+        socklen_t len = sizeof(incomingCpu);
+        ASSERT_EQ(getsockopt(shards[i].getSocketFd(), SOL_SOCKET, SO_INCOMING_CPU, &incomingCpu, &len), 0);
+        EXPECT_EQ(incomingCpu, cpu + i);
+    }
+    if (shards[0].attachCpuSteering(cpu, kShards) != ErrorCode::SUCCESS) {
+        GTEST_SKIP() << "内核不支持 SO_ATTACH_REUSEPORT_CBPF";
+    }
+
+    // 不同源端口的四元组哈希各不相同，但都应落在 cpu 对应的分片 0 上
+    std::thread([&]() {
+        ASSERT_EQ(pthread_setaffinity_np(pthread_self(), sizeof(one), &one), 0);
+        sockaddr_in target{};
+        target.sin_family = AF_INET;
+        target.sin_port = htons(port);
+        target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        for (uint32_t i = 0; i < 8; ++i) {
+            UdpSocket sender;
+            ASSERT_EQ(sender.init(0), ErrorCode::SUCCESS);
+            NegotiationPacket packet = makeTestPacket(100 + i);
+            ASSERT_EQ(sender.sendPacket(packet, target), ErrorCode::SUCCESS);
+        }
+    }).join();
+
+    for (uint32_t i = 0; i < 8; ++i) {
+        NegotiationPacket received{};
+        sockaddr_in from{};
+        ASSERT_EQ(shards[0].recvPacket(received, from, 100), ErrorCode::SUCCESS) << "packet " << i;
+        EXPECT_EQ(received.header.sequence, 100u + i);
+    }
+    NegotiationPacket stray{};
+    sockaddr_in from{};
+    EXPECT_EQ(shards[1].recvPacket(stray, from, 10), ErrorCode::TIMEOUT);
+}
+
+TEST(UdpSocketTest, ReusePortSteersByPolicyId) {
+    constexpr uint16_t port = 7791;
+    constexpr int kShards = 3;
+    UdpSocket shards[kShards];
+    for (auto &shard : shards) {
+        UdpSocketOptions options;
+        options.reusePort = true;
+        ASSERT_EQ(shard.init(port, options), ErrorCode::SUCCESS);
+    }
+    if (shards[0].attachPolicySteering(kShards) != ErrorCode::SUCCESS) {
+        GTEST_SKIP() << "内核不支持 SO_ATTACH_REUSEPORT_CBPF";
+    }
+
+    // 同一源端口发出的不同策略按 policy_id % 3 分到各分片，与四元组哈希无关
+    sockaddr_in target{};
+    target.sin_family = AF_INET;
+    target.sin_port = htons(port);
+    target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UdpSocket sender;
+    ASSERT_EQ(sender.init(0), ErrorCode::SUCCESS);
+    const uint32_t policyIds[] = {0, 1, 2, 3, 0x01000004, 0xFFFFFFFE};
+    for (const uint32_t policyId : policyIds) {
+        NegotiationPacket packet = makeTestPacket(policyId);
+        ASSERT_EQ(sender.sendPacket(packet, target), ErrorCode::SUCCESS);
+    }
+
+    for (const uint32_t policyId : policyIds) {
+        NegotiationPacket received{};
+        sockaddr_in from{};
+        ASSERT_EQ(shards[policyId % kShards].recvPacket(received, from, 100), ErrorCode::SUCCESS)
+            << "policy " << policyId;
+        EXPECT_EQ(received.header.sequence, policyId);
+    }
+    for (auto &shard : shards) {
+        NegotiationPacket stray{};
+        sockaddr_in from{};
+        EXPECT_EQ(shard.recvPacket(stray, from, 10), ErrorCode::TIMEOUT);
+    }
+}
+
+// sendmmsg / recvmmsg 批量收发：一次最多取 maxPackets 个，解析失败的数据报计入读取数但不输出
+TEST(UdpSocketTest, SendAndReceiveBatch) {
+    UdpSocket sender;
+    UdpSocket receiver;
+    ASSERT_EQ(sender.init(0), ErrorCode::SUCCESS);
+    ASSERT_EQ(receiver.init(7778), ErrorCode::SUCCESS);
+
+    sockaddr_in recvAddr{};
+    recvAddr.sin_family = AF_INET;
+    recvAddr.sin_port = htons(7778);
+    recvAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::vector<AddressedPacket> outPackets;
+    for (uint32_t seq = 1; seq <= 5; ++seq) {
+        outPackets.emplace_back(makeTestPacket(seq), recvAddr);
+    }
+    EXPECT_EQ(sender.sendPackets(outPackets), 5u);
+    constexpr uint8_t truncated[3] = {1, 2, 3};
+    ASSERT_EQ(sender.sendBuffer(truncated, sizeof(truncated), recvAddr), ErrorCode::SUCCESS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::vector<AddressedPacket> inPackets;
+    EXPECT_EQ(receiver.recvPackets(inPackets, 4), 4u);
+    EXPECT_EQ(receiver.recvPackets(inPackets, 4), 2u);
+    EXPECT_EQ(receiver.recvPackets(inPackets, 4), 0u); // 缓冲区已空，不阻塞
+    ASSERT_EQ(inPackets.size(), 5u);
+    for (uint32_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(inPackets[i].first.header.sequence, i + 1);
+        EXPECT_EQ(inPackets[i].first.payload, outPackets[i].first.payload);
+        EXPECT_EQ(inPackets[i].second.sin_addr.s_addr, htonl(INADDR_LOOPBACK));
+    }
+}
+
+// 预热后接收不再分配数据报缓冲区
+TEST(UdpSocketTest, PrefaultedBuffersAvoidAllocation) {
+    if (!allocStatsEnabled()) {
+        GTEST_SKIP() << "NEGOTIO_ALLOC_STATS 未开启";
+    }
+    UdpSocket sender;
+    UdpSocket receiver;
+    ASSERT_EQ(sender.init(0), ErrorCode::SUCCESS);
+    ASSERT_EQ(receiver.init(7779), ErrorCode::SUCCESS);
+    sockaddr_in recvAddr{};
+    recvAddr.sin_family = AF_INET;
+    recvAddr.sin_port = htons(7779);
+    recvAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    UdpSocket::prefaultBuffers(4);
+    ASSERT_EQ(sender.sendPacket(makeTestPacket(7), recvAddr), ErrorCode::SUCCESS);
+    NegotiationPacket packet{};
+    packet.payload.reserve(4);
+    sockaddr_in from{};
+    const AllocCounters before = currentThreadAllocCounters();
+    ASSERT_EQ(receiver.recvPacket(packet, from, 100), ErrorCode::SUCCESS);
+    EXPECT_EQ(currentThreadAllocCounters().allocations - before.allocations, 0u);
+    EXPECT_EQ(packet.header.sequence, 7u);
+}
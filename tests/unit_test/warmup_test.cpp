@@ -0,0 +1,67 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/unit_test/warmup_test.cpp
+
+#include <gtest/gtest.h>
+#include "../../src/warmup/warmup.h"
+#include "../../src/negotiate/negotiate.h"
+#include <thread>
+#include <sys/resource.h>
+
+using namespace negotio;
+
+// 预热完成演练协商，且不向正式协商器写入任何会话
+TEST(WarmupTest, RehearsesWithoutTouchingSessions) {
+    Negotiator negotiator;
+    WarmupOptions options;
+    options.expectedSessions = 1024;
+    options.hashIterations = 16;
+    options.negotiationRounds = 8;
+
+    std::streambuf *coutBuf = std::cout.rdbuf();
+    testing::internal::CaptureStdout();
+    const WarmupReport report = warmUp(negotiator, options);
+    // 演练协商器静默，全局 std::cout 不被替换
+    EXPECT_EQ(testing::internal::GetCapturedStdout().find("[TRACE]"), std::string::npos);
+    EXPECT_EQ(std::cout.rdbuf(), coutBuf);
+    EXPECT_GT(report.firstNegotiationNs, 0u);
+    EXPECT_GT(report.lastNegotiationNs, 0u);
+    for (uint32_t id = 1; id <= options.negotiationRounds; ++id) {
+        EXPECT_FALSE(negotiator.getSession(id).has_value());
+    }
+}
+
+// 预热后的协商器可以正常协商
+TEST(WarmupTest, NegotiatorUsableAfterWarmup) {
+    Negotiator negotiator;
+    WarmupOptions options;
+    options.negotiationRounds = 2;
+    warmUp(negotiator, options);
+
+    sockaddr_in peer{};
+    peer.sin_family = AF_INET;
+    ASSERT_EQ(negotiator.startNegotiation(1, peer), ErrorCode::SUCCESS);
+    const auto session = negotiator.getSession(1);
+    ASSERT_TRUE(session.has_value());
+    EXPECT_EQ(session->state, NegotiateState::WAIT_R2);
+}
+
+// 预先触碰后，再次使用同一段栈不再缺页
+TEST(WarmupTest, PrefaultStack) {
+    long secondTouchFaults = -1;
+    std::thread([&secondTouchFaults] {
+        prefaultStack(64 * 1024);
+        rusage before{};
+        getrusage(RUSAGE_THREAD, &before);
+        prefaultStack(64 * 1024);
+        rusage after{};
+        getrusage(RUSAGE_THREAD, &after);
+        secondTouchFaults = after.ru_minflt - before.ru_minflt;
+    }).join();
+    EXPECT_GE(secondTouchFaults, 0);
+    EXPECT_LE(secondTouchFaults, 1);
+}
@@ -0,0 +1,93 @@
+/**
+ * @author fanfan187
+ * @version v1.0.0
+ * @since v1.0.0
+ */
+
+// tests/utils/bench_util.h
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <malloc.h>
+#include <unistd.h>
+
+namespace benchutils {
+
+    /**
+     * @brief 读取当前进程常驻内存（RSS），单位字节
+     */
+    inline uint64_t readRssBytes() {
+        std::ifstream statm("/proc/self/statm");
+        uint64_t sizePages = 0;
+        uint64_t residentPages = 0;
+        statm >> sizePages >> residentPages;
+        return residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    /**
+     * @brief 读取分配器当前已分配字节数（glibc mallinfo2：堆内已用 + mmap 大块）
+     */
+    inline uint64_t readAllocatorBytes() {
+        const struct mallinfo2 info = mallinfo2();
+        return static_cast<uint64_t>(info.uordblks) + static_cast<uint64_t>(info.hblkhd);
+    }
+
+    /**
+     * @brief 解析逗号分隔的数值列表，例如 "4096,100000,1000000"
+     */
+    inline std::vector<uint32_t> parseSizeList(const std::string &text) {
+        std::vector<uint32_t> sizes;
+        std::stringstream ss(text);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            if (!item.empty()) {
+                sizes.push_back(static_cast<uint32_t>(std::strtoul(item.c_str(), nullptr, 10)));
+            }
+        }
+        return sizes;
+    }
+
+    /**
+     * @brief 计算样本的分位数（会对样本排序）
+     * @param samples 样本
+     * @param quantile 分位 [0, 1]
+     */
+    template<typename T>
+    T percentile(std::vector<T> &samples, double quantile) {
+        if (samples.empty()) {
+            return T{};
+        }
+        std::sort(samples.begin(), samples.end());
+        const auto rank = static_cast<size_t>(quantile * static_cast<double>(samples.size() - 1));
+        return samples[rank];
+    }
+
+    /**
+     * @brief 在作用域内屏蔽 std::cout 输出，避免协商路径上的 TRACE 日志干扰基准数据
+     */
+    class ScopedSilence {
+    public:
+        ScopedSilence() : saved(std::cout.rdbuf(nullptr)) {
+        }
+
+        ~ScopedSilence() {
+            std::cout.rdbuf(saved);
+            std::cout.clear();
+        }
+
+        ScopedSilence(const ScopedSilence &) = delete;
+        ScopedSilence &operator=(const ScopedSilence &) = delete;
+
+    private:
+        std::streambuf *saved;
+    };
+
+} // namespace benchutils